@@ -0,0 +1,365 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "buffer/mem_pool.h"
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace {
+constexpr size_t BLOCK_ALIGNMENT = 4096;
+constexpr size_t HUGE_PAGE_SIZE = 2UL * 1024 * 1024;
+constexpr int TAG_SHIFT = 48;
+constexpr uint64_t POINTER_MASK = (UINT64_C(1) << TAG_SHIFT) - 1;
+
+std::atomic<MemPool *> g_poolRegistry[MemPool::MAX_POOLS];
+std::atomic<uint64_t> g_poolGeneration[MemPool::MAX_POOLS];
+
+inline uint64_t MakeTagged(void *ptr, uint64_t tag)
+{
+    return (reinterpret_cast<uint64_t>(ptr) & POINTER_MASK) | (tag << TAG_SHIFT);
+}
+
+inline void *TaggedPointer(uint64_t tagged) { return reinterpret_cast<void *>(tagged & POINTER_MASK); }
+
+inline uint64_t NextTag(uint64_t tagged) { return (tagged >> TAG_SHIFT) + 1; }
+
+int OnlineNumaNodes()
+{
+    // format like "0" or "0-3"
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string range;
+    if (!online.is_open() || !std::getline(online, range) || range.empty()) {
+        return 1;
+    }
+    auto pos = range.find_last_of("-,");
+    int last = std::atoi(range.c_str() + (pos == std::string::npos ? 0 : pos + 1));
+    return std::clamp(last + 1, 1, MemPool::MAX_NUMA_NODES);
+}
+
+int CurrentNumaNode()
+{
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (getcpu(&cpu, &node) != 0) {
+        return 0;
+    }
+    return static_cast<int>(node);
+}
+} // namespace
+
+struct MemPoolThreadCache
+{
+    struct Magazine
+    {
+        MemPool *pool = nullptr;
+        uint64_t generation = 0;
+        size_t count = 0;
+        void *blocks[MemPool::MAX_MAGAZINE_SIZE];
+    };
+
+    Magazine magazines[MemPool::MAX_POOLS];
+    int numaNode = -1;
+
+    Magazine *Get(MemPool *pool)
+    {
+        if (pool->m_poolId < 0 || pool->m_magazineSize == 0) {
+            return nullptr;
+        }
+        Magazine &magazine = magazines[pool->m_poolId];
+        uint64_t generation = g_poolGeneration[pool->m_poolId].load(std::memory_order_acquire);
+        if (magazine.pool != pool || magazine.generation != generation) {
+            // blocks of a destroyed pool are unmapped already, just forget them
+            magazine.pool = pool;
+            magazine.generation = generation;
+            magazine.count = 0;
+        }
+        return &magazine;
+    }
+
+    int NumaNode()
+    {
+        if (numaNode < 0) {
+            numaNode = CurrentNumaNode();
+        }
+        return numaNode;
+    }
+
+    ~MemPoolThreadCache()
+    {
+        for (int i = 0; i < MemPool::MAX_POOLS; ++i) {
+            Magazine &magazine = magazines[i];
+            if (magazine.count == 0 || g_poolRegistry[i].load(std::memory_order_acquire) != magazine.pool ||
+                g_poolGeneration[i].load(std::memory_order_acquire) != magazine.generation) {
+                continue;
+            }
+            while (magazine.count > 0) {
+                magazine.pool->SlabFree(magazine.blocks[--magazine.count]);
+            }
+        }
+    }
+};
+
+static thread_local MemPoolThreadCache t_threadCache;
+
+void MemPool::init(size_t blockSize, size_t capacity, MemPoolOptions options)
+{
+    if (m_init.exchange(true)) {
+        return;
+    }
+    m_blockSize = blockSize;
+    m_blockStride = (blockSize + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+    m_capacity = capacity;
+
+    int nodeNum = options.numaLocal ? OnlineNumaNodes() : 1;
+    nodeNum = static_cast<int>(std::min<size_t>(nodeNum, std::max<size_t>(capacity, 1)));
+    if (capacity > 0 && m_blockStride > 0) {
+        size_t alignment = options.hugePage ? HUGE_PAGE_SIZE : BLOCK_ALIGNMENT;
+        size_t dataSize = capacity * m_blockStride;
+        m_regionSize = dataSize + (options.hugePage ? HUGE_PAGE_SIZE : 0);
+        void *region = mmap(nullptr,
+                            m_regionSize,
+                            PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                            -1,
+                            0);
+        if (region == MAP_FAILED) {
+            // every block becomes an overflow block
+            m_regionSize = 0;
+        } else {
+            m_region = static_cast<char *>(region);
+            char *base = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(m_region) + alignment - 1) /
+                                                  alignment * alignment);
+            if (options.hugePage) {
+                madvise(base, dataSize, MADV_HUGEPAGE);
+            }
+            size_t perNode = capacity / nodeNum;
+            char *begin = base;
+            for (int node = 0; node < nodeNum; ++node) {
+                Slab &slab = m_slabs[node];
+                slab.blockNum = perNode + (node == 0 ? capacity % nodeNum : 0);
+                slab.begin = begin;
+                slab.end = begin + slab.blockNum * m_blockStride;
+                begin = slab.end;
+                if (options.numaLocal && nodeNum > 1) {
+                    // preferred rather than bind, so a full node falls back to others instead of failing
+                    unsigned long nodeMask = 1UL << node;
+                    syscall(SYS_mbind,
+                            slab.begin,
+                            slab.end - slab.begin,
+                            MPOL_PREFERRED,
+                            &nodeMask,
+                            MAX_NUMA_NODES + 1,
+                            0);
+                }
+            }
+            m_slabNum = nodeNum;
+        }
+    }
+
+    for (int i = 0; i < MAX_POOLS; ++i) {
+        MemPool *expected = nullptr;
+        if (g_poolRegistry[i].compare_exchange_strong(expected, this)) {
+            m_poolId = i;
+            g_poolGeneration[i].fetch_add(1, std::memory_order_acq_rel);
+            break;
+        }
+    }
+    // keep most blocks shareable among threads, magazines only absorb bursts
+    size_t threadNum = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    m_magazineSize = std::min(MAX_MAGAZINE_SIZE, capacity / (4 * threadNum));
+}
+
+MemPool::~MemPool()
+{
+    if (m_poolId >= 0) {
+        g_poolRegistry[m_poolId].store(nullptr, std::memory_order_release);
+        g_poolGeneration[m_poolId].fetch_add(1, std::memory_order_acq_rel);
+    }
+    if (m_region != nullptr) {
+        munmap(m_region, m_regionSize);
+        m_region = nullptr;
+    }
+}
+
+void *MemPool::PopFree(Slab &slab)
+{
+    uint64_t head = slab.head.load(std::memory_order_acquire);
+    while (TaggedPointer(head) != nullptr) {
+        // the block stays mapped even if another thread pops it first, the tag makes that CAS fail
+        auto *block = static_cast<FreeBlock *>(TaggedPointer(head));
+        FreeBlock *next = block->next.load(std::memory_order_relaxed);
+        if (slab.head.compare_exchange_weak(head,
+                                            MakeTagged(next, NextTag(head)),
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+            return block;
+        }
+    }
+    return nullptr;
+}
+
+void MemPool::PushFree(Slab &slab, void *buf)
+{
+    auto *block = static_cast<FreeBlock *>(buf);
+    uint64_t head = slab.head.load(std::memory_order_relaxed);
+    do {
+        block->next.store(static_cast<FreeBlock *>(TaggedPointer(head)), std::memory_order_relaxed);
+    } while (!slab.head.compare_exchange_weak(head,
+                                              MakeTagged(block, NextTag(head)),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+}
+
+int MemPool::OwnerSlab(const void *buf) const
+{
+    const char *p = static_cast<const char *>(buf);
+    for (int i = 0; i < m_slabNum; ++i) {
+        if (p >= m_slabs[i].begin && p < m_slabs[i].end) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void *MemPool::SlabAlloc(int preferNode)
+{
+    if (m_slabNum == 0) {
+        return nullptr;
+    }
+    int first = preferNode % m_slabNum;
+    for (int n = 0; n < m_slabNum; ++n) {
+        Slab &slab = m_slabs[(first + n) % m_slabNum];
+        void *block = PopFree(slab);
+        if (block != nullptr) {
+            m_cached.fetch_sub(1, std::memory_order_relaxed);
+            return block;
+        }
+        size_t carved = slab.carved.load(std::memory_order_relaxed);
+        while (carved < slab.blockNum) {
+            if (slab.carved.compare_exchange_weak(carved, carved + 1, std::memory_order_relaxed)) {
+                return slab.begin + carved * m_blockStride;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void MemPool::SlabFree(void *buf)
+{
+    int slab = OwnerSlab(buf);
+    if (slab >= 0) {
+        PushFree(m_slabs[slab], buf);
+    }
+}
+
+void *MemPool::alloc()
+{
+    if (!m_init.load()) {
+        return nullptr;
+    }
+    void *block = nullptr;
+    auto *magazine = t_threadCache.Get(this);
+    if (magazine != nullptr && magazine->count > 0) {
+        block = magazine->blocks[--magazine->count];
+        m_cached.fetch_sub(1, std::memory_order_relaxed);
+    } else {
+        block = SlabAlloc(m_slabNum > 1 ? t_threadCache.NumaNode() : 0);
+    }
+    if (block == nullptr) {
+        block = aligned_alloc(512, m_blockSize);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        m_overflow.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_inUse.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+std::vector<void *> MemPool::calloc(int num)
+{
+    if (!m_init.load()) {
+        return {};
+    }
+    std::vector<void *> bulkMem;
+    bulkMem.reserve(std::max(num, 0));
+    while (num-- > 0) {
+        void *mem = alloc();
+        if (mem == nullptr) {
+            for (auto &m : bulkMem) {
+                free(m);
+            }
+            bulkMem.clear();
+            break;
+        }
+        bulkMem.emplace_back(mem);
+    }
+    return bulkMem;
+}
+
+void MemPool::free(void *buf)
+{
+    if (!m_init.load()) {
+        return;
+    }
+    if (buf == nullptr) {
+        return;
+    }
+    m_inUse.fetch_sub(1, std::memory_order_relaxed);
+    int slab = OwnerSlab(buf);
+    if (slab < 0) {
+        m_overflow.fetch_sub(1, std::memory_order_relaxed);
+        ::free(buf);
+        return;
+    }
+    m_cached.fetch_add(1, std::memory_order_relaxed);
+
+    auto *magazine = t_threadCache.Get(this);
+    // a block of a remote node goes straight home, so it is reused by threads of its own node
+    bool remote = m_slabNum > 1 && slab != t_threadCache.NumaNode() % m_slabNum;
+    if (magazine == nullptr || remote) {
+        PushFree(m_slabs[slab], buf);
+        return;
+    }
+    if (magazine->count == m_magazineSize) {
+        // keep the hot half, give the rest back
+        while (magazine->count > m_magazineSize / 2) {
+            SlabFree(magazine->blocks[--magazine->count]);
+        }
+    }
+    magazine->blocks[magazine->count++] = buf;
+}
+
+MemPool::Stats MemPool::GetStats() const
+{
+    Stats stats{};
+    stats.blockSize = m_blockSize;
+    stats.capacity = m_capacity;
+    for (int i = 0; i < m_slabNum; ++i) {
+        stats.carved += std::min(m_slabs[i].carved.load(std::memory_order_relaxed), m_slabs[i].blockNum);
+    }
+    stats.inUse = std::max<int64_t>(m_inUse.load(std::memory_order_relaxed), 0);
+    stats.overflow = std::max<int64_t>(m_overflow.load(std::memory_order_relaxed), 0);
+    stats.cached = std::max<int64_t>(m_cached.load(std::memory_order_relaxed), 0);
+    return stats;
+}
+
+std::vector<std::pair<void *, size_t>> MemPool::GetRegions() const
+{
+    std::vector<std::pair<void *, size_t>> regions;
+    for (int i = 0; i < m_slabNum; ++i) {
+        if (m_slabs[i].blockNum > 0) {
+            regions.emplace_back(m_slabs[i].begin, m_slabs[i].end - m_slabs[i].begin);
+        }
+    }
+    return regions;
+}
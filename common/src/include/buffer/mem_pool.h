@@ -4,12 +4,25 @@
 
 #pragma once
 
-#include <pthread.h>
 #include <atomic>
+#include <cstdint>
 #include <cstdlib>
-#include <queue>
+#include <utility>
 #include <vector>
 
+struct MemPoolOptions
+{
+    bool hugePage = false;  // advise transparent huge pages for the slabs
+    bool numaLocal = false; // split slabs per NUMA node, threads prefer blocks of their own node
+};
+
+/*
+ * Fixed size block pool.
+ * Up to capacity blocks are carved lazily from mmap'ed slabs which stay mapped for the pool's
+ * lifetime, recycled blocks go to a small per-thread magazine first and then to a lock-free
+ * freelist of the owning slab. Requests beyond capacity fall back to aligned_alloc and are
+ * released to the system on free.
+ */
 class MemPool {
   public:
     static MemPool &GetInstance()
@@ -19,120 +32,69 @@ class MemPool {
     }
 
     MemPool() = default;
+    MemPool(size_t blockSize, size_t capacity, MemPoolOptions options = {}) { init(blockSize, capacity, options); }
+    ~MemPool();
+    MemPool(const MemPool &) = delete;
+    MemPool &operator=(const MemPool &) = delete;
 
-    MemPool(size_t blockSize, size_t capacity)
-    {
-        if (!m_init.exchange(true)) {
-            m_blockSize = blockSize;
-            m_capacity = capacity;
-            m_memLock = new (std::nothrow) pthread_spinlock_t;
-            if (m_memLock != nullptr) {
-                pthread_spin_init(m_memLock, 0);
-            } else {
-                m_init.store(false);
-            }
-        }
-    }
+    void init(size_t blockSize, size_t capacity, MemPoolOptions options = {});
 
-    ~MemPool()
-    {
-        while (!m_freeBlocks.empty()) {
-            free(m_freeBlocks.front());
-            m_freeBlocks.pop();
-        }
-        if (m_memLock) {
-            delete m_memLock;
-            m_memLock = nullptr;
-        }
-    }
+    void *alloc();
+    // all or nothing
+    std::vector<void *> calloc(int num);
+    void free(void *buf);
 
-    void init(size_t blockSize, size_t capacity)
+    struct Stats
     {
-        if (!m_init.exchange(true)) {
-            m_blockSize = blockSize;
-            m_capacity = capacity;
-            m_memLock = new (std::nothrow) pthread_spinlock_t;
-            if (m_memLock != nullptr) {
-                pthread_spin_init(m_memLock, 0);
-            } else {
-                m_init.store(false);
-            }
-        }
-    }
+        size_t blockSize;
+        size_t capacity;
+        size_t carved;     // blocks ever handed out from slabs
+        size_t inUse;      // blocks held by callers, slab and overflow
+        size_t overflow;   // overflow blocks held by callers
+        size_t cached;     // slab blocks sitting in freelists and magazines
+    };
+    Stats GetStats() const;
+    // address ranges of the slabs, e.g. for registering them with io_uring
+    std::vector<std::pair<void *, size_t>> GetRegions() const;
 
-    void *alloc()
-    {
-        if (!m_init.load()) {
-            return nullptr;
-        }
-        void *block = nullptr;
-        pthread_spin_lock(m_memLock);
-        if (!m_freeBlocks.empty()) {
-            block = m_freeBlocks.front();
-            m_freeBlocks.pop();
-        }
-        pthread_spin_unlock(m_memLock);
-        block = block ? block : aligned_alloc(512, m_blockSize);
-        m_size += block ? 1 : 0;
-        return block;
-    }
+    static constexpr int MAX_POOLS = 16;
+    static constexpr int MAX_NUMA_NODES = 8;
+    static constexpr size_t MAX_MAGAZINE_SIZE = 16;
 
-    std::vector<void *> calloc(int num)
+  private:
+    struct FreeBlock
     {
-        if (!m_init.load()) {
-            return {};
-        }
-        std::vector<void *> bulkMem;
+        std::atomic<FreeBlock *> next;
+    };
 
-        pthread_spin_lock(m_memLock);
-        while (!m_freeBlocks.empty() && num--) {
-            bulkMem.emplace_back(m_freeBlocks.front());
-            m_freeBlocks.pop();
-        }
-        pthread_spin_unlock(m_memLock);
-        while (num > 0) {
-            void *mem = aligned_alloc(512, m_blockSize);
-            if (mem == nullptr) {
-                break;
-            }
-            bulkMem.emplace_back(mem);
-            num--;
-        }
+    struct alignas(64) Slab
+    {
+        char *begin = nullptr;
+        char *end = nullptr;
+        size_t blockNum = 0;
+        std::atomic<size_t> carved = 0;
+        std::atomic<uint64_t> head = 0; // tagged pointer of the freelist
+    };
 
-        if (num > 0) {
-            /* error */
-            for (auto &m : bulkMem) {
-                /* how to free? */
-                ::free(m);
-            }
-            bulkMem.clear();
-        }
-        m_size += bulkMem.size();
-        return bulkMem;
-    }
+    friend struct MemPoolThreadCache;
 
-    void free(void *buf)
-    {
-        if (!m_init.load()) {
-            return;
-        }
-        if (buf == nullptr) {
-            return;
-        }
-        if (m_size-- < m_capacity) {
-            pthread_spin_lock(m_memLock);
-            m_freeBlocks.push(buf);
-            pthread_spin_unlock(m_memLock);
-        } else {
-            ::free(buf);
-        }
-    }
+    void *SlabAlloc(int preferNode);
+    void SlabFree(void *buf);
+    int OwnerSlab(const void *buf) const;
+    void *PopFree(Slab &slab);
+    void PushFree(Slab &slab, void *buf);
 
-  private:
     std::atomic<bool> m_init = false;
+    int m_poolId = -1;
     size_t m_blockSize = 0;
+    size_t m_blockStride = 0;
     size_t m_capacity = 0;
-    std::atomic<size_t> m_size = 0;
-    std::queue<void *> m_freeBlocks;
-    pthread_spinlock_t *m_memLock = nullptr;
+    size_t m_magazineSize = 0;
+    char *m_region = nullptr;
+    size_t m_regionSize = 0;
+    int m_slabNum = 0;
+    Slab m_slabs[MAX_NUMA_NODES];
+    std::atomic<int64_t> m_inUse = 0;
+    std::atomic<int64_t> m_overflow = 0;
+    std::atomic<int64_t> m_cached = 0;
 };
@@ -6,11 +6,15 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 
 #include "read_stream/read_stream.h"
 #include "write_stream/stream_assembler.h"
 
+class MultipartUpload;
+class RangeDownload;
+
 struct OpenInstance
 {
     OpenInstance() = default;
@@ -23,8 +27,6 @@ struct OpenInstance
     uint64_t fd = UINT64_MAX;
     // inodeid of the file
     uint64_t inodeId;
-    // offset + size of last serial read
-    off_t serialReadEnd = 0;
     // current size of file, max of original size & end of file
     //  uint64_t currentSize = 0;
     std::atomic<uint64_t> currentSize = 0;
@@ -68,6 +70,11 @@ struct OpenInstance
     std::shared_mutex fileMutex;
     // openfile called to open physical file
     std::atomic<bool> isOpened{false};
+    // background ranged download of the cache file, ranges in are read from it
+    std::shared_ptr<RangeDownload> download;
+    // upload of the cache file streamed while it is written, taken by the next flush
+    std::shared_ptr<MultipartUpload> upload;
+    std::mutex uploadMutex;
     // buffer to aggregate write data
     WriteStream writeStream;
     // buffer to store pre-fetched data. Must be LAST to be DESTRUCTED FIRST
@@ -71,4 +71,76 @@ class CuckooPropertyKey : public PropertyKey {
 
     inline static const auto CUCKOO_LOG_RESERVED_TIME =
         PropertyKey::Builder("main", "cuckoo_log_reserved_time", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_STAT_CACHE_CAPACITY =
+        PropertyKey::Builder("main", "cuckoo_stat_cache_capacity", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_STAT_CACHE_LEASE_MS =
+        PropertyKey::Builder("main", "cuckoo_stat_cache_lease_ms", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_PLACEMENT_CACHE_CAPACITY =
+        PropertyKey::Builder("main", "cuckoo_placement_cache_capacity", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_PLACEMENT_POLICY =
+        PropertyKey::Builder("main", "cuckoo_placement_policy", CUCKOO, CUCKOO_STRING).build();
+
+    inline static const auto CUCKOO_MEM_POOL_HUGEPAGE =
+        PropertyKey::Builder("main", "cuckoo_mem_pool_hugepage", CUCKOO, CUCKOO_BOOL).build();
+
+    inline static const auto CUCKOO_MEM_POOL_NUMA_LOCAL =
+        PropertyKey::Builder("main", "cuckoo_mem_pool_numa_local", CUCKOO, CUCKOO_BOOL).build();
+
+    inline static const auto CUCKOO_IO_ENGINE =
+        PropertyKey::Builder("main", "cuckoo_io_engine", CUCKOO, CUCKOO_STRING).build();
+
+    inline static const auto CUCKOO_IO_URING_DEPTH =
+        PropertyKey::Builder("main", "cuckoo_io_uring_depth", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_IO_URING_FIXED_BUFFERS =
+        PropertyKey::Builder("main", "cuckoo_io_uring_fixed_buffers", CUCKOO, CUCKOO_BOOL).build();
+
+    inline static const auto CUCKOO_READ_AHEAD_STREAMS =
+        PropertyKey::Builder("main", "cuckoo_read_ahead_streams", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_READ_AHEAD_MAX_BLOCKS =
+        PropertyKey::Builder("main", "cuckoo_read_ahead_max_blocks", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_CACHE_SNAPSHOT_INTERVAL =
+        PropertyKey::Builder("main", "cuckoo_cache_snapshot_interval", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_STORAGE =
+        PropertyKey::Builder("main", "cuckoo_storage", CUCKOO, CUCKOO_STRING).build();
+    inline static const auto CUCKOO_LOCAL_STORAGE_ROOT =
+        PropertyKey::Builder("main", "cuckoo_local_storage_root", CUCKOO, CUCKOO_STRING).build();
+    inline static const auto CUCKOO_LOCAL_STORAGE_LATENCY_US =
+        PropertyKey::Builder("main", "cuckoo_local_storage_latency_us", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_LOCAL_STORAGE_BANDWIDTH_MBPS =
+        PropertyKey::Builder("main", "cuckoo_local_storage_bandwidth_mbps", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_DOWNLOAD_RANGE_SIZE =
+        PropertyKey::Builder("main", "cuckoo_download_range_size", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_DOWNLOAD_PARALLELISM =
+        PropertyKey::Builder("main", "cuckoo_download_parallelism", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_UPLOAD_PART_SIZE =
+        PropertyKey::Builder("main", "cuckoo_upload_part_size", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_UPLOAD_PARALLELISM =
+        PropertyKey::Builder("main", "cuckoo_upload_parallelism", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_UPLOAD_STREAMING =
+        PropertyKey::Builder("main", "cuckoo_upload_streaming", CUCKOO, CUCKOO_BOOL).build();
+    inline static const auto CUCKOO_WRITE_BACK_CONCURRENCY =
+        PropertyKey::Builder("main", "cuckoo_write_back_concurrency", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_WRITE_BACK_RATE_MBPS =
+        PropertyKey::Builder("main", "cuckoo_write_back_rate_mbps", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_WRITE_BACK_DELAY_MS =
+        PropertyKey::Builder("main", "cuckoo_write_back_delay_ms", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_OBJECT_LAYOUT =
+        PropertyKey::Builder("main", "cuckoo_object_layout", CUCKOO, CUCKOO_STRING).build();
+    inline static const auto CUCKOO_OBJECT_LAYOUT_MIGRATE =
+        PropertyKey::Builder("main", "cuckoo_object_layout_migrate", CUCKOO, CUCKOO_BOOL).build();
+    inline static const auto CUCKOO_PACKED_CACHE =
+        PropertyKey::Builder("main", "cuckoo_packed_cache", CUCKOO, CUCKOO_BOOL).build();
+    inline static const auto CUCKOO_PACKED_SEGMENT_SIZE =
+        PropertyKey::Builder("main", "cuckoo_packed_segment_size", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_PACKED_MAX_FILE_SIZE =
+        PropertyKey::Builder("main", "cuckoo_packed_max_file_size", CUCKOO, CUCKOO_UINT).build();
+    inline static const auto CUCKOO_MEM_CACHE_MB =
+        PropertyKey::Builder("main", "cuckoo_mem_cache_mb", CUCKOO, CUCKOO_UINT).build();
 };
@@ -0,0 +1,80 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+struct IoEngineOptions
+{
+    std::string engine = "uring"; // "uring" or "sync"
+    uint32_t queueDepth = 64;
+    bool fixedBuffers = false; // register MemPool slabs with every ring, pins the whole pool
+};
+
+struct IoRequest
+{
+    int fd = -1;
+    void *buf = nullptr;
+    size_t size = 0;
+    off_t offset = 0;
+    bool write = false;
+    /* output: bytes transferred, short only at EOF for reads, or -errno */
+    ssize_t result = 0;
+};
+
+class IoRing;
+
+/*
+ * Local cache file I/O.
+ * With io_uring every thread owns a ring, requests of one call are submitted with a single
+ * io_uring_enter, large requests are split so they are served in parallel by the device.
+ * Hot fds are registered as fixed files of the calling thread's ring, buffers inside the
+ * MemPool slabs use fixed buffers when enabled. Without io_uring support, or before Init,
+ * requests fall back to pread/pwrite on the calling thread.
+ * Short transfers, EINTR and EAGAIN are retried, callers only see full size, EOF or an error.
+ */
+class IoEngine {
+  public:
+    static IoEngine &GetInstance()
+    {
+        static IoEngine instance;
+        return instance;
+    }
+
+    int Init(const IoEngineOptions &options);
+    bool UringEnabled() const { return uringEnabled.load(std::memory_order_acquire); }
+
+    ssize_t Read(int fd, void *buf, size_t size, off_t offset);
+    ssize_t Write(int fd, const void *buf, size_t size, off_t offset);
+    // submit all requests at once and wait for all of them
+    void Submit(IoRequest *reqs, size_t num);
+    // fds passed to Read/Write/Submit must be closed through here, they may be fixed files of a ring
+    int Close(int fd);
+
+    static constexpr size_t IO_CHUNK_SIZE = 1024 * 1024;
+
+  private:
+    friend class IoRing;
+
+    IoEngine() = default;
+    IoRing *LocalRing();
+    void SubmitSync(IoRequest *reqs, size_t num);
+    void AddRing(IoRing *ring);
+    void RemoveRing(IoRing *ring);
+
+    std::atomic<bool> uringEnabled{false};
+    uint32_t queueDepth = 64;
+    std::vector<iovec> fixedBuffers;
+    std::mutex ringMutex;
+    std::vector<IoRing *> rings;
+    std::atomic<int64_t> fixedFileNum{0};
+};
@@ -6,53 +6,102 @@
 
 #include <securec.h>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <map>
 #include <memory>
 #include <mutex>
-#include <thread>
 #include <vector>
 
-#define QUEUE_SIZE 3
+#include <butil/iobuf.h>
 
 struct OpenInstance;
+class ThreadPool;
 
-class Pipe {
-  public:
-    bool Init(size_t initSize);
-    void Init(size_t initSize, std::shared_ptr<char> initMem);
-    ssize_t WaitPop(char *buf, size_t popSize, bool &end);
-    ssize_t WaitPush(OpenInstance *openInstance, off_t offset);
-    void Destroy();
-
-    std::mutex mutex;
-    std::condition_variable readCV;
-    std::condition_variable writeCV;
-    std::shared_ptr<char> mem = nullptr;
-    size_t capacity = 0;
-    ssize_t size = 0;
-    ssize_t index = 0;
-    std::atomic<bool> stop = true;
+struct ReadAheadOptions
+{
+    size_t blockSize = 0;
+    uint32_t maxStreams = 4;       // sequential streams tracked per open file
+    uint32_t maxWindowBlocks = 16; // upper bound of the read-ahead window of one stream
 };
 
+/*
+ * Read-ahead of one open file.
+ * A read within JUMP_TOLERANCE_BLOCKS of the position of a tracked stream continues that stream,
+ * otherwise it starts a new one in place of the least recently used. Each stream keeps a window
+ * of blocks ahead of its position loading on the shared pool: the window doubles when readers
+ * catch up with loading, otherwise follows fetch latency over consumption time, and halves when
+ * prefetched blocks are dropped unused. Blocks are shared by the streams and dropped once no
+ * stream covers them.
+ */
 class ReadStream {
   public:
-    bool Init(OpenInstance *instance, int blocks, size_t pipeSize);
-    ssize_t WaitPop(char *buf, size_t popSize);
-    void StartPushThreaded();
-    void StopPushThreaded();
-    void WaitPushEnded();
-
-    void addPipeIndex();
     ~ReadStream();
 
-    std::atomic<size_t> stopOffset = -1;
-    size_t pipeCap = 0;
-    int pipeIndex = 0;
-    int fileBlocks = 0;
-    OpenInstance *openInstance;
-    int pipeNum = 0;
-    Pipe pipes[QUEUE_SIZE];
-    std::mutex pipeMutex;
-    std::atomic<bool> stop = true;
-    std::vector<std::thread> threads;
+    void Init(OpenInstance *instance, const ReadAheadOptions &readAheadOptions, ThreadPool *loadPool);
+    // bytes read, short only at end of file, or -errno
+    ssize_t Read(char *buf, size_t size, off_t offset);
+    // drop read-ahead data, later reads go to the file directly
+    void Stop();
+    // wait for loads in flight, prefetch tasks use the OpenInstance
+    void WaitLoadEnded();
+
+    struct Stats
+    {
+        size_t streams;
+        size_t blocks;
+        uint32_t maxWindow;
+        uint64_t hits;   // blocks ready when read
+        uint64_t waits;  // blocks still loading when read
+        uint64_t misses; // blocks loaded by the reader itself
+        uint64_t wasted; // prefetched blocks dropped unused
+    };
+    Stats GetStats();
+
+    static constexpr off_t JUMP_TOLERANCE_BLOCKS = 2;
+
+  private:
+    struct Block
+    {
+        off_t offset = 0;
+        std::shared_ptr<char> mem;
+        butil::IOBuf remoteData; // used instead of mem for remote files
+        ssize_t size = 0;
+        bool ready = false;
+        bool used = false;
+        bool dropped = false; // never loaded, the pool was full
+        int stream = -1; // stream which prefetched it, -1 if loaded on demand
+    };
+
+    struct Stream
+    {
+        bool active = false;
+        bool sequential = false;
+        off_t position = 0; // end of the furthest read
+        uint32_t window = 0;
+        uint64_t lastUse = 0;
+        std::chrono::steady_clock::time_point lastRead;
+        double blockIntervalUs = 0; // time to consume one block
+    };
+
+    int MatchStream(off_t offset);
+    void Advance(int stream, off_t offset, size_t readSize, bool stalled);
+    void Trim();
+    std::vector<std::shared_ptr<Block>> Plan(int stream);
+    std::shared_ptr<Block> NewBlock(off_t offset, int stream);
+    void Load(const std::shared_ptr<Block> &block);
+    void CopyOut(const Block &block, char *buf, size_t pos, size_t size);
+
+    OpenInstance *openInstance = nullptr;
+    ThreadPool *pool = nullptr;
+    ReadAheadOptions options;
+    bool enabled = false;
+    std::mutex mutex;
+    std::condition_variable loadCV;
+    std::map<off_t, std::shared_ptr<Block>> blocks;
+    std::vector<Stream> streams;
+    uint64_t useClock = 0;
+    double fetchLatencyUs = 0;
+    int inflight = 0;
+    Stats stats{};
 };
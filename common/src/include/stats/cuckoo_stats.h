@@ -23,9 +23,13 @@ enum {
     META_LAT,
     META_OPEN,
     META_OPEN_ATOMIC,
+    META_OPEN_SPECULATE_HIT,
+    META_OPEN_SPECULATE_MISS,
     META_RELEASE,
     META_STAT,
     META_STAT_LAT,
+    META_STAT_CACHE_HIT,
+    META_STAT_CACHE_MISS,
     META_LOOKUP,
     META_CREATE,
     META_UNLINK,
@@ -41,6 +45,19 @@ enum {
     META_FSYNC,
     BLOCKCACHE_READ,
     BLOCKCACHE_WRITE,
+    DISKCACHE_HIT,
+    DISKCACHE_MISS,
+    DISKCACHE_EVICT,
+    MEMCACHE_HIT,
+    MEMCACHE_MISS,
+    MEMCACHE_READ,
+    READ_AHEAD_HIT,
+    READ_AHEAD_WAIT,
+    READ_AHEAD_MISS,
+    READ_AHEAD_WASTE,
+    THREADPOOL_TASK,
+    THREADPOOL_QUEUE_LAT,
+    THREADPOOL_STEAL,
     OBJ_GET,
     OBJ_PUT,
     STATS_END
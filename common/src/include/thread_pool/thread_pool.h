@@ -4,20 +4,38 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
-#include <semaphore>
+#include <string>
 #include <thread>
 #include <vector>
 
+enum class TaskPriority {
+    FOREGROUND = 0, // a caller is or will soon be waiting for it
+    BACKGROUND,     // cache fill, eviction, run only when no foreground task is queued
+    PRIORITY_END
+};
+
 struct ThreadTask
 {
     std::string taskName;
     std::function<void()> task;
+    TaskPriority priority = TaskPriority::FOREGROUND;
 };
 
+/*
+ * Work-stealing pool.
+ * Every worker owns a deque per priority. Tasks submitted by a worker go to its own deques, others
+ * are spread round-robin. A worker runs its own tasks oldest first and steals the oldest from the
+ * others when its own deque is empty, foreground before background everywhere.
+ * At most maxTaskNum tasks are queued: Submit blocks until there is room, or runs the task inline
+ * when called from a worker of the pool, TrySubmit fails instead.
+ */
 class ThreadPool {
   public:
     ThreadPool(uint32_t threadNum, uint64_t maxTaskNum, std::string name);
@@ -29,20 +47,69 @@ class ThreadPool {
 
     int Start();
 
+    // run every queued task, then join the workers
     void Stop();
 
     int Submit(const ThreadTask &func);
 
+    // -EAGAIN if the queue is full or the pool is stopped
+    int TrySubmit(const ThreadTask &func);
+
+    /*
+     * Run tasks on the workers and the calling thread, return once all are done. The caller also runs the
+     * tasks no worker has started yet, so it never waits behind a queue, even from a worker or on a full pool.
+     */
+    void RunAndWait(const std::vector<std::function<void()>> &tasks);
+
+    struct Stats
+    {
+        uint64_t queued[static_cast<int>(TaskPriority::PRIORITY_END)];
+        uint64_t completed;
+        uint64_t stolen;
+        uint64_t inlined;           // run by the submitting worker because the queue was full
+        uint64_t avgQueueLatencyUs; // from submit to start
+        uint64_t maxQueueLatencyUs;
+    };
+    Stats GetStats() const;
+
   private:
-    void WorkLoop(const std::string &threadName);
+    struct QueuedTask
+    {
+        ThreadTask task;
+        std::chrono::steady_clock::time_point enqueueTime;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<QueuedTask> queues[static_cast<int>(TaskPriority::PRIORITY_END)];
+    };
+
+    void WorkLoop(uint32_t index, std::stop_token token);
+    bool Pop(uint32_t index, QueuedTask &out);
+    void Run(QueuedTask &queued);
+    void Push(const ThreadTask &func);
+    int LocalWorker() const;
 
     uint32_t threadNum{};
     uint64_t maxTaskNum{};
     std::string name;
-    std::mutex mutex;
-    std::condition_variable_any cv;
-    std::queue<ThreadTask> tasks;
+    std::vector<std::unique_ptr<Worker>> workers;
     std::vector<std::jthread> threads;
-    std::stop_source stopSource;
-    std::counting_semaphore<> taskSem;
+    std::atomic<bool> stopped{false};
+    std::atomic<uint32_t> nextWorker{0};
+
+    std::atomic<uint64_t> queuedNum[static_cast<int>(TaskPriority::PRIORITY_END)]{};
+    std::atomic<uint64_t> pendingNum{0};
+    std::atomic<uint32_t> sleepingNum{0};
+    std::mutex idleMutex;
+    std::condition_variable_any idleCV;
+    std::mutex fullMutex;
+    std::condition_variable fullCV;
+
+    std::atomic<uint64_t> completedNum{0};
+    std::atomic<uint64_t> stolenNum{0};
+    std::atomic<uint64_t> inlinedNum{0};
+    std::atomic<uint64_t> queueLatencyUs{0};
+    std::atomic<uint64_t> maxQueueLatencyUs{0};
 };
@@ -7,6 +7,7 @@
 #include <securec.h>
 #include <unistd.h>
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <set>
 #include <shared_mutex>
@@ -269,6 +270,11 @@ class WriteStream {
     int SetFd(uint64_t newPhysicalFd);
     void SetInodeId(uint64_t newInodeId) { inodeId = newInodeId; }
     void SetDirect(bool isDirect) { direct = isDirect; }
+    /* called after data is written to the local file, set before the first write */
+    void SetWrittenCallback(std::function<void(uint64_t offset, uint64_t size)> callback)
+    {
+        writtenCallback = std::move(callback);
+    }
     void SetClient(std::shared_ptr<CuckooIOClient> cuckooIOClient);
     uint64_t GetSize();
 
@@ -282,4 +288,5 @@ class WriteStream {
     SerialData data;
     uint64_t inodeId = 0;
     bool direct = false;
+    std::function<void(uint64_t offset, uint64_t size)> writtenCallback;
 };
@@ -0,0 +1,507 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "io_engine/io_engine.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+#include "buffer/mem_pool.h"
+#include "log/logging.h"
+
+namespace {
+constexpr int FIXED_FILE_NUM = 64;
+constexpr uint32_t HOT_FD_THRESHOLD = 4;
+constexpr int MAX_RETRY_NUM = 3;
+constexpr size_t MAX_SQE_LEN = 1UL << 30; // also the kernel limit of one fixed buffer
+constexpr ssize_t IO_PENDING = -EINPROGRESS;
+
+int IoUringSetup(unsigned entries, io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int ringFd, unsigned opcode, const void *arg, unsigned nrArgs)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, ringFd, opcode, arg, nrArgs));
+}
+
+bool Retryable(ssize_t res) { return res == -EAGAIN || res == -EINTR; }
+
+/*
+ * Account one completion of reqs[i], returns true if the remainder has to be submitted again.
+ */
+bool Complete(IoRequest &req, ssize_t res, size_t &done, int &retries)
+{
+    if (Retryable(res)) {
+        if (res == -EINTR || ++retries <= MAX_RETRY_NUM) {
+            return true;
+        }
+        req.result = res;
+        return false;
+    }
+    if (res < 0) {
+        // like read(2), report what was read before the error, e.g. O_DIRECT at an unaligned EOF
+        req.result = !req.write && done > 0 ? static_cast<ssize_t>(done) : res;
+        return false;
+    }
+    if (res == 0) {
+        // EOF for reads, a write which makes no progress would spin forever
+        req.result = req.write ? -EIO : static_cast<ssize_t>(done);
+        return false;
+    }
+    done += res;
+    if (done < req.size) {
+        return true;
+    }
+    req.result = static_cast<ssize_t>(done);
+    return false;
+}
+} // namespace
+
+class IoRing {
+  public:
+    IoRing() = default;
+    ~IoRing();
+    IoRing(const IoRing &) = delete;
+    IoRing &operator=(const IoRing &) = delete;
+
+    int Setup(unsigned entries, const std::vector<iovec> &buffers);
+    // false if the ring is broken, unfinished requests are left with IO_PENDING
+    bool Run(IoRequest *reqs, size_t num);
+    // may be called by any thread
+    void ForgetFd(int fd);
+
+  private:
+    struct FileSlot
+    {
+        int fd = -1;
+        uint32_t hits = 0;
+        bool registered = false;
+    };
+
+    int FixedFileIndex(int fd);
+    int FixedBufferIndex(const char *addr, size_t len) const;
+    bool UpdateFixedFile(int index, int fd);
+    void Prepare(const IoRequest &req, size_t done, int fileIndex, uint64_t userData);
+
+    int ringFd = -1;
+    void *sqRing = nullptr;
+    void *cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe *cqes = nullptr;
+
+    std::vector<iovec> fixedBuffers;
+    bool fixedFiles = false;
+    std::mutex slotMutex;
+    FileSlot slots[FIXED_FILE_NUM];
+};
+
+IoRing::~IoRing()
+{
+    if (ringFd < 0) {
+        return;
+    }
+    IoEngine::GetInstance().RemoveRing(this);
+    int64_t registered = 0;
+    for (auto &slot : slots) {
+        registered += slot.registered ? 1 : 0;
+    }
+    IoEngine::GetInstance().fixedFileNum.fetch_sub(registered, std::memory_order_relaxed);
+    if (sqes != nullptr) {
+        munmap(sqes, sqesSize);
+    }
+    if (cqRing != nullptr && cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != nullptr) {
+        munmap(sqRing, sqRingSize);
+    }
+    close(ringFd);
+}
+
+int IoRing::Setup(unsigned entries, const std::vector<iovec> &buffers)
+{
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CLAMP;
+    ringFd = IoUringSetup(entries, &params);
+    if (ringFd < 0) {
+        return -errno;
+    }
+    sqEntries = params.sq_entries;
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        return -errno;
+    }
+    if (singleMmap) {
+        cqRing = sqRing;
+    } else {
+        cqRing =
+            mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            return -errno;
+        }
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqesMap =
+        mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqesMap == MAP_FAILED) {
+        return -errno;
+    }
+    sqes = static_cast<io_uring_sqe *>(sqesMap);
+
+    char *sq = static_cast<char *>(sqRing);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    char *cq = static_cast<char *>(cqRing);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    // a sparse table, hot fds are put in place by FILES_UPDATE later
+    std::vector<int> emptyFiles(FIXED_FILE_NUM, -1);
+    fixedFiles = IoUringRegister(ringFd, IORING_REGISTER_FILES, emptyFiles.data(), FIXED_FILE_NUM) == 0;
+    if (!buffers.empty()) {
+        if (IoUringRegister(ringFd, IORING_REGISTER_BUFFERS, buffers.data(), buffers.size()) == 0) {
+            fixedBuffers = buffers;
+        } else {
+            CUCKOO_LOG(LOG_WARNING) << "IoRing: register fixed buffers failed: " << strerror(errno);
+        }
+    }
+    return 0;
+}
+
+bool IoRing::UpdateFixedFile(int index, int fd)
+{
+    io_uring_files_update update{};
+    update.offset = index;
+    update.fds = reinterpret_cast<uint64_t>(&fd);
+    return IoUringRegister(ringFd, IORING_REGISTER_FILES_UPDATE, &update, 1) == 1;
+}
+
+int IoRing::FixedFileIndex(int fd)
+{
+    if (!fixedFiles || fd < 0) {
+        return -1;
+    }
+    int index = fd % FIXED_FILE_NUM;
+    std::lock_guard<std::mutex> lock(slotMutex);
+    FileSlot &slot = slots[index];
+    if (slot.fd != fd) {
+        if (slot.registered) {
+            // do not keep an evicted cache file alive through the ring
+            UpdateFixedFile(index, -1);
+            IoEngine::GetInstance().fixedFileNum.fetch_sub(1, std::memory_order_relaxed);
+        }
+        slot = FileSlot{fd, 1, false};
+        return -1;
+    }
+    if (!slot.registered && ++slot.hits >= HOT_FD_THRESHOLD) {
+        // count first, so a concurrent Close never misses this ring
+        IoEngine::GetInstance().fixedFileNum.fetch_add(1, std::memory_order_relaxed);
+        slot.registered = UpdateFixedFile(index, fd);
+        if (!slot.registered) {
+            IoEngine::GetInstance().fixedFileNum.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    return slot.registered ? index : -1;
+}
+
+void IoRing::ForgetFd(int fd)
+{
+    if (!fixedFiles || fd < 0) {
+        return;
+    }
+    int index = fd % FIXED_FILE_NUM;
+    std::lock_guard<std::mutex> lock(slotMutex);
+    FileSlot &slot = slots[index];
+    if (slot.fd != fd) {
+        return;
+    }
+    if (slot.registered) {
+        UpdateFixedFile(index, -1);
+        IoEngine::GetInstance().fixedFileNum.fetch_sub(1, std::memory_order_relaxed);
+    }
+    slot = FileSlot{};
+}
+
+int IoRing::FixedBufferIndex(const char *addr, size_t len) const
+{
+    for (size_t i = 0; i < fixedBuffers.size(); ++i) {
+        const char *base = static_cast<const char *>(fixedBuffers[i].iov_base);
+        if (addr >= base && addr + len <= base + fixedBuffers[i].iov_len) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void IoRing::Prepare(const IoRequest &req, size_t done, int fileIndex, uint64_t userData)
+{
+    unsigned tail = *sqTail;
+    unsigned index = tail & sqMask;
+    io_uring_sqe *sqe = &sqes[index];
+    *sqe = io_uring_sqe{};
+    char *addr = static_cast<char *>(req.buf) + done;
+    size_t len = std::min(req.size - done, MAX_SQE_LEN);
+    int bufIndex = FixedBufferIndex(addr, len);
+    if (bufIndex >= 0) {
+        sqe->opcode = req.write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->buf_index = static_cast<uint16_t>(bufIndex);
+    } else {
+        sqe->opcode = req.write ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+    if (fileIndex >= 0) {
+        sqe->fd = fileIndex;
+        sqe->flags = IOSQE_FIXED_FILE;
+    } else {
+        sqe->fd = req.fd;
+    }
+    sqe->addr = reinterpret_cast<uint64_t>(addr);
+    sqe->len = static_cast<uint32_t>(len);
+    sqe->off = static_cast<uint64_t>(req.offset) + done;
+    sqe->user_data = userData;
+    sqArray[index] = index;
+    std::atomic_ref<unsigned>(*sqTail).store(tail + 1, std::memory_order_release);
+}
+
+bool IoRing::Run(IoRequest *reqs, size_t num)
+{
+    std::vector<size_t> done(num, 0);
+    std::vector<int> retries(num, 0);
+    std::vector<int> fileIndex(num, -1);
+    std::vector<size_t> resubmit;
+    size_t next = 0;
+    unsigned inflight = 0;
+    for (size_t i = 0; i < num; ++i) {
+        reqs[i].result = IO_PENDING;
+    }
+
+    while (next < num || !resubmit.empty() || inflight > 0) {
+        unsigned queued = *sqTail - std::atomic_ref<unsigned>(*sqHead).load(std::memory_order_acquire);
+        while (inflight + queued < sqEntries && (!resubmit.empty() || next < num)) {
+            size_t i = 0;
+            if (!resubmit.empty()) {
+                i = resubmit.back();
+                resubmit.pop_back();
+            } else {
+                i = next++;
+                if (reqs[i].size == 0) {
+                    reqs[i].result = 0;
+                    continue;
+                }
+                fileIndex[i] = FixedFileIndex(reqs[i].fd);
+            }
+            Prepare(reqs[i], done[i], fileIndex[i], i);
+            ++queued;
+        }
+        if (queued == 0 && inflight == 0) {
+            break;
+        }
+
+        int ret = IoUringEnter(ringFd, queued, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            CUCKOO_LOG(LOG_ERROR) << "IoRing: io_uring_enter failed: " << strerror(errno);
+            return false;
+        }
+        inflight += ret > 0 ? ret : 0;
+
+        unsigned head = *cqHead;
+        unsigned tail = std::atomic_ref<unsigned>(*cqTail).load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            const io_uring_cqe &cqe = cqes[head & cqMask];
+            size_t i = cqe.user_data;
+            --inflight;
+            if (cqe.res == -EBADF && fileIndex[i] >= 0) {
+                // the slot was dropped by a concurrent Close, let the plain fd decide
+                fileIndex[i] = -1;
+                resubmit.push_back(i);
+                continue;
+            }
+            if (Complete(reqs[i], cqe.res, done[i], retries[i])) {
+                resubmit.push_back(i);
+            }
+        }
+        std::atomic_ref<unsigned>(*cqHead).store(head, std::memory_order_release);
+    }
+    return true;
+}
+
+static thread_local std::unique_ptr<IoRing> t_ring;
+static thread_local bool t_ringFailed = false;
+
+int IoEngine::Init(const IoEngineOptions &options)
+{
+    queueDepth = std::max<uint32_t>(options.queueDepth, 1);
+    if (options.engine != "uring") {
+        CUCKOO_LOG(LOG_INFO) << "IoEngine: use sync io";
+        return 0;
+    }
+    fixedBuffers.clear();
+    if (options.fixedBuffers) {
+        for (auto &region : MemPool::GetInstance().GetRegions()) {
+            char *base = static_cast<char *>(region.first);
+            for (size_t off = 0; off < region.second; off += MAX_SQE_LEN) {
+                fixedBuffers.push_back(iovec{base + off, std::min(region.second - off, MAX_SQE_LEN)});
+            }
+        }
+    }
+    IoRing probe;
+    int ret = probe.Setup(queueDepth, {});
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_WARNING) << "IoEngine: io_uring not available, fall back to sync io: " << strerror(-ret);
+        return 0;
+    }
+    uringEnabled.store(true, std::memory_order_release);
+    CUCKOO_LOG(LOG_INFO) << "IoEngine: use io_uring, queue depth " << queueDepth << ", fixed buffers "
+                         << fixedBuffers.size();
+    return 0;
+}
+
+IoRing *IoEngine::LocalRing()
+{
+    if (t_ring != nullptr || t_ringFailed) {
+        return t_ring.get();
+    }
+    auto ring = std::make_unique<IoRing>();
+    int ret = ring->Setup(queueDepth, fixedBuffers);
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_WARNING) << "IoEngine: setup io_uring failed, this thread uses sync io: " << strerror(-ret);
+        t_ringFailed = true;
+        return nullptr;
+    }
+    AddRing(ring.get());
+    t_ring = std::move(ring);
+    return t_ring.get();
+}
+
+void IoEngine::AddRing(IoRing *ring)
+{
+    std::lock_guard<std::mutex> lock(ringMutex);
+    rings.push_back(ring);
+}
+
+void IoEngine::RemoveRing(IoRing *ring)
+{
+    std::lock_guard<std::mutex> lock(ringMutex);
+    std::erase(rings, ring);
+}
+
+void IoEngine::SubmitSync(IoRequest *reqs, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        IoRequest &req = reqs[i];
+        size_t done = 0;
+        int retries = 0;
+        req.result = 0;
+        while (done < req.size) {
+            char *addr = static_cast<char *>(req.buf) + done;
+            ssize_t res = req.write ? pwrite(req.fd, addr, req.size - done, req.offset + done)
+                                    : pread(req.fd, addr, req.size - done, req.offset + done);
+            if (!Complete(req, res < 0 ? -errno : res, done, retries)) {
+                break;
+            }
+        }
+    }
+}
+
+void IoEngine::Submit(IoRequest *reqs, size_t num)
+{
+    IoRing *ring = UringEnabled() ? LocalRing() : nullptr;
+    if (ring == nullptr) {
+        SubmitSync(reqs, num);
+        return;
+    }
+    if (!ring->Run(reqs, num)) {
+        // the ring is unusable, redo what is left without it
+        for (size_t i = 0; i < num; ++i) {
+            if (reqs[i].result == IO_PENDING) {
+                SubmitSync(&reqs[i], 1);
+            }
+        }
+        t_ring.reset();
+        t_ringFailed = true;
+    }
+}
+
+static ssize_t RunChunked(IoEngine &engine, int fd, char *buf, size_t size, off_t offset, bool write)
+{
+    size_t chunkNum = std::max<size_t>((size + IoEngine::IO_CHUNK_SIZE - 1) / IoEngine::IO_CHUNK_SIZE, 1);
+    std::vector<IoRequest> reqs(chunkNum);
+    for (size_t i = 0; i < chunkNum; ++i) {
+        size_t chunkOffset = i * IoEngine::IO_CHUNK_SIZE;
+        reqs[i].fd = fd;
+        reqs[i].buf = buf + chunkOffset;
+        reqs[i].size = std::min(IoEngine::IO_CHUNK_SIZE, size - chunkOffset);
+        reqs[i].offset = offset + chunkOffset;
+        reqs[i].write = write;
+    }
+    engine.Submit(reqs.data(), reqs.size());
+    ssize_t total = 0;
+    for (auto &req : reqs) {
+        if (req.result < 0) {
+            return req.result;
+        }
+        total += req.result;
+        if (req.result < static_cast<ssize_t>(req.size)) {
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t IoEngine::Read(int fd, void *buf, size_t size, off_t offset)
+{
+    return RunChunked(*this, fd, static_cast<char *>(buf), size, offset, false);
+}
+
+ssize_t IoEngine::Write(int fd, const void *buf, size_t size, off_t offset)
+{
+    // the buffer is only read from, IoRequest just has no const flavour
+    return RunChunked(*this, fd, static_cast<char *>(const_cast<void *>(buf)), size, offset, true);
+}
+
+int IoEngine::Close(int fd)
+{
+    if (fixedFileNum.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(ringMutex);
+        for (auto *ring : rings) {
+            ring->ForgetFd(fd);
+        }
+    }
+    return close(fd);
+}
@@ -4,253 +4,369 @@
 
 #include "read_stream/read_stream.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "buffer/mem_pool.h"
 #include "buffer/open_instance.h"
 #include "cuckoo_store/cuckoo_store.h"
+#include "stats/cuckoo_stats.h"
+#include "thread_pool/thread_pool.h"
 
-/*---------------------- Pipe ----------------------*/
+namespace {
+constexpr uint32_t INIT_WINDOW_BLOCKS = 2;
+constexpr uint32_t MIN_WINDOW_BLOCKS = 1;
+constexpr double EWMA_WEIGHT = 0.25;
 
-bool Pipe::Init(size_t initSize)
+void UpdateEwma(double &average, double sample)
 {
-    std::unique_lock<std::mutex> xlock(mutex);
-    if (mem != nullptr) {
-        return true;
-    }
-
-    std::function<void(char *)> freeFunc = [](char *ptr) { MemPool::GetInstance().free(ptr); };
-    mem = std::shared_ptr<char>((char *)MemPool::GetInstance().alloc(), freeFunc);
-    if (mem == nullptr) {
-        CUCKOO_LOG(LOG_ERROR) << "Pipe::Init(): malloc failed";
-        return false;
-    }
-    capacity = initSize;
-    size = initSize;
-    index = initSize;
-    stop = false;
-    return true;
+    average = average == 0 ? sample : average + EWMA_WEIGHT * (sample - average);
 }
+} // namespace
 
-void Pipe::Init(size_t initSize, std::shared_ptr<char> initMem)
+void ReadStream::Init(OpenInstance *instance, const ReadAheadOptions &readAheadOptions, ThreadPool *loadPool)
 {
     std::unique_lock<std::mutex> xlock(mutex);
-    if (mem != nullptr) {
-        return;
-    }
-    mem = initMem;
-    capacity = initSize;
-    size = initSize;
-    index = initSize;
-    stop = false;
+    openInstance = instance;
+    options = readAheadOptions;
+    options.maxStreams = std::max<uint32_t>(options.maxStreams, 1);
+    options.maxWindowBlocks = std::max(options.maxWindowBlocks, MIN_WINDOW_BLOCKS);
+    pool = loadPool;
+    streams.assign(options.maxStreams, Stream{});
+    enabled = options.blockSize > 0;
 }
 
 /*
- * Wait to pop data of size to buf. Mark end to caller.
+ * Find the stream continued by a read at offset, or replace the least recently used one.
  */
-ssize_t Pipe::WaitPop(char *buf, size_t popSize, bool &end)
+int ReadStream::MatchStream(off_t offset)
 {
-    std::unique_lock<std::mutex> xlock(mutex);
-    /* wait for pipe not empty, or no data to push, or error */
-    readCV.wait(xlock, [this]() { return index != size || size <= 0 || stop; });
-    if (size < 0) {
-        /* read error */
-        CUCKOO_LOG(LOG_ERROR) << "Pipe::WaitPop(): read error : " << strerror(-size);
-        auto err = size;
-        Destroy();
-        return err;
-    }
-    if (size == 0) {
-        /* read end */
-        CUCKOO_LOG(LOG_INFO) << "Pipe::WaitPop(): read to end and return";
-        Destroy();
-        return 0;
-    }
-    if (index == size && stop) {
-        /* no data to push, and empty pipe */
-        Destroy();
-        return 0;
+    off_t tolerance = JUMP_TOLERANCE_BLOCKS * options.blockSize;
+    int victim = 0;
+    for (int i = 0; i < (int)streams.size(); ++i) {
+        Stream &stream = streams[i];
+        if (stream.active && offset >= stream.position - tolerance && offset <= stream.position + tolerance) {
+            return i;
+        }
+        if (!stream.active) {
+            victim = streams[victim].active ? i : victim;
+        } else if (streams[victim].active && stream.lastUse < streams[victim].lastUse) {
+            victim = i;
+        }
     }
+    Stream &stream = streams[victim];
+    stream = Stream{};
+    stream.active = true;
+    stream.position = offset;
+    stream.window = std::min(INIT_WINDOW_BLOCKS, options.maxWindowBlocks);
+    /* files are mostly read from the beginning, do not wait for a second read to confirm */
+    stream.sequential = offset == 0;
+    return victim;
+}
 
-    ssize_t readSize = std::min(popSize, (size_t)size - index);
-    errno_t err = memcpy_s(buf, popSize, mem.get() + index, readSize);
-    if (err != 0) {
-        CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
-        return -EIO;
+void ReadStream::Advance(int stream, off_t offset, size_t readSize, bool stalled)
+{
+    Stream &s = streams[stream];
+    auto now = std::chrono::steady_clock::now();
+    if (s.sequential && readSize > 0 && s.lastRead.time_since_epoch().count() != 0) {
+        double elapsedUs = std::chrono::duration<double, std::micro>(now - s.lastRead).count();
+        UpdateEwma(s.blockIntervalUs, elapsedUs * options.blockSize / readSize);
     }
-    index += readSize;
-    if (index == size) {
-        /* all data popped in pipe */
-        if (stop) {
-            Destroy();
+    bool wasSequential = s.sequential;
+    s.sequential = s.sequential || (s.lastUse != 0 && offset == s.position);
+    s.lastRead = now;
+    s.lastUse = ++useClock;
+    s.position = std::max<off_t>(s.position, offset + readSize);
+
+    if (stalled && wasSequential) {
+        s.window = std::min(s.window * 2, options.maxWindowBlocks);
+    } else if (fetchLatencyUs > 0 && s.blockIntervalUs > 0) {
+        /* enough blocks in flight to cover one fetch at the current consumption rate */
+        auto target = static_cast<uint32_t>(std::ceil(fetchLatencyUs / s.blockIntervalUs)) + 1;
+        target = std::clamp(target, MIN_WINDOW_BLOCKS, options.maxWindowBlocks);
+        if (target > s.window) {
+            s.window = target;
+        } else if (target < s.window) {
+            --s.window;
         }
-        end = true;
-        writeCV.notify_all();
     }
-    return readSize;
 }
 
 /*
- * Wait to read data of size capacity to mem.
- * Use ReadFileLR to read data, other than pass data to pipe.
+ * Drop blocks no stream covers any more, prefetched ones never read shrink their stream.
  */
-ssize_t Pipe::WaitPush(OpenInstance *openInstance, off_t offset)
+void ReadStream::Trim()
 {
-    std::unique_lock<std::mutex> xlock(mutex);
-    /* wait for pipe empty, or no need to push */
-    writeCV.wait(xlock, [this]() { return index == size || stop; });
-    if (stop) {
-        readCV.notify_all();
-        return 0;
-    }
-
-    ssize_t readSize = CuckooStore::GetInstance()->ReadFileLR(mem.get(), offset, openInstance, capacity);
-    if (readSize < 0) {
-        CUCKOO_LOG(LOG_ERROR) << "In WaitPush(): ReadFileLR() failed";
+    off_t blockSize = options.blockSize;
+    off_t tolerance = JUMP_TOLERANCE_BLOCKS * blockSize;
+    for (auto it = blocks.begin(); it != blocks.end();) {
+        auto &block = it->second;
+        bool covered = false;
+        for (auto &stream : streams) {
+            if (stream.active && block->offset + blockSize > stream.position - tolerance &&
+                block->offset < stream.position + (off_t)(stream.window + 1) * blockSize) {
+                covered = true;
+                break;
+            }
+        }
+        if (covered) {
+            ++it;
+            continue;
+        }
+        if (block->stream >= 0 && !block->used) {
+            ++stats.wasted;
+            CuckooStats::GetInstance().stats[READ_AHEAD_WASTE]++;
+            Stream &owner = streams[block->stream];
+            if (owner.active) {
+                owner.window = std::max(owner.window / 2, MIN_WINDOW_BLOCKS);
+            }
+        }
+        it = blocks.erase(it);
     }
-
-    index = 0;
-    size = readSize;
-    readCV.notify_all();
-
-    return readSize;
 }
 
-void Pipe::Destroy()
+std::shared_ptr<ReadStream::Block> ReadStream::NewBlock(off_t offset, int stream)
 {
-    capacity = 0;
-    size = 0;
-    index = 0;
-    stop = true;
-    mem = nullptr;
+    std::function<void(char *)> freeFunc = [](char *ptr) { MemPool::GetInstance().free(ptr); };
+    auto block = std::make_shared<Block>();
+    block->mem = std::shared_ptr<char>((char *)MemPool::GetInstance().alloc(), freeFunc);
+    if (block->mem == nullptr) {
+        CUCKOO_LOG(LOG_ERROR) << "ReadStream::NewBlock(): alloc failed";
+        return nullptr;
+    }
+    block->offset = offset;
+    block->stream = stream;
+    return block;
 }
 
-/*---------------------- ReadStream ----------------------*/
-
 /*
- * Init pipes under stream.
+ * Blocks to prefetch for a stream, registered as loading.
  */
-bool ReadStream::Init(OpenInstance *instance, int blocks, size_t pipeSize)
+std::vector<std::shared_ptr<ReadStream::Block>> ReadStream::Plan(int stream)
 {
-    std::unique_lock<std::mutex> xlock(pipeMutex);
-
-    openInstance = instance;
-    fileBlocks = blocks;
-    pipeNum = std::min(blocks, QUEUE_SIZE);
-    pipeCap = pipeSize;
-    stop = false;
+    std::vector<std::shared_ptr<Block>> toLoad;
+    Stream &s = streams[stream];
+    if (!s.sequential) {
+        return toLoad;
+    }
+    /* speculative loads never take blocks beyond the pool capacity */
+    MemPool::Stats poolStats = MemPool::GetInstance().GetStats();
+    size_t poolFree = poolStats.capacity > poolStats.inUse ? poolStats.capacity - poolStats.inUse : 0;
+    off_t blockSize = options.blockSize;
+    off_t fileSize = openInstance->currentSize.load();
+    off_t first = s.position / blockSize * blockSize;
+    for (uint32_t i = 0; i <= s.window && toLoad.size() < poolFree; ++i) {
+        off_t offset = first + (off_t)i * blockSize;
+        if (offset >= fileSize) {
+            break;
+        }
+        if (blocks.contains(offset)) {
+            continue;
+        }
+        auto block = NewBlock(offset, stream);
+        if (block == nullptr) {
+            break;
+        }
+        blocks.emplace(offset, block);
+        toLoad.push_back(block);
+        ++inflight;
+    }
+    return toLoad;
+}
 
-    std::function<void(char *)> freeFunc = [](char *ptr) { MemPool::GetInstance().free(ptr); };
-    std::vector<void *> mem = MemPool::GetInstance().calloc(pipeNum);
-    if (mem.empty()) {
-        CUCKOO_LOG(LOG_ERROR) << "ReadStream::Init: calloc mem failed";
-        return false;
+void ReadStream::Load(const std::shared_ptr<Block> &block)
+{
+    auto start = std::chrono::steady_clock::now();
+    block->size = CuckooStore::GetInstance()->ReadFileLR(block->mem.get(),
+                                                         block->offset,
+                                                         openInstance,
+                                                         options.blockSize,
+                                                         &block->remoteData);
+    double latencyUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    if (block->size < 0) {
+        CUCKOO_LOG(LOG_ERROR) << "ReadStream::Load(): ReadFileLR() failed at " << block->offset;
     }
-    for (int i = 0; i < pipeNum; i++) {
-        pipes[i].Init(pipeCap, std::shared_ptr<char>((char *)mem[i], freeFunc));
+
+    std::unique_lock<std::mutex> xlock(mutex);
+    if (block->size > 0) {
+        UpdateEwma(fetchLatencyUs, latencyUs);
     }
+    block->ready = true;
+    --inflight;
+    loadCV.notify_all();
+}
 
-    return true;
+void ReadStream::CopyOut(const Block &block, char *buf, size_t pos, size_t size)
+{
+    if (!block.remoteData.empty()) {
+        block.remoteData.copy_to(buf, size, pos);
+        return;
+    }
+    errno_t err = memcpy_s(buf, size, block.mem.get() + pos, size);
+    if (err != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
+    }
 }
 
 /*
- * Called by user.
- * Wait for data to be popped to buf.
- * If current pipe gives out less data than wanted, loop to read next pipe.
+ * Called by user. Serve the read from loaded blocks, load missing ones, then move the window on.
  */
-ssize_t ReadStream::WaitPop(char *buf, size_t popSize)
+ssize_t ReadStream::Read(char *buf, size_t size, off_t offset)
 {
-    std::unique_lock<std::mutex> xlock(pipeMutex);
+    std::unique_lock<std::mutex> xlock(mutex);
+    if (!enabled) {
+        xlock.unlock();
+        return CuckooStore::GetInstance()->RandomRead(CuckooReadBuffer{buf, size}, openInstance, offset);
+    }
+    off_t fileSize = openInstance->currentSize.load();
+    if (size == 0 || offset >= fileSize) {
+        return 0;
+    }
+    size = std::min<size_t>(size, fileSize - offset);
+
+    int stream = MatchStream(offset);
+    bool continued = streams[stream].lastUse != 0 && offset == streams[stream].position;
+    if (!streams[stream].sequential && !continued) {
+        /* not known to be sequential yet, do not load whole blocks for it */
+        xlock.unlock();
+        ssize_t readSize = CuckooStore::GetInstance()->RandomRead(CuckooReadBuffer{buf, size}, openInstance, offset);
+        xlock.lock();
+        if (streams[stream].active) {
+            Advance(stream, offset, std::max<ssize_t>(readSize, 0), false);
+        }
+        return readSize;
+    }
 
-    ssize_t readSize = 0;
-    ssize_t curSize = 0;
-    while (!stop && (size_t)readSize != popSize) {
-        bool isEnd = false;
-        curSize = pipes[pipeIndex].WaitPop(buf + readSize, popSize - readSize, isEnd);
-        if (isEnd) {
-            /* next pipe */
-            addPipeIndex();
+    off_t blockSize = options.blockSize;
+    size_t readSize = 0;
+    bool stalled = false;
+    ssize_t err = 0;
+    while (readSize < size) {
+        off_t pos = offset + readSize;
+        off_t blockOffset = pos / blockSize * blockSize;
+        std::shared_ptr<Block> block;
+        auto it = blocks.find(blockOffset);
+        if (it == blocks.end()) {
+            block = NewBlock(blockOffset, -1);
+            if (block == nullptr) {
+                err = -ENOMEM;
+                break;
+            }
+            blocks.emplace(blockOffset, block);
+            ++inflight;
+            ++stats.misses;
+            CuckooStats::GetInstance().stats[READ_AHEAD_MISS]++;
+            stalled = true;
+            xlock.unlock();
+            Load(block);
+            xlock.lock();
+        } else {
+            block = it->second;
+            if (block->ready) {
+                ++stats.hits;
+                CuckooStats::GetInstance().stats[READ_AHEAD_HIT]++;
+            } else {
+                ++stats.waits;
+                CuckooStats::GetInstance().stats[READ_AHEAD_WAIT]++;
+                stalled = true;
+                loadCV.wait(xlock, [&block]() { return block->ready; });
+                if (block->dropped) {
+                    /* already out of blocks, read it on demand */
+                    continue;
+                }
+            }
         }
-        if (curSize < 0) {
-            /* error */
-            return curSize;
+        block->used = true;
+        if (block->size < 0) {
+            err = block->size;
+            auto cur = blocks.find(blockOffset);
+            if (cur != blocks.end() && cur->second == block) {
+                /* let the next read try again */
+                blocks.erase(cur);
+            }
+            break;
         }
-        if (curSize == 0) {
-            /* read to end */
+        size_t inBlock = pos - blockOffset;
+        if ((ssize_t)inBlock >= block->size) {
+            /* end of file */
             break;
         }
-        readSize += curSize;
+        size_t copySize = std::min<size_t>(size - readSize, block->size - inBlock);
+        xlock.unlock();
+        CopyOut(*block, buf + readSize, inBlock, copySize);
+        xlock.lock();
+        readSize += copySize;
     }
 
+    std::vector<std::shared_ptr<Block>> toLoad;
+    if (enabled && streams[stream].active) {
+        Advance(stream, offset, readSize, stalled);
+        Trim();
+        toLoad = Plan(stream);
+    }
+    xlock.unlock();
+
+    for (auto &block : toLoad) {
+        ThreadTask task;
+        task.taskName = "read ahead";
+        task.task = [this, block]() { Load(block); };
+        /* never block the reader on a full pool, readers waiting for the block load it on demand instead */
+        if (pool == nullptr || pool->TrySubmit(task) != 0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto cur = blocks.find(block->offset);
+            if (cur != blocks.end() && cur->second == block) {
+                blocks.erase(cur);
+            }
+            block->dropped = true;
+            block->ready = true;
+            --inflight;
+            loadCV.notify_all();
+        }
+    }
+    if (readSize == 0 && err != 0) {
+        return err;
+    }
     return readSize;
 }
 
 /*
- * Switch the pipe that gives out data to next one
- */
-void ReadStream::addPipeIndex() { pipeIndex = (pipeIndex + 1) % pipeNum; }
-
-/*
- * Called by user.
- * Start max of threadNum and pipeNum number of threads to concurrently fills in the pipes.
+ * Called by user when the file is written or closed.
  */
-void ReadStream::StartPushThreaded()
+void ReadStream::Stop()
 {
-    std::unique_lock<std::mutex> xlock(pipeMutex);
-    for (int i = 0; i < pipeNum; i++) {
-        threads.emplace_back([=, this]() {
-            size_t offset = i * pipeCap;
-            while (!stop.load() && offset < stopOffset) {
-                ssize_t retSize = pipes[i].WaitPush(openInstance, offset);
-                if (retSize != (ssize_t)pipes[i].capacity) {
-                    /* Read data not equals capacity, means error or read end. Mark end for other reading threads */
-                    /* stopOffset will be small than offset for other threads because pipes are popped in order */
-                    stopOffset = offset;
-                    break;
-                }
-                offset += pipeNum * pipeCap;
-            }
-            /* no data will be pushed to pipe later, wake up reader */
-            pipes[i].stop = true;
-            pipes[i].readCV.notify_all();
-        });
+    std::unique_lock<std::mutex> xlock(mutex);
+    enabled = false;
+    blocks.clear();
+    for (auto &stream : streams) {
+        stream.active = false;
     }
 }
 
-/*
- * Called by user.
- * Stop all threads pushing the pipes started by StartPushThreaded.
- * Deallocate all memory of pipe.
- */
-void ReadStream::StopPushThreaded()
+void ReadStream::WaitLoadEnded()
 {
-    std::unique_lock<std::mutex> xlock(pipeMutex);
-    stop = true;
-    for (int i = 0; i < pipeNum; i++) {
-        std::unique_lock<std::mutex> pipelock(pipes[i].mutex);
-        pipes[i].Destroy();
-        pipes[i].writeCV.notify_all();
-    }
+    std::unique_lock<std::mutex> xlock(mutex);
+    loadCV.wait(xlock, [this]() { return inflight == 0; });
 }
 
-void ReadStream::WaitPushEnded()
+ReadStream::Stats ReadStream::GetStats()
 {
-    for (auto &th : threads) {
-        if (th.joinable()) {
-            th.join();
+    std::unique_lock<std::mutex> xlock(mutex);
+    Stats current = stats;
+    current.streams = 0;
+    current.maxWindow = 0;
+    for (auto &stream : streams) {
+        if (stream.active) {
+            ++current.streams;
+            current.maxWindow = std::max(current.maxWindow, stream.window);
         }
     }
+    current.blocks = blocks.size();
+    return current;
 }
 
-/*
- * Wait for all threads pushing to join
- */
 ReadStream::~ReadStream()
 {
-    for (int i = 0; i < pipeNum; i++) {
-        pipes[i].stop = true;
-        pipes[i].writeCV.notify_all();
-    }
-    for (auto &th : threads) {
-        if (th.joinable()) {
-            th.join();
-        }
-    }
+    Stop();
+    WaitLoadEnded();
 }
@@ -112,11 +112,15 @@ void PrintStats(std::string_view mountPath, std::stop_token stoken)
 
         std::println(outFile, "  Open: {}", currentStats[META_OPEN]);
         std::println(outFile, "  Open Atomic: {}", currentStats[META_OPEN_ATOMIC]);
+        std::println(outFile, "  Open Speculate Hit: {}", currentStats[META_OPEN_SPECULATE_HIT]);
+        std::println(outFile, "  Open Speculate Miss: {}", currentStats[META_OPEN_SPECULATE_MISS]);
         std::println(outFile, "  Release: {}", currentStats[META_RELEASE]);
         std::println(outFile, "  Stat: {}", currentStats[META_STAT]);
         std::println(outFile,
                      "  Stat Latency: {} μs",
                      formatTime(currentStats[META_STAT_LAT], currentStats[META_STAT]));
+        std::println(outFile, "  Stat Cache Hit: {}", currentStats[META_STAT_CACHE_HIT]);
+        std::println(outFile, "  Stat Cache Miss: {}", currentStats[META_STAT_CACHE_MISS]);
         std::println(outFile, "  Lookup: {}", currentStats[META_LOOKUP]);
         std::println(outFile, "  Create: {}", currentStats[META_CREATE]);
         std::println(outFile, "  Unlink: {}", currentStats[META_UNLINK]);
@@ -135,6 +139,31 @@ void PrintStats(std::string_view mountPath, std::stop_token stoken)
         std::println(outFile, "\nBlock Cache Operations:");
         std::println(outFile, "  Reads: {}", formatU64(currentStats[BLOCKCACHE_READ]));
         std::println(outFile, "  Writes: {}", formatU64(currentStats[BLOCKCACHE_WRITE]));
+        std::println(outFile, "  Hits: {}", currentStats[DISKCACHE_HIT]);
+        std::println(outFile, "  Misses: {}", currentStats[DISKCACHE_MISS]);
+        std::println(outFile, "  Evictions: {}", currentStats[DISKCACHE_EVICT]);
+
+        std::println(outFile, "\nMemory Cache:");
+        std::println(outFile, "  Hits: {}", currentStats[MEMCACHE_HIT]);
+        std::println(outFile, "  Misses: {}", currentStats[MEMCACHE_MISS]);
+        size_t memLookups = currentStats[MEMCACHE_HIT] + currentStats[MEMCACHE_MISS];
+        std::println(outFile,
+                     "  Hit Ratio: {:.1f}%",
+                     memLookups == 0 ? 0.0 : currentStats[MEMCACHE_HIT] * 100.0 / memLookups);
+        std::println(outFile, "  Served: {}", formatU64(currentStats[MEMCACHE_READ]));
+
+        std::println(outFile, "\nRead Ahead:");
+        std::println(outFile, "  Hits: {}", currentStats[READ_AHEAD_HIT]);
+        std::println(outFile, "  Waits: {}", currentStats[READ_AHEAD_WAIT]);
+        std::println(outFile, "  Misses: {}", currentStats[READ_AHEAD_MISS]);
+        std::println(outFile, "  Wasted: {}", currentStats[READ_AHEAD_WASTE]);
+
+        std::println(outFile, "\nThread Pool:");
+        std::println(outFile, "  Tasks: {}", formatOp(currentStats[THREADPOOL_TASK]));
+        std::println(outFile,
+                     "  Queue Latency: {} μs",
+                     formatTime(currentStats[THREADPOOL_QUEUE_LAT], currentStats[THREADPOOL_TASK]));
+        std::println(outFile, "  Steals: {}", currentStats[THREADPOOL_STEAL]);
 
         std::println(outFile, "\nObject Operations:");
         std::println(outFile, "  Gets: {}", currentStats[OBJ_GET]);
@@ -4,12 +4,25 @@
 
 #include "thread_pool/thread_pool.h"
 
+#include <algorithm>
+#include <cerrno>
+
+#include "stats/cuckoo_stats.h"
+
+namespace {
+constexpr size_t THREAD_NAME_MAX = 15;
+thread_local const ThreadPool *tlsPool = nullptr;
+thread_local uint32_t tlsIndex = 0;
+} // namespace
+
 ThreadPool::ThreadPool(uint32_t threadNum, uint64_t maxTaskNum, std::string name)
-    : threadNum(threadNum),
-      maxTaskNum(maxTaskNum),
-      name(std::move(name)),
-      taskSem(maxTaskNum)
+    : threadNum(std::max<uint32_t>(threadNum, 1)),
+      maxTaskNum(std::max<uint64_t>(maxTaskNum, 1)),
+      name(std::move(name))
 {
+    for (uint32_t i = 0; i < this->threadNum; ++i) {
+        workers.emplace_back(std::make_unique<Worker>());
+    }
 }
 
 ThreadPool::~ThreadPool() { Stop(); }
@@ -25,9 +38,9 @@ int ThreadPool::Start()
     std::jthread t;
     std::string threadName;
     try {
-        for (uint32_t i = 0;i < threadNum; ++i) {
-            threadName = name + "_" + std::to_string(i);
-            t = std::jthread([this, threadName]() { WorkLoop(threadName); });
+        for (uint32_t i = 0; i < threadNum; ++i) {
+            threadName = (name + "_" + std::to_string(i)).substr(0, THREAD_NAME_MAX);
+            t = std::jthread([this, i](std::stop_token token) { WorkLoop(i, token); });
             pthread_setname_np(t.native_handle(), threadName.c_str());
             threads.emplace_back(std::move(t));
         }
@@ -41,41 +54,206 @@ int ThreadPool::Start()
 
 void ThreadPool::Stop()
 {
-    stopSource.request_stop();
-    cv.notify_all();
+    stopped = true;
+    {
+        std::lock_guard lock(fullMutex);
+    }
+    fullCV.notify_all();
+    for (auto &thread : threads) {
+        thread.request_stop();
+    }
     threads.clear();
 }
 
+int ThreadPool::LocalWorker() const { return tlsPool == this ? static_cast<int>(tlsIndex) : -1; }
+
 int ThreadPool::Submit(const ThreadTask &func)
 {
-    taskSem.acquire();
-    {
-        std::lock_guard lock(mutex);
-        tasks.push(func);
+    uint64_t pending = pendingNum.load();
+    while (true) {
+        if (stopped) {
+            return -EAGAIN;
+        }
+        if (pending < maxTaskNum) {
+            if (pendingNum.compare_exchange_weak(pending, pending + 1)) {
+                break;
+            }
+            continue;
+        }
+        if (LocalWorker() >= 0) {
+            /* a worker waiting for room may be the one that should make it */
+            ++inlinedNum;
+            QueuedTask queued{func, std::chrono::steady_clock::now()};
+            Run(queued);
+            return 0;
+        }
+        std::unique_lock lock(fullMutex);
+        fullCV.wait(lock, [this]() { return pendingNum.load() < maxTaskNum || stopped; });
+        pending = pendingNum.load();
     }
+    Push(func);
+    return 0;
+}
 
-    cv.notify_one();
+int ThreadPool::TrySubmit(const ThreadTask &func)
+{
+    uint64_t pending = pendingNum.load();
+    do {
+        if (stopped || pending >= maxTaskNum) {
+            return -EAGAIN;
+        }
+    } while (!pendingNum.compare_exchange_weak(pending, pending + 1));
+    Push(func);
     return 0;
 }
 
-void ThreadPool::WorkLoop(const std::string &)
+void ThreadPool::RunAndWait(const std::vector<std::function<void()>> &tasks)
 {
-    auto token = stopSource.get_token();
-    std::unique_lock lock(mutex);
-    while (!token.stop_requested() || !tasks.empty()) {
-        cv.wait(lock, token, [this, token] { return !tasks.empty() || token.stop_requested(); });
-        if (tasks.empty()) {
+    struct State
+    {
+        const std::vector<std::function<void()>> *tasks;
+        std::unique_ptr<std::atomic<bool>[]> claimed;
+        std::mutex mutex;
+        std::condition_variable doneCV;
+        size_t doneNum = 0;
+    };
+    size_t taskNum = tasks.size();
+    auto state = std::make_shared<State>();
+    state->tasks = &tasks;
+    state->claimed = std::make_unique<std::atomic<bool>[]>(taskNum);
+    /* a copy left in the queue after return finds its task claimed and does nothing */
+    auto runOne = [state, taskNum](size_t i) {
+        if (state->claimed[i].exchange(true)) {
+            return;
+        }
+        (*state->tasks)[i]();
+        std::lock_guard lock(state->mutex);
+        if (++state->doneNum == taskNum) {
+            state->doneCV.notify_all();
+        }
+    };
+    for (size_t i = 1; i < taskNum; ++i) {
+        if (TrySubmit({.taskName = "run and wait", .task = [runOne, i]() { runOne(i); }}) != 0) {
             break;
         }
+    }
+    for (size_t i = 0; i < taskNum; ++i) {
+        runOne(i);
+    }
+    std::unique_lock lock(state->mutex);
+    state->doneCV.wait(lock, [&state, taskNum]() { return state->doneNum == taskNum; });
+}
+
+void ThreadPool::Push(const ThreadTask &func)
+{
+    int local = LocalWorker();
+    uint32_t index = local >= 0 ? local : nextWorker.fetch_add(1, std::memory_order_relaxed) % threadNum;
+    int priority = static_cast<int>(func.priority);
+    {
+        std::lock_guard lock(workers[index]->mutex);
+        workers[index]->queues[priority].push_back(QueuedTask{func, std::chrono::steady_clock::now()});
+        ++queuedNum[priority];
+    }
+    /* pairs with the sleepingNum increment of an idle worker, one of the two sees the other */
+    if (sleepingNum.load() > 0) {
+        {
+            std::lock_guard lock(idleMutex);
+        }
+        idleCV.notify_one();
+    }
+}
+
+/*
+ * Own oldest task first, then the others' oldest, a priority level at a time.
+ */
+bool ThreadPool::Pop(uint32_t index, QueuedTask &out)
+{
+    for (int priority = 0; priority < static_cast<int>(TaskPriority::PRIORITY_END); ++priority) {
+        if (queuedNum[priority].load() == 0) {
+            continue;
+        }
+        for (uint32_t i = 0; i < threadNum; ++i) {
+            Worker &worker = *workers[(index + i) % threadNum];
+            std::lock_guard lock(worker.mutex);
+            auto &queue = worker.queues[priority];
+            if (queue.empty()) {
+                continue;
+            }
+            out = std::move(queue.front());
+            queue.pop_front();
+            --queuedNum[priority];
+            if (pendingNum.fetch_sub(1) == maxTaskNum) {
+                std::lock_guard fullLock(fullMutex);
+                fullCV.notify_all();
+            }
+            if (i != 0) {
+                ++stolenNum;
+                CuckooStats::GetInstance().stats[THREADPOOL_STEAL]++;
+            }
+            return true;
+        }
+    }
+    return false;
+}
 
-        auto task = std::move(tasks.front());
-        tasks.pop();
-        lock.unlock();
+void ThreadPool::Run(QueuedTask &queued)
+{
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                         queued.enqueueTime)
+                       .count();
+    queueLatencyUs += latency;
+    uint64_t maxLatency = maxQueueLatencyUs.load();
+    while ((uint64_t)latency > maxLatency && !maxQueueLatencyUs.compare_exchange_weak(maxLatency, latency)) {
+    }
+    CuckooStats::GetInstance().stats[THREADPOOL_QUEUE_LAT] += latency;
+
+    if (queued.task.task) {
+        queued.task.task();
+    }
+    ++completedNum;
+    CuckooStats::GetInstance().stats[THREADPOOL_TASK]++;
+}
 
-        if (task.task) {
-            task.task();
+void ThreadPool::WorkLoop(uint32_t index, std::stop_token token)
+{
+    tlsPool = this;
+    tlsIndex = index;
+    QueuedTask queued;
+    while (true) {
+        if (Pop(index, queued)) {
+            Run(queued);
+            queued = QueuedTask{};
+            continue;
         }
-        taskSem.release();
-        lock.lock();
+        /* queued tasks are run even after stop */
+        if (token.stop_requested()) {
+            break;
+        }
+        std::unique_lock lock(idleMutex);
+        ++sleepingNum;
+        idleCV.wait(lock, token, [this]() {
+            for (auto &num : queuedNum) {
+                if (num.load() > 0) {
+                    return true;
+                }
+            }
+            return false;
+        });
+        --sleepingNum;
+    }
+    tlsPool = nullptr;
+}
+
+ThreadPool::Stats ThreadPool::GetStats() const
+{
+    Stats stats{};
+    for (int i = 0; i < static_cast<int>(TaskPriority::PRIORITY_END); ++i) {
+        stats.queued[i] = queuedNum[i].load();
     }
+    stats.completed = completedNum.load();
+    stats.stolen = stolenNum.load();
+    stats.inlined = inlinedNum.load();
+    stats.avgQueueLatencyUs = stats.completed == 0 ? 0 : queueLatencyUs.load() / stats.completed;
+    stats.maxQueueLatencyUs = maxQueueLatencyUs.load();
+    return stats;
 }
@@ -5,6 +5,7 @@
 #include "write_stream/stream_assembler.h"
 
 #include "disk_cache/disk_cache.h"
+#include "io_engine/io_engine.h"
 #include "stats/cuckoo_stats.h"
 
 MemPool FixMemory::writeMemPool(CUCKOO_STORE_STREAM_MAX_SIZE, 500);
@@ -97,12 +98,11 @@ int WriteStream::PersistToFile(const char *buf, size_t size, off_t offset, uint6
             return -ENOSPC;
         }
         CuckooStats::GetInstance().stats[BLOCKCACHE_WRITE] += size;
-        retSize = pwrite(physicalFd, buf, size, offset);
+        retSize = IoEngine::GetInstance().Write(physicalFd, buf, size, offset);
         if (retSize < 0) {
-            int err = errno;
-            CUCKOO_LOG(LOG_ERROR) << "In WriteStream::persistToFile(): pwrite failed" << strerror(err);
+            CUCKOO_LOG(LOG_ERROR) << "In WriteStream::persistToFile(): pwrite failed" << strerror(-retSize);
             DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
-            return -err;
+            return retSize;
         }
         if (!DiskCache::GetInstance().Add(inodeId, sizeToAdd)) {
             DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
@@ -110,6 +110,9 @@ int WriteStream::PersistToFile(const char *buf, size_t size, off_t offset, uint6
             return -ENOENT;
         }
         DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
+        if (writtenCallback) {
+            writtenCallback(offset, size);
+        }
         return 0;
     }
     return 0;
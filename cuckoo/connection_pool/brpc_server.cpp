@@ -29,7 +29,12 @@ class ConnectionPoolBrpcServer {
     {
         char *userName = getenv("USER");
         std::shared_ptr<PGConnectionPool> pgConnectionPool =
-            std::make_shared<PGConnectionPool>(CuckooPGPort, userName, poolSize, 20, 400);
+            std::make_shared<PGConnectionPool>(CuckooPGPort,
+                                               userName,
+                                               poolSize,
+                                               CuckooConnectionPoolPendingTaskBufferSize,
+                                               CuckooConnectionPoolMaxBatchSize,
+                                               CuckooConnectionPoolMaxBatchLingerUs);
 
         cuckoo::meta_proto::MetaServiceImpl metaServiceImpl(pgConnectionPool);
         if (server.AddService(&metaServiceImpl, brpc::SERVER_DOESNT_OWN_SERVICE) != 0)
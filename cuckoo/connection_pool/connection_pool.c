@@ -10,9 +10,15 @@
 
 #include "postgres.h"
 
+#include "access/htup_details.h"
+#include "catalog/pg_type_d.h"
+#include "fmgr.h"
+#include "funcapi.h"
 #include "postmaster/bgworker.h"
 #include "postmaster/postmaster.h"
 #include "storage/shmem.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
 #include "utils/error_log.h"
 #include "utils/memutils.h"
 #include "utils/resowner.h"
@@ -24,8 +30,12 @@ int CuckooPGPort = 0;
 int CuckooConnectionPoolPort = CUCKOO_CONNECTION_POOL_PORT_DEFAULT;
 int CuckooConnectionPoolSize = CUCKOO_CONNECTION_POOL_SIZE_DEFAULT;
 uint64_t CuckooConnectionPoolShmemSize = CUCKOO_CONNECTION_POOL_SHMEM_SIZE_DEFAULT;
+int CuckooConnectionPoolPendingTaskBufferSize = CUCKOO_CONNECTION_POOL_PENDING_TASK_BUFFER_SIZE_DEFAULT;
+int CuckooConnectionPoolMaxBatchSize = CUCKOO_CONNECTION_POOL_MAX_BATCH_SIZE_DEFAULT;
+int CuckooConnectionPoolMaxBatchLingerUs = CUCKOO_CONNECTION_POOL_MAX_BATCH_LINGER_US_DEFAULT;
 static char *CuckooConnectionPoolShmemBuffer = NULL;
 CuckooShmemAllocator CuckooConnectionPoolShmemAllocator;
+CuckooConnectionPoolBatchStats *CuckooConnectionPoolBatchStatsShmem = NULL;
 
 static volatile bool got_SIGTERM = false;
 static void CuckooDaemonConnectionPoolProcessSigTermHandler(SIGNAL_ARGS);
@@ -71,16 +81,22 @@ static void CuckooDaemonConnectionPoolProcessSigTermHandler(SIGNAL_ARGS)
 
 int CuckooConnectionPoolGotSigTerm(void) { return got_SIGTERM; }
 
-size_t CuckooConnectionPoolShmemsize() { return CuckooConnectionPoolShmemSize; }
+#define CUCKOO_CONNECTION_POOL_BATCH_STATS_SIZE \
+    (sizeof(CuckooConnectionPoolBatchStats) * CUCKOO_CONNECTION_POOL_BATCH_TYPE_NUM)
+
+size_t CuckooConnectionPoolShmemsize()
+{
+    return add_size(CuckooConnectionPoolShmemSize, CUCKOO_CONNECTION_POOL_BATCH_STATS_SIZE);
+}
 void CuckooConnectionPoolShmemInit()
 {
     bool initialized;
 
     CuckooConnectionPoolShmemBuffer =
-        ShmemInitStruct("Cuckoo Connection Pool Shmem", CuckooConnectionPoolShmemsize(), &initialized);
+        ShmemInitStruct("Cuckoo Connection Pool Shmem", CuckooConnectionPoolShmemSize, &initialized);
     if (CuckooShmemAllocatorInit(&CuckooConnectionPoolShmemAllocator,
                                  CuckooConnectionPoolShmemBuffer,
-                                 CuckooConnectionPoolShmemsize()) != 0)
+                                 CuckooConnectionPoolShmemSize) != 0)
         CUCKOO_ELOG_ERROR(PROGRAM_ERROR, "CuckooShmemAllocatorInit failed.");
     if (!initialized) {
         memset(CuckooConnectionPoolShmemAllocator.signatureCounter,
@@ -88,4 +104,61 @@ void CuckooConnectionPoolShmemInit()
                sizeof(PaddedAtomic64) *
                    (1 + CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT + CuckooConnectionPoolShmemAllocator.pageCount));
     }
-}
\ No newline at end of file
+
+    CuckooConnectionPoolBatchStatsShmem = ShmemInitStruct("Cuckoo Connection Pool Batch Stats",
+                                                          CUCKOO_CONNECTION_POOL_BATCH_STATS_SIZE,
+                                                          &initialized);
+    if (!initialized)
+        memset(CuckooConnectionPoolBatchStatsShmem, 0, CUCKOO_CONNECTION_POOL_BATCH_STATS_SIZE);
+}
+
+PG_FUNCTION_INFO_V1(cuckoo_connection_pool_batch_stats);
+
+static const char *const CuckooConnectionPoolBatchTypeName[CUCKOO_CONNECTION_POOL_BATCH_TYPE_NUM] =
+    {"mkdir", "create", "stat", "unlink", "open", "close", "opendir", "utimens", "chown", "chmod"};
+
+Datum cuckoo_connection_pool_batch_stats(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *functionContext = NULL;
+    TupleDesc tupleDescriptor;
+
+    if (SRF_IS_FIRSTCALL()) {
+        functionContext = SRF_FIRSTCALL_INIT();
+
+        MemoryContext oldContext = MemoryContextSwitchTo(functionContext->multi_call_memory_ctx);
+        if (get_call_result_type(fcinfo, NULL, &tupleDescriptor) != TYPEFUNC_COMPOSITE) {
+            CUCKOO_ELOG_ERROR(PROGRAM_ERROR, "return type must be a row type.");
+        }
+        functionContext->tuple_desc = BlessTupleDesc(tupleDescriptor);
+        functionContext->max_calls = CUCKOO_CONNECTION_POOL_BATCH_TYPE_NUM;
+        MemoryContextSwitchTo(oldContext);
+    }
+    functionContext = SRF_PERCALL_SETUP();
+
+    uint32 type = functionContext->call_cntr;
+    if (type < functionContext->max_calls) {
+        volatile CuckooConnectionPoolBatchStats *stats = &CuckooConnectionPoolBatchStatsShmem[type];
+        Datum histogram[CUCKOO_CONNECTION_POOL_BATCH_SIZE_BUCKET_NUM];
+        for (int i = 0; i < CUCKOO_CONNECTION_POOL_BATCH_SIZE_BUCKET_NUM; ++i)
+            histogram[i] = Int64GetDatum(stats->sizeHistogram[i]);
+
+        Datum values[7];
+        bool resNulls[7];
+        memset(resNulls, false, sizeof(resNulls));
+        values[0] = CStringGetTextDatum(CuckooConnectionPoolBatchTypeName[type]);
+        values[1] = Int64GetDatum(stats->batches);
+        values[2] = Int64GetDatum(stats->jobs);
+        values[3] = Int64GetDatum(stats->lingered);
+        values[4] = Int64GetDatum(stats->targetBatchSize);
+        values[5] = Int64GetDatum(stats->backendLatencyUs);
+        values[6] = PointerGetDatum(construct_array(histogram,
+                                                    CUCKOO_CONNECTION_POOL_BATCH_SIZE_BUCKET_NUM,
+                                                    INT8OID,
+                                                    sizeof(int64),
+                                                    FLOAT8PASSBYVAL,
+                                                    TYPALIGN_DOUBLE));
+        HeapTuple heapTupleRes = heap_form_tuple(functionContext->tuple_desc, values, resNulls);
+        SRF_RETURN_NEXT(functionContext, HeapTupleGetDatum(heapTupleRes));
+    }
+    SRF_RETURN_DONE(functionContext);
+}
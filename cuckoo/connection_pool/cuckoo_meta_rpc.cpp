@@ -12,7 +12,7 @@ namespace cuckoo::meta_proto
 
 void MetaServiceImpl::MetaCall(google::protobuf::RpcController *cntlBase,
                                const MetaRequest *request,
-                               Empty *response,
+                               MetaReply *response,
                                google::protobuf::Closure *done)
 {
     brpc::ClosureGuard doneGuard(done);
@@ -4,6 +4,7 @@
 
 #include "connection_pool/pg_connection.h"
 
+#include <chrono>
 #include <iostream>
 #include <sstream>
 
@@ -107,6 +108,7 @@ void PGConnection::BackgroundWorker()
                     totalParamCount,
                     (int64_t)totalParamShift,
                     signature);
+            auto sendTime = std::chrono::steady_clock::now();
             int sendQuerySucceed = PQsendQuery(conn, command);
             if (sendQuerySucceed != 1)
                 throw std::runtime_error(PQerrorMessage(conn));
@@ -115,6 +117,10 @@ void PGConnection::BackgroundWorker()
             res = PQgetResult(conn);
             if (res == NULL)
                 throw std::runtime_error(PQerrorMessage(conn));
+            parent->RecordBackendLatency(
+                serviceType,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sendTime)
+                    .count());
             // param is useless now
             CuckooShmemAllocatorFree(allocator, totalParamShift);
             if (PQresultStatus(res) != PGRES_TUPLES_OK) {
@@ -139,6 +145,7 @@ void PGConnection::BackgroundWorker()
                     char *data = (char *)malloc(replyBuilder.size);
                     memcpy(data, replyBuilder.buffer, replyBuilder.size);
                     cntl->response_attachment().append_user_data(data, replyBuilder.size, NULL);
+                    taskToExec->jobList[i]->GetResponse()->set_error_code(errorCode);
                     taskToExec->jobList[i]->Done();
                 }
             } else {
@@ -271,6 +278,8 @@ void PGConnection::BackgroundWorker()
                     CuckooErrorCode errorCode = CuckooErrorMsgAnalyse(totalErrorMsg, &validErrorMsg);
                     if (errorCode == SUCCESS)
                         errorCode = PROGRAM_ERROR;
+                    // one error reply stands for the whole segment
+                    job->GetResponse()->set_error_code(errorCode);
 
                     flatBufferBuilder.Clear();
                     auto metaResponse = cuckoo::meta_fbs::CreateMetaResponse(flatBufferBuilder, errorCode);
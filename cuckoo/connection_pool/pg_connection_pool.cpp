@@ -4,8 +4,85 @@
 
 #include "connection_pool/pg_connection_pool.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include "connection_pool/pg_connection.h"
 
+extern "C" {
+#include "connection_pool/connection_pool.h"
+}
+
+// a gap longer than this counts as idle, so the first jobs after a pause are sent alone
+#define ARRIVAL_GAP_MAX_NS ((int64_t)1000 * 1000 * 1000)
+
+static int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// the number of jobs of the type that arrive while pg handles one batch of it. it stays 1 while clients wait for
+// each other, so a job is sent at once, and grows with the load, so more jobs share one call
+size_t PGConnectionPool::TargetBatchSize(TaskSupportBatch &batch)
+{
+    int64_t target = batch.backendLatencyNs.load(std::memory_order_relaxed) / std::max<int64_t>(batch.arrivalGapNs, 1);
+    return std::clamp<int64_t>(target, 1, batchTaskBufferMaxSize);
+}
+
+// called with the batch taken from the pending queue while it still collects jobs. the batch is held back for
+// the rest of its target size only if no other task waits and at least half of the connections are idle, and
+// never longer than half a pg round trip. the manager dispatches nothing meanwhile, so a task queued during the
+// linger ends it at once
+void PGConnectionPool::CloseBatch(TaskSupportBatchType type, bool canLinger)
+{
+    TaskSupportBatch &batch = supportBatchTaskList[type];
+    bool lingered = false;
+    Task *closed;
+    {
+        std::unique_lock<std::mutex> lk(batch.taskMutex);
+        size_t target = TargetBatchSize(batch);
+        size_t size = batch.task->jobList.size();
+        if (canLinger && maxBatchLingerNs > 0 && size < target) {
+            int64_t lingerNs = std::min({maxBatchLingerNs,
+                                         batch.backendLatencyNs.load(std::memory_order_relaxed) / 2,
+                                         (int64_t)(target - size) * batch.arrivalGapNs});
+            lingeringBatch = &batch;
+            batch.cvBatchGrown.wait_for(lk, std::chrono::nanoseconds(lingerNs), [this, &batch, target]() -> bool {
+                return batch.task->jobList.size() >= target || pendingTaskNum > 0 || !working;
+            });
+            lingeringBatch = nullptr;
+            lingered = true;
+        }
+        closed = batch.task;
+        batch.task = new Task(batchTaskBufferMaxSize);
+        batch.task->isBatch = true;
+
+        CuckooConnectionPoolBatchStats *stats = &CuckooConnectionPoolBatchStatsShmem[type];
+        size = closed->jobList.size();
+        int bucket = std::min<int>(63 - __builtin_clzll(size), CUCKOO_CONNECTION_POOL_BATCH_SIZE_BUCKET_NUM - 1);
+        ++stats->batches;
+        stats->jobs += size;
+        stats->lingered += lingered;
+        ++stats->sizeHistogram[bucket];
+        stats->targetBatchSize = target;
+        stats->backendLatencyUs = batch.backendLatencyNs.load(std::memory_order_relaxed) / 1000;
+    }
+    batch.cvBatchNotFull.notify_all();
+}
+
+void PGConnectionPool::RecordBackendLatency(const cuckoo::meta_proto::MetaServiceType type, const int64_t latencyNs)
+{
+    TaskSupportBatchType taskSupportBatchType = ConvertMetaServiceTypeToTaskSupportBatchType(type);
+    if (taskSupportBatchType == TaskSupportBatchType::NOT_SUPPORT)
+        return;
+    // racing connections may drop an update, that only blurs the average
+    std::atomic<int64_t> &backendLatencyNs = supportBatchTaskList[taskSupportBatchType].backendLatencyNs;
+    int64_t old = backendLatencyNs.load(std::memory_order_relaxed);
+    backendLatencyNs.store(old + (latencyNs - old) / 8, std::memory_order_relaxed);
+}
+
 void PGConnectionPool::BackgroundPoolManager()
 {
     while (working) {
@@ -14,6 +91,7 @@ void PGConnectionPool::BackgroundPoolManager()
 
         // 2. wait for command
         Task *taskToExec = nullptr;
+        bool canLinger;
         {
             std::unique_lock<std::mutex> lk(pendingTaskMutex);
             cvPendingTaskNotEmpty.wait(lk, [this]() -> bool { return !pendingTask.empty() || !working; });
@@ -23,21 +101,24 @@ void PGConnectionPool::BackgroundPoolManager()
             // fetch command
             taskToExec = pendingTask.front();
             pendingTask.pop();
-            for (int i = 0; i < TaskSupportBatchType::NOT_SUPPORT; ++i) {
-                if (taskToExec != supportBatchTaskList[i].task)
-                    continue;
-                {
-                    std::unique_lock<std::mutex> lk(supportBatchTaskList[i].taskMutex);
-                    supportBatchTaskList[i].task = new Task(batchTaskBufferMaxSize);
-                    supportBatchTaskList[i].task->isBatch = true;
-                }
-                supportBatchTaskList[i].cvBatchNotFull.notify_one();
+            pendingTaskNum = pendingTask.size();
+            canLinger = pendingTask.empty();
+        }
+        cvPendingTaskNotFull.notify_one();
+        if (canLinger) {
+            std::unique_lock<std::mutex> lk(connPoolMutex);
+            canLinger = connPool.size() * 2 >= currentManagedConn.size();
+        }
+
+        // 3. stop the batch collecting jobs, only this thread replaces the task of a type
+        for (int i = 0; i < TaskSupportBatchType::NOT_SUPPORT; ++i) {
+            if (taskToExec == supportBatchTaskList[i].task) {
+                CloseBatch((TaskSupportBatchType)i, canLinger);
                 break;
             }
         }
-        cvPendingTaskNotFull.notify_one();
 
-        // 3. exec bt backgroundworker of connection
+        // 4. exec bt backgroundworker of connection
         conn->Exec(taskToExec);
     }
 }
@@ -46,7 +127,8 @@ PGConnectionPool::PGConnectionPool(const uint16_t port,
                                    const char *userName,
                                    const int connPoolSize,
                                    const uint16_t pendingTaskBufferMaxSize,
-                                   const uint16_t batchTaskBufferMaxSize)
+                                   const uint16_t batchTaskBufferMaxSize,
+                                   const int maxBatchLingerUs)
 {
     for (int i = 0; i < connPoolSize; ++i) {
         PGConnection *conn = new PGConnection(this, "127.0.0.1", port, userName);
@@ -55,9 +137,18 @@ PGConnectionPool::PGConnectionPool(const uint16_t port,
     }
     this->pendingTaskBufferMaxSize = pendingTaskBufferMaxSize;
     this->batchTaskBufferMaxSize = batchTaskBufferMaxSize;
+    this->maxBatchLingerNs = (int64_t)maxBatchLingerUs * 1000;
+    lingeringBatch = nullptr;
+    pendingTaskNum = 0;
+    static_assert(TaskSupportBatchType::NOT_SUPPORT == CUCKOO_CONNECTION_POOL_BATCH_TYPE_NUM,
+                  "one row of batch stats per batch type");
+    int64_t now = NowNs();
     for (int i = 0; i < TaskSupportBatchType::NOT_SUPPORT; ++i) {
         supportBatchTaskList[i].task = new Task(batchTaskBufferMaxSize);
         supportBatchTaskList[i].task->isBatch = true;
+        supportBatchTaskList[i].lastArrivalNs = now;
+        supportBatchTaskList[i].arrivalGapNs = ARRIVAL_GAP_MAX_NS;
+        supportBatchTaskList[i].backendLatencyNs = 0;
     }
 
     working = true;
@@ -110,13 +201,21 @@ void PGConnectionPool::DispatchAsyncMetaServiceJob(cuckoo::meta_proto::AsyncMeta
 
     Task *toInsertTask = NULL;
     if (allowBatchWithOthers) {
-        std::unique_lock<std::mutex> lk(supportBatchTaskList[taskSupportBatchType].taskMutex);
-        supportBatchTaskList[taskSupportBatchType].cvBatchNotFull.wait(lk, [this, taskSupportBatchType]() -> bool {
-            return supportBatchTaskList[taskSupportBatchType].task->jobList.size() < batchTaskBufferMaxSize;
-        });
-        if (supportBatchTaskList[taskSupportBatchType].task->jobList.size() == 0)
-            toInsertTask = supportBatchTaskList[taskSupportBatchType].task;
-        supportBatchTaskList[taskSupportBatchType].task->jobList.emplace_back(job);
+        TaskSupportBatch &batch = supportBatchTaskList[taskSupportBatchType];
+        {
+            std::unique_lock<std::mutex> lk(batch.taskMutex);
+            int64_t now = NowNs();
+            batch.arrivalGapNs += (std::min(now - batch.lastArrivalNs, ARRIVAL_GAP_MAX_NS) - batch.arrivalGapNs) / 8;
+            batch.lastArrivalNs = now;
+
+            batch.cvBatchNotFull.wait(lk, [this, &batch]() -> bool {
+                return batch.task->jobList.size() < batchTaskBufferMaxSize;
+            });
+            if (batch.task->jobList.size() == 0)
+                toInsertTask = batch.task;
+            batch.task->jobList.emplace_back(job);
+        }
+        batch.cvBatchGrown.notify_one();
     } else {
         toInsertTask = new Task();
         toInsertTask->jobList.emplace_back(job);
@@ -127,8 +226,16 @@ void PGConnectionPool::DispatchAsyncMetaServiceJob(cuckoo::meta_proto::AsyncMeta
             std::unique_lock<std::mutex> lk(pendingTaskMutex);
             cvPendingTaskNotFull.wait(lk, [this]() -> bool { return pendingTask.size() < pendingTaskBufferMaxSize; });
             pendingTask.push(toInsertTask);
+            pendingTaskNum = pendingTask.size();
         }
         cvPendingTaskNotEmpty.notify_one();
+        // the manager publishes lingeringBatch before it checks pendingTaskNum, so it either sees the task or
+        // is woken here
+        TaskSupportBatch *lingering = lingeringBatch;
+        if (lingering != nullptr) {
+            std::unique_lock<std::mutex> lk(lingering->taskMutex);
+            lingering->cvBatchGrown.notify_one();
+        }
     }
 }
 
@@ -152,6 +152,22 @@ CREATE FUNCTION pg_catalog.cuckoo_print_dir_path_hash_elem()
 COMMENT ON FUNCTION pg_catalog.cuckoo_print_dir_path_hash_elem()
     IS 'cuckoo print dir path hash elem';
 
+CREATE FUNCTION pg_catalog.cuckoo_dir_path_hash_stats(OUT capacity bigint, OUT entries bigint, OUT hits bigint,
+                                                      OUT lockFreeHits bigint, OUT misses bigint, OUT evictions bigint)
+    RETURNS record
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$cuckoo_dir_path_hash_stats$$;
+COMMENT ON FUNCTION pg_catalog.cuckoo_dir_path_hash_stats()
+    IS 'cuckoo dir path hash stats';
+
+CREATE FUNCTION pg_catalog.cuckoo_connection_pool_batch_stats()
+    RETURNS TABLE(type text, batches bigint, jobs bigint, lingered bigint, targetBatchSize bigint,
+                  backendLatencyUs bigint, sizeHistogram bigint[])
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$cuckoo_connection_pool_batch_stats$$;
+COMMENT ON FUNCTION pg_catalog.cuckoo_connection_pool_batch_stats()
+    IS 'cuckoo connection pool batch stats, sizeHistogram[i] counts batches of [2^(i-1), 2^i) jobs';
+
 CREATE FUNCTION pg_catalog.cuckoo_acquire_hash_lock(IN path cstring, IN parentId bigint, IN lockmode bigint)
     RETURNS INTEGER
     LANGUAGE C STRICT
@@ -276,6 +292,13 @@ CREATE FUNCTION pg_catalog.cuckoo_plain_readdir(path cstring)
     AS 'MODULE_PATHNAME', $$cuckoo_plain_readdir$$;
 COMMENT ON FUNCTION pg_catalog.cuckoo_plain_readdir(path cstring) IS 'cuckoo plain readdir';
 
+CREATE FUNCTION pg_catalog.cuckoo_plain_batch_bench(op cstring, dir cstring, batch_size int, rounds int)
+    RETURNS float8
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$cuckoo_plain_batch_bench$$;
+COMMENT ON FUNCTION pg_catalog.cuckoo_plain_batch_bench(op cstring, dir cstring, batch_size int, rounds int)
+    IS 'cpu microseconds per file of a batch meta handler';
+
 
 ----------------------------------------------------------------
 -- cuckoo_serialize_interface
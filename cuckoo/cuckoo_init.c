@@ -220,4 +220,56 @@ static void RegisterCuckooConfigVariables(void)
                             NULL,
                             NULL);
     CuckooConnectionPoolShmemSize = (uint64_t)CuckooConnectionPoolShmemSizeInMB * 1024 * 1024;
+
+    DefineCustomIntVariable("cuckoo_connection_pool.pending_task_buffer_size",
+                            gettext_noop("Max number of tasks waiting for a connection of the pool manager."),
+                            NULL,
+                            &CuckooConnectionPoolPendingTaskBufferSize,
+                            CUCKOO_CONNECTION_POOL_PENDING_TASK_BUFFER_SIZE_DEFAULT,
+                            1,
+                            65535,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("cuckoo_connection_pool.max_batch_size",
+                            gettext_noop("Max number of requests the pool manager batches into one call."),
+                            NULL,
+                            &CuckooConnectionPoolMaxBatchSize,
+                            CUCKOO_CONNECTION_POOL_MAX_BATCH_SIZE_DEFAULT,
+                            1,
+                            65535,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("cuckoo_connection_pool.max_batch_linger_us",
+                            gettext_noop("Max time a batch waits for more requests under load, 0 disables it."),
+                            NULL,
+                            &CuckooConnectionPoolMaxBatchLingerUs,
+                            CUCKOO_CONNECTION_POOL_MAX_BATCH_LINGER_US_DEFAULT,
+                            0,
+                            100000,
+                            PGC_POSTMASTER,
+                            GUC_UNIT_US,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("cuckoo_dir_path_hash.capacity",
+                            gettext_noop("Number of directories cached by the shared path resolution hash."),
+                            NULL,
+                            &CuckooDirPathHashCapacity,
+                            CUCKOO_DIR_PATH_HASH_CAPACITY_DEFAULT,
+                            CUCKOO_DIR_PATH_HASH_CAPACITY_MIN,
+                            CUCKOO_DIR_PATH_HASH_CAPACITY_MAX,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
 }
\ No newline at end of file
@@ -19,11 +19,13 @@
 #include "catalog/pg_namespace_d.h"
 #include "common/hashfn.h"
 #include "funcapi.h"
+#include "miscadmin.h"
+#include "port/pg_bitutils.h"
 #include "storage/lock.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/builtins.h"
-#include "utils/dynahash.h"
 #include "utils/fmgroids.h"
-#include "utils/hsearch.h"
 #include "utils/palloc.h"
 #include "utils/snapmgr.h"
 
@@ -34,77 +36,84 @@
 #include "utils/shmem_control.h"
 #include "utils/utils.h"
 
-#define NUM_FREELISTS 32
-
-typedef HASHELEMENT *HASHBUCKET;
+/*
+ * The shared directory path hash is split into DIR_PATH_HASH_PARTITION_SIZE partitions. Each partition owns
+ * a fixed range of buckets, items and name chunks carved out of one shmem block sized by
+ * cuckoo_dir_path_hash.capacity, and an LWLock that serializes its writers.
+ *
+ * Every writer also bumps the partition's seq to odd before changing the chains and back to even after, so a
+ * DIR_LOCK_NONE lookup can walk the chains without the LWLock and keep the result only if seq was even and
+ * unchanged around the walk. Lookups that have to pin the entry's RWLock still take the LWLock, eviction only
+ * removes entries whose RWLock is destroyable.
+ */
+#define DIR_PATH_HASH_PARTITION_SIZE 128
+#define DIR_PATH_HASH_PARTITION_INDEX(hashcode) ((hashcode) % DIR_PATH_HASH_PARTITION_SIZE)
+#define DIR_PATH_HASH_CHUNKS_PER_ITEM 2
+#define DIR_PATH_HASH_MAX_USAGE_COUNT 5
+#define DIR_PATH_HASH_OPTIMISTIC_RETRY 3
+#define DIR_PATH_NAME_CHUNK_NUM(length) \
+    (((length) + DIR_PATH_NAME_CHUNK_DATA_SIZE - 1) / DIR_PATH_NAME_CHUNK_DATA_SIZE)
 
-typedef HASHBUCKET *HASHSEGMENT;
+typedef struct
+{
+    LWLock lock;
+    pg_atomic_uint32 seq;   /* odd while a writer is changing the partition */
+    pg_atomic_uint32 count; /* items in use */
+    int32_t freeItem;
+    int32_t freeChunk;
+    uint32_t freeChunkCount;
+    uint32_t clockHand;
+} DirPathHashPartition;
+
+typedef union
+{
+    DirPathHashPartition partition;
+    char pad[PG_CACHE_LINE_SIZE];
+} DirPathHashPartitionPadded;
 
 typedef struct
 {
-    slock_t mutex;         /* spinlock for this freelist */
-    long nentries;         /* number of entries in associated buckets */
-    HASHELEMENT *freeList; /* chain of free elements */
-} FreeListData;
-
-struct HASHHDR
-{
-    FreeListData freeList[NUM_FREELISTS];
-
-    long dsize;        /* directory size */
-    long nsegs;        /* number of allocated segments (<= dsize) */
-    uint32 max_bucket; /* ID of maximum bucket in use */
-    uint32 high_mask;  /* mask to modulo into entire table */
-    uint32 low_mask;   /* mask to modulo into lower half of table */
-
-    Size keysize;        /* hash key length in bytes */
-    Size entrysize;      /* total user element size in bytes */
-    long num_partitions; /* # partitions (must be power of 2), or 0 */
-    long max_dsize;      /* 'dsize' limit if directory is fixed size */
-    long ssize;          /* segment size --- must be power of 2 */
-    int sshift;          /* segment shift = log2(ssize) */
-    int nelem_alloc;     /* number of entries to allocate at once */
-
-#ifdef HASH_STATISTICS
-    long accesses;
-    long collisions;
-#endif
-};
-
-struct HTAB
-{
-    HASHHDR *hctl;         /* => shared control information */
-    HASHSEGMENT *dir;      /* directory of segment starts */
-    HashValueFunc hash;    /* hash function */
-    HashCompareFunc match; /* key comparison function */
-    HashCopyFunc keycopy;  /* key copying function */
-    HashAllocFunc alloc;   /* memory allocator */
-    MemoryContext hcxt;    /* memory context if default allocator used */
-    char *tabname;         /* table name (for error messages) */
-    bool isshared;         /* true if table is in shared memory */
-    bool isfixed;          /* if true, don't enlarge */
-
-    bool frozen; /* true = no more inserts allowed */
-
-    Size keysize; /* hash key length in bytes */
-    long ssize;   /* segment size --- must be power of 2 */
-    int sshift;   /* segment shift = log2(ssize) */
-};
-// end
+    pg_atomic_uint64 hits;
+    pg_atomic_uint64 lockFreeHits;
+    pg_atomic_uint64 misses;
+    pg_atomic_uint64 evictions;
+} DirPathHashCounters;
+
+/* kept apart from the partition, so counting hits does not disturb the readers of seq */
+typedef union
+{
+    DirPathHashCounters counters;
+    char pad[PG_CACHE_LINE_SIZE];
+} DirPathHashCountersPadded;
+
+StaticAssertDecl(sizeof(DirPathHashPartition) <= PG_CACHE_LINE_SIZE, "DirPathHashPartition exceeds a cache line");
+
+int CuckooDirPathHashCapacity = CUCKOO_DIR_PATH_HASH_CAPACITY_DEFAULT;
 
-#define DIR_PATH_HASH_PARTITION_SIZE 128
-#define DIR_PATH_HASH_PARTITION_INDEX(hashcode) ((hashcode) % DIR_PATH_HASH_PARTITION_SIZE)
 static int DirPathLWLockTrancheId;
 static char *DirPathLWLockTrancheName = "Cuckoo dir path hash";
-static LWLockPadded *DirPathLWLockArray;
-#define DIR_PATH_HASH_PARTITION_LOCK(hashcode) (&(DirPathLWLockArray[(hashcode) % DIR_PATH_HASH_PARTITION_SIZE].lock))
-static HTAB *PathDirHash[DIR_PATH_HASH_PARTITION_SIZE] = {0};
-#define DIR_PATH_HASH_PARTITION(hashcode) (PathDirHash[(hashcode) % DIR_PATH_HASH_PARTITION_SIZE])
-static pg_atomic_uint32 *PathDirHashEntryCount = NULL;
-#define DIR_PATH_HASH_PARTITION_COUNT(hashcode) (PathDirHashEntryCount + (hashcode) % DIR_PATH_HASH_PARTITION_SIZE)
-
-static char DirPathHashToCommitAction[MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH];
-static DirPathHashItem DirPathHashToCommitActionInfo[MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH];
+static DirPathHashPartitionPadded *DirPathPartitions = NULL;
+static DirPathHashCountersPadded *DirPathCounters = NULL;
+static int32_t *DirPathBuckets = NULL;
+static DirPathHashItem *DirPathItems = NULL;
+static DirPathNameChunk *DirPathChunks = NULL;
+static uint32_t DirPathItemsPerPartition = 0;
+static uint32_t DirPathBucketsPerPartition = 0;
+static uint32_t DirPathChunksPerPartition = 0;
+#define DIR_PATH_HASH_PARTITION(hashcode) (&DirPathPartitions[DIR_PATH_HASH_PARTITION_INDEX(hashcode)].partition)
+#define DIR_PATH_HASH_COUNTERS(hashcode) (&DirPathCounters[DIR_PATH_HASH_PARTITION_INDEX(hashcode)].counters)
+#define DIR_PATH_HASH_ITEM_TOTAL ((int64_t)DirPathItemsPerPartition * DIR_PATH_HASH_PARTITION_SIZE)
+#define DIR_PATH_HASH_CHUNK_TOTAL ((int64_t)DirPathChunksPerPartition * DIR_PATH_HASH_PARTITION_SIZE)
+
+typedef struct
+{
+    char action;
+    uint64_t parentId;
+    uint64_t inodeId;
+    char fileName[MAX_DIRECTORY_PATH_HASH_SIZE];
+} DirPathHashToCommitEntry;
+
+static DirPathHashToCommitEntry DirPathHashToCommitActionInfo[MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH];
 static int DirPathHashToCommitSize = 0;
 void DirPathHashToCommitAddEntry(uint64_t parentId, const char *fileName);
 void DirPathHashToCommitUpdateEntry(uint64_t parentId, const char *fileName, uint64_t inodeId);
@@ -115,9 +124,9 @@ void DirPathHashToCommitAddEntry(uint64_t parentId, const char *fileName)
     if (DirPathHashToCommitSize >= MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH)
         CUCKOO_ELOG_ERROR(PROGRAM_ERROR,
                           "concurrency of directory action surpass MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH.");
-    DirPathHashToCommitAction[DirPathHashToCommitSize] = 'A';
-    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.parentId = parentId;
-    strcpy(DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.fileName, fileName);
+    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].action = 'A';
+    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].parentId = parentId;
+    strcpy(DirPathHashToCommitActionInfo[DirPathHashToCommitSize].fileName, fileName);
     DirPathHashToCommitSize++;
 }
 void DirPathHashToCommitUpdateEntry(uint64_t parentId, const char *fileName, uint64_t inodeId)
@@ -125,38 +134,49 @@ void DirPathHashToCommitUpdateEntry(uint64_t parentId, const char *fileName, uin
     if (DirPathHashToCommitSize >= MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH)
         CUCKOO_ELOG_ERROR(PROGRAM_ERROR,
                           "concurrency of directory action surpass MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH.");
-    DirPathHashToCommitAction[DirPathHashToCommitSize] = 'U';
-    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.parentId = parentId;
-    strcpy(DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.fileName, fileName);
+    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].action = 'U';
+    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].parentId = parentId;
+    strcpy(DirPathHashToCommitActionInfo[DirPathHashToCommitSize].fileName, fileName);
     DirPathHashToCommitActionInfo[DirPathHashToCommitSize].inodeId = inodeId;
     DirPathHashToCommitSize++;
 }
 void DirPathHashToCommitClear() { DirPathHashToCommitSize = 0; }
 
-DirPathHashKey ClockCountList[DIRECTORY_PATH_HASH_BUCKET_NUM];
-
 RWLock *DirectoryHashTableLastAcquiredLock = NULL;
 
-static uint32 dir_path_hash(const void *key, Size keysize);
-static int dir_path_compare(const void *key1, const void *key2);
-static int dir_path_compare(const void *key1, const void *key2);
-static int dir_path_match(const void *key1, const void *key2, Size keysize);
-static void *dir_path_keycopy(void *dest, const void *src, Size keysize);
+static void DirPathHashKeyInit(DirPathHashKey *key, uint64_t parentId, const char *name);
+static bool DirPathNameEquals(int32_t chunk, const char *name, uint32_t length);
+static int32_t FindDirPathHashItem(const DirPathHashKey *key);
+static bool SearchDirPathHashOptimistic(const DirPathHashKey *key, uint64_t *inodeId);
+static DirPathHashItem *EnterDirPathHashItem(const DirPathHashKey *key, uint64_t inodeId, bool *found);
+static void SetDirPathHashInodeId(const DirPathHashKey *key, DirPathHashItem *item, uint64_t inodeId);
+static void TouchDirPathHashItem(DirPathHashItem *item);
+static void RemoveDirPathHashItem(int partitionIndex, int32_t index);
+static bool EvictDirPathHashItem(int partitionIndex);
+static void EvictDirPathHashOverThreshold(int partitionIndex);
+static void ResetDirPathHashPartition(int partitionIndex);
 static void ReleaseDirPathHashLock(uint64_t parentId, char *filename);
-static DirPathHashItem *FindNextItem(HASH_SEQ_STATUS *status, int32_t *destroyableCnt);
-static bool EliminateDirPathHashByLRU(int partitionIndex);
 
 PG_FUNCTION_INFO_V1(cuckoo_print_dir_path_hash_elem);
+PG_FUNCTION_INFO_V1(cuckoo_dir_path_hash_stats);
 PG_FUNCTION_INFO_V1(cuckoo_acquire_hash_lock);
 PG_FUNCTION_INFO_V1(cuckoo_release_hash_lock);
 
+typedef struct
+{
+    char fileName[MAX_DIRECTORY_PATH_HASH_SIZE];
+    uint64_t parentId;
+    uint64_t inodeId;
+    bool locked;
+} DirPathHashElem;
+
 Datum cuckoo_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
 {
     FuncCallContext *functionContext = NULL;
     TupleDesc tupleDescriptor;
     List *returnInfoList = NIL;
     uint32 d_off;
-    DirPathHashItem *entry;
+    DirPathHashElem *entry;
     Datum values[4];
     bool resNulls[4];
     HeapTuple heapTupleRes;
@@ -170,14 +190,28 @@ Datum cuckoo_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
         }
         functionContext->tuple_desc = BlessTupleDesc(tupleDescriptor);
 
-        HASH_SEQ_STATUS status;
         for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
-            hash_seq_init(&status, PathDirHash[i]);
-            while ((entry = hash_seq_search(&status)) != 0) {
-                DirPathHashItem *temp_entry = (DirPathHashItem *)palloc(sizeof(DirPathHashItem));
-                memcpy(temp_entry, entry, sizeof(DirPathHashItem));
-                returnInfoList = lappend(returnInfoList, temp_entry);
+            DirPathHashPartition *partition = &DirPathPartitions[i].partition;
+            LWLockAcquire(&partition->lock, LW_SHARED);
+            for (uint32_t j = 0; j < DirPathItemsPerPartition; ++j) {
+                DirPathHashItem *item = &DirPathItems[(int64_t)i * DirPathItemsPerPartition + j];
+                if (!item->inUse) {
+                    continue;
+                }
+                entry = (DirPathHashElem *)palloc(sizeof(DirPathHashElem));
+                int32_t chunk = item->nameChunk;
+                for (uint32_t offset = 0; offset < item->nameLength; offset += DIR_PATH_NAME_CHUNK_DATA_SIZE) {
+                    uint32_t size = Min(item->nameLength - offset, DIR_PATH_NAME_CHUNK_DATA_SIZE);
+                    memcpy(entry->fileName + offset, DirPathChunks[chunk].data, size);
+                    chunk = DirPathChunks[chunk].next;
+                }
+                entry->fileName[item->nameLength] = '\0';
+                entry->parentId = item->parentId;
+                entry->inodeId = item->inodeId;
+                entry->locked = pg_atomic_read_u64(&item->lock.state) != 0;
+                returnInfoList = lappend(returnInfoList, entry);
             }
+            LWLockRelease(&partition->lock);
         }
 
         functionContext->user_fctx = returnInfoList;
@@ -189,13 +223,12 @@ Datum cuckoo_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
     d_off = functionContext->call_cntr;
 
     if (d_off < functionContext->max_calls) {
-        entry = (DirPathHashItem *)list_nth(returnInfoList, d_off);
+        entry = (DirPathHashElem *)list_nth(returnInfoList, d_off);
         memset(resNulls, false, sizeof(resNulls));
-        values[0] = CStringGetTextDatum(entry->key.fileName);
-        values[1] = Int32GetDatum(entry->key.parentId);
-        values[2] = Int32GetDatum(entry->inodeId);
-        RWLock *lock = &entry->lock;
-        if (pg_atomic_read_u64(&lock->state) == 0) {
+        values[0] = CStringGetTextDatum(entry->fileName);
+        values[1] = Int64GetDatum(entry->parentId);
+        values[2] = Int64GetDatum(entry->inodeId);
+        if (!entry->locked) {
             values[3] = CStringGetTextDatum("no lock");
         } else {
             values[3] = CStringGetTextDatum("locked");
@@ -206,6 +239,40 @@ Datum cuckoo_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
     SRF_RETURN_DONE(functionContext);
 }
 
+Datum cuckoo_dir_path_hash_stats(PG_FUNCTION_ARGS)
+{
+    TupleDesc tupleDescriptor;
+    if (get_call_result_type(fcinfo, NULL, &tupleDescriptor) != TYPEFUNC_COMPOSITE) {
+        CUCKOO_ELOG_ERROR(PROGRAM_ERROR, "return type must be a row type.");
+    }
+    tupleDescriptor = BlessTupleDesc(tupleDescriptor);
+
+    uint64_t entries = 0;
+    uint64_t hits = 0;
+    uint64_t lockFreeHits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
+        entries += pg_atomic_read_u32(&DirPathPartitions[i].partition.count);
+        hits += pg_atomic_read_u64(&DirPathCounters[i].counters.hits);
+        lockFreeHits += pg_atomic_read_u64(&DirPathCounters[i].counters.lockFreeHits);
+        misses += pg_atomic_read_u64(&DirPathCounters[i].counters.misses);
+        evictions += pg_atomic_read_u64(&DirPathCounters[i].counters.evictions);
+    }
+
+    Datum values[6];
+    bool resNulls[6];
+    memset(resNulls, false, sizeof(resNulls));
+    values[0] = Int64GetDatum(DIR_PATH_HASH_ITEM_TOTAL);
+    values[1] = Int64GetDatum(entries);
+    values[2] = Int64GetDatum(hits);
+    values[3] = Int64GetDatum(lockFreeHits);
+    values[4] = Int64GetDatum(misses);
+    values[5] = Int64GetDatum(evictions);
+    HeapTuple heapTupleRes = heap_form_tuple(tupleDescriptor, values, resNulls);
+    PG_RETURN_DATUM(HeapTupleGetDatum(heapTupleRes));
+}
+
 Datum cuckoo_acquire_hash_lock(PG_FUNCTION_ARGS)
 {
     char *fileName = PG_GETARG_CSTRING(0);
@@ -246,58 +313,270 @@ Datum cuckoo_release_hash_lock(PG_FUNCTION_ARGS)
     PG_RETURN_INT16(SUCCESS);
 }
 
-static uint32 dir_path_hash(const void *key, Size keysize)
+static void DirPathHashKeyInit(DirPathHashKey *key, uint64_t parentId, const char *name)
+{
+    size_t nameLength = strlen(name);
+    if (nameLength >= MAX_DIRECTORY_PATH_HASH_SIZE)
+        CUCKOO_ELOG_ERROR_EXTENDED(ARGUMENT_ERROR, "file name %s is too long.", name);
+    key->parentId = parentId;
+    key->name = name;
+    key->nameLength = (uint32_t)nameLength;
+    key->hashcode = DatumGetUInt32(hash_any_extended((const unsigned char *)name, nameLength, parentId));
+}
+
+static inline int32_t *DirPathHashBucket(uint32_t hashcode)
+{
+    uint32_t bucket = (hashcode / DIR_PATH_HASH_PARTITION_SIZE) & (DirPathBucketsPerPartition - 1);
+    return &DirPathBuckets[(int64_t)DIR_PATH_HASH_PARTITION_INDEX(hashcode) * DirPathBucketsPerPartition + bucket];
+}
+
+/* seq is odd between these, the atomic add is a full barrier */
+static inline void DirPathHashWriteBegin(DirPathHashPartition *partition)
+{
+    pg_atomic_fetch_add_u32(&partition->seq, 1);
+}
+
+static inline void DirPathHashWriteEnd(DirPathHashPartition *partition)
+{
+    pg_atomic_fetch_add_u32(&partition->seq, 1);
+}
+
+static bool DirPathNameEquals(int32_t chunk, const char *name, uint32_t length)
+{
+    for (uint32_t offset = 0; offset < length; offset += DIR_PATH_NAME_CHUNK_DATA_SIZE) {
+        if (chunk < 0 || chunk >= DIR_PATH_HASH_CHUNK_TOTAL) {
+            return false;
+        }
+        uint32_t size = Min(length - offset, DIR_PATH_NAME_CHUNK_DATA_SIZE);
+        if (memcmp(DirPathChunks[chunk].data, name + offset, size) != 0) {
+            return false;
+        }
+        chunk = DirPathChunks[chunk].next;
+    }
+    return true;
+}
+
+/*
+ * Walk the bucket of key. The optimistic readers walk it without the partition lock, so every index read is
+ * range checked and the walk is bounded; what a racing writer makes it return is discarded by the seq check.
+ */
+static int32_t FindDirPathHashItem(const DirPathHashKey *key)
+{
+    int32_t index = *DirPathHashBucket(key->hashcode);
+    for (uint32_t step = 0; step < DirPathItemsPerPartition; ++step) {
+        if (index < 0 || index >= DIR_PATH_HASH_ITEM_TOTAL) {
+            break;
+        }
+        DirPathHashItem *item = &DirPathItems[index];
+        if (item->hashcode == key->hashcode && item->parentId == key->parentId &&
+            item->nameLength == key->nameLength && DirPathNameEquals(item->nameChunk, key->name, key->nameLength)) {
+            return index;
+        }
+        index = item->next;
+    }
+    return -1;
+}
+
+/* returns whether a consistent walk found the key, without taking the partition lock */
+static bool SearchDirPathHashOptimistic(const DirPathHashKey *key, uint64_t *inodeId)
+{
+    DirPathHashPartition *partition = DIR_PATH_HASH_PARTITION(key->hashcode);
+    for (int retry = 0; retry < DIR_PATH_HASH_OPTIMISTIC_RETRY; ++retry) {
+        uint32 seq = pg_atomic_read_u32(&partition->seq);
+        if (seq & 1) {
+            pg_spin_delay();
+            continue;
+        }
+        pg_read_barrier();
+        int32_t index = FindDirPathHashItem(key);
+        uint64_t result = index >= 0 ? DirPathItems[index].inodeId : 0;
+        pg_read_barrier();
+        if (pg_atomic_read_u32(&partition->seq) != seq) {
+            continue;
+        }
+        if (index < 0) {
+            return false;
+        }
+        TouchDirPathHashItem(&DirPathItems[index]);
+        *inodeId = result;
+        return true;
+    }
+    return false;
+}
+
+/* a hint for the clock, only written while below the cap so hot entries stay clean */
+static void TouchDirPathHashItem(DirPathHashItem *item)
+{
+    if (item->usageCount < DIR_PATH_HASH_MAX_USAGE_COUNT) {
+        item->usageCount++;
+    }
+}
+
+/*
+ * Find key, or add it with inodeId, evicting as needed. Called with the partition lock held exclusively,
+ * returns NULL if nothing could be evicted to make room.
+ */
+static DirPathHashItem *EnterDirPathHashItem(const DirPathHashKey *key, uint64_t inodeId, bool *found)
 {
-    const DirPathHashKey *l = (const DirPathHashKey *)key;
-    return DatumGetUInt32(hash_any_extended((const unsigned char *)l->fileName, strlen(l->fileName), l->parentId));
+    int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(key->hashcode);
+    DirPathHashPartition *partition = &DirPathPartitions[partitionIndex].partition;
+    int32_t index = FindDirPathHashItem(key);
+    *found = index >= 0;
+    if (*found) {
+        return &DirPathItems[index];
+    }
+    uint32_t chunkNum = DIR_PATH_NAME_CHUNK_NUM(key->nameLength);
+    while (partition->freeItem < 0 || partition->freeChunkCount < chunkNum) {
+        if (!EvictDirPathHashItem(partitionIndex)) {
+            return NULL;
+        }
+    }
+
+    DirPathHashWriteBegin(partition);
+    index = partition->freeItem;
+    DirPathHashItem *item = &DirPathItems[index];
+    partition->freeItem = item->next;
+
+    int32_t *link = &item->nameChunk;
+    for (uint32_t offset = 0; offset < key->nameLength; offset += DIR_PATH_NAME_CHUNK_DATA_SIZE) {
+        int32_t chunk = partition->freeChunk;
+        partition->freeChunk = DirPathChunks[chunk].next;
+        uint32_t size = Min(key->nameLength - offset, DIR_PATH_NAME_CHUNK_DATA_SIZE);
+        memcpy(DirPathChunks[chunk].data, key->name + offset, size);
+        *link = chunk;
+        link = &DirPathChunks[chunk].next;
+    }
+    *link = -1;
+    partition->freeChunkCount -= chunkNum;
+
+    item->parentId = key->parentId;
+    item->inodeId = inodeId;
+    item->hashcode = key->hashcode;
+    item->nameLength = (uint16_t)key->nameLength;
+    item->usageCount = 0;
+    item->inUse = true;
+    RWLockInitialize(&item->lock);
+    int32_t *bucket = DirPathHashBucket(key->hashcode);
+    item->next = *bucket;
+    *bucket = index;
+    pg_atomic_fetch_add_u32(&partition->count, 1);
+    DirPathHashWriteEnd(partition);
+    return item;
 }
 
-static int dir_path_compare(const void *key1, const void *key2)
+/* called with the partition lock held exclusively */
+static void SetDirPathHashInodeId(const DirPathHashKey *key, DirPathHashItem *item, uint64_t inodeId)
 {
-    const DirPathHashKey *d1 = (const DirPathHashKey *)key1;
-    const DirPathHashKey *d2 = (const DirPathHashKey *)key2;
+    DirPathHashPartition *partition = DIR_PATH_HASH_PARTITION(key->hashcode);
+    DirPathHashWriteBegin(partition);
+    item->inodeId = inodeId;
+    DirPathHashWriteEnd(partition);
+}
 
-    /* First, compare by parentId */
-    if (d1->parentId > d2->parentId) {
-        return 1;
-    } else if (d1->parentId < d2->parentId) {
-        return -1;
+/* called with the partition lock held exclusively */
+static void RemoveDirPathHashItem(int partitionIndex, int32_t index)
+{
+    DirPathHashPartition *partition = &DirPathPartitions[partitionIndex].partition;
+    DirPathHashItem *item = &DirPathItems[index];
+    int32_t *link = DirPathHashBucket(item->hashcode);
+    while (*link != index) {
+        link = &DirPathItems[*link].next;
     }
-    /* parentId are equal, do a byte-by-byte comparison on fileName */
-    return strcmp(d1->fileName, d2->fileName);
+
+    DirPathHashWriteBegin(partition);
+    *link = item->next;
+    if (item->nameChunk >= 0) {
+        int32_t tail = item->nameChunk;
+        while (DirPathChunks[tail].next >= 0) {
+            tail = DirPathChunks[tail].next;
+        }
+        DirPathChunks[tail].next = partition->freeChunk;
+        partition->freeChunk = item->nameChunk;
+        partition->freeChunkCount += DIR_PATH_NAME_CHUNK_NUM(item->nameLength);
+    }
+    item->inUse = false;
+    item->next = partition->freeItem;
+    partition->freeItem = index;
+    pg_atomic_fetch_sub_u32(&partition->count, 1);
+    DirPathHashWriteEnd(partition);
 }
 
-static int dir_path_match(const void *key1, const void *key2, Size keysize) { return dir_path_compare(key1, key2); }
+/*
+ * Clock over the partition's items, an entry whose RWLock is held or declared is never chosen. Called with
+ * the partition lock held exclusively, returns false if every entry is pinned.
+ */
+static bool EvictDirPathHashItem(int partitionIndex)
+{
+    DirPathHashPartition *partition = &DirPathPartitions[partitionIndex].partition;
+    uint32_t maxStep = DirPathItemsPerPartition * (DIR_PATH_HASH_MAX_USAGE_COUNT + 1);
+    for (uint32_t step = 0; step < maxStep; ++step) {
+        int32_t index = (int32_t)((int64_t)partitionIndex * DirPathItemsPerPartition + partition->clockHand);
+        partition->clockHand = (partition->clockHand + 1) % DirPathItemsPerPartition;
+        DirPathHashItem *item = &DirPathItems[index];
+        if (!item->inUse || !RWLockCheckDestroyable(&item->lock)) {
+            continue;
+        }
+        if (item->usageCount > 0) {
+            item->usageCount--;
+            continue;
+        }
+        RemoveDirPathHashItem(partitionIndex, index);
+        pg_atomic_fetch_add_u64(&DirPathCounters[partitionIndex].counters.evictions, 1);
+        return true;
+    }
+    return false;
+}
 
-static void *dir_path_keycopy(void *dest, const void *src, Size keysize)
+/* keep a quarter of the partition free for new directories, so lookups seldom evict inline */
+static void EvictDirPathHashOverThreshold(int partitionIndex)
 {
-    const DirPathHashKey *srcVal = (const DirPathHashKey *)src;
-    DirPathHashKey *destVal = (DirPathHashKey *)dest;
-    destVal->parentId = srcVal->parentId;
-    strcpy(destVal->fileName, srcVal->fileName);
-    return NULL;
+    DirPathHashPartition *partition = &DirPathPartitions[partitionIndex].partition;
+    if (pg_atomic_read_u32(&partition->count) <= DirPathItemsPerPartition / 4 * 3)
+        return;
+    LWLockAcquire(&partition->lock, LW_EXCLUSIVE);
+    EvictDirPathHashItem(partitionIndex);
+    LWLockRelease(&partition->lock);
+}
+
+static void ResetDirPathHashPartition(int partitionIndex)
+{
+    DirPathHashPartition *partition = &DirPathPartitions[partitionIndex].partition;
+    int64_t bucketBase = (int64_t)partitionIndex * DirPathBucketsPerPartition;
+    int64_t itemBase = (int64_t)partitionIndex * DirPathItemsPerPartition;
+    int64_t chunkBase = (int64_t)partitionIndex * DirPathChunksPerPartition;
+
+    DirPathHashWriteBegin(partition);
+    for (uint32_t i = 0; i < DirPathBucketsPerPartition; ++i) {
+        DirPathBuckets[bucketBase + i] = -1;
+    }
+    for (uint32_t i = 0; i < DirPathItemsPerPartition; ++i) {
+        DirPathItems[itemBase + i].inUse = false;
+        DirPathItems[itemBase + i].next = i + 1 < DirPathItemsPerPartition ? (int32_t)(itemBase + i + 1) : -1;
+    }
+    for (uint32_t i = 0; i < DirPathChunksPerPartition; ++i) {
+        DirPathChunks[chunkBase + i].next = i + 1 < DirPathChunksPerPartition ? (int32_t)(chunkBase + i + 1) : -1;
+    }
+    partition->freeItem = (int32_t)itemBase;
+    partition->freeChunk = (int32_t)chunkBase;
+    partition->freeChunkCount = DirPathChunksPerPartition;
+    partition->clockHand = 0;
+    pg_atomic_write_u32(&partition->count, 0);
+    DirPathHashWriteEnd(partition);
 }
 
 static void ReleaseDirPathHashLock(uint64_t parentId, char *filename)
 {
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, filename);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, filename);
 
-    bool isfound = false;
-    uint32 hashcode = dir_path_hash(&dirPathHashKey, sizeof(DirPathHashKey));
-    LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
-    LWLockAcquire(lock, LW_SHARED);
-    DirPathHashItem *item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                           (const void *)&dirPathHashKey,
-                                                                           hashcode,
-                                                                           HASH_FIND,
-                                                                           &isfound);
-    LWLockRelease(lock);
-    if (!isfound) {
+    DirPathHashPartition *partition = DIR_PATH_HASH_PARTITION(dirPathHashKey.hashcode);
+    LWLockAcquire(&partition->lock, LW_SHARED);
+    int32_t index = FindDirPathHashItem(&dirPathHashKey);
+    LWLockRelease(&partition->lock);
+    if (index < 0) {
         CUCKOO_ELOG_ERROR_EXTENDED(FILE_NOT_EXISTS, "elem %s does not exist, can not release lock!", filename);
     } else {
-        RWLockRelease(&item->lock);
+        RWLockRelease(&DirPathItems[index].lock);
     }
 }
 
@@ -310,19 +589,15 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
                                          DirPathLockMode lockMode)
 {
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, name);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, name);
 
     bool isfound = false;
-    uint32 hashcode = dir_path_hash((const void *)&dirPathHashKey, sizeof(DirPathHashKey));
-    LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
+    DirPathHashPartition *partition = DIR_PATH_HASH_PARTITION(dirPathHashKey.hashcode);
+    LWLock *lock = &partition->lock;
     LWLockAcquire(lock, LW_SHARED);
-    DirPathHashItem *item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                           (const void *)&dirPathHashKey,
-                                                                           hashcode,
-                                                                           HASH_FIND,
-                                                                           &isfound);
-    if (!isfound || item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
+    int32_t index = FindDirPathHashItem(&dirPathHashKey);
+    DirPathHashItem *item = index >= 0 ? &DirPathItems[index] : NULL;
+    if (!item || item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
         LWLockRelease(lock);
         uint64_t tempId;
         SearchDirectoryTableInfo(relation, parentId, name, &tempId);
@@ -331,27 +606,18 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
 
         for (;;) {
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                  (const void *)&dirPathHashKey,
-                                                                  hashcode,
-                                                                  HASH_ENTER_NULL,
-                                                                  &isfound);
-            if (!isfound && !item) // no space
+            item = EnterDirPathHashItem(&dirPathHashKey, tempId, &isfound);
+            if (!item) // no space
             {
                 if (lockMode != DIR_LOCK_NONE) {
                     LWLockRelease(lock);
-                    EliminateDirPathHashByLRU(DIR_PATH_HASH_PARTITION_INDEX(hashcode));
+                    CHECK_FOR_INTERRUPTS();
                     continue;
                 }
-            } else if (!isfound && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
-                RWLockInitialize(&item->lock);
-                item->usageCount = 0;
-                item->inodeId = tempId;
-                DirPathHashToCommitAddEntry(dirPathHashKey.parentId, dirPathHashKey.fileName);
+            } else if (!isfound) {
+                DirPathHashToCommitAddEntry(parentId, name);
             } else if (item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
-                item->inodeId = tempId;
+                SetDirPathHashInodeId(&dirPathHashKey, item, tempId);
             } else if (item->inodeId != tempId)
                 CUCKOO_ELOG_ERROR(PROGRAM_ERROR, "dir path hash table is corrupt.");
             break;
@@ -362,7 +628,7 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
         InsertIntoDirectoryTable(relation, indexState, parentId, name, inodeId);
         return;
     }
-    item->usageCount++;
+    TouchDirPathHashItem(item);
     if (lockMode != DIR_LOCK_NONE)
         RWLockDeclare(&item->lock);
     LWLockRelease(lock);
@@ -397,57 +663,56 @@ SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const
     uint64_t inodeId;
 
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, name);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, name);
+
+    DirPathHashCounters *counters = DIR_PATH_HASH_COUNTERS(dirPathHashKey.hashcode);
+    if (lockMode == DIR_LOCK_NONE && SearchDirPathHashOptimistic(&dirPathHashKey, &inodeId) &&
+        inodeId != DIR_HASH_TABLE_PATH_UNKNOWN) {
+        pg_atomic_fetch_add_u64(&counters->hits, 1);
+        pg_atomic_fetch_add_u64(&counters->lockFreeHits, 1);
+        return inodeId;
+    }
 
     bool isfound = false;
-    uint32 hashcode = dir_path_hash((const void *)&dirPathHashKey, sizeof(DirPathHashKey));
-    LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
+    DirPathHashPartition *partition = DIR_PATH_HASH_PARTITION(dirPathHashKey.hashcode);
+    LWLock *lock = &partition->lock;
     LWLockAcquire(lock, LW_SHARED);
-    DirPathHashItem *item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                           (const void *)&dirPathHashKey,
-                                                                           hashcode,
-                                                                           HASH_FIND,
-                                                                           &isfound);
-    if (!isfound || item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
+    int32_t index = FindDirPathHashItem(&dirPathHashKey);
+    DirPathHashItem *item = index >= 0 ? &DirPathItems[index] : NULL;
+    if (!item || item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
         LWLockRelease(lock);
+        pg_atomic_fetch_add_u64(&counters->misses, 1);
         SearchDirectoryTableInfo(relation, parentId, name, &inodeId);
 
         for (;;) {
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                  (const void *)&dirPathHashKey,
-                                                                  hashcode,
-                                                                  HASH_ENTER_NULL,
-                                                                  &isfound);
-            if (!isfound && !item) // no space, and must allocate space for rwlock
+            item = EnterDirPathHashItem(&dirPathHashKey, inodeId, &isfound);
+            if (!item) // no space, and must allocate space for rwlock
             {
                 if (lockMode != DIR_LOCK_NONE) {
                     LWLockRelease(lock);
-                    EliminateDirPathHashByLRU(DIR_PATH_HASH_PARTITION_INDEX(hashcode));
+                    CHECK_FOR_INTERRUPTS();
                     continue;
                 }
-            } else if (!isfound && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
-                RWLockInitialize(&item->lock);
-                item->usageCount = 0;
-                item->inodeId = inodeId;
-                DirPathHashToCommitAddEntry(dirPathHashKey.parentId, dirPathHashKey.fileName);
+            } else if (!isfound) {
+                DirPathHashToCommitAddEntry(parentId, name);
             } else if (item->inodeId == DIR_HASH_TABLE_PATH_UNKNOWN) {
-                item->inodeId = inodeId;
+                SetDirPathHashInodeId(&dirPathHashKey, item, inodeId);
             } else if (item->inodeId != inodeId)
                 CUCKOO_ELOG_ERROR(PROGRAM_ERROR, "dir path hash table is corrupt.");
             break;
         }
+    } else {
+        pg_atomic_fetch_add_u64(&counters->hits, 1);
     }
     if (!item) {
         LWLockRelease(lock);
         return inodeId;
     }
-    item->usageCount++;
+    TouchDirPathHashItem(item);
     if (lockMode != DIR_LOCK_NONE)
         RWLockDeclare(&item->lock);
+    inodeId = item->inodeId;
     LWLockRelease(lock);
 
     switch (lockMode) {
@@ -467,9 +732,10 @@ SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const
     if (lockMode != DIR_LOCK_NONE) {
         RWLockUndeclare(&item->lock);
         DirectoryHashTableLastAcquiredLock = &item->lock;
+        inodeId = item->inodeId;
     }
 
-    return item->inodeId;
+    return inodeId;
 }
 void DeleteDirectoryByDirectoryHashTable(Relation relation,
                                          uint64_t parentId,
@@ -479,42 +745,29 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
     if (lockMode == DIR_LOCK_SHARED)
         CUCKOO_ELOG_ERROR(PROGRAM_ERROR, "not supported lockmode while deleting.");
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, name);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, name);
 
     bool isfound = false;
-    uint32 hashcode = dir_path_hash((const void *)&dirPathHashKey, sizeof(DirPathHashKey));
-    LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
+    DirPathHashPartition *partition = DIR_PATH_HASH_PARTITION(dirPathHashKey.hashcode);
+    LWLock *lock = &partition->lock;
     LWLockAcquire(lock, LW_SHARED);
-    DirPathHashItem *item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                           (const void *)&dirPathHashKey,
-                                                                           hashcode,
-                                                                           HASH_FIND,
-                                                                           &isfound);
-    if (!isfound) {
+    int32_t index = FindDirPathHashItem(&dirPathHashKey);
+    DirPathHashItem *item = index >= 0 ? &DirPathItems[index] : NULL;
+    if (!item) {
         LWLockRelease(lock);
 
         for (;;) {
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                  (const void *)&dirPathHashKey,
-                                                                  hashcode,
-                                                                  HASH_ENTER_NULL,
-                                                                  &isfound);
-            if (!isfound && !item) // no space, and must allocate space for rwlock
+            item = EnterDirPathHashItem(&dirPathHashKey, DIR_HASH_TABLE_PATH_UNKNOWN, &isfound);
+            if (!item) // no space, and must allocate space for rwlock
             {
                 if (lockMode != DIR_LOCK_NONE) {
                     LWLockRelease(lock);
-                    EliminateDirPathHashByLRU(DIR_PATH_HASH_PARTITION_INDEX(hashcode));
+                    CHECK_FOR_INTERRUPTS();
                     continue;
                 }
-            } else if (!isfound && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
-                RWLockInitialize(&item->lock);
-                item->usageCount = 0;
-                item->inodeId = DIR_HASH_TABLE_PATH_UNKNOWN;
-                DirPathHashToCommitAddEntry(dirPathHashKey.parentId, dirPathHashKey.fileName);
+            } else if (!isfound) {
+                DirPathHashToCommitAddEntry(parentId, name);
             }
             break;
         }
@@ -524,7 +777,7 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
         DeleteFromDirectoryTable(relation, parentId, name);
         return;
     }
-    item->usageCount++;
+    TouchDirPathHashItem(item);
     if (lockMode == DIR_LOCK_EXCLUSIVE)
         RWLockDeclare(&item->lock);
     LWLockRelease(lock);
@@ -537,116 +790,27 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
 
     DeleteFromDirectoryTable(relation, parentId, name);
 
-    DirPathHashToCommitUpdateEntry(dirPathHashKey.parentId, dirPathHashKey.fileName, DIR_HASH_TABLE_PATH_NOT_EXIST);
-}
-
-static DirPathHashItem *FindNextItem(HASH_SEQ_STATUS *status, int32_t *destroyableCnt)
-{
-    DirPathHashItem *entry;
-    while ((entry = hash_seq_search(status)) != NULL) {
-        if (!RWLockCheckDestroyable(&entry->lock)) {
-            continue;
-        }
-        if (destroyableCnt) {
-            (*destroyableCnt)++;
-        }
-        entry->usageCount--;
-        if (entry->usageCount <= 0) {
-            hash_seq_term(status);
-            break;
-        }
-    }
-    return entry;
-}
-
-static bool EliminateDirPathHashByLRU(int partitionIndex)
-{
-    if (pg_atomic_read_u32(&(PathDirHashEntryCount[partitionIndex])) <=
-        MAX_BUCKET_SUM_LRU_CLAER_BEGIN / DIR_PATH_HASH_PARTITION_SIZE)
-        return false;
-
-    HASH_SEQ_STATUS status;
-    int32_t destroyableCnt = 0;
-    DirPathHashItem *entry = NULL;
-    DirPathHashKey target;
-
-    // eliminate one
-    for (;;) {
-        LWLockAcquire(&(DirPathLWLockArray[partitionIndex].lock), LW_SHARED);
-        hash_seq_init(&status, PathDirHash[partitionIndex]);
-        status.curBucket = rand() % PathDirHash[partitionIndex]->hctl->max_bucket;
-        entry = FindNextItem(&status, NULL);
-        while (entry == NULL) {
-            destroyableCnt = 0;
-            hash_seq_init(&status, PathDirHash[partitionIndex]);
-            entry = FindNextItem(&status, &destroyableCnt);
-            if (destroyableCnt == 0) {
-                break;
-            }
-        }
-        if (entry != NULL) {
-            strcpy(target.fileName, entry->key.fileName);
-            target.parentId = entry->key.parentId;
-        }
-        LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
-
-        if (entry == NULL) // no candidate
-            return false;
-
-        bool found;
-        uint32 hashcode = dir_path_hash((const void *)&target, sizeof(DirPathHashKey));
-        LWLockAcquire(&(DirPathLWLockArray[partitionIndex].lock), LW_EXCLUSIVE);
-        entry = hash_search_with_hash_value(PathDirHash[partitionIndex],
-                                            (const void *)&target,
-                                            hashcode,
-                                            HASH_FIND,
-                                            &found);
-        if (!found || !RWLockCheckDestroyable(&entry->lock)) {
-            LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
-            continue;
-        }
-        hash_search_with_hash_value(PathDirHash[partitionIndex], (const void *)&target, hashcode, HASH_REMOVE, &found);
-        LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
-        if (found) // succeed in eliminating
-            break;
-    }
-
-    pg_atomic_fetch_sub_u32(&(PathDirHashEntryCount[partitionIndex]), 1);
-    return true;
+    DirPathHashToCommitUpdateEntry(parentId, name, DIR_HASH_TABLE_PATH_NOT_EXIST);
 }
 
 void CommitForDirPathHash()
 {
-    // switch()
     for (int i = 0; i < DirPathHashToCommitSize; ++i) {
-        switch (DirPathHashToCommitAction[i]) {
+        DirPathHashToCommitEntry *entry = &DirPathHashToCommitActionInfo[i];
+        DirPathHashKey dirPathHashKey;
+        DirPathHashKeyInit(&dirPathHashKey, entry->parentId, entry->fileName);
+        switch (entry->action) {
         case 'A': {
-            uint32 hashcode =
-                dir_path_hash((const void *)&(DirPathHashToCommitActionInfo[i].key), sizeof(DirPathHashKey));
-            int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(hashcode);
-            EliminateDirPathHashByLRU(partitionIndex);
-
+            EvictDirPathHashOverThreshold(DIR_PATH_HASH_PARTITION_INDEX(dirPathHashKey.hashcode));
             break;
         }
         case 'U': {
             bool found;
-            uint32 hashcode =
-                dir_path_hash((const void *)&(DirPathHashToCommitActionInfo[i].key), sizeof(DirPathHashKey));
-            LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
+            LWLock *lock = &DIR_PATH_HASH_PARTITION(dirPathHashKey.hashcode)->lock;
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            DirPathHashItem *item = hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                (const void *)&(DirPathHashToCommitActionInfo[i].key),
-                                                                hashcode,
-                                                                HASH_ENTER_NULL,
-                                                                &found);
-            if (!found && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
-                item->key.parentId = DirPathHashToCommitActionInfo[i].key.parentId;
-                strcpy(item->key.fileName, DirPathHashToCommitActionInfo[i].key.fileName);
-            }
-            if (item)
-                item->inodeId = DirPathHashToCommitActionInfo[i].inodeId;
+            DirPathHashItem *item = EnterDirPathHashItem(&dirPathHashKey, entry->inodeId, &found);
+            if (found)
+                SetDirPathHashInodeId(&dirPathHashKey, item, entry->inodeId);
             LWLockRelease(lock);
             break;
         }
@@ -664,53 +828,57 @@ void AbortForDirPathHash() { DirPathHashToCommitClear(); }
 void ClearDirPathHash()
 {
     for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
-        LWLockAcquire(&(DirPathLWLockArray[i].lock), LW_EXCLUSIVE);
-        hash_clear(PathDirHash[i]);
-        LWLockRelease(&(DirPathLWLockArray[i].lock));
+        LWLockAcquire(&(DirPathPartitions[i].partition.lock), LW_EXCLUSIVE);
+        ResetDirPathHashPartition(i);
+        LWLockRelease(&(DirPathPartitions[i].partition.lock));
     }
 }
 
+static void DirPathHashSetSize(void)
+{
+    DirPathItemsPerPartition = Max(CuckooDirPathHashCapacity / DIR_PATH_HASH_PARTITION_SIZE, 8);
+    DirPathBucketsPerPartition = pg_nextpower2_32(DirPathItemsPerPartition);
+    DirPathChunksPerPartition = DirPathItemsPerPartition * DIR_PATH_HASH_CHUNKS_PER_ITEM;
+}
+
 size_t DirPathShmemsize()
 {
-    return (sizeof(LWLockPadded) + sizeof(pg_atomic_uint32)) * DIR_PATH_HASH_PARTITION_SIZE +
-           (sizeof(DirPathHashItem)) * MAX_DIRECTORY_PATH_HASH_CAPACITY;
+    DirPathHashSetSize();
+    size_t size = add_size(mul_size(sizeof(DirPathHashPartitionPadded), DIR_PATH_HASH_PARTITION_SIZE),
+                           mul_size(sizeof(DirPathHashCountersPadded), DIR_PATH_HASH_PARTITION_SIZE));
+    size = add_size(size, mul_size(sizeof(int32_t), (size_t)DirPathBucketsPerPartition * DIR_PATH_HASH_PARTITION_SIZE));
+    size = add_size(size, mul_size(sizeof(DirPathHashItem), DIR_PATH_HASH_ITEM_TOTAL));
+    size = add_size(size, mul_size(sizeof(DirPathNameChunk), DIR_PATH_HASH_CHUNK_TOTAL));
+    return add_size(size, PG_CACHE_LINE_SIZE);
 }
 
 void DirPathShmemInit()
 {
-    srand((unsigned)time(NULL) + 0xD5F1);
-
     bool initialized;
-    DirPathLWLockArray =
-        ShmemInitStruct("Cucuoo path directory walk path resolution LWLock",
-                        (sizeof(LWLockPadded) + sizeof(pg_atomic_uint32)) * DIR_PATH_HASH_PARTITION_SIZE,
-                        &initialized);
-    PathDirHashEntryCount = (pg_atomic_uint32 *)(DirPathLWLockArray + DIR_PATH_HASH_PARTITION_SIZE);
+    char *base = ShmemInitStruct("Cuckoo path directory hash", DirPathShmemsize(), &initialized);
+    base = (char *)CACHELINEALIGN(base);
+    DirPathPartitions = (DirPathHashPartitionPadded *)base;
+    base += sizeof(DirPathHashPartitionPadded) * DIR_PATH_HASH_PARTITION_SIZE;
+    DirPathCounters = (DirPathHashCountersPadded *)base;
+    base += sizeof(DirPathHashCountersPadded) * DIR_PATH_HASH_PARTITION_SIZE;
+    DirPathItems = (DirPathHashItem *)base;
+    base += sizeof(DirPathHashItem) * DIR_PATH_HASH_ITEM_TOTAL;
+    DirPathChunks = (DirPathNameChunk *)base;
+    base += sizeof(DirPathNameChunk) * DIR_PATH_HASH_CHUNK_TOTAL;
+    DirPathBuckets = (int32_t *)base;
     if (!initialized) {
         DirPathLWLockTrancheId = LWLockNewTrancheId();
         LWLockRegisterTranche(DirPathLWLockTrancheId, DirPathLWLockTrancheName);
         for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
-            LWLockInitialize(&(DirPathLWLockArray[i].lock), DirPathLWLockTrancheId);
-            pg_atomic_init_u32(PathDirHashEntryCount + i, 0);
+            DirPathHashPartition *partition = &DirPathPartitions[i].partition;
+            LWLockInitialize(&partition->lock, DirPathLWLockTrancheId);
+            pg_atomic_init_u32(&partition->seq, 0);
+            pg_atomic_init_u32(&partition->count, 0);
+            pg_atomic_init_u64(&DirPathCounters[i].counters.hits, 0);
+            pg_atomic_init_u64(&DirPathCounters[i].counters.lockFreeHits, 0);
+            pg_atomic_init_u64(&DirPathCounters[i].counters.misses, 0);
+            pg_atomic_init_u64(&DirPathCounters[i].counters.evictions, 0);
+            ResetDirPathHashPartition(i);
         }
     }
-    HASHCTL info;
-
-    info.keysize = sizeof(DirPathHashKey);
-    info.entrysize = sizeof(DirPathHashItem);
-    info.hash = dir_path_hash;
-    info.match = dir_path_match;
-    info.keycopy = dir_path_keycopy;
-    char buf[64];
-    for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
-        sprintf(buf, "Cuckoo path directory hash %d", i);
-        PathDirHash[i] = ShmemInitHash(buf,
-                                       MAX_DIRECTORY_PATH_HASH_CAPACITY / DIR_PATH_HASH_PARTITION_SIZE,
-                                       MAX_DIRECTORY_PATH_HASH_CAPACITY / DIR_PATH_HASH_PARTITION_SIZE,
-                                       &info,
-                                       HASH_ELEM | HASH_FUNCTION | HASH_KEYCOPY | HASH_COMPARE);
-        if (!PathDirHash[i]) {
-            elog(FATAL, "invalid shmem status when creating path directory hash ");
-        }
-    }
-}
\ No newline at end of file
+}
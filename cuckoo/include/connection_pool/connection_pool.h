@@ -12,6 +12,24 @@ void CuckooDaemonConnectionPoolProcessMain(unsigned long int main_arg);
 
 extern CuckooShmemAllocator CuckooConnectionPoolShmemAllocator;
 
+// mkdir, create, stat, unlink, open, close, opendir, utimens, chown, chmod
+#define CUCKOO_CONNECTION_POOL_BATCH_TYPE_NUM 10
+// bucket i counts batches of [2^i, 2^(i+1)) jobs, the last one also all larger
+#define CUCKOO_CONNECTION_POOL_BATCH_SIZE_BUCKET_NUM 10
+
+typedef struct CuckooConnectionPoolBatchStats
+{
+    uint64_t batches;
+    uint64_t jobs;
+    uint64_t lingered;
+    uint64_t targetBatchSize;
+    uint64_t backendLatencyUs;
+    uint64_t sizeHistogram[CUCKOO_CONNECTION_POOL_BATCH_SIZE_BUCKET_NUM];
+} CuckooConnectionPoolBatchStats;
+
+// one per batch type, only written by the pool manager thread, read without locks
+extern CuckooConnectionPoolBatchStats *CuckooConnectionPoolBatchStatsShmem;
+
 size_t CuckooConnectionPoolShmemsize(void);
 void CuckooConnectionPoolShmemInit(void);
 
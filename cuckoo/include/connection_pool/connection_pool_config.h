@@ -24,6 +24,16 @@ extern uint64_t CuckooConnectionPoolShmemSize;
 
 #define CUCKOO_CONNECTION_POOL_MAX_CONCURRENT_SOCKET 4096
 
+#define CUCKOO_CONNECTION_POOL_PENDING_TASK_BUFFER_SIZE_DEFAULT 20
+extern int CuckooConnectionPoolPendingTaskBufferSize;
+
+#define CUCKOO_CONNECTION_POOL_MAX_BATCH_SIZE_DEFAULT 400
+extern int CuckooConnectionPoolMaxBatchSize;
+
+// upper bound of the time a batch is held back for more jobs, 0 never holds one back
+#define CUCKOO_CONNECTION_POOL_MAX_BATCH_LINGER_US_DEFAULT 200
+extern int CuckooConnectionPoolMaxBatchLingerUs;
+
 int CuckooConnectionPoolGotSigTerm(void);
 
 #ifdef __cplusplus
@@ -27,7 +27,7 @@ class MetaServiceImpl : public MetaService {
 
     virtual void MetaCall(google::protobuf::RpcController *cntlBase,
                           const MetaRequest *request,
-                          Empty *response,
+                          MetaReply *response,
                           google::protobuf::Closure *done);
 };
 
@@ -5,6 +5,7 @@
 #ifndef CUCKOO_CONNECTION_POOL_PG_CONNECTION_POOL_H
 #define CUCKOO_CONNECTION_POOL_PG_CONNECTION_POOL_H
 
+#include <atomic>
 #include <condition_variable>
 #include <queue>
 #include <string>
@@ -32,7 +33,20 @@ class PGConnectionPool {
     std::condition_variable cvPendingTaskNotFull;
     uint16_t pendingTaskBufferMaxSize;
 
-    enum TaskSupportBatchType { MKDIR = 0, CREATE, STAT, UNLINK, OPEN, CLOSE, NOT_SUPPORT };
+    // same order as the rows of cuckoo_connection_pool_batch_stats
+    enum TaskSupportBatchType {
+        MKDIR = 0,
+        CREATE,
+        STAT,
+        UNLINK,
+        OPEN,
+        CLOSE,
+        OPENDIR,
+        UTIMENS,
+        CHOWN,
+        CHMOD,
+        NOT_SUPPORT
+    };
     TaskSupportBatchType ConvertMetaServiceTypeToTaskSupportBatchType(const cuckoo::meta_proto::MetaServiceType type)
     {
         switch (type) {
@@ -48,6 +62,14 @@ class PGConnectionPool {
             return TaskSupportBatchType::OPEN;
         case cuckoo::meta_proto::MetaServiceType::CLOSE:
             return TaskSupportBatchType::CLOSE;
+        case cuckoo::meta_proto::MetaServiceType::OPENDIR:
+            return TaskSupportBatchType::OPENDIR;
+        case cuckoo::meta_proto::MetaServiceType::UTIMENS:
+            return TaskSupportBatchType::UTIMENS;
+        case cuckoo::meta_proto::MetaServiceType::CHOWN:
+            return TaskSupportBatchType::CHOWN;
+        case cuckoo::meta_proto::MetaServiceType::CHMOD:
+            return TaskSupportBatchType::CHMOD;
         default:
             return TaskSupportBatchType::NOT_SUPPORT;
         }
@@ -57,25 +79,41 @@ class PGConnectionPool {
         Task *task;
         std::mutex taskMutex;
         std::condition_variable cvBatchNotFull;
+        std::condition_variable cvBatchGrown;
+        // smoothed gap between two jobs, guarded by taskMutex
+        int64_t lastArrivalNs;
+        int64_t arrivalGapNs;
+        // smoothed time pg takes for one batch, updated by the connections
+        std::atomic<int64_t> backendLatencyNs;
     };
     TaskSupportBatch supportBatchTaskList[TaskSupportBatchType::NOT_SUPPORT];
     uint16_t batchTaskBufferMaxSize;
+    int64_t maxBatchLingerNs;
+    // the batch the manager holds back, a task queued meanwhile ends the linger
+    std::atomic<TaskSupportBatch *> lingeringBatch;
+    std::atomic<size_t> pendingTaskNum;
 
     std::thread backgroundPoolManager;
 
     PGConnection *GetPGConnection();
     void BackgroundPoolManager();
+    size_t TargetBatchSize(TaskSupportBatch &batch);
+    void CloseBatch(TaskSupportBatchType type, bool canLinger);
 
   public:
     PGConnectionPool(const uint16_t port,
                      const char *userName,
                      const int connPoolSize,
                      const uint16_t pendingTaskBufferMaxSize,
-                     const uint16_t batchTaskBufferMaxSize);
+                     const uint16_t batchTaskBufferMaxSize,
+                     const int maxBatchLingerUs);
     ~PGConnectionPool();
 
     void ReaddWorkingPGConnection(PGConnection *conn);
 
+    // called by a connection after pg answered a batch of this type
+    void RecordBackendLatency(const cuckoo::meta_proto::MetaServiceType type, const int64_t latencyNs);
+
     void DispatchAsyncMetaServiceJob(cuckoo::meta_proto::AsyncMetaServiceJob *job);
 
     void Stop();
@@ -16,13 +16,13 @@ class AsyncMetaServiceJob {
   private:
     brpc::Controller *cntl;
     const MetaRequest *request;
-    Empty *response;
+    MetaReply *response;
     google::protobuf::Closure *done;
 
   public:
     AsyncMetaServiceJob(brpc::Controller *cntl,
                         const MetaRequest *request,
-                        Empty *response,
+                        MetaReply *response,
                         google::protobuf::Closure *done)
         : cntl(cntl),
           request(request),
@@ -32,7 +32,7 @@ class AsyncMetaServiceJob {
     }
     brpc::Controller *GetCntl() { return cntl; }
     const MetaRequest *GetRequest() { return request; }
-    Empty *GetResponse() { return response; }
+    MetaReply *GetResponse() { return response; }
     void Done() { done->Run(); }
 };
 
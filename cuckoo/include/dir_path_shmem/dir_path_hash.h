@@ -23,22 +23,40 @@
 #define DIR_HASH_TABLE_PATH_NOT_EXIST -1
 #define DIR_HASH_TABLE_PATH_UNKNOWN -2
 
-/* A hash key for directory path */
+/* A lookup key for directory path, name points to the caller's string */
 typedef struct
 {
-    char        fileName[MAX_DIRECTORY_PATH_HASH_SIZE];
     uint64_t    parentId;
+    const char* name;
+    uint32_t    nameLength;
+    uint32_t    hashcode;
 } DirPathHashKey;
 
-/* A hash table entry */
+/*
+ * A hash table entry, the file name is kept in a chain of DirPathNameChunk so that short names do not
+ * pay for MAX_DIRECTORY_PATH_HASH_SIZE bytes. Items and chunks are addressed by index, -1 ends a chain.
+ */
 typedef struct
 {
-    DirPathHashKey  key;
-    uint64_t        inodeId;
-    RWLock          lock;
-    int32_t         usageCount;
+    uint64_t    parentId;
+    uint64_t    inodeId;
+    RWLock      lock;
+    uint32_t    hashcode;
+    int32_t     next;       /* next item of the bucket, or of the free list */
+    int32_t     nameChunk;  /* first chunk of the file name */
+    uint16_t    nameLength;
+    uint8_t     inUse;
+    uint8_t     usageCount;
 } DirPathHashItem;
 
+#define DIR_PATH_NAME_CHUNK_DATA_SIZE 28
+
+typedef struct
+{
+    int32_t     next;
+    char        data[DIR_PATH_NAME_CHUNK_DATA_SIZE];
+} DirPathNameChunk;
+
 typedef enum
 {
     DIR_LOCK_EXCLUSIVE,
@@ -58,8 +76,10 @@ extern uint64_t SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t
 extern void InsertDirectoryByDirectoryHashTable(Relation relation, CatalogIndexState indexState, uint64_t parentId, const char* name, uint64_t inodeId, uint32_t numSubparts, DirPathLockMode lockMode);
 extern void DeleteDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const char* name, DirPathLockMode lockMode);
 
-#define DIRECTORY_PATH_HASH_BUCKET_NUM 2048
-#define MAX_DIRECTORY_PATH_HASH_CAPACITY 2048
-#define MAX_BUCKET_SUM_LRU_CLAER_BEGIN (MAX_DIRECTORY_PATH_HASH_CAPACITY / 4 * 3)
+#define CUCKOO_DIR_PATH_HASH_CAPACITY_DEFAULT (128 * 1024)
+#define CUCKOO_DIR_PATH_HASH_CAPACITY_MIN 1024
+#define CUCKOO_DIR_PATH_HASH_CAPACITY_MAX (64 * 1024 * 1024)
+// number of directories cached, set by cuckoo_dir_path_hash.capacity at startup
+extern int CuckooDirPathHashCapacity;
 
 #endif
\ No newline at end of file
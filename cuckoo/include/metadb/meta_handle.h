@@ -48,15 +48,15 @@ void CuckooOpenHandle(MetaProcessInfo *infoArray, int count);
 void CuckooCloseHandle(MetaProcessInfo *infoArray, int count);
 void CuckooUnlinkHandle(MetaProcessInfo* infoArray, int count);
 void CuckooReadDirHandle(MetaProcessInfo info);
-void CuckooOpenDirHandle(MetaProcessInfo info);
+void CuckooOpenDirHandle(MetaProcessInfo *infoArray, int count);
 void CuckooRmdirHandle(MetaProcessInfo info);
 void CuckooRmdirSubRmdirHandle(MetaProcessInfo info);
 void CuckooRmdirSubUnlinkHandle(MetaProcessInfo info);
 void CuckooRenameHandle(MetaProcessInfo info);
 void CuckooRenameSubRenameLocallyHandle(MetaProcessInfo info);
 void CuckooRenameSubCreateHandle(MetaProcessInfo info);
-void CuckooUtimeNsHandle(MetaProcessInfo info);
-void CuckooChownHandle(MetaProcessInfo info);
-void CuckooChmodHandle(MetaProcessInfo info);
+void CuckooUtimeNsHandle(MetaProcessInfo *infoArray, int count);
+void CuckooChownHandle(MetaProcessInfo *infoArray, int count);
+void CuckooChmodHandle(MetaProcessInfo *infoArray, int count);
 
 #endif
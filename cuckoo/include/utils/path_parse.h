@@ -50,6 +50,8 @@ uint64_t CheckWhetherPathExistsInDirectoryTable(Relation directoryRel, const cha
 void PathParseTreeInit(PathParseRBTreeNode *root);
 CuckooErrorCode PathParseTreeInsert(PathParseTree root, Relation directoryRel, const char* path, 
                         uint16_t flag, uint64_t *parentId, char **fileName, uint64_t *inodeId);
+// drop the cached resolutions of path and of everything under it
+void PathParsePrefixCacheInvalidate(const char *path);
 
 #define VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_DIRECTORY  1
 #define VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_FILE       2
@@ -12,7 +12,9 @@
 #include "access/genam.h"
 #include "access/htup_details.h"
 #include "access/table.h"
+#include "access/tableam.h"
 #include "catalog/indexing.h"
+#include "executor/tuptable.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
@@ -31,6 +33,21 @@ MemoryManager PgMemoryManager = {.alloc = palloc, .free = pfree, .realloc = repa
 
 #define BATCH_OPERATION_GROUP_SIZE 8
 
+// a resolved item of a batch, batches are handled sorted by shard and then by inode index key
+typedef struct BatchShardItem
+{
+    int32_t shardId;
+    MetaProcessInfo info;
+} BatchShardItem;
+
+// one index scan of an inode shard, rescanned for every key looked up
+typedef struct InodeShardProbe
+{
+    Relation indexRel;
+    IndexScanDesc scan;
+    TupleTableSlot *slot;
+} InodeShardProbe;
+
 static inline uint16_t HashPartId(const char *fileName);
 static inline uint64_t CombineParentIdWithPartId(uint64_t parent_id, uint16_t part_id);
 
@@ -40,6 +57,11 @@ static StringInfo GetXattrShardName(int shardId);
 static StringInfo GetXattrIndexShardName(int shardId);
 
 static Oid GetRelationOidByName_CUCKOO(const char *relationName);
+static BatchShardItem *ResolveBatchByShard(MetaProcessInfo *infoArray, int count, uint16_t flag, int *itemCount);
+static int BatchShardGroupEnd(const BatchShardItem *items, int itemCount, int begin);
+static void InodeShardProbeBegin(InodeShardProbe *probe, Relation workerInodeRel, Oid workerInodeIndexOid);
+static bool InodeShardProbeNext(InodeShardProbe *probe, uint64_t parentId_partId, const char *fileName);
+static void InodeShardProbeEnd(InodeShardProbe *probe);
 static bool SearchAndUpdateInodeTableInfo(const char *workerInodeRelationName,
                                           Relation workerInodeRelation,
                                           const char *workerInodeRelationIndexName,
@@ -398,32 +420,13 @@ void CuckooCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
     }
     pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
 
-    HASHCTL info;
-    memset(&info, 0, sizeof(info));
-    info.keysize = sizeof(int32_t);
-    info.entrysize = sizeof(ShardHashInfo);
-    info.hcxt = CurrentMemoryContext;
-    int hashFlags = (HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-    HTAB *batchMetaProcessInfoListPerShard =
-        hash_create("Batch Meta Process Info List Per Shard Hash Table", GetShardTableSize(), &info, hashFlags);
-    ShardHashInfo *entry;
-    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
-    for (int i = 0; i < count; ++i) {
-        MetaProcessInfo info = infoArray[i];
-        if (info->errorCode != SUCCESS)
-            continue;
-
-        CuckooErrorCode errorCode = PathParseTreeInsert(NULL,
-                                                        directoryRel,
-                                                        info->path,
-                                                        PATH_PARSE_FLAG_NOT_ROOT | PATH_PARSE_FLAG_TARGET_TO_BE_CREATED,
-                                                        &info->parentId,
-                                                        &info->name,
-                                                        &info->inodeId);
-        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
-
-        uint16_t partId = HashPartId(info->name);
-        info->parentId_partId = CombineParentIdWithPartId(info->parentId, partId);
+    int itemCount;
+    BatchShardItem *items = ResolveBatchByShard(infoArray,
+                                                count,
+                                                PATH_PARSE_FLAG_NOT_ROOT | PATH_PARSE_FLAG_TARGET_TO_BE_CREATED,
+                                                &itemCount);
+    for (int i = 0; i < itemCount; ++i) {
+        MetaProcessInfo info = items[i].info;
         info->st_mode = S_IFREG | 0644;
         info->st_mtim = GetCurrentTimestamp();
         info->st_size = 0;
@@ -438,42 +441,25 @@ void CuckooCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
         info->st_blocks = 0;
         info->st_atim = 0;
         info->st_ctim = 0;
-
-        int shardId, workerId;
-        SearchShardInfoByShardValue(info->parentId_partId, &shardId, &workerId);
-        if (workerId != GetLocalServerId())
-            CHECK_ERROR_CODE_WITH_CONTINUE(WRONG_WORKER);
-
-        bool found;
-        entry = hash_search(batchMetaProcessInfoListPerShard, &shardId, HASH_ENTER, &found);
-        if (!found) {
-            entry->shardId = shardId;
-            entry->info = NIL;
-        }
-        entry->info = lappend(entry->info, info);
     }
-    table_close(directoryRel, AccessShareLock);
 
-    HASH_SEQ_STATUS status;
-    hash_seq_init(&status, batchMetaProcessInfoListPerShard);
-    while ((entry = hash_seq_search(&status)) != 0) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
+    int begin = 0;
+    while (begin < itemCount) {
+        int end = BatchShardGroupEnd(items, itemCount, begin);
+        StringInfo inodeShardName = GetInodeShardName(items[begin].shardId);
+        StringInfo inodeIndexShardName = GetInodeIndexShardName(items[begin].shardId);
+        Oid inodeRelOid = GetRelationOidByName_CUCKOO(inodeShardName->data);
         Oid inodeIndexOid = GetRelationOidByName_CUCKOO(inodeIndexShardName->data);
 
+        // handled from the tail, so inserted in index key order
         List *toHandleMetaProcessList = NIL;
-        for (int i = list_length(entry->info) - 1; i >= 0; --i) {
-            MetaProcessInfo info = list_nth(entry->info, i);
-
-            if (info->errorCode != SUCCESS)
-                continue;
-            toHandleMetaProcessList = lappend(toHandleMetaProcessList, info);
-        }
+        for (int i = end - 1; i >= begin; --i)
+            toHandleMetaProcessList = lappend(toHandleMetaProcessList, items[i].info);
 
         MetaProcessInfo info = NULL;
         while (list_length(toHandleMetaProcessList) != 0) {
             BeginInternalSubTransaction(NULL);
-            Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), RowExclusiveLock);
+            Relation workerInodeRel = table_open(inodeRelOid, RowExclusiveLock);
             CatalogIndexState indexState = CatalogOpenIndexes(workerInodeRel);
             PG_TRY();
             {
@@ -487,7 +473,7 @@ void CuckooCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
                     if (info->errorCode != SUCCESS) {
                         if (info->errorCode == FILE_EXISTS) {
                             SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                          NULL,
+                                                          workerInodeRel,
                                                           inodeIndexShardName->data,
                                                           inodeIndexOid,
                                                           info->parentId_partId,
@@ -578,6 +564,7 @@ void CuckooCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
             }
             PG_END_TRY();
         }
+        begin = end;
     }
 }
 
@@ -598,96 +585,44 @@ void CuckooStatHandle(MetaProcessInfo *infoArray, int count)
 
     SetUpScanCaches();
 
-    HASHCTL info;
-    memset(&info, 0, sizeof(info));
-    info.keysize = sizeof(int32_t);
-    info.entrysize = sizeof(ShardHashInfo);
-    info.hcxt = CurrentMemoryContext;
-    int hashFlags = (HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-    HTAB *batchMetaProcessInfoListPerShard =
-        hash_create("Batch Meta Process Info List Per Shard Hash Table", GetShardTableSize(), &info, hashFlags);
-    ShardHashInfo *entry;
-    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
-    for (int i = 0; i < count; ++i) {
-        MetaProcessInfo info = infoArray[i];
-        if (info->errorCode != SUCCESS)
-            continue;
-
-        CuckooErrorCode errorCode =
-            PathParseTreeInsert(NULL, directoryRel, info->path, 0, &(info->parentId), &(info->name), NULL);
-        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
-
-        uint16_t partId = HashPartId(info->name);
-        info->parentId_partId = CombineParentIdWithPartId(info->parentId, partId);
-        int shardId, workerId;
-        SearchShardInfoByShardValue(info->parentId_partId, &shardId, &workerId);
-        if (workerId != GetLocalServerId())
-            CHECK_ERROR_CODE_WITH_CONTINUE(WRONG_WORKER);
-
-        bool found;
-        entry = hash_search(batchMetaProcessInfoListPerShard, &shardId, HASH_ENTER, &found);
-        if (!found) {
-            entry->shardId = shardId;
-            entry->info = NULL;
-        }
-        entry->info = lappend(entry->info, info);
-    }
-    table_close(directoryRel, AccessShareLock);
-
-    HASH_SEQ_STATUS status;
-    hash_seq_init(&status, batchMetaProcessInfoListPerShard);
-    while ((entry = hash_seq_search(&status)) != NULL) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
+    int itemCount;
+    BatchShardItem *items = ResolveBatchByShard(infoArray, count, 0, &itemCount);
+    int begin = 0;
+    while (begin < itemCount) {
+        int end = BatchShardGroupEnd(items, itemCount, begin);
+        StringInfo inodeShardName = GetInodeShardName(items[begin].shardId);
+        StringInfo inodeIndexShardName = GetInodeIndexShardName(items[begin].shardId);
         Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), AccessShareLock);
-        Oid workerInodeIndexOid = GetRelationOidByName_CUCKOO(inodeIndexShardName->data);
-
-        for (int i = 0; i < list_length(entry->info); ++i) {
-            MetaProcessInfo info = list_nth(entry->info, i);
+        InodeShardProbe probe;
+        InodeShardProbeBegin(&probe, workerInodeRel, GetRelationOidByName_CUCKOO(inodeIndexShardName->data));
 
-            ScanKeyData scanKey[2];
-            int scanKeyCount = 2;
-            SysScanDesc scanDescriptor = NULL;
-            HeapTuple heapTuple;
+        for (int i = begin; i < end; ++i) {
+            MetaProcessInfo info = items[i].info;
 
-            scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
-            scanKey[0].sk_argument = UInt64GetDatum(info->parentId_partId);
-            scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_EQ];
-            scanKey[1].sk_argument = CStringGetTextDatum(info->name);
-
-            scanDescriptor = systable_beginscan(workerInodeRel,
-                                                workerInodeIndexOid,
-                                                true,
-                                                GetTransactionSnapshot(),
-                                                scanKeyCount,
-                                                scanKey);
-            heapTuple = systable_getnext(scanDescriptor);
-            TupleDesc tupleDesc = RelationGetDescr(workerInodeRel);
-            if (!HeapTupleIsValid(heapTuple)) {
+            if (!InodeShardProbeNext(&probe, info->parentId_partId, info->name)) {
                 info->errorCode = FILE_NOT_EXISTS;
-            } else {
-                Datum datumArray[Natts_pg_dfs_inode_table];
-                bool isNullArray[Natts_pg_dfs_inode_table];
-                heap_deform_tuple(heapTuple, tupleDesc, datumArray, isNullArray);
-                info->inodeId = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_ino - 1]);
-                info->st_dev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_dev - 1]);
-                info->st_mode = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_mode - 1]);
-                info->st_nlink = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_nlink - 1]);
-                info->st_uid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_uid - 1]);
-                info->st_gid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_gid - 1]);
-                info->st_rdev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_rdev - 1]);
-                info->st_size = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_size - 1]);
-                info->st_blksize = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blksize - 1]);
-                info->st_blocks = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blocks - 1]);
-                info->st_atim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_atim - 1]);
-                info->st_mtim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_mtim - 1]);
-                info->st_ctim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_ctim - 1]);
-                info->etag = TextDatumGetCString(datumArray[Anum_pg_dfs_file_etag - 1]);
+                continue;
             }
-            systable_endscan(scanDescriptor);
+            Datum *datumArray = probe.slot->tts_values;
+            info->inodeId = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_ino - 1]);
+            info->st_dev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_dev - 1]);
+            info->st_mode = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_mode - 1]);
+            info->st_nlink = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_nlink - 1]);
+            info->st_uid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_uid - 1]);
+            info->st_gid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_gid - 1]);
+            info->st_rdev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_rdev - 1]);
+            info->st_size = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_size - 1]);
+            info->st_blksize = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blksize - 1]);
+            info->st_blocks = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blocks - 1]);
+            info->st_atim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_atim - 1]);
+            info->st_mtim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_mtim - 1]);
+            info->st_ctim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_ctim - 1]);
+            info->etag = TextDatumGetCString(datumArray[Anum_pg_dfs_file_etag - 1]);
         }
 
+        InodeShardProbeEnd(&probe);
         table_close(workerInodeRel, AccessShareLock);
+        begin = end;
     }
 }
 
@@ -704,82 +639,23 @@ void CuckooOpenHandle(MetaProcessInfo *infoArray, int count)
     }
     pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
 
-    HASHCTL info;
-    memset(&info, 0, sizeof(info));
-    info.keysize = sizeof(int32_t);
-    info.entrysize = sizeof(ShardHashInfo);
-    info.hcxt = CurrentMemoryContext;
-    int hashFlags = (HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-    HTAB *batchMetaProcessInfoListPerShard =
-        hash_create("Batch Meta Process Info List Per Shard Hash Table", GetShardTableSize(), &info, hashFlags);
-    ShardHashInfo *entry;
-    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
-    for (int i = 0; i < count; ++i) {
-        MetaProcessInfo info = infoArray[i];
-        if (info->errorCode != SUCCESS)
-            continue;
-
-        CuckooErrorCode errorCode = PathParseTreeInsert(NULL,
-                                                        directoryRel,
-                                                        info->path,
-                                                        PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY,
-                                                        &info->parentId,
-                                                        &info->name,
-                                                        NULL);
-        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
-
-        uint16_t partId = HashPartId(info->name);
-        info->parentId_partId = CombineParentIdWithPartId(info->parentId, partId);
-        int shardId, workerId;
-        SearchShardInfoByShardValue(info->parentId_partId, &shardId, &workerId);
-        if (workerId != GetLocalServerId())
-            CHECK_ERROR_CODE_WITH_CONTINUE(WRONG_WORKER);
-
-        bool found;
-        entry = hash_search(batchMetaProcessInfoListPerShard, &shardId, HASH_ENTER, &found);
-        if (!found) {
-            entry->shardId = shardId;
-            entry->info = NULL;
-        }
-        entry->info = lappend(entry->info, info);
-    }
-    table_close(directoryRel, AccessShareLock);
-
-    HASH_SEQ_STATUS status;
-    hash_seq_init(&status, batchMetaProcessInfoListPerShard);
-    while ((entry = hash_seq_search(&status)) != 0) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
+    SetUpScanCaches();
 
-        for (int i = 0; i < list_length(entry->info); ++i) {
-            MetaProcessInfo info = list_nth(entry->info, i);
+    int itemCount;
+    BatchShardItem *items =
+        ResolveBatchByShard(infoArray, count, PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY, &itemCount);
+    int begin = 0;
+    while (begin < itemCount) {
+        int end = BatchShardGroupEnd(items, itemCount, begin);
+        StringInfo inodeShardName = GetInodeShardName(items[begin].shardId);
+        StringInfo inodeIndexShardName = GetInodeIndexShardName(items[begin].shardId);
+        Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), AccessShareLock);
+        InodeShardProbe probe;
+        InodeShardProbeBegin(&probe, workerInodeRel, GetRelationOidByName_CUCKOO(inodeIndexShardName->data));
 
-            if (info->errorCode != SUCCESS)
-                continue;
+        for (int i = begin; i < end; ++i) {
+            MetaProcessInfo info = items[i].info;
 
-            bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                           NULL,
-                                                           inodeIndexShardName->data,
-                                                           InvalidOid,
-                                                           info->parentId_partId,
-                                                           info->name,
-                                                           false,
-                                                           &info->inodeId,
-                                                           &info->st_size,
-                                                           NULL,
-                                                           NULL,
-                                                           &info->st_nlink,
-                                                           0,
-                                                           &info->st_mode,
-                                                           NULL,
-                                                           NULL,
-                                                           NULL,
-                                                           NULL,
-                                                           NULL,
-                                                           NULL,
-                                                           &info->node_id,
-                                                           NULL,
-                                                           NULL);
             info->st_dev = 0;
             info->st_uid = 0;
             info->st_gid = 0;
@@ -790,11 +666,21 @@ void CuckooOpenHandle(MetaProcessInfo *infoArray, int count)
             info->st_mtim = 0;
             info->st_ctim = 0;
             info->etag = (char *)"";
-            if (!fileExist)
+            if (!InodeShardProbeNext(&probe, info->parentId_partId, info->name)) {
                 info->errorCode = FILE_NOT_EXISTS;
-            else
-                info->errorCode = SUCCESS;
+                continue;
+            }
+            Datum *datumArray = probe.slot->tts_values;
+            info->inodeId = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_ino - 1]);
+            info->st_size = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_size - 1]);
+            info->st_nlink = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_nlink - 1]);
+            info->st_mode = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_mode - 1]);
+            info->node_id = DatumGetInt32(datumArray[Anum_pg_dfs_file_primary_nodeid - 1]);
         }
+
+        InodeShardProbeEnd(&probe);
+        table_close(workerInodeRel, AccessShareLock);
+        begin = end;
     }
 }
 
@@ -811,66 +697,27 @@ void CuckooCloseHandle(MetaProcessInfo *infoArray, int count)
     }
     pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
 
-    HASHCTL info;
-    memset(&info, 0, sizeof(info));
-    info.keysize = sizeof(int32_t);
-    info.entrysize = sizeof(ShardHashInfo);
-    info.hcxt = CurrentMemoryContext;
-    int hashFlags = (HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-    HTAB *batchMetaProcessInfoListPerShard =
-        hash_create("Batch Meta Process Info List Per Shard Hash Table", GetShardTableSize(), &info, hashFlags);
-    ShardHashInfo *entry;
-    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
-    for (int i = 0; i < count; ++i) {
-        MetaProcessInfo info = infoArray[i];
-        if (info->errorCode != SUCCESS)
-            continue;
-
-        CuckooErrorCode errorCode = PathParseTreeInsert(NULL,
-                                                        directoryRel,
-                                                        info->path,
-                                                        PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY,
-                                                        &info->parentId,
-                                                        &info->name,
-                                                        NULL);
-        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
-
-        uint16_t partId = HashPartId(info->name);
-        info->parentId_partId = CombineParentIdWithPartId(info->parentId, partId);
-        int shardId, workerId;
-        SearchShardInfoByShardValue(info->parentId_partId, &shardId, &workerId);
-        if (workerId != GetLocalServerId())
-            CHECK_ERROR_CODE_WITH_CONTINUE(WRONG_WORKER);
-
-        bool found;
-        entry = hash_search(batchMetaProcessInfoListPerShard, &shardId, HASH_ENTER, &found);
-        if (!found) {
-            entry->shardId = shardId;
-            entry->info = NULL;
-        }
-        entry->info = lappend(entry->info, info);
-    }
-    table_close(directoryRel, AccessShareLock);
-
-    HASH_SEQ_STATUS status;
-    hash_seq_init(&status, batchMetaProcessInfoListPerShard);
-    while ((entry = hash_seq_search(&status)) != 0) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
-
-        for (int i = 0; i < list_length(entry->info); ++i) {
-            MetaProcessInfo info = list_nth(entry->info, i);
+    int itemCount;
+    BatchShardItem *items =
+        ResolveBatchByShard(infoArray, count, PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY, &itemCount);
+    int begin = 0;
+    while (begin < itemCount) {
+        int end = BatchShardGroupEnd(items, itemCount, begin);
+        StringInfo inodeShardName = GetInodeShardName(items[begin].shardId);
+        StringInfo inodeIndexShardName = GetInodeIndexShardName(items[begin].shardId);
+        Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), RowExclusiveLock);
+        Oid workerInodeIndexOid = GetRelationOidByName_CUCKOO(inodeIndexShardName->data);
 
-            if (info->errorCode != SUCCESS)
-                continue;
+        for (int i = begin; i < end; ++i) {
+            MetaProcessInfo info = items[i].info;
 
             int64_t size = info->st_size;
             int64_t mtime = GetCurrentTimestamp();
             int32_t nodeId = info->node_id;
             bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                           NULL,
+                                                           workerInodeRel,
                                                            inodeIndexShardName->data,
-                                                           InvalidOid,
+                                                           workerInodeIndexOid,
                                                            info->parentId_partId,
                                                            info->name,
                                                            true,
@@ -895,6 +742,9 @@ void CuckooCloseHandle(MetaProcessInfo *infoArray, int count)
             else
                 info->errorCode = SUCCESS;
         }
+
+        table_close(workerInodeRel, RowExclusiveLock);
+        begin = end;
     }
 }
 
@@ -912,60 +762,25 @@ void CuckooUnlinkHandle(MetaProcessInfo *infoArray, int count)
     }
     pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
 
-    HASHCTL info;
-    memset(&info, 0, sizeof(info));
-    info.keysize = sizeof(int32_t);
-    info.entrysize = sizeof(ShardHashInfo);
-    info.hcxt = CurrentMemoryContext;
-    int hashFlags = (HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-    HTAB *batchMetaProcessInfoListPerShard =
-        hash_create("Batch Meta Process Info List Per Shard Hash Table", GetShardTableSize(), &info, hashFlags);
-    ShardHashInfo *entry;
-    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
-    for (int i = 0; i < count; ++i) {
-        MetaProcessInfo info = infoArray[i];
-        if (info->errorCode != SUCCESS)
-            continue;
-
-        CuckooErrorCode errorCode =
-            PathParseTreeInsert(NULL, directoryRel, info->path, 0, &info->parentId, &info->name, NULL);
-        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
-
-        uint16_t partId = HashPartId(info->name);
-        info->parentId_partId = CombineParentIdWithPartId(info->parentId, partId);
-        int shardId, workerId;
-        SearchShardInfoByShardValue(info->parentId_partId, &shardId, &workerId);
-        if (workerId != GetLocalServerId())
-            CHECK_ERROR_CODE_WITH_CONTINUE(WRONG_WORKER);
-
-        bool found;
-        entry = hash_search(batchMetaProcessInfoListPerShard, &shardId, HASH_ENTER, &found);
-        if (!found) {
-            entry->shardId = shardId;
-            entry->info = NIL;
-        }
-        entry->info = lappend(entry->info, info);
-    }
-    table_close(directoryRel, AccessShareLock);
-
-    HASH_SEQ_STATUS status;
-    hash_seq_init(&status, batchMetaProcessInfoListPerShard);
-    while ((entry = hash_seq_search(&status)) != 0) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
-
-        for (int i = 0; i < list_length(entry->info); ++i) {
-            MetaProcessInfo info = list_nth(entry->info, i);
+    int itemCount;
+    BatchShardItem *items = ResolveBatchByShard(infoArray, count, 0, &itemCount);
+    int begin = 0;
+    while (begin < itemCount) {
+        int end = BatchShardGroupEnd(items, itemCount, begin);
+        StringInfo inodeShardName = GetInodeShardName(items[begin].shardId);
+        StringInfo inodeIndexShardName = GetInodeIndexShardName(items[begin].shardId);
+        Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), RowExclusiveLock);
+        Oid workerInodeIndexOid = GetRelationOidByName_CUCKOO(inodeIndexShardName->data);
 
-            if (info->errorCode != SUCCESS)
-                continue;
+        for (int i = begin; i < end; ++i) {
+            MetaProcessInfo info = items[i].info;
 
             uint64_t nlink;
             mode_t mode;
             bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                           NULL,
+                                                           workerInodeRel,
                                                            inodeIndexShardName->data,
-                                                           InvalidOid,
+                                                           workerInodeIndexOid,
                                                            info->parentId_partId,
                                                            info->name,
                                                            true,
@@ -992,6 +807,9 @@ void CuckooUnlinkHandle(MetaProcessInfo *infoArray, int count)
             else
                 info->errorCode = SUCCESS;
         }
+
+        table_close(workerInodeRel, RowExclusiveLock);
+        begin = end;
     }
 }
 
@@ -1140,28 +958,39 @@ void CuckooReadDirHandle(MetaProcessInfo info)
     info->readDirResultCount = list_length(resultList);
     info->errorCode = SUCCESS;
 }
-void CuckooOpenDirHandle(MetaProcessInfo info)
+void CuckooOpenDirHandle(MetaProcessInfo *infoArray, int count)
 {
-    const char *path = info->path;
-    int32_t property;
-    VerifyPathValidity(path, VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_DIRECTORY, &property);
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        info->errorCode = SUCCESS;
+        info->errorMsg = NULL;
+
+        int32_t property;
+        CuckooErrorCode errorCode =
+            VerifyPathValidity(info->path, VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_DIRECTORY, &property);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+    }
+    pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
 
     Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
-    uint64_t directoryId;
-    CuckooErrorCode errorCode = PathParseTreeInsert(NULL,
-                                                    directoryRel,
-                                                    path,
-                                                    PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY |
-                                                        PATH_PARSE_FLAG_TARGET_IS_DIRECTORY,
-                                                    NULL,
-                                                    NULL,
-                                                    &directoryId);
-    if (errorCode != SUCCESS)
-        CUCKOO_ELOG_ERROR(errorCode, "path parse error.");
-    table_close(directoryRel, AccessShareLock);
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        if (info->errorCode != SUCCESS)
+            continue;
 
-    info->inodeId = directoryId;
-    info->errorCode = SUCCESS;
+        uint64_t directoryId;
+        CuckooErrorCode errorCode = PathParseTreeInsert(NULL,
+                                                        directoryRel,
+                                                        info->path,
+                                                        PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY |
+                                                            PATH_PARSE_FLAG_TARGET_IS_DIRECTORY,
+                                                        NULL,
+                                                        NULL,
+                                                        &directoryId);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+        info->inodeId = directoryId;
+    }
+    table_close(directoryRel, AccessShareLock);
 }
 
 void CuckooRmdirHandle(MetaProcessInfo info)
@@ -1190,6 +1019,7 @@ void CuckooRmdirHandle(MetaProcessInfo info)
                                     &info->inodeId);
     if (errorCode != SUCCESS)
         CUCKOO_ELOG_ERROR(errorCode, "path parse error.");
+    PathParsePrefixCacheInvalidate(info->path);
     DeleteDirectoryByDirectoryHashTable(directoryRel, info->parentId, info->name, DIR_LOCK_NONE);
     table_close(directoryRel, RowExclusiveLock);
 
@@ -1427,6 +1257,7 @@ void CuckooRenameHandle(MetaProcessInfo info)
 
     // 3.
     if (renameDirectory) {
+        PathParsePrefixCacheInvalidate(srcPath);
         DeleteDirectoryByDirectoryHashTable(directoryRel, parentId[srcIndex], name[srcIndex], DIR_LOCK_NONE);
         CommandCounterIncrement();
 
@@ -1719,193 +1550,198 @@ void CuckooRenameSubCreateHandle(MetaProcessInfo info)
     info->errorCode = SUCCESS;
 }
 
-void CuckooUtimeNsHandle(MetaProcessInfo info)
+void CuckooUtimeNsHandle(MetaProcessInfo *infoArray, int count)
 {
-    const char *path = info->path;
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        info->errorCode = SUCCESS;
+        info->errorMsg = NULL;
 
-    TimestampTz accessTime;
-    TimestampTz modifyTime;
-    if (info->st_atim == -1 || info->st_mtim == -1) {
-        accessTime = GetCurrentTimestamp();
-        modifyTime = GetCurrentTimestamp();
-    } else {
-        accessTime = (TimestampTz)info->st_atim;
-        modifyTime = (TimestampTz)info->st_mtim;
+        int32_t property;
+        CuckooErrorCode errorCode = VerifyPathValidity(info->path, 0, &property);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
     }
+    pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
 
-    int32_t property;
-    VerifyPathValidity(path, 0, &property);
+    int itemCount;
+    BatchShardItem *items =
+        ResolveBatchByShard(infoArray, count, PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY, &itemCount);
+    int begin = 0;
+    while (begin < itemCount) {
+        int end = BatchShardGroupEnd(items, itemCount, begin);
+        StringInfo inodeShardName = GetInodeShardName(items[begin].shardId);
+        StringInfo inodeIndexShardName = GetInodeIndexShardName(items[begin].shardId);
+        Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), RowExclusiveLock);
+        Oid workerInodeIndexOid = GetRelationOidByName_CUCKOO(inodeIndexShardName->data);
 
-    uint64_t parentId = 0;
-    char *fileName;
-    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
-    CuckooErrorCode errorCode = PathParseTreeInsert(NULL,
-                                                    directoryRel,
-                                                    path,
-                                                    PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY,
-                                                    &parentId,
-                                                    &fileName,
-                                                    NULL);
-    if (errorCode != SUCCESS)
-        CUCKOO_ELOG_ERROR(errorCode, "path parse error.");
-    table_close(directoryRel, AccessShareLock);
+        for (int i = begin; i < end; ++i) {
+            MetaProcessInfo info = items[i].info;
 
-    uint16_t partId = HashPartId(fileName);
-    uint64_t parentId_partId = CombineParentIdWithPartId(parentId, partId);
-    int shardId, workerId;
-    SearchShardInfoByShardValue(parentId_partId, &shardId, &workerId);
-    if (workerId != GetLocalServerId())
-        CUCKOO_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
-
-    StringInfo inodeShardName = GetInodeShardName(shardId);
-    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
-    bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                   NULL,
-                                                   inodeIndexShardName->data,
-                                                   InvalidOid,
-                                                   parentId_partId,
-                                                   fileName,
-                                                   true,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   0,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   &accessTime,
-                                                   &modifyTime,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL);
-    if (!fileExist)
-        CUCKOO_ELOG_ERROR(FILE_NOT_EXISTS, "file doesn't exist.");
+            TimestampTz accessTime;
+            TimestampTz modifyTime;
+            if (info->st_atim == -1 || info->st_mtim == -1) {
+                accessTime = GetCurrentTimestamp();
+                modifyTime = GetCurrentTimestamp();
+            } else {
+                accessTime = (TimestampTz)info->st_atim;
+                modifyTime = (TimestampTz)info->st_mtim;
+            }
+            bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
+                                                           workerInodeRel,
+                                                           inodeIndexShardName->data,
+                                                           workerInodeIndexOid,
+                                                           info->parentId_partId,
+                                                           info->name,
+                                                           true,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           0,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           &accessTime,
+                                                           &modifyTime,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL);
+            if (!fileExist)
+                info->errorCode = FILE_NOT_EXISTS;
+            else
+                info->errorCode = SUCCESS;
+        }
 
-    info->errorCode = SUCCESS;
+        table_close(workerInodeRel, RowExclusiveLock);
+        begin = end;
+    }
 }
 
-void CuckooChownHandle(MetaProcessInfo info)
+void CuckooChownHandle(MetaProcessInfo *infoArray, int count)
 {
-    const char *path = info->path;
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        info->errorCode = SUCCESS;
+        info->errorMsg = NULL;
 
-    int32_t property;
-    VerifyPathValidity(path, 0, &property);
+        int32_t property;
+        CuckooErrorCode errorCode = VerifyPathValidity(info->path, 0, &property);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+    }
+    pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
 
-    uint64_t parentId = 0;
-    char *fileName;
-    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
-    CuckooErrorCode errorCode = PathParseTreeInsert(NULL,
-                                                    directoryRel,
-                                                    path,
-                                                    PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY,
-                                                    &parentId,
-                                                    &fileName,
-                                                    NULL);
-    if (errorCode != SUCCESS)
-        CUCKOO_ELOG_ERROR(errorCode, "path parse error.");
-    table_close(directoryRel, AccessShareLock);
+    int itemCount;
+    BatchShardItem *items =
+        ResolveBatchByShard(infoArray, count, PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY, &itemCount);
+    int begin = 0;
+    while (begin < itemCount) {
+        int end = BatchShardGroupEnd(items, itemCount, begin);
+        StringInfo inodeShardName = GetInodeShardName(items[begin].shardId);
+        StringInfo inodeIndexShardName = GetInodeIndexShardName(items[begin].shardId);
+        Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), RowExclusiveLock);
+        Oid workerInodeIndexOid = GetRelationOidByName_CUCKOO(inodeIndexShardName->data);
 
-    uint16_t partId = HashPartId(fileName);
-    uint64_t parentId_partId = CombineParentIdWithPartId(parentId, partId);
-    int shardId, workerId;
-    SearchShardInfoByShardValue(parentId_partId, &shardId, &workerId);
-    if (workerId != GetLocalServerId())
-        CUCKOO_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
+        for (int i = begin; i < end; ++i) {
+            MetaProcessInfo info = items[i].info;
 
-    StringInfo inodeShardName = GetInodeShardName(shardId);
-    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
-    bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                   NULL,
-                                                   inodeIndexShardName->data,
-                                                   InvalidOid,
-                                                   parentId_partId,
-                                                   fileName,
-                                                   true,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   0,
-                                                   NULL,
-                                                   NULL,
-                                                   &info->st_uid,
-                                                   &info->st_gid,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL);
-    if (!fileExist)
-        CUCKOO_ELOG_ERROR(FILE_NOT_EXISTS, "file doesn't exist.");
+            bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
+                                                           workerInodeRel,
+                                                           inodeIndexShardName->data,
+                                                           workerInodeIndexOid,
+                                                           info->parentId_partId,
+                                                           info->name,
+                                                           true,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           0,
+                                                           NULL,
+                                                           NULL,
+                                                           &info->st_uid,
+                                                           &info->st_gid,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL);
+            if (!fileExist)
+                info->errorCode = FILE_NOT_EXISTS;
+            else
+                info->errorCode = SUCCESS;
+        }
 
-    info->errorCode = SUCCESS;
+        table_close(workerInodeRel, RowExclusiveLock);
+        begin = end;
+    }
 }
 
-void CuckooChmodHandle(MetaProcessInfo info)
+void CuckooChmodHandle(MetaProcessInfo *infoArray, int count)
 {
-    const char *path = info->path;
-    mode_t newExecMode = info->st_mode;
-    newExecMode &= 0x1FF;
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        info->errorCode = SUCCESS;
+        info->errorMsg = NULL;
 
-    int32_t property;
-    VerifyPathValidity(path, 0, &property);
+        int32_t property;
+        CuckooErrorCode errorCode = VerifyPathValidity(info->path, 0, &property);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+    }
+    pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
 
-    uint64_t parentId = 0;
-    char *fileName;
-    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
-    CuckooErrorCode errorCode = PathParseTreeInsert(NULL,
-                                                    directoryRel,
-                                                    path,
-                                                    PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY,
-                                                    &parentId,
-                                                    &fileName,
-                                                    NULL);
-    if (errorCode != SUCCESS)
-        CUCKOO_ELOG_ERROR(errorCode, "path parse error.");
-    table_close(directoryRel, AccessShareLock);
+    int itemCount;
+    BatchShardItem *items =
+        ResolveBatchByShard(infoArray, count, PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY, &itemCount);
+    int begin = 0;
+    while (begin < itemCount) {
+        int end = BatchShardGroupEnd(items, itemCount, begin);
+        StringInfo inodeShardName = GetInodeShardName(items[begin].shardId);
+        StringInfo inodeIndexShardName = GetInodeIndexShardName(items[begin].shardId);
+        Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), RowExclusiveLock);
+        Oid workerInodeIndexOid = GetRelationOidByName_CUCKOO(inodeIndexShardName->data);
 
-    uint16_t partId = HashPartId(fileName);
-    uint64_t parentId_partId = CombineParentIdWithPartId(parentId, partId);
-    int shardId, workerId;
-    SearchShardInfoByShardValue(parentId_partId, &shardId, &workerId);
-    if (workerId != GetLocalServerId())
-        CUCKOO_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
+        for (int i = begin; i < end; ++i) {
+            MetaProcessInfo info = items[i].info;
 
-    StringInfo inodeShardName = GetInodeShardName(shardId);
-    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
-    bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                   NULL,
-                                                   inodeIndexShardName->data,
-                                                   InvalidOid,
-                                                   parentId_partId,
-                                                   fileName,
-                                                   true,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   0,
-                                                   NULL,
-                                                   &newExecMode,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL);
-    if (!fileExist)
-        CUCKOO_ELOG_ERROR(FILE_NOT_EXISTS, "file doesn't exist.");
+            mode_t newExecMode = info->st_mode;
+            newExecMode &= 0x1FF;
+            bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
+                                                           workerInodeRel,
+                                                           inodeIndexShardName->data,
+                                                           workerInodeIndexOid,
+                                                           info->parentId_partId,
+                                                           info->name,
+                                                           true,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           0,
+                                                           NULL,
+                                                           &newExecMode,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL);
+            if (!fileExist)
+                info->errorCode = FILE_NOT_EXISTS;
+            else
+                info->errorCode = SUCCESS;
+        }
 
-    info->errorCode = SUCCESS;
+        table_close(workerInodeRel, RowExclusiveLock);
+        begin = end;
+    }
 }
 
 static inline uint16_t HashPartId(const char *fileName)
@@ -1960,6 +1796,102 @@ static Oid GetRelationOidByName_CUCKOO(const char *relationName)
     return res;
 }
 
+static int BatchShardItemCmp(const void *a, const void *b)
+{
+    const BatchShardItem *pa = (const BatchShardItem *)a;
+    const BatchShardItem *pb = (const BatchShardItem *)b;
+    if (pa->shardId != pb->shardId)
+        return pa->shardId < pb->shardId ? -1 : 1;
+    if (pa->info->parentId_partId != pb->info->parentId_partId)
+        return pa->info->parentId_partId < pb->info->parentId_partId ? -1 : 1;
+    return strcmp(pa->info->name, pb->info->name);
+}
+
+/*
+ * Resolves the parent of every valid item of a path sorted batch and returns the local items sorted by shard
+ * and then by inode index key. Siblings come one after another in path order, so after the first of them the
+ * parent is taken from the path parse prefix cache.
+ */
+static BatchShardItem *ResolveBatchByShard(MetaProcessInfo *infoArray, int count, uint16_t flag, int *itemCount)
+{
+    BatchShardItem *items = palloc(sizeof(BatchShardItem) * Max(count, 1));
+    int n = 0;
+    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        if (info->errorCode != SUCCESS)
+            continue;
+
+        CuckooErrorCode errorCode =
+            PathParseTreeInsert(NULL,
+                                directoryRel,
+                                info->path,
+                                flag,
+                                &info->parentId,
+                                &info->name,
+                                (flag & PATH_PARSE_FLAG_TARGET_TO_BE_CREATED) ? &info->inodeId : NULL);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+
+        uint16_t partId = HashPartId(info->name);
+        info->parentId_partId = CombineParentIdWithPartId(info->parentId, partId);
+        int shardId, workerId;
+        SearchShardInfoByShardValue(info->parentId_partId, &shardId, &workerId);
+        if (workerId != GetLocalServerId())
+            CHECK_ERROR_CODE_WITH_CONTINUE(WRONG_WORKER);
+
+        items[n].shardId = shardId;
+        items[n].info = info;
+        ++n;
+    }
+    table_close(directoryRel, AccessShareLock);
+
+    pg_qsort(items, n, sizeof(BatchShardItem), BatchShardItemCmp);
+    *itemCount = n;
+    return items;
+}
+
+static int BatchShardGroupEnd(const BatchShardItem *items, int itemCount, int begin)
+{
+    int end = begin + 1;
+    while (end < itemCount && items[end].shardId == items[begin].shardId)
+        ++end;
+    return end;
+}
+
+/*
+ * Unlike systable_beginscan per item, the index is opened and the scan set up once per shard, each lookup is
+ * an index_rescan. Keys are looked up in index order, so each descent mostly hits the pages of the previous.
+ */
+static void InodeShardProbeBegin(InodeShardProbe *probe, Relation workerInodeRel, Oid workerInodeIndexOid)
+{
+    probe->indexRel = index_open(workerInodeIndexOid, AccessShareLock);
+    probe->scan = index_beginscan(workerInodeRel, probe->indexRel, GetTransactionSnapshot(), 2, 0);
+    probe->slot = table_slot_create(workerInodeRel, NULL);
+}
+
+// on success the columns of the file are in probe->slot->tts_values until the next lookup
+static bool InodeShardProbeNext(InodeShardProbe *probe, uint64_t parentId_partId, const char *fileName)
+{
+    ScanKeyData scanKey[2];
+    scanKey[0] = InodeTableIndexParentIdPartIdNameScanKey[INODE_TABLE_INDEX_PARENT_ID_PART_ID_EQ];
+    scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
+    scanKey[1] = InodeTableIndexParentIdPartIdNameScanKey[INODE_TABLE_INDEX_NAME_EQ];
+    scanKey[1].sk_argument = CStringGetTextDatum(fileName);
+
+    index_rescan(probe->scan, scanKey, 2, NULL, 0);
+    if (!index_getnext_slot(probe->scan, ForwardScanDirection, probe->slot))
+        return false;
+    slot_getallattrs(probe->slot);
+    return true;
+}
+
+static void InodeShardProbeEnd(InodeShardProbe *probe)
+{
+    ExecDropSingleTupleTableSlot(probe->slot);
+    index_endscan(probe->scan);
+    index_close(probe->indexRel, AccessShareLock);
+}
+
 static bool SearchAndUpdateInodeTableInfo(const char *workerInodeRelationName,
                                           Relation workerInodeRelation,
                                           const char *workerInodeRelationIndexName,
@@ -2,6 +2,8 @@
  * SPDX-License-Identifier: MulanPSL-2.0
  */
 
+#include <time.h>
+
 #include "postgres.h"
 
 #include "fmgr.h"
@@ -10,6 +12,7 @@
 #include "metadb/meta_process_info.h"
 #include "utils/builtins.h"
 #include "utils/error_log.h"
+#include "utils/memutils.h"
 #include "utils/timestamp.h"
 #include "utils/utils.h"
 
@@ -18,6 +21,7 @@ PG_FUNCTION_INFO_V1(cuckoo_plain_create);
 PG_FUNCTION_INFO_V1(cuckoo_plain_stat);
 PG_FUNCTION_INFO_V1(cuckoo_plain_rmdir);
 PG_FUNCTION_INFO_V1(cuckoo_plain_readdir);
+PG_FUNCTION_INFO_V1(cuckoo_plain_batch_bench);
 
 Datum cuckoo_plain_mkdir(PG_FUNCTION_ARGS)
 {
@@ -92,3 +96,71 @@ Datum cuckoo_plain_readdir(PG_FUNCTION_ARGS)
     }
     PG_RETURN_TEXT_P(cstring_to_text(result->data));
 }
+
+static bool RunBatchHandler(const char *op, MetaProcessInfo *infoArray, int count)
+{
+    if (strcmp(op, "create") == 0)
+        CuckooCreateHandle(infoArray, count, false);
+    else if (strcmp(op, "stat") == 0)
+        CuckooStatHandle(infoArray, count);
+    else if (strcmp(op, "open") == 0)
+        CuckooOpenHandle(infoArray, count);
+    else if (strcmp(op, "close") == 0)
+        CuckooCloseHandle(infoArray, count);
+    else if (strcmp(op, "unlink") == 0)
+        CuckooUnlinkHandle(infoArray, count);
+    else if (strcmp(op, "utimens") == 0)
+        CuckooUtimeNsHandle(infoArray, count);
+    else if (strcmp(op, "chown") == 0)
+        CuckooChownHandle(infoArray, count);
+    else if (strcmp(op, "chmod") == 0)
+        CuckooChmodHandle(infoArray, count);
+    else
+        return false;
+    return true;
+}
+
+/*
+ * Runs rounds batches of batch_size files <dir>/bench_<n> through one batch handler and returns the backend
+ * cpu time per file in microseconds. create makes the files that stat, open, close, utimens, chown, chmod and
+ * unlink then work on, so a sweep runs the ops in that order with the same batch_size and rounds.
+ */
+Datum cuckoo_plain_batch_bench(PG_FUNCTION_ARGS)
+{
+    char *op = PG_GETARG_CSTRING(0);
+    char *dir = PG_GETARG_CSTRING(1);
+    int32_t batchSize = PG_GETARG_INT32(2);
+    int32_t rounds = PG_GETARG_INT32(3);
+    if (batchSize <= 0 || rounds <= 0)
+        CUCKOO_ELOG_ERROR(ARGUMENT_ERROR, "batch_size and rounds must be positive.");
+    const char *prefix = strcmp(dir, "/") == 0 ? "" : dir;
+
+    MemoryContext roundContext =
+        AllocSetContextCreate(CurrentMemoryContext, "Cuckoo Plain Batch Bench", ALLOCSET_DEFAULT_SIZES);
+    MemoryContext oldContext = MemoryContextSwitchTo(roundContext);
+    int64_t cpuTimeNs = 0;
+    for (int32_t round = 0; round < rounds; ++round) {
+        MemoryContextReset(roundContext);
+        MetaProcessInfoData *infoData = palloc0(sizeof(MetaProcessInfoData) * batchSize);
+        MetaProcessInfo *infoArray = palloc(sizeof(MetaProcessInfo) * batchSize);
+        for (int32_t i = 0; i < batchSize; ++i) {
+            infoData[i].path = psprintf("%s/bench_%d", prefix, round * batchSize + i);
+            infoData[i].node_id = -1;
+            infoData[i].st_atim = -1;
+            infoData[i].st_mtim = -1;
+            infoData[i].st_mode = 0644;
+            infoArray[i] = &infoData[i];
+        }
+
+        struct timespec start, stop;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+        if (!RunBatchHandler(op, infoArray, batchSize))
+            CUCKOO_ELOG_ERROR_EXTENDED(ARGUMENT_ERROR, "unsupported op %s.", op);
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &stop);
+        cpuTimeNs += (int64_t)(stop.tv_sec - start.tv_sec) * 1000000000 + (stop.tv_nsec - start.tv_nsec);
+    }
+    MemoryContextSwitchTo(oldContext);
+    MemoryContextDelete(roundContext);
+
+    PG_RETURN_FLOAT8((double)cpuTimeNs / 1000.0 / ((double)rounds * batchSize));
+}
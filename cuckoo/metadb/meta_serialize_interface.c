@@ -20,7 +20,8 @@ static SerializedData MetaProcess(CuckooSupportMetaService metaService, int coun
 {
     if (count != 1 && !(metaService == MKDIR || metaService == MKDIR_SUB_MKDIR || metaService == MKDIR_SUB_CREATE ||
                         metaService == CREATE || metaService == STAT || metaService == OPEN || metaService == CLOSE ||
-                        metaService == UNLINK))
+                        metaService == UNLINK || metaService == OPENDIR || metaService == UTIMENS ||
+                        metaService == CHOWN || metaService == CHMOD))
         CUCKOO_ELOG_ERROR_EXTENDED(ARGUMENT_ERROR, "metaService %d doesn't support batch operation.", metaService);
 
     SerializedData param;
@@ -65,7 +66,7 @@ static SerializedData MetaProcess(CuckooSupportMetaService metaService, int coun
         CuckooReadDirHandle(infoArray[0]);
         break;
     case OPENDIR:
-        CuckooOpenDirHandle(infoArray[0]);
+        CuckooOpenDirHandle(infoArray, count);
         break;
     case RMDIR:
         CuckooRmdirHandle(infoArray[0]);
@@ -86,13 +87,13 @@ static SerializedData MetaProcess(CuckooSupportMetaService metaService, int coun
         CuckooRenameSubCreateHandle(infoArray[0]);
         break;
     case UTIMENS:
-        CuckooUtimeNsHandle(infoArray[0]);
+        CuckooUtimeNsHandle(infoArray, count);
         break;
     case CHOWN:
-        CuckooChownHandle(infoArray[0]);
+        CuckooChownHandle(infoArray, count);
         break;
     case CHMOD:
-        CuckooChmodHandle(infoArray[0]);
+        CuckooChmodHandle(infoArray, count);
         break;
     default:
         CUCKOO_ELOG_ERROR_EXTENDED(ARGUMENT_ERROR, "unexpected metaService: %d", metaService);
@@ -6,7 +6,9 @@
 #include "postgres.h"
 
 #include "catalog/namespace.h"
+#include "common/hashfn.h"
 #include "utils/builtins.h"
+#include "utils/hsearch.h"
 #include "utils/memutils.h"
 #include "utils/palloc.h"
 #include "utils/syscache.h"
@@ -23,6 +25,26 @@ static MemoryContext PathParseContext = NULL;
 //      this can be done by additional check in transaction.c
 static PathParseTree TransactionLevelPathParseRoot = NULL;
 
+/*
+ * Maps the directory part of a path, up to and including its last '/', to the node of
+ * TransactionLevelPathParseRoot it resolved to. The node holds the inodeId and the shared locks taken on the
+ * way, which are only valid until the transaction ends, so the cache is reset with the tree. A batch of
+ * requests under one directory walks it once.
+ */
+typedef struct PathParsePrefixKey
+{
+    const char *path;
+    uint32_t length;
+} PathParsePrefixKey;
+
+typedef struct PathParsePrefixEntry
+{
+    PathParsePrefixKey key;
+    PathParseRBTreeNode *node;
+} PathParsePrefixEntry;
+
+static HTAB *TransactionLevelPathParsePrefixCache = NULL;
+
 static int PathParseRBT_cmp(const RBTNode *a, const RBTNode *b, void *arg)
 {
     const PathParseRBTreeNode *ea = (const PathParseRBTreeNode *)a;
@@ -49,6 +71,70 @@ static RBTNode *PathParseRBT_alloc(void *arg)
 
 static void PathParseRBT_free(RBTNode *node, void *arg) { pfree(node); }
 
+static uint32 PathParsePrefix_hash(const void *key, Size keysize)
+{
+    const PathParsePrefixKey *k = (const PathParsePrefixKey *)key;
+    return hash_bytes((const unsigned char *)k->path, k->length);
+}
+
+static int PathParsePrefix_match(const void *key1, const void *key2, Size keysize)
+{
+    const PathParsePrefixKey *k1 = (const PathParsePrefixKey *)key1;
+    const PathParsePrefixKey *k2 = (const PathParsePrefixKey *)key2;
+    if (k1->length != k2->length)
+        return 1;
+    return memcmp(k1->path, k2->path, k1->length);
+}
+
+static void *PathParsePrefix_keycopy(void *dest, const void *src, Size keysize)
+{
+    const PathParsePrefixKey *srcKey = (const PathParsePrefixKey *)src;
+    PathParsePrefixKey *destKey = (PathParsePrefixKey *)dest;
+    char *path = MemoryContextAlloc(PathParseContext, srcKey->length + 1);
+    memcpy(path, srcKey->path, srcKey->length);
+    path[srcKey->length] = '\0';
+    destKey->path = path;
+    destKey->length = srcKey->length;
+    return dest;
+}
+
+static PathParsePrefixEntry *PathParsePrefixCacheSearch(const char *path, uint32_t length, HASHACTION action)
+{
+    if (TransactionLevelPathParsePrefixCache == NULL) {
+        if (action == HASH_FIND)
+            return NULL;
+        HASHCTL info;
+        memset(&info, 0, sizeof(info));
+        info.keysize = sizeof(PathParsePrefixKey);
+        info.entrysize = sizeof(PathParsePrefixEntry);
+        info.hash = PathParsePrefix_hash;
+        info.match = PathParsePrefix_match;
+        info.keycopy = PathParsePrefix_keycopy;
+        info.hcxt = PathParseContext;
+        TransactionLevelPathParsePrefixCache =
+            hash_create("Cuckoo path parse prefix cache",
+                        64,
+                        &info,
+                        HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_KEYCOPY | HASH_CONTEXT);
+    }
+    PathParsePrefixKey key = {path, length};
+    return (PathParsePrefixEntry *)hash_search(TransactionLevelPathParsePrefixCache, &key, action, NULL);
+}
+
+void PathParsePrefixCacheInvalidate(const char *path)
+{
+    if (TransactionLevelPathParsePrefixCache == NULL)
+        return;
+    size_t length = strlen(path);
+    HASH_SEQ_STATUS status;
+    PathParsePrefixEntry *entry;
+    hash_seq_init(&status, TransactionLevelPathParsePrefixCache);
+    while ((entry = hash_seq_search(&status)) != NULL) {
+        if (entry->key.length >= length && memcmp(entry->key.path, path, length) == 0)
+            hash_search(TransactionLevelPathParsePrefixCache, &entry->key, HASH_REMOVE, NULL);
+    }
+}
+
 void PathParseTreeInit(PathParseRBTreeNode *root)
 {
     root->inodeId = 0;
@@ -101,6 +187,7 @@ void PathParseMemoryContextInit()
 void TransactionLevelPathParseReset()
 {
     TransactionLevelPathParseRoot = NULL;
+    TransactionLevelPathParsePrefixCache = NULL;
     MemoryContextReset(PathParseContext);
 }
 
@@ -116,6 +203,7 @@ CuckooErrorCode PathParseTreeInsert(PathParseTree root,
         return PATH_IS_ROOT;
     }
 
+    bool usePrefixCache = root == NULL;
     if (root == NULL) {
         if (TransactionLevelPathParseRoot == NULL) {
             TransactionLevelPathParseRoot = MemoryContextAlloc(PathParseContext, sizeof(PathParseRBTreeNode));
@@ -128,7 +216,21 @@ CuckooErrorCode PathParseTreeInsert(PathParseTree root,
     int currentFileNameLength = 1;
     PathParseRBTreeNode *currentNode = root;
     PathParseRBTreeNode *node;
-    while (path[currentFileNameStartPos + currentFileNameLength] != '\0') {
+
+    // directories are walked up to and including the last '/', the rest is the file name
+    const char *lastSlash = strrchr(path, '/');
+    uint32_t prefixLength = (path[0] != '/' || path[1] == '\0') ? 0 : lastSlash - path + 1;
+    PathParsePrefixEntry *prefixEntry = NULL;
+    if (usePrefixCache && prefixLength > 0)
+        prefixEntry = PathParsePrefixCacheSearch(path, prefixLength, HASH_FIND);
+    if (prefixEntry) {
+        if (prefixEntry->node->lockAcquired == PP_EXCLUSIVE)
+            return PATH_LOCK_CONFLICT;
+        currentNode = prefixEntry->node;
+        currentFileNameStartPos = prefixLength;
+        currentFileNameLength = strlen(path + prefixLength);
+    }
+    while (!prefixEntry && path[currentFileNameStartPos + currentFileNameLength] != '\0') {
         PathParseRBTreeNode target;
         target.name = palloc(currentFileNameLength + 1);
         memcpy(target.name, path + currentFileNameStartPos, currentFileNameLength);
@@ -177,6 +279,8 @@ CuckooErrorCode PathParseTreeInsert(PathParseTree root,
             ++currentFileNameLength;
         currentNode = node;
     }
+    if (usePrefixCache && prefixLength > 0 && !prefixEntry)
+        PathParsePrefixCacheSearch(path, prefixLength, HASH_ENTER)->node = currentNode;
     if (parentId != NULL)
         *parentId = currentNode->inodeId;
     if (fileName != NULL) {
@@ -80,7 +80,9 @@ CuckooErrorCode Connection::ProcessRequest(cuckoo::meta_proto::MetaServiceType p
     request.add_type(proto_type);
     if (proto_type == cuckoo::meta_proto::MKDIR || proto_type == cuckoo::meta_proto::CREATE ||
         proto_type == cuckoo::meta_proto::STAT || proto_type == cuckoo::meta_proto::OPEN ||
-        proto_type == cuckoo::meta_proto::CLOSE || proto_type == cuckoo::meta_proto::UNLINK) {
+        proto_type == cuckoo::meta_proto::CLOSE || proto_type == cuckoo::meta_proto::UNLINK ||
+        proto_type == cuckoo::meta_proto::OPENDIR || proto_type == cuckoo::meta_proto::UTIMENS ||
+        proto_type == cuckoo::meta_proto::CHOWN || proto_type == cuckoo::meta_proto::CHMOD) {
         request.set_allow_batch_with_others(ALLOW_BATCH_WITH_OTHERS);
     }
     brpc::Controller cntl;
@@ -90,7 +92,7 @@ CuckooErrorCode Connection::ProcessRequest(cuckoo::meta_proto::MetaServiceType p
                                                BrpcDummyDeleter);
 
     // 3. Send request
-    cuckoo::meta_proto::Empty dummyResponse;
+    cuckoo::meta_proto::MetaReply dummyResponse;
     stub.MetaCall(&cntl, &request, &dummyResponse, nullptr);
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << std::format("{}: Send request failed, error code = {}, error text = {}",
@@ -155,6 +157,117 @@ static timespec ConvertTimestampFromPGToUnix(uint64_t t)
     return res;
 }
 
+// Stat, Open and Create responses share the same attribute layout
+template <typename AttrResponse>
+static void FillStatFromResponse(const AttrResponse *response, struct stat *stbuf)
+{
+    stbuf->st_ino = response->st_ino();
+    stbuf->st_dev = response->st_dev();
+    stbuf->st_mode = response->st_mode();
+    stbuf->st_nlink = response->st_nlink();
+    stbuf->st_uid = response->st_uid();
+    stbuf->st_gid = response->st_gid();
+    stbuf->st_rdev = response->st_rdev();
+    stbuf->st_size = response->st_size();
+    stbuf->st_blksize = ST_BLKSIZE;
+    stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
+    stbuf->st_atim = ConvertTimestampFromPGToUnix(response->st_atim());
+    stbuf->st_mtim = ConvertTimestampFromPGToUnix(response->st_mtim());
+    stbuf->st_ctim = ConvertTimestampFromPGToUnix(response->st_ctim());
+}
+
+template <typename ParamBuilder, typename ItemHandler>
+CuckooErrorCode Connection::ProcessBatchRequest(cuckoo::meta_proto::MetaServiceType proto_type,
+                                                size_t count,
+                                                const ParamBuilder &paramBuilder,
+                                                ItemHandler itemHandler,
+                                                ConnectionCache *cache)
+{
+    if (count == 0)
+        return SUCCESS;
+    if (!cache)
+        cache = &ThreadLocalConnectionCache;
+
+    // 1. Prepare params, one serialized segment per item
+    SerializedDataClear(&cache->serializedDataBuffer);
+    auto type = ToFlatBuffersType(proto_type);
+    cuckoo::meta_proto::MetaRequest request;
+    for (size_t i = 0; i < count; ++i) {
+        cache->flatBufferBuilder.Clear();
+        auto param = paramBuilder(cache->flatBufferBuilder, i);
+        auto metaParam = cuckoo::meta_fbs::CreateMetaParam(cache->flatBufferBuilder, type, param.Union());
+        cache->flatBufferBuilder.Finish(metaParam);
+
+        char *p = SerializedDataApplyForSegment(&cache->serializedDataBuffer, cache->flatBufferBuilder.GetSize());
+        if (p == nullptr) {
+            CUCKOO_LOG(LOG_ERROR) << "apply for serialized segment failed.";
+            return PROGRAM_ERROR;
+        }
+        memcpy(p, cache->flatBufferBuilder.GetBufferPointer(), cache->flatBufferBuilder.GetSize());
+        request.add_type(proto_type);
+    }
+
+    // 2. Construct request, items of the same type can be merged with other clients' batches
+    request.set_allow_batch_with_others(ALLOW_BATCH_WITH_OTHERS);
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(10000);
+    cntl.request_attachment().append_user_data(cache->serializedDataBuffer.buffer,
+                                               cache->serializedDataBuffer.size,
+                                               BrpcDummyDeleter);
+
+    // 3. Send request
+    cuckoo::meta_proto::MetaReply reply;
+    stub.MetaCall(&cntl, &request, &reply, nullptr);
+    if (cntl.Failed()) {
+        CUCKOO_LOG(LOG_ERROR) << std::format("{}: Send request failed, error code = {}, error text = {}",
+                                             __func__,
+                                             cntl.ErrorCode(),
+                                             cntl.ErrorText());
+
+        if (cntl.ErrorCode() == brpc::ELOGOFF || cntl.ErrorCode() == EHOSTDOWN) {
+            return SERVER_FAULT;
+        } else {
+            return REMOTE_QUERY_FAILED;
+        }
+    }
+
+    // 4. Parse response, one reply per item unless the whole call failed
+    if (reply.error_code() != SUCCESS) {
+        CUCKOO_LOG(LOG_ERROR) << "batch meta call failed, error code = " << reply.error_code();
+        return reply.error_code() < LAST_CUCKOO_ERROR_CODE ? (CuckooErrorCode)reply.error_code() : PROGRAM_ERROR;
+    }
+    size_t responseBufferSize = cntl.response_attachment().size();
+    std::unique_ptr<char[]> tempBuffer = std::make_unique<char[]>(responseBufferSize);
+    cntl.response_attachment().cutn(tempBuffer.get(), responseBufferSize);
+    SerializedData response;
+    SerializedDataInit(&response, tempBuffer.get(), responseBufferSize, responseBufferSize, nullptr);
+
+    sd_size_t offset = 0;
+    for (size_t i = 0; i < count; ++i) {
+        sd_size_t responseSize = SerializedDataNextSeveralItemSize(&response, offset, 1);
+        if (responseSize == (sd_size_t)-1) {
+            CUCKOO_LOG(LOG_ERROR) << "returned data is corrupt.";
+            return REMOTE_QUERY_FAILED;
+        }
+
+        uint8_t *item = (uint8_t *)response.buffer + offset + SERIALIZED_DATA_ALIGNMENT;
+        flatbuffers::Verifier verifier(item, responseSize - SERIALIZED_DATA_ALIGNMENT);
+        if (!verifier.VerifyBuffer<cuckoo::meta_fbs::MetaResponse>()) {
+            CUCKOO_LOG(LOG_ERROR) << "Meta response is corrupt.";
+            return REMOTE_QUERY_FAILED;
+        }
+        auto metaResponse = cuckoo::meta_fbs::GetMetaResponse(item);
+        offset += responseSize;
+
+        CuckooErrorCode errorCode = metaResponse->error_code() < LAST_CUCKOO_ERROR_CODE
+                                        ? (CuckooErrorCode)metaResponse->error_code()
+                                        : PROGRAM_ERROR;
+        itemHandler(i, metaResponse, errorCode);
+    }
+
+    return SUCCESS;
+}
+
 CuckooErrorCode Connection::PlainCommand(const char *command, PlainCommandResult &result, ConnectionCache *cache)
 {
     auto paramBuilder = [command](flatbuffers::FlatBufferBuilder &builder) {
@@ -202,19 +315,7 @@ Connection::Create(const char *path, uint64_t &inodeId, int32_t &nodeId, struct
         nodeId = createResponse->node_id();
 
         if (stbuf) {
-            stbuf->st_ino = createResponse->st_ino();
-            stbuf->st_dev = createResponse->st_dev();
-            stbuf->st_mode = createResponse->st_mode();
-            stbuf->st_nlink = createResponse->st_nlink();
-            stbuf->st_uid = createResponse->st_uid();
-            stbuf->st_gid = createResponse->st_gid();
-            stbuf->st_rdev = createResponse->st_rdev();
-            stbuf->st_size = createResponse->st_size();
-            stbuf->st_blksize = ST_BLKSIZE;
-            stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
-            stbuf->st_atim = ConvertTimestampFromPGToUnix(createResponse->st_atim());
-            stbuf->st_mtim = ConvertTimestampFromPGToUnix(createResponse->st_mtim());
-            stbuf->st_ctim = ConvertTimestampFromPGToUnix(createResponse->st_ctim());
+            FillStatFromResponse(createResponse, stbuf);
         }
 
         return (CuckooErrorCode)metaResponse->error_code();
@@ -236,19 +337,7 @@ CuckooErrorCode Connection::Stat(const char *path, struct stat *stbuf, Connectio
 
         auto statResponse = metaResponse->response_as_StatResponse();
         if (stbuf) {
-            stbuf->st_ino = statResponse->st_ino();
-            stbuf->st_dev = statResponse->st_dev();
-            stbuf->st_mode = statResponse->st_mode();
-            stbuf->st_nlink = statResponse->st_nlink();
-            stbuf->st_uid = statResponse->st_uid();
-            stbuf->st_gid = statResponse->st_gid();
-            stbuf->st_rdev = statResponse->st_rdev();
-            stbuf->st_size = statResponse->st_size();
-            stbuf->st_blksize = ST_BLKSIZE;
-            stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
-            stbuf->st_atim = ConvertTimestampFromPGToUnix(statResponse->st_atim());
-            stbuf->st_mtim = ConvertTimestampFromPGToUnix(statResponse->st_mtim());
-            stbuf->st_ctim = ConvertTimestampFromPGToUnix(statResponse->st_ctim());
+            FillStatFromResponse(statResponse, stbuf);
         }
         return (CuckooErrorCode)metaResponse->error_code();
     };
@@ -279,19 +368,7 @@ CuckooErrorCode Connection::Open(const char *path,
         nodeId = openResponse->node_id();
 
         if (stbuf) {
-            stbuf->st_ino = openResponse->st_ino();
-            stbuf->st_dev = openResponse->st_dev();
-            stbuf->st_mode = openResponse->st_mode();
-            stbuf->st_nlink = openResponse->st_nlink();
-            stbuf->st_uid = openResponse->st_uid();
-            stbuf->st_gid = openResponse->st_gid();
-            stbuf->st_rdev = openResponse->st_rdev();
-            stbuf->st_size = openResponse->st_size();
-            stbuf->st_blksize = ST_BLKSIZE;
-            stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
-            stbuf->st_atim = ConvertTimestampFromPGToUnix(openResponse->st_atim());
-            stbuf->st_mtim = ConvertTimestampFromPGToUnix(openResponse->st_mtim());
-            stbuf->st_ctim = ConvertTimestampFromPGToUnix(openResponse->st_ctim());
+            FillStatFromResponse(openResponse, stbuf);
         }
 
         return (CuckooErrorCode)metaResponse->error_code();
@@ -455,3 +532,114 @@ CuckooErrorCode Connection::Chmod(const char *path, uint32_t mode, ConnectionCac
 
     return ProcessRequest(cuckoo::meta_proto::CHMOD, paramBuilder, responseHandler, cache);
 }
+
+CuckooErrorCode
+Connection::BatchStat(const std::vector<std::string> &paths, std::vector<BatchStatResult> &results, ConnectionCache *cache)
+{
+    results.assign(paths.size(), BatchStatResult{});
+    for (auto &result : results) {
+        result.errorCode = REMOTE_QUERY_FAILED;
+    }
+
+    auto paramBuilder = [&paths](flatbuffers::FlatBufferBuilder &builder, size_t i) {
+        return cuckoo::meta_fbs::CreatePathOnlyParamDirect(builder, paths[i].c_str());
+    };
+
+    auto itemHandler = [&results](size_t i, const cuckoo::meta_fbs::MetaResponse *metaResponse,
+                                  CuckooErrorCode errorCode) {
+        results[i].errorCode = errorCode;
+        if (errorCode != SUCCESS) {
+            return;
+        }
+        if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_StatResponse) {
+            results[i].errorCode = PROGRAM_ERROR;
+            return;
+        }
+        FillStatFromResponse(metaResponse->response_as_StatResponse(), &results[i].stbuf);
+    };
+
+    return ProcessBatchRequest(cuckoo::meta_proto::STAT, paths.size(), paramBuilder, itemHandler, cache);
+}
+
+CuckooErrorCode
+Connection::BatchOpen(const std::vector<std::string> &paths, std::vector<BatchOpenResult> &results, ConnectionCache *cache)
+{
+    results.assign(paths.size(), BatchOpenResult{});
+    for (auto &result : results) {
+        result.errorCode = REMOTE_QUERY_FAILED;
+    }
+
+    auto paramBuilder = [&paths](flatbuffers::FlatBufferBuilder &builder, size_t i) {
+        return cuckoo::meta_fbs::CreatePathOnlyParamDirect(builder, paths[i].c_str());
+    };
+
+    auto itemHandler = [&results](size_t i, const cuckoo::meta_fbs::MetaResponse *metaResponse,
+                                  CuckooErrorCode errorCode) {
+        results[i].errorCode = errorCode;
+        if (errorCode != SUCCESS) {
+            return;
+        }
+        if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_OpenResponse) {
+            results[i].errorCode = PROGRAM_ERROR;
+            return;
+        }
+        auto openResponse = metaResponse->response_as_OpenResponse();
+        results[i].inodeId = openResponse->st_ino();
+        results[i].size = openResponse->st_size();
+        results[i].nodeId = openResponse->node_id();
+        FillStatFromResponse(openResponse, &results[i].stbuf);
+    };
+
+    return ProcessBatchRequest(cuckoo::meta_proto::OPEN, paths.size(), paramBuilder, itemHandler, cache);
+}
+
+CuckooErrorCode Connection::BatchCreate(const std::vector<std::string> &paths,
+                                        std::vector<BatchCreateResult> &results,
+                                        ConnectionCache *cache)
+{
+    results.assign(paths.size(), BatchCreateResult{});
+    for (auto &result : results) {
+        result.errorCode = REMOTE_QUERY_FAILED;
+    }
+
+    auto paramBuilder = [&paths](flatbuffers::FlatBufferBuilder &builder, size_t i) {
+        return cuckoo::meta_fbs::CreatePathOnlyParamDirect(builder, paths[i].c_str());
+    };
+
+    auto itemHandler = [&results](size_t i, const cuckoo::meta_fbs::MetaResponse *metaResponse,
+                                  CuckooErrorCode errorCode) {
+        results[i].errorCode = errorCode;
+        if (errorCode != SUCCESS) {
+            return;
+        }
+        if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_CreateResponse) {
+            results[i].errorCode = PROGRAM_ERROR;
+            return;
+        }
+        auto createResponse = metaResponse->response_as_CreateResponse();
+        results[i].inodeId = createResponse->st_ino();
+        results[i].nodeId = createResponse->node_id();
+        FillStatFromResponse(createResponse, &results[i].stbuf);
+    };
+
+    return ProcessBatchRequest(cuckoo::meta_proto::CREATE, paths.size(), paramBuilder, itemHandler, cache);
+}
+
+CuckooErrorCode Connection::BatchClose(const std::vector<std::string> &paths,
+                                       const std::vector<int64_t> &sizes,
+                                       const std::vector<int32_t> &nodeIds,
+                                       std::vector<BatchCloseResult> &results,
+                                       ConnectionCache *cache)
+{
+    results.assign(paths.size(), BatchCloseResult{REMOTE_QUERY_FAILED});
+
+    auto paramBuilder = [&paths, &sizes, &nodeIds](flatbuffers::FlatBufferBuilder &builder, size_t i) {
+        return cuckoo::meta_fbs::CreateCloseParamDirect(builder, paths[i].c_str(), sizes[i], 0, nodeIds[i]);
+    };
+
+    auto itemHandler = [&results](size_t i, const cuckoo::meta_fbs::MetaResponse *, CuckooErrorCode errorCode) {
+        results[i].errorCode = errorCode;
+    };
+
+    return ProcessBatchRequest(cuckoo::meta_proto::CLOSE, paths.size(), paramBuilder, itemHandler, cache);
+}
@@ -4,29 +4,50 @@
 
 #include "cuckoo_meta.h"
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <mutex>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include <sys/stat.h>
 #include <sys/time.h>
 
 #include "buffer/dir_open_instance.h"
 #include "cm/cuckoo_cm.h"
+#include "conf/cuckoo_property_key.h"
 #include "cuckoo_store/cuckoo_store.h"
+#include "init/cuckoo_init.h"
 #include "inner_cuckoo_meta.h"
+#include "placement_cache.h"
 #include "router.h"
+#include "stat_cache.h"
+#include "stats/cuckoo_stats.h"
 #include "utils.h"
 
 constexpr int FILE_NUMBER_PER_EPOCH = 1048576;
 constexpr int FILE_NUMBER_PER_WORKER = 4096;
+constexpr size_t BATCH_META_MAX_PATHS = 256;
 
 std::shared_ptr<Router> router;
 
+static void InitStatCache()
+{
+    auto &config = GetInit().GetCuckooConfig();
+    if (config == nullptr) {
+        return;
+    }
+    StatCache::GetInstance().Init(config->GetUint32(CuckooPropertyKey::CUCKOO_STAT_CACHE_CAPACITY),
+                                  config->GetUint32(CuckooPropertyKey::CUCKOO_STAT_CACHE_LEASE_MS));
+    PlacementCache::GetInstance().Init(config->GetUint32(CuckooPropertyKey::CUCKOO_PLACEMENT_CACHE_CAPACITY));
+}
+
 int CuckooInit(std::string &coordinatorIp, int coordinatorPort)
 {
     int ret = CuckooStore::GetInstance()->GetInitStatus();
@@ -35,6 +56,7 @@ int CuckooInit(std::string &coordinatorIp, int coordinatorPort)
     }
     ServerIdentifier coordinator(coordinatorIp, coordinatorPort);
     router = std::make_shared<Router>(coordinator);
+    InitStatCache();
     return 0;
 }
 
@@ -64,6 +86,7 @@ int CuckooInitWithZK(std::string zkEndPoint, const std::string &zkPath)
     }
     ServerIdentifier coordinator(coordinatorIp, coordinatorPort);
     router = std::make_shared<Router>(coordinator);
+    InitStatCache();
     return 0;
 }
 
@@ -85,6 +108,7 @@ int CuckooMkdir(const std::string &path)
         errorCode = conn->Mkdir(path.c_str());
     }
 #endif
+    StatCache::GetInstance().InvalidateParent(path);
     return errorCode;
 }
 
@@ -107,6 +131,8 @@ int CuckooCreate(const std::string &path, uint64_t &fd, int oflags, struct stat
         errorCode = conn->Create(path.c_str(), inodeId, nodeId, stbuf);
     }
 #endif
+    StatCache::GetInstance().Invalidate(path);
+    StatCache::GetInstance().InvalidateParent(path);
     if (errorCode == FILE_EXISTS && (oflags & O_EXCL))
         return FILE_EXISTS;
 
@@ -120,6 +146,16 @@ int CuckooCreate(const std::string &path, uint64_t &fd, int oflags, struct stat
 
 int CuckooGetStat(const std::string &path, struct stat *stbuf)
 {
+    StatCache &statCache = StatCache::GetInstance();
+    if (statCache.Enabled()) {
+        if (statCache.Get(path, stbuf)) {
+            CuckooStats::GetInstance().stats[META_STAT_CACHE_HIT].fetch_add(1);
+            return SUCCESS;
+        }
+        CuckooStats::GetInstance().stats[META_STAT_CACHE_MISS].fetch_add(1);
+    }
+    uint64_t generation = statCache.Generation(path);
+
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         CUCKOO_LOG(LOG_ERROR) << "route error";
@@ -135,9 +171,160 @@ int CuckooGetStat(const std::string &path, struct stat *stbuf)
         errorCode = conn->Stat(path.c_str(), stbuf);
     }
 #endif
+    if (errorCode == SUCCESS) {
+        statCache.Put(path, stbuf, generation);
+    }
     return errorCode;
 }
 
+/* small files are read whole at open */
+static bool ReadWholeAtOpen(int64_t size, int oflags)
+{
+    return size > 0 && size < READ_BIGFILE_SIZE && (oflags & O_ACCMODE) == O_RDONLY;
+}
+
+static std::shared_ptr<char> NewSmallReadBuffer(int64_t size, int oflags)
+{
+    if (oflags & __O_DIRECT) {
+        int alignedNum = size / 512 + int(size % 512 != 0);
+        return std::shared_ptr<char>((char *)aligned_alloc(512, 512 * alignedNum), free);
+    }
+    return std::shared_ptr<char>((char *)malloc(size), free);
+}
+
+/*
+ * fill the openInstance with fetched open meta, with the buffer of a small file to read whole at open,
+ * readBuffer is the content if already read
+ */
+static int FillOpenInstance(const std::string &path,
+                            int oflags,
+                            std::shared_ptr<OpenInstance> openInstance,
+                            uint64_t inodeId,
+                            int64_t size,
+                            int32_t nodeId,
+                            bool &readSmall,
+                            std::shared_ptr<char> readBuffer = nullptr)
+{
+    openInstance->inodeId = inodeId;
+    openInstance->originalSize = size;
+    openInstance->currentSize = size;
+    openInstance->nodeId = nodeId;
+    openInstance->path = path;
+    openInstance->oflags = oflags;
+    PlacementCache::GetInstance().Put(path, Placement{inodeId, size, nodeId});
+
+    if (ReadWholeAtOpen(openInstance->originalSize, openInstance->oflags)) {
+        // For small files: read all when open
+        if (readBuffer == nullptr) {
+            readBuffer = NewSmallReadBuffer(openInstance->originalSize, openInstance->oflags);
+            if (readBuffer == nullptr) {
+                CUCKOO_LOG(LOG_ERROR) << "In CuckooOpen() malloc failed";
+                CuckooFd::GetInstance()->ReleaseOpenInstance();
+                return -ENOMEM;
+            }
+            readSmall = true;
+        }
+        openInstance->readBuffer = readBuffer;
+        openInstance->readBufferSize = openInstance->originalSize;
+    }
+    return 0;
+}
+
+/* fill the openInstance with fetched open meta, allocate fd and handle the small file read */
+static int AttachOpenInstance(const std::string &path,
+                              int oflags,
+                              std::shared_ptr<OpenInstance> openInstance,
+                              uint64_t inodeId,
+                              int64_t size,
+                              int32_t nodeId,
+                              uint64_t &fd,
+                              std::shared_ptr<char> readBuffer = nullptr)
+{
+    bool readSmall = false;
+    int ret = FillOpenInstance(path, oflags, openInstance, inodeId, size, nodeId, readSmall, readBuffer);
+    if (ret != 0) {
+        return ret;
+    }
+    if (readSmall) {
+        ret = InnerCuckooReadSmallFiles(openInstance.get());
+        if (ret < 0) {
+            CuckooFd::GetInstance()->ReleaseOpenInstance();
+            return ret;
+        }
+    }
+    fd = CuckooFd::GetInstance()->AttachFd(path, openInstance);
+    return 0;
+}
+
+/* a small file read at its cached placement while the open meta is fetched */
+struct SpeculativeRead
+{
+    Placement predicted;
+    OpenInstance instance;
+    std::atomic<bool> claimed = false; // by the pool task to run it, or by the open to skip it
+    std::mutex mutex;
+    std::condition_variable doneCV;
+    bool done = false;
+    int ret = 0;
+};
+
+/*
+ * Start reading a small file at its cached placement on the store thread pool, to overlap the store round trip
+ * with the meta open. The content is only used if the open reply confirms the placement.
+ */
+static std::shared_ptr<SpeculativeRead> StartSpeculativeRead(const std::string &path, int oflags)
+{
+    ThreadPool *pool = CuckooStore::GetInstance()->GetThreadPool();
+    Placement predicted{};
+    if (pool == nullptr || !PlacementCache::GetInstance().Get(path, predicted) || predicted.nodeId < 0 ||
+        !ReadWholeAtOpen(predicted.size, oflags)) {
+        return nullptr;
+    }
+    std::shared_ptr<char> buffer = NewSmallReadBuffer(predicted.size, oflags);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+    auto speculative = std::make_shared<SpeculativeRead>();
+    speculative->predicted = predicted;
+    OpenInstance &instance = speculative->instance;
+    instance.inodeId = predicted.inodeId;
+    instance.originalSize = predicted.size;
+    instance.currentSize = predicted.size;
+    instance.nodeId = predicted.nodeId;
+    instance.path = path;
+    instance.oflags = oflags;
+    instance.readBuffer = buffer;
+    instance.readBufferSize = predicted.size;
+    /* the task keeps the state alive, the open may give up on it */
+    int ret = pool->TrySubmit({.taskName = "speculative read", .task = [speculative]() {
+                                   if (speculative->claimed.exchange(true)) {
+                                       return;
+                                   }
+                                   int readRet = InnerCuckooReadSmallFileSpeculative(&speculative->instance);
+                                   std::lock_guard<std::mutex> lock(speculative->mutex);
+                                   speculative->ret = readRet;
+                                   speculative->done = true;
+                                   speculative->doneCV.notify_all();
+                               }});
+    return ret == 0 ? speculative : nullptr;
+}
+
+/* the content read ahead if the open reply confirms its placement, the read is skipped if not started yet */
+static std::shared_ptr<char> FinishSpeculativeRead(SpeculativeRead &speculative,
+                                                   uint64_t inodeId,
+                                                   int64_t size,
+                                                   int32_t nodeId)
+{
+    const Placement &predicted = speculative.predicted;
+    bool confirmed = inodeId == predicted.inodeId && size == predicted.size && nodeId == predicted.nodeId;
+    if (!speculative.claimed.exchange(true) || !confirmed) {
+        return nullptr;
+    }
+    std::unique_lock<std::mutex> lock(speculative.mutex);
+    speculative.doneCV.wait(lock, [&speculative]() { return speculative.done; });
+    return speculative.ret == 0 ? speculative.instance.readBuffer : nullptr;
+}
+
 int CuckooOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *stbuf)
 {
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
@@ -151,6 +338,8 @@ int CuckooOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *s
         CUCKOO_LOG(LOG_ERROR) << "new openInstance failed";
         return -ENOMEM;
     }
+    std::shared_ptr<SpeculativeRead> speculative = StartSpeculativeRead(path, oflags);
+
     uint64_t inodeId = 0;
     int64_t size = 0;
     int32_t nodeId = 0;
@@ -164,43 +353,330 @@ int CuckooOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *s
         errorCode = conn->Open(path.c_str(), inodeId, size, nodeId, stbuf);
     }
 #endif
-    openInstance->inodeId = inodeId;
-    openInstance->originalSize = size;
-    openInstance->currentSize = size;
-    openInstance->nodeId = nodeId;
-    openInstance->path = path;
-    openInstance->oflags = oflags;
-
     /******************* Fetch open meta finish ************************/
 
-    /* allocate fd and handle the small file read */
+    std::shared_ptr<char> readBuffer;
+    if (speculative != nullptr) {
+        if (errorCode == SUCCESS) {
+            readBuffer = FinishSpeculativeRead(*speculative, inodeId, size, nodeId);
+        } else {
+            speculative->claimed.store(true);
+        }
+        CuckooStats::GetInstance().stats[readBuffer != nullptr ? META_OPEN_SPECULATE_HIT : META_OPEN_SPECULATE_MISS]
+            .fetch_add(1);
+    }
     if (errorCode == SUCCESS) {
-        if (openInstance->originalSize > 0 && openInstance->originalSize < READ_BIGFILE_SIZE &&
-            (openInstance->oflags & O_ACCMODE) == O_RDONLY) {
-            // For small files: read all when open
-            std::shared_ptr<char> buffer;
-            if (openInstance->oflags & __O_DIRECT) {
-                int alignedNum = openInstance->originalSize / 512 + int(openInstance->originalSize % 512 != 0);
-                buffer = std::shared_ptr<char>((char *)aligned_alloc(512, 512 * alignedNum), free);
-            } else {
-                buffer = std::shared_ptr<char>((char *)malloc(openInstance->originalSize), free);
+        int ret = AttachOpenInstance(path, oflags, openInstance, inodeId, size, nodeId, fd, readBuffer);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    return errorCode;
+}
+
+/*
+ * Group paths by the worker owning them and issue one batch request per worker (split every
+ * BATCH_META_MAX_PATHS), workers are requested concurrently on the store thread pool.
+ * batchCall(conn, subIndexes, subPaths, subResults) performs the rpc for paths[subIndexes[k]], results[i] holds
+ * the outcome of paths[i].
+ */
+template <typename Result, typename BatchCall>
+static int BatchCallOnWorkers(const std::vector<std::string> &paths,
+                              const std::vector<size_t> &indexes,
+                              std::vector<Result> &results,
+                              BatchCall batchCall)
+{
+    std::unordered_map<std::shared_ptr<Connection>, std::vector<size_t>> groups;
+    for (size_t idx : indexes) {
+        std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(paths[idx]);
+        if (!conn) {
+            CUCKOO_LOG(LOG_ERROR) << "route error";
+            return PROGRAM_ERROR;
+        }
+        groups[conn].push_back(idx);
+    }
+
+    auto runGroup = [&paths, &results, &batchCall](std::shared_ptr<Connection> conn,
+                                                   const std::vector<size_t> &group) {
+        for (size_t start = 0; start < group.size(); start += BATCH_META_MAX_PATHS) {
+            size_t end = std::min(group.size(), start + BATCH_META_MAX_PATHS);
+            std::vector<size_t> subIndexes(group.begin() + start, group.begin() + end);
+            std::vector<std::string> subPaths;
+            subPaths.reserve(end - start);
+            for (size_t i = start; i < end; ++i) {
+                subPaths.push_back(paths[group[i]]);
             }
-            if (buffer == nullptr) {
-                CUCKOO_LOG(LOG_ERROR) << "In CuckooOpen() malloc failed";
-                CuckooFd::GetInstance()->ReleaseOpenInstance();
-                return -ENOMEM;
+            std::vector<Result> subResults;
+            int errorCode = batchCall(conn, subIndexes, subPaths, subResults);
+#ifdef ZK_INIT
+            int cnt = 0;
+            while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+                ++cnt;
+                sleep(SLEEPTIME);
+                conn = router->TryToUpdateWorkerConn(conn);
+                errorCode = batchCall(conn, subIndexes, subPaths, subResults);
             }
-            openInstance->readBuffer = buffer;
-            openInstance->readBufferSize = openInstance->originalSize;
-            int ret = InnerCuckooReadSmallFiles(openInstance.get());
-            if (ret < 0) {
-                CuckooFd::GetInstance()->ReleaseOpenInstance();
-                return ret;
+#endif
+            for (size_t i = start; i < end; ++i) {
+                if (errorCode == SUCCESS) {
+                    results[group[i]] = subResults[i - start];
+                } else {
+                    results[group[i]].errorCode = (CuckooErrorCode)errorCode;
+                }
             }
         }
-        fd = CuckooFd::GetInstance()->AttachFd(path, openInstance);
+    };
+
+    std::vector<std::function<void()>> tasks;
+    for (auto &[conn, group] : groups) {
+        tasks.emplace_back([&runGroup, conn, &group]() { runGroup(conn, group); });
     }
-    return errorCode;
+    ThreadPool *pool = CuckooStore::GetInstance()->GetThreadPool();
+    if (pool == nullptr) {
+        for (auto &task : tasks) {
+            task();
+        }
+    } else {
+        pool->RunAndWait(tasks);
+    }
+    return SUCCESS;
+}
+
+int CuckooBatchStat(const std::vector<std::string> &paths,
+                    std::vector<struct stat> &stbufs,
+                    std::vector<int> &errorCodes)
+{
+    stbufs.assign(paths.size(), {});
+    errorCodes.assign(paths.size(), SUCCESS);
+
+    StatCache &statCache = StatCache::GetInstance();
+    std::vector<size_t> missIndexes;
+    std::vector<uint64_t> generations(paths.size(), 0);
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (statCache.Enabled()) {
+            if (statCache.Get(paths[i], &stbufs[i])) {
+                CuckooStats::GetInstance().stats[META_STAT_CACHE_HIT].fetch_add(1);
+                continue;
+            }
+            CuckooStats::GetInstance().stats[META_STAT_CACHE_MISS].fetch_add(1);
+            generations[i] = statCache.Generation(paths[i]);
+        }
+        missIndexes.push_back(i);
+    }
+
+    std::vector<Connection::BatchStatResult> results(paths.size());
+    int ret = BatchCallOnWorkers(paths,
+                                 missIndexes,
+                                 results,
+                                 [](std::shared_ptr<Connection> &conn,
+                                    const std::vector<size_t> & /*subIndexes*/,
+                                    const std::vector<std::string> &subPaths,
+                                    std::vector<Connection::BatchStatResult> &subResults) {
+                                     return conn->BatchStat(subPaths, subResults);
+                                 });
+    if (ret != SUCCESS) {
+        return ret;
+    }
+
+    for (size_t idx : missIndexes) {
+        errorCodes[idx] = results[idx].errorCode;
+        if (results[idx].errorCode == SUCCESS) {
+            stbufs[idx] = results[idx].stbuf;
+            statCache.Put(paths[idx], &stbufs[idx], generations[idx]);
+        }
+    }
+    return SUCCESS;
+}
+
+int CuckooBatchOpen(const std::vector<std::string> &paths,
+                    int oflags,
+                    std::vector<uint64_t> &fds,
+                    std::vector<struct stat> &stbufs,
+                    std::vector<int> &errorCodes)
+{
+    fds.assign(paths.size(), UINT64_MAX);
+    stbufs.assign(paths.size(), {});
+    errorCodes.assign(paths.size(), SUCCESS);
+
+    std::vector<size_t> indexes(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        indexes[i] = i;
+    }
+    std::vector<Connection::BatchOpenResult> results(paths.size());
+    int ret = BatchCallOnWorkers(paths,
+                                 indexes,
+                                 results,
+                                 [](std::shared_ptr<Connection> &conn,
+                                    const std::vector<size_t> & /*subIndexes*/,
+                                    const std::vector<std::string> &subPaths,
+                                    std::vector<Connection::BatchOpenResult> &subResults) {
+                                     return conn->BatchOpen(subPaths, subResults);
+                                 });
+    if (ret != SUCCESS) {
+        return ret;
+    }
+
+    /* small files are read together, with one rpc per store node */
+    std::vector<std::shared_ptr<OpenInstance>> openInstances(paths.size());
+    std::vector<OpenInstance *> toRead;
+    std::vector<size_t> toReadIndexes;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        errorCodes[i] = results[i].errorCode;
+        if (results[i].errorCode != SUCCESS) {
+            continue;
+        }
+        stbufs[i] = results[i].stbuf;
+        std::shared_ptr<OpenInstance> openInstance = CuckooFd::GetInstance()->WaitGetNewOpenInstance();
+        if (openInstance == nullptr) {
+            CUCKOO_LOG(LOG_ERROR) << "new openInstance failed";
+            errorCodes[i] = -ENOMEM;
+            continue;
+        }
+        bool readSmall = false;
+        errorCodes[i] = FillOpenInstance(paths[i],
+                                         oflags,
+                                         openInstance,
+                                         results[i].inodeId,
+                                         results[i].size,
+                                         results[i].nodeId,
+                                         readSmall);
+        if (errorCodes[i] != SUCCESS) {
+            continue;
+        }
+        openInstances[i] = openInstance;
+        if (readSmall) {
+            toRead.push_back(openInstance.get());
+            toReadIndexes.push_back(i);
+        }
+    }
+
+    std::vector<int> readResults;
+    InnerCuckooReadSmallFilesBatch(toRead, readResults);
+    for (size_t k = 0; k < toReadIndexes.size(); ++k) {
+        if (readResults[k] < 0) {
+            errorCodes[toReadIndexes[k]] = readResults[k];
+            openInstances[toReadIndexes[k]] = nullptr;
+            CuckooFd::GetInstance()->ReleaseOpenInstance();
+        }
+    }
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (openInstances[i] != nullptr) {
+            fds[i] = CuckooFd::GetInstance()->AttachFd(paths[i], openInstances[i]);
+        }
+    }
+    return SUCCESS;
+}
+
+int CuckooBatchWrite(const std::vector<std::string> &paths,
+                     const std::vector<std::string_view> &datas,
+                     std::vector<int> &errorCodes)
+{
+    if (datas.size() != paths.size()) {
+        return -EINVAL;
+    }
+    errorCodes.assign(paths.size(), SUCCESS);
+
+    std::vector<size_t> indexes(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        indexes[i] = i;
+    }
+    std::vector<Connection::BatchCreateResult> created(paths.size());
+    int ret = BatchCallOnWorkers(paths,
+                                 indexes,
+                                 created,
+                                 [](std::shared_ptr<Connection> &conn,
+                                    const std::vector<size_t> & /*subIndexes*/,
+                                    const std::vector<std::string> &subPaths,
+                                    std::vector<Connection::BatchCreateResult> &subResults) {
+                                     return conn->BatchCreate(subPaths, subResults);
+                                 });
+    /* other sub batches may have created their entries even if one failed */
+    for (const auto &path : paths) {
+        StatCache::GetInstance().InvalidateParent(path);
+    }
+    if (ret != SUCCESS) {
+        return ret;
+    }
+
+    /* existing files are reported, never overwritten, empty files are done once created */
+    std::vector<std::shared_ptr<OpenInstance>> openInstances(paths.size());
+    std::vector<OpenInstance *> toWrite;
+    std::vector<std::string_view> toWriteDatas;
+    std::vector<size_t> toWriteIndexes;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        errorCodes[i] = created[i].errorCode;
+        if (created[i].errorCode != SUCCESS || datas[i].empty()) {
+            continue;
+        }
+        auto openInstance = std::make_shared<OpenInstance>();
+        openInstance->inodeId = created[i].inodeId;
+        openInstance->nodeId = created[i].nodeId;
+        openInstance->path = paths[i];
+        openInstance->oflags = O_WRONLY | O_CREAT;
+        openInstances[i] = openInstance;
+        toWrite.push_back(openInstance.get());
+        toWriteDatas.push_back(datas[i]);
+        toWriteIndexes.push_back(i);
+    }
+
+    std::vector<int> writeResults;
+    InnerCuckooWriteSmallFilesBatch(toWrite, toWriteDatas, writeResults);
+    /* a file created here but left without its data is removed, so a retry can create it again */
+    std::vector<size_t> unlinkIndexes;
+    std::vector<size_t> closeIndexes;
+    std::vector<int64_t> sizes(paths.size(), 0);
+    std::vector<int32_t> nodeIds(paths.size(), -1);
+    for (size_t k = 0; k < toWriteIndexes.size(); ++k) {
+        size_t i = toWriteIndexes[k];
+        if (writeResults[k] != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "In CuckooBatchWrite(): write " << paths[i] << " failed";
+            errorCodes[i] = writeResults[k];
+            unlinkIndexes.push_back(i);
+            continue;
+        }
+        /* the node may have been allocated or switched by the write */
+        sizes[i] = openInstances[i]->currentSize;
+        nodeIds[i] = openInstances[i]->nodeId;
+        closeIndexes.push_back(i);
+    }
+
+    std::vector<Connection::BatchCloseResult> closed(paths.size());
+    ret = BatchCallOnWorkers(paths,
+                             closeIndexes,
+                             closed,
+                             [&sizes, &nodeIds](std::shared_ptr<Connection> &conn,
+                                                const std::vector<size_t> &subIndexes,
+                                                const std::vector<std::string> &subPaths,
+                                                std::vector<Connection::BatchCloseResult> &subResults) {
+                                 std::vector<int64_t> subSizes;
+                                 std::vector<int32_t> subNodeIds;
+                                 for (size_t idx : subIndexes) {
+                                     subSizes.push_back(sizes[idx]);
+                                     subNodeIds.push_back(nodeIds[idx]);
+                                 }
+                                 return conn->BatchClose(subPaths, subSizes, subNodeIds, subResults);
+                             });
+    if (ret != SUCCESS) {
+        return ret;
+    }
+    for (size_t idx : closeIndexes) {
+        errorCodes[idx] = closed[idx].errorCode;
+        if (closed[idx].errorCode == SUCCESS) {
+            Placement placement{openInstances[idx]->inodeId, sizes[idx], nodeIds[idx]};
+            PlacementCache::GetInstance().Put(paths[idx], placement);
+        } else {
+            unlinkIndexes.push_back(idx);
+        }
+    }
+    for (size_t idx : unlinkIndexes) {
+        if (CuckooUnlink(paths[idx]) != SUCCESS) {
+            CUCKOO_LOG(LOG_ERROR) << "In CuckooBatchWrite(): remove " << paths[idx] << " after failed write failed";
+        }
+    }
+    for (const auto &path : paths) {
+        StatCache::GetInstance().Invalidate(path);
+    }
+    return SUCCESS;
 }
 
 int CuckooClose(const std::string &path, uint64_t fd, bool isFlush, int datasync)
@@ -251,6 +727,12 @@ int CuckooClose(const std::string &path, uint64_t fd, bool isFlush, int datasync
         errorCode = conn->Close(path.c_str(), size, 0, openInstance->nodeId);
     }
 #endif
+    StatCache::GetInstance().Invalidate(path);
+    if (errorCode == SUCCESS) {
+        PlacementCache::GetInstance().Put(path, Placement{openInstance->inodeId, (int64_t)size, openInstance->nodeId});
+    } else {
+        PlacementCache::GetInstance().Invalidate(path);
+    }
     openInstance->originalSize = size;
     if (!isFlush) {
         CuckooFd::GetInstance()->DeleteOpenInstance(fd);
@@ -279,6 +761,9 @@ int CuckooUnlink(const std::string &path)
         errorCode = conn->Unlink(path.c_str(), inodeId, size, nodeId);
     }
 #endif
+    StatCache::GetInstance().Invalidate(path);
+    StatCache::GetInstance().InvalidateParent(path);
+    PlacementCache::GetInstance().Invalidate(path);
     int ret = 0;
     if (errorCode == SUCCESS) {
         // delete data
@@ -451,6 +936,9 @@ int CuckooRmDir(const std::string &path)
         errorCode = conn->Rmdir(path.c_str());
     }
 #endif
+    StatCache::GetInstance().InvalidateTree(path);
+    StatCache::GetInstance().InvalidateParent(path);
+    PlacementCache::GetInstance().InvalidateTree(path);
 
     return errorCode;
 }
@@ -500,11 +988,22 @@ int CuckooRename(const std::string &srcName, const std::string &dstName)
         errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
     }
 #endif
+    StatCache::GetInstance().InvalidateTree(srcName);
+    StatCache::GetInstance().InvalidateTree(dstName);
+    StatCache::GetInstance().InvalidateParent(srcName);
+    StatCache::GetInstance().InvalidateParent(dstName);
+    PlacementCache::GetInstance().InvalidateTree(srcName);
+    PlacementCache::GetInstance().InvalidateTree(dstName);
     return errorCode;
 }
 
 int CuckooRenamePersist(const std::string &srcName, const std::string &dstName)
 {
+    // objects keyed by inode stay where they are, directories included
+    if (InnerCuckooRenameKeepsData()) {
+        return CuckooRename(srcName, dstName);
+    }
+
     struct stat stbuf;
     errno_t err = memset_s(&stbuf, sizeof(stbuf), 0, sizeof(stbuf));
     if (err != 0) {
@@ -522,7 +1021,7 @@ int CuckooRenamePersist(const std::string &srcName, const std::string &dstName)
         return -EOPNOTSUPP;
     }
     // first copy the data in obs
-    ret = InnerCuckooCopydata(srcName, dstName);
+    ret = InnerCuckooCopydata(srcName, dstName, stbuf.st_ino);
     if (ret != 0) {
         return ret;
     }
@@ -542,6 +1041,12 @@ int CuckooRenamePersist(const std::string &srcName, const std::string &dstName)
         errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
     }
 #endif
+    StatCache::GetInstance().InvalidateTree(srcName);
+    StatCache::GetInstance().InvalidateTree(dstName);
+    StatCache::GetInstance().InvalidateParent(srcName);
+    StatCache::GetInstance().InvalidateParent(dstName);
+    PlacementCache::GetInstance().InvalidateTree(srcName);
+    PlacementCache::GetInstance().InvalidateTree(dstName);
     if (errorCode == SUCCESS) {
         // delete src object
         InnerCuckooDeleteDataAfterRename(srcName);
@@ -581,6 +1086,7 @@ int CuckooUtimens(const std::string &path, int64_t accessTime, int64_t modifyTim
         errorCode = conn->UtimeNs(path.c_str(), accessTime, modifyTime);
     }
 #endif
+    StatCache::GetInstance().Invalidate(path);
     return errorCode;
 }
 
@@ -602,6 +1108,7 @@ int CuckooChown(const std::string &path, uid_t uid, gid_t gid)
         errorCode = conn->Chown(path.c_str(), uid, gid);
     }
 #endif
+    StatCache::GetInstance().Invalidate(path);
     return errorCode;
 }
 
@@ -623,6 +1130,7 @@ int CuckooChmod(const std::string &path, mode_t mode)
         errorCode = conn->Chmod(path.c_str(), mode);
     }
 #endif
+    StatCache::GetInstance().Invalidate(path);
     return errorCode;
 }
 
@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <sys/stat.h>
 
@@ -69,6 +70,12 @@ class Connection {
                                    ResponseHandler responseHandler,
                                    ConnectionCache *cache = nullptr,
                                    ResultType *result = nullptr);
+    template <typename ParamBuilder, typename ItemHandler>
+    CuckooErrorCode ProcessBatchRequest(cuckoo::meta_proto::MetaServiceType type,
+                                        size_t count,
+                                        const ParamBuilder &paramBuilder,
+                                        ItemHandler itemHandler,
+                                        ConnectionCache *cache = nullptr);
 
   public:
     ServerIdentifier server;
@@ -136,4 +143,49 @@ class Connection {
     CuckooErrorCode UtimeNs(const char *path, int64_t atime = -1, int64_t mtime = -1, ConnectionCache *cache = nullptr);
     CuckooErrorCode Chown(const char *path, uint32_t uid, uint32_t gid, ConnectionCache *cache = nullptr);
     CuckooErrorCode Chmod(const char *path, uint32_t mode, ConnectionCache *cache = nullptr);
+
+    // Batch interfaces send all paths in one request, the returned code only reflects the rpc itself,
+    // per-path status is in errorCode of each result.
+    struct BatchStatResult
+    {
+        CuckooErrorCode errorCode;
+        struct stat stbuf;
+    };
+    CuckooErrorCode BatchStat(const std::vector<std::string> &paths,
+                              std::vector<BatchStatResult> &results,
+                              ConnectionCache *cache = nullptr);
+
+    struct BatchOpenResult
+    {
+        CuckooErrorCode errorCode;
+        uint64_t inodeId;
+        int64_t size;
+        int32_t nodeId;
+        struct stat stbuf;
+    };
+    CuckooErrorCode BatchOpen(const std::vector<std::string> &paths,
+                              std::vector<BatchOpenResult> &results,
+                              ConnectionCache *cache = nullptr);
+
+    struct BatchCreateResult
+    {
+        CuckooErrorCode errorCode;
+        uint64_t inodeId;
+        int32_t nodeId;
+        struct stat stbuf;
+    };
+    CuckooErrorCode BatchCreate(const std::vector<std::string> &paths,
+                                std::vector<BatchCreateResult> &results,
+                                ConnectionCache *cache = nullptr);
+
+    struct BatchCloseResult
+    {
+        CuckooErrorCode errorCode;
+    };
+    // sizes[i] and nodeIds[i] are those of paths[i]
+    CuckooErrorCode BatchClose(const std::vector<std::string> &paths,
+                               const std::vector<int64_t> &sizes,
+                               const std::vector<int32_t> &nodeIds,
+                               std::vector<BatchCloseResult> &results,
+                               ConnectionCache *cache = nullptr);
 };
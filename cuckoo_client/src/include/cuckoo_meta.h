@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 #include <memory>
+#include <string_view>
+#include <vector>
 
 #include "router.h"
 
@@ -44,6 +46,24 @@ int CuckooCreate(const std::string &path, uint64_t &fd, int oflags, struct stat
 
 int CuckooOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *stbuf);
 
+// Fetch meta of many files with one request per worker, errorCodes[i] is the result of paths[i]
+int CuckooBatchStat(const std::vector<std::string> &paths, std::vector<struct stat> &stbufs, std::vector<int> &errorCodes);
+
+// Open many files with one meta request per worker, read-only small files are read into their buffers at once
+// with one request per store node, for a data loader to prefetch a list of files
+int CuckooBatchOpen(const std::vector<std::string> &paths,
+                    int oflags,
+                    std::vector<uint64_t> &fds,
+                    std::vector<struct stat> &stbufs,
+                    std::vector<int> &errorCodes);
+
+// Create new files with datas[i] as the whole content of paths[i], with one meta request per worker to create
+// and to close them and one data request per store node, for jobs writing many small files. A file whose data
+// could not be written is removed again, errorCodes[i] holds why
+int CuckooBatchWrite(const std::vector<std::string> &paths,
+                     const std::vector<std::string_view> &datas,
+                     std::vector<int> &errorCodes);
+
 int CuckooUnlink(const std::string &path);
 
 int CuckooOpenDir(const std::string &path, struct CuckooFuseInfo *fi);
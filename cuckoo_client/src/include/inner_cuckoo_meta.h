@@ -8,6 +8,8 @@
 #include <sys/statvfs.h>
 #include <sys/time.h>
 
+#include <string_view>
+
 #include "buffer/open_instance.h"
 
 struct BatchCreatePrams
@@ -27,8 +29,14 @@ int InnerCuckooRead(OpenInstance *openInstance, char *buffer, size_t size, off_t
 int InnerCuckooAsyncCopy(uint64_t inodeId, int &backupNodeId);
 
 int InnerCuckooReadSmallFiles(OpenInstance *openInstance);
+int InnerCuckooReadSmallFileSpeculative(OpenInstance *openInstance);
+void InnerCuckooReadSmallFilesBatch(const std::vector<OpenInstance *> &openInstances, std::vector<int> &results);
+void InnerCuckooWriteSmallFilesBatch(const std::vector<OpenInstance *> &openInstances,
+                                     const std::vector<std::string_view> &datas,
+                                     std::vector<int> &results);
 int InnerCuckooStatFS(struct statvfs *vfsbuf);
-int InnerCuckooCopydata(const std::string &srcName, const std::string &dstName);
+bool InnerCuckooRenameKeepsData();
+int InnerCuckooCopydata(const std::string &srcName, const std::string &dstName, uint64_t inodeId);
 int InnerCuckooDeleteDataAfterRename(const std::string &objectName);
 int InnerCuckooTruncateOpenInstance(OpenInstance *openInstance, off_t size);
 int InnerCuckooTruncateFile(OpenInstance *openInstance, off_t size);
@@ -0,0 +1,68 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct Placement
+{
+    uint64_t inodeId;
+    int64_t size;
+    int32_t nodeId;
+};
+
+/*
+ * Client side hint of where the data of a file is, keyed by full path and filled from open replies.
+ * Entries never expire: a hint is only used to start reading a small file concurrently with its meta
+ * open, and the read is dropped unless the open reply agrees, so a stale hint costs one wasted read.
+ */
+class PlacementCache {
+  public:
+    static PlacementCache &GetInstance()
+    {
+        static PlacementCache instance;
+        return instance;
+    }
+
+    // capacity == 0 disables the cache
+    void Init(size_t capacity);
+    bool Enabled() const { return enabled.load(std::memory_order_acquire); }
+
+    bool Get(const std::string &path, Placement &placement);
+    void Put(const std::string &path, const Placement &placement);
+    void Invalidate(const std::string &path);
+    // drop the directory itself and everything below it, used by rename/rmdir
+    void InvalidateTree(const std::string &dirPath);
+    void Clear();
+
+  private:
+    static constexpr size_t SHARD_NUM = 64;
+
+    struct CacheEntry
+    {
+        Placement placement;
+        std::list<std::string>::iterator lruIter;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<std::string> lruList; // front is the most recently used
+        std::unordered_map<std::string, CacheEntry> entries;
+    };
+
+    PlacementCache() = default;
+    Shard &GetShard(const std::string &path);
+    static void EraseLocked(Shard &shard, std::unordered_map<std::string, CacheEntry>::iterator it);
+
+    Shard shards[SHARD_NUM];
+    std::atomic<bool> enabled{false};
+    size_t shardCapacity = 0;
+};
@@ -0,0 +1,74 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+/*
+ * Client side attribute cache. Entries are keyed by full path and expire after a
+ * fixed lease, local namespace/attribute changes invalidate them eagerly.
+ * Only successful stat results are cached, lookups of missing files always go to meta.
+ * A stat fetched from meta is put with the generation taken before the request, so an invalidation
+ * that ran meanwhile keeps the older result out.
+ */
+class StatCache {
+  public:
+    static StatCache &GetInstance()
+    {
+        static StatCache instance;
+        return instance;
+    }
+
+    // capacity == 0 or leaseMs == 0 disables the cache
+    void Init(size_t capacity, uint32_t leaseMs);
+    bool Enabled() const { return enabled.load(std::memory_order_acquire); }
+
+    bool Get(const std::string &path, struct stat *stbuf);
+    // bumped by every invalidation of path, take it before fetching the stat to put
+    uint64_t Generation(const std::string &path);
+    // dropped if path was invalidated after generation was taken
+    void Put(const std::string &path, const struct stat *stbuf, uint64_t generation);
+    void Invalidate(const std::string &path);
+    // drop the directory itself and everything below it, used by rename/rmdir
+    void InvalidateTree(const std::string &dirPath);
+    // drop the parent directory of path, whose nlink/mtime change when an entry is added or removed
+    void InvalidateParent(const std::string &path);
+    void Clear();
+
+  private:
+    static constexpr size_t SHARD_NUM = 64;
+
+    struct CacheEntry
+    {
+        struct stat st;
+        std::chrono::steady_clock::time_point expireTime;
+        std::list<std::string>::iterator lruIter;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<std::string> lruList; // front is the most recently used
+        std::unordered_map<std::string, CacheEntry> entries;
+        uint64_t generation = 0; // per shard, an invalidation also holds back puts of its neighbours
+    };
+
+    StatCache() = default;
+    Shard &GetShard(const std::string &path);
+    static void EraseLocked(Shard &shard, std::unordered_map<std::string, CacheEntry>::iterator it);
+
+    Shard shards[SHARD_NUM];
+    std::atomic<bool> enabled{false};
+    size_t shardCapacity = 0;
+    std::chrono::milliseconds lease{0};
+};
@@ -26,11 +26,30 @@ int InnerCuckooReadSmallFiles(OpenInstance *openInstance)
     return CuckooStore::GetInstance()->ReadSmallFiles(openInstance);
 }
 
+int InnerCuckooReadSmallFileSpeculative(OpenInstance *openInstance)
+{
+    return CuckooStore::GetInstance()->ReadSmallFileSpeculative(openInstance);
+}
+
+void InnerCuckooReadSmallFilesBatch(const std::vector<OpenInstance *> &openInstances, std::vector<int> &results)
+{
+    CuckooStore::GetInstance()->ReadSmallFilesBatch(openInstances, results);
+}
+
+void InnerCuckooWriteSmallFilesBatch(const std::vector<OpenInstance *> &openInstances,
+                                     const std::vector<std::string_view> &datas,
+                                     std::vector<int> &results)
+{
+    CuckooStore::GetInstance()->WriteSmallFilesBatch(openInstances, datas, results);
+}
+
 int InnerCuckooStatFS(struct statvfs *vfsbuf) { return CuckooStore::GetInstance()->StatFS(vfsbuf); }
 
-int InnerCuckooCopydata(const std::string &srcName, const std::string &dstName)
+bool InnerCuckooRenameKeepsData() { return CuckooStore::GetInstance()->RenameKeepsData(); }
+
+int InnerCuckooCopydata(const std::string &srcName, const std::string &dstName, uint64_t inodeId)
 {
-    return CuckooStore::GetInstance()->CopyData(srcName, dstName);
+    return CuckooStore::GetInstance()->CopyData(srcName, dstName, inodeId);
 }
 
 int InnerCuckooDeleteDataAfterRename(const std::string &objectName)
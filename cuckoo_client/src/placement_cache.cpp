@@ -0,0 +1,108 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "placement_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+void PlacementCache::Init(size_t capacity)
+{
+    Clear();
+    if (capacity == 0) {
+        enabled.store(false, std::memory_order_release);
+        return;
+    }
+    shardCapacity = std::max<size_t>(1, (capacity + SHARD_NUM - 1) / SHARD_NUM);
+    enabled.store(true, std::memory_order_release);
+}
+
+PlacementCache::Shard &PlacementCache::GetShard(const std::string &path)
+{
+    return shards[std::hash<std::string>()(path) % SHARD_NUM];
+}
+
+void PlacementCache::EraseLocked(Shard &shard, std::unordered_map<std::string, CacheEntry>::iterator it)
+{
+    shard.lruList.erase(it->second.lruIter);
+    shard.entries.erase(it);
+}
+
+bool PlacementCache::Get(const std::string &path, Placement &placement)
+{
+    if (!Enabled()) {
+        return false;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    shard.lruList.splice(shard.lruList.begin(), shard.lruList, it->second.lruIter);
+    placement = it->second.placement;
+    return true;
+}
+
+void PlacementCache::Put(const std::string &path, const Placement &placement)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it != shard.entries.end()) {
+        it->second.placement = placement;
+        shard.lruList.splice(shard.lruList.begin(), shard.lruList, it->second.lruIter);
+        return;
+    }
+    while (shard.entries.size() >= shardCapacity && !shard.lruList.empty()) {
+        shard.entries.erase(shard.lruList.back());
+        shard.lruList.pop_back();
+    }
+    shard.lruList.push_front(path);
+    shard.entries.emplace(path, CacheEntry{placement, shard.lruList.begin()});
+}
+
+void PlacementCache::Invalidate(const std::string &path)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it != shard.entries.end()) {
+        EraseLocked(shard, it);
+    }
+}
+
+void PlacementCache::InvalidateTree(const std::string &dirPath)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Invalidate(dirPath);
+    std::string prefix = dirPath.ends_with('/') ? dirPath : dirPath + "/";
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            auto next = std::next(it);
+            if (it->first.starts_with(prefix)) {
+                EraseLocked(shard, it);
+            }
+            it = next;
+        }
+    }
+}
+
+void PlacementCache::Clear()
+{
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+        shard.lruList.clear();
+    }
+}
@@ -0,0 +1,145 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "stat_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+void StatCache::Init(size_t capacity, uint32_t leaseMs)
+{
+    Clear();
+    if (capacity == 0 || leaseMs == 0) {
+        enabled.store(false, std::memory_order_release);
+        return;
+    }
+    shardCapacity = std::max<size_t>(1, (capacity + SHARD_NUM - 1) / SHARD_NUM);
+    lease = std::chrono::milliseconds(leaseMs);
+    enabled.store(true, std::memory_order_release);
+}
+
+StatCache::Shard &StatCache::GetShard(const std::string &path)
+{
+    return shards[std::hash<std::string>()(path) % SHARD_NUM];
+}
+
+void StatCache::EraseLocked(Shard &shard, std::unordered_map<std::string, CacheEntry>::iterator it)
+{
+    shard.lruList.erase(it->second.lruIter);
+    shard.entries.erase(it);
+}
+
+bool StatCache::Get(const std::string &path, struct stat *stbuf)
+{
+    if (!Enabled()) {
+        return false;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    if (std::chrono::steady_clock::now() >= it->second.expireTime) {
+        EraseLocked(shard, it);
+        return false;
+    }
+    shard.lruList.splice(shard.lruList.begin(), shard.lruList, it->second.lruIter);
+    *stbuf = it->second.st;
+    return true;
+}
+
+uint64_t StatCache::Generation(const std::string &path)
+{
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.generation;
+}
+
+void StatCache::Put(const std::string &path, const struct stat *stbuf, uint64_t generation)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    auto expireTime = std::chrono::steady_clock::now() + lease;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.generation != generation) {
+        return;
+    }
+    auto it = shard.entries.find(path);
+    if (it != shard.entries.end()) {
+        it->second.st = *stbuf;
+        it->second.expireTime = expireTime;
+        shard.lruList.splice(shard.lruList.begin(), shard.lruList, it->second.lruIter);
+        return;
+    }
+    while (shard.entries.size() >= shardCapacity && !shard.lruList.empty()) {
+        shard.entries.erase(shard.lruList.back());
+        shard.lruList.pop_back();
+    }
+    shard.lruList.push_front(path);
+    shard.entries.emplace(path, CacheEntry{*stbuf, expireTime, shard.lruList.begin()});
+}
+
+void StatCache::Invalidate(const std::string &path)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.generation;
+    auto it = shard.entries.find(path);
+    if (it != shard.entries.end()) {
+        EraseLocked(shard, it);
+    }
+}
+
+void StatCache::InvalidateTree(const std::string &dirPath)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Invalidate(dirPath);
+    std::string prefix = dirPath.ends_with('/') ? dirPath : dirPath + "/";
+    // children are spread over all shards, rename/rmdir are rare enough to afford a full walk
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ++shard.generation;
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            auto next = std::next(it);
+            if (it->first.starts_with(prefix)) {
+                EraseLocked(shard, it);
+            }
+            it = next;
+        }
+    }
+}
+
+void StatCache::InvalidateParent(const std::string &path)
+{
+    if (!Enabled()) {
+        return;
+    }
+    std::string_view view(path);
+    while (view.size() > 1 && view.back() == '/') {
+        view.remove_suffix(1);
+    }
+    size_t slash = view.find_last_of('/');
+    if (slash == std::string_view::npos || view.size() <= 1) {
+        return;
+    }
+    Invalidate(std::string(view.substr(0, slash == 0 ? 1 : slash)));
+}
+
+void StatCache::Clear()
+{
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ++shard.generation;
+        shard.entries.clear();
+        shard.lruList.clear();
+    }
+}
@@ -154,14 +154,24 @@ void RemoteIOServiceImpl::ReadFile(google::protobuf::RpcController *cntl_base,
         return;
     }
 
-    char *buffer;
-    size_t allocSize = readSize;
-    if (openInstance->oflags & __O_DIRECT) {
-        allocSize = (readSize / ALIGNMENT + (readSize % ALIGNMENT != 0)) * ALIGNMENT;
-        buffer = static_cast<char *>(aligned_alloc(ALIGNMENT, allocSize));
-    } else {
-        buffer = static_cast<char *>(malloc(allocSize));
+    if (!(openInstance->oflags & __O_DIRECT)) {
+        /* pread straight into the response attachment */
+        ssize_t retSize = CuckooStore::GetInstance()->ReadFileLRForBrpc(openInstance.get(),
+                                                                       cntl->response_attachment(),
+                                                                       readSize,
+                                                                       offset);
+        if (retSize < 0) {
+            cntl->response_attachment().clear();
+            CUCKOO_LOG(LOG_ERROR) << "ReadFile rpc failed, fd = " << fd << ", error = " << retSize;
+            response->set_error_code(retSize);
+            return;
+        }
+        response->set_error_code(0);
+        return;
     }
+
+    size_t allocSize = (readSize / ALIGNMENT + (readSize % ALIGNMENT != 0)) * ALIGNMENT;
+    char *buffer = static_cast<char *>(aligned_alloc(ALIGNMENT, allocSize));
     if (buffer == nullptr) {
         CUCKOO_LOG(LOG_ERROR) << "Allocation failed for size " << allocSize;
         response->set_error_code(-ENOMEM);
@@ -193,6 +203,7 @@ void RemoteIOServiceImpl::ReadSmallFile(google::protobuf::RpcController *cntl_ba
     const std::string &path = request->path();
     int32_t oflags = request->oflags();
     bool nodeFail = request->node_fail();
+    bool cachedOnly = request->cached_only();
     CUCKOO_LOG(LOG_INFO) << "Receive ReadSmallFile rpc request, inode = " << inodeId << ", size = " << readSize;
 
     if (readSize < 0 || readSize > (int)READ_BIGFILE_SIZE) {
@@ -224,7 +235,13 @@ void RemoteIOServiceImpl::ReadSmallFile(google::protobuf::RpcController *cntl_ba
         return;
     }
 
-    int ret = CuckooStore::GetInstance()->ReadSmallFilesForBrpc(inodeId, path, buffer, readSize, oflags, nodeFail);
+    int ret = CuckooStore::GetInstance()->ReadSmallFilesForBrpc(inodeId,
+                                                                path,
+                                                                buffer,
+                                                                readSize,
+                                                                oflags,
+                                                                nodeFail,
+                                                                cachedOnly);
     if (ret < 0) {
         CUCKOO_LOG(LOG_ERROR) << "ReadSmallFile rpc failed, inodeId = " << inodeId << ", error = " << ret;
         response->set_error_code(ret);
@@ -239,6 +256,55 @@ void RemoteIOServiceImpl::ReadSmallFile(google::protobuf::RpcController *cntl_ba
     cntl->response_attachment().append_user_data(buffer, readSize, deleter);
 }
 
+void RemoteIOServiceImpl::ReadSmallFiles(google::protobuf::RpcController *cntl_base,
+                                         const ReadSmallFilesRequest *request,
+                                         ReadSmallFilesReply *response,
+                                         google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    auto *cntl = static_cast<brpc::Controller *>(cntl_base);
+
+    int fileNum = request->inode_id_size();
+    int32_t oflags = request->oflags();
+    CUCKOO_LOG(LOG_INFO) << "Receive ReadSmallFiles rpc request, files = " << fileNum;
+    if (request->path_size() != fileNum || request->read_size_size() != fileNum ||
+        request->node_fail_size() != fileNum) {
+        response->set_error_code(-EINVAL);
+        return;
+    }
+
+    butil::IOBuf &attachment = cntl->response_attachment();
+    for (int i = 0; i < fileNum; ++i) {
+        uint64_t inodeId = request->inode_id(i);
+        uint64_t readSize = request->read_size(i);
+        if (readSize == 0 || readSize > READ_BIGFILE_SIZE) {
+            response->add_error_codes(-EAGAIN);
+            continue;
+        }
+        char *buffer = static_cast<char *>(malloc(readSize));
+        if (buffer == nullptr) {
+            CUCKOO_LOG(LOG_ERROR) << "Allocation failed for size " << readSize;
+            response->add_error_codes(-ENOMEM);
+            continue;
+        }
+        int ret = CuckooStore::GetInstance()->ReadSmallFilesForBrpc(inodeId,
+                                                                    request->path(i),
+                                                                    buffer,
+                                                                    readSize,
+                                                                    oflags,
+                                                                    request->node_fail(i));
+        if (ret < 0) {
+            CUCKOO_LOG(LOG_ERROR) << "ReadSmallFiles rpc failed, inodeId = " << inodeId << ", error = " << ret;
+            free(buffer);
+            response->add_error_codes(ret);
+            continue;
+        }
+        response->add_error_codes(0);
+        attachment.append_user_data(buffer, readSize, [](void *buf) { free(buf); });
+    }
+    response->set_error_code(0);
+}
+
 void RemoteIOServiceImpl::WriteFile(google::protobuf::RpcController *cntl_base,
                                     const WriteRequest *request,
                                     WriteReply *response,
@@ -277,6 +343,42 @@ void RemoteIOServiceImpl::WriteFile(google::protobuf::RpcController *cntl_base,
     response->set_write_size(writeSize);
 }
 
+void RemoteIOServiceImpl::WriteSmallFiles(google::protobuf::RpcController *cntl_base,
+                                          const WriteSmallFilesRequest *request,
+                                          WriteSmallFilesReply *response,
+                                          google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    auto *cntl = static_cast<brpc::Controller *>(cntl_base);
+
+    int fileNum = request->inode_id_size();
+    CUCKOO_LOG(LOG_INFO) << "Receive WriteSmallFiles rpc request, files = " << fileNum;
+    butil::IOBuf &attachment = cntl->request_attachment();
+    uint64_t totalSize = 0;
+    for (int i = 0; i < request->write_size_size(); ++i) {
+        totalSize += request->write_size(i);
+    }
+    if (request->path_size() != fileNum || request->write_size_size() != fileNum ||
+        request->node_fail_size() != fileNum || totalSize != attachment.size()) {
+        response->set_error_code(-EINVAL);
+        return;
+    }
+
+    for (int i = 0; i < fileNum; ++i) {
+        butil::IOBuf data;
+        attachment.cutn(&data, request->write_size(i));
+        int ret = CuckooStore::GetInstance()->WriteSmallFileForBrpc(request->inode_id(i),
+                                                                    request->path(i),
+                                                                    data,
+                                                                    request->node_fail(i));
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "WriteSmallFiles rpc failed, path = " << request->path(i) << ", error = " << ret;
+        }
+        response->add_error_codes(ret);
+    }
+    response->set_error_code(0);
+}
+
 void RemoteIOServiceImpl::DeleteFile(google::protobuf::RpcController * /*cntl_base*/,
                                      const DeleteRequest *request,
                                      ErrorCodeOnlyReply *response,
@@ -97,10 +97,27 @@ int CuckooIOClient::CloseFile(uint64_t physicalFd,
     return 0;
 }
 
+// return positive: read length, return negative error of both network and IO
+int CuckooIOClient::ReadFile(uint64_t inodeId,
+                             int oflags,
+                             char *readBuffer,
+                             uint64_t &physicalFd,
+                             int bufferSize,
+                             off_t offset,
+                             const std::string &path)
+{
+    butil::IOBuf readBuf;
+    int retLen = ReadFile(inodeId, oflags, readBuf, physicalFd, bufferSize, offset, path);
+    if (retLen > 0) {
+        readBuf.cutn(readBuffer, retLen);
+    }
+    return retLen;
+}
+
 // return positive: read length, return negative error of both network and IO
 int CuckooIOClient::ReadFile(uint64_t /*inodeId*/,
                              int /*oflags*/,
-                             char *readBuffer,
+                             butil::IOBuf &readBuf,
                              uint64_t &physicalFd,
                              int bufferSize,
                              off_t offset,
@@ -133,7 +150,7 @@ int CuckooIOClient::ReadFile(uint64_t /*inodeId*/,
         return -EIO;
     }
 
-    cntl.response_attachment().cutn(readBuffer, retLen);
+    readBuf.swap(cntl.response_attachment());
     CUCKOO_LOG(LOG_INFO) << "In CuckooIOClient::ReadFile(): read file successfully! you have read: " << retLen
                          << " bytes";
     return retLen;
@@ -145,7 +162,8 @@ ssize_t CuckooIOClient::ReadSmallFile(uint64_t inodeId,
                                       std::string &path,
                                       char *readBuffer,
                                       int oflags,
-                                      bool nodeFail)
+                                      bool nodeFail,
+                                      bool cachedOnly)
 {
     cuckoo::brpc_io::ReadSmallFileRequest request;
     request.set_inode_id(inodeId);
@@ -153,6 +171,7 @@ ssize_t CuckooIOClient::ReadSmallFile(uint64_t inodeId,
     request.set_path(path);
     request.set_oflags(oflags);
     request.set_node_fail(nodeFail);
+    request.set_cached_only(cachedOnly);
     cuckoo::brpc_io::ErrorCodeOnlyReply response;
     brpc::Controller cntl;
     cntl.set_timeout_ms(10000);
@@ -181,6 +200,96 @@ ssize_t CuckooIOClient::ReadSmallFile(uint64_t inodeId,
     return 0;
 }
 
+// return 0: OK, result of each file set; return negative: remote IO error, return positive: network error
+int CuckooIOClient::ReadSmallFiles(std::vector<SmallFileRead> &files, int oflags)
+{
+    cuckoo::brpc_io::ReadSmallFilesRequest request;
+    for (auto &file : files) {
+        request.add_path(file.path);
+        request.add_inode_id(file.inodeId);
+        request.add_read_size(file.size);
+        request.add_node_fail(file.nodeFail);
+    }
+    request.set_oflags(oflags);
+    cuckoo::brpc_io::ReadSmallFilesReply response;
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(10000);
+
+    stub->ReadSmallFiles(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        CUCKOO_LOG(LOG_ERROR) << "Read small files by brpc failed " << cntl.ErrorText()
+                              << "error code: " << cntl.ErrorCode();
+        return BrpcErrorCodeToFuseErrno(cntl.ErrorCode()); // positive reply
+    }
+
+    if (response.error_code() != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "CuckooIOClient::ReadSmallFiles failed: " << strerror(-response.error_code());
+        return response.error_code();
+    }
+    if (response.error_codes_size() != (int)files.size()) {
+        CUCKOO_LOG(LOG_ERROR) << "Return files doesn't equal to requested.";
+        return -EIO;
+    }
+
+    butil::IOBuf &attachment = cntl.response_attachment();
+    for (size_t i = 0; i < files.size(); ++i) {
+        files[i].result = response.error_codes(i);
+        if (files[i].result != 0) {
+            continue;
+        }
+        if (attachment.cutn(files[i].buffer, files[i].size) != files[i].size) {
+            CUCKOO_LOG(LOG_ERROR) << "Return bytes doesn't equal to requested.";
+            return -EIO;
+        }
+    }
+    if (!attachment.empty()) {
+        CUCKOO_LOG(LOG_ERROR) << "Return bytes doesn't equal to requested.";
+        return -EIO;
+    }
+    CUCKOO_LOG(LOG_INFO) << "In CuckooIOClient::ReadSmallFiles(): read " << files.size() << " files";
+    return 0;
+}
+
+// return 0: OK with per-file results, return positive: network error, return negative: IO error
+int CuckooIOClient::WriteSmallFiles(std::vector<SmallFileWrite> &files)
+{
+    cuckoo::brpc_io::WriteSmallFilesRequest request;
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(10000);
+    auto dummyDeleter = [](void *) -> void {};
+    for (auto &file : files) {
+        request.add_path(file.path);
+        request.add_inode_id(file.inodeId);
+        request.add_write_size(file.data.size());
+        request.add_node_fail(file.nodeFail);
+        if (!file.data.empty()) {
+            cntl.request_attachment().append_user_data((void *)file.data.data(), file.data.size(), dummyDeleter);
+        }
+    }
+    cuckoo::brpc_io::WriteSmallFilesReply response;
+
+    stub->WriteSmallFiles(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        CUCKOO_LOG(LOG_ERROR) << "Write small files by brpc failed " << cntl.ErrorText()
+                              << "error code: " << cntl.ErrorCode();
+        return BrpcErrorCodeToFuseErrno(cntl.ErrorCode()); // positive reply
+    }
+
+    if (response.error_code() != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "CuckooIOClient::WriteSmallFiles failed: " << strerror(-response.error_code());
+        return response.error_code();
+    }
+    if (response.error_codes_size() != (int)files.size()) {
+        CUCKOO_LOG(LOG_ERROR) << "Return files doesn't equal to requested.";
+        return -EIO;
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+        files[i].result = response.error_codes(i);
+    }
+    CUCKOO_LOG(LOG_INFO) << "In CuckooIOClient::WriteSmallFiles(): wrote " << files.size() << " files";
+    return 0;
+}
+
 // return 0: OK, return negative: error of both network and IO
 int CuckooIOClient::WriteFile(uint64_t physicalFd, const char *writeBuffer, uint64_t size, off_t offset)
 {
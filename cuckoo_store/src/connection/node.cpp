@@ -34,10 +34,28 @@ void StoreNode::SetNodeConfig(int initNodeId, std::string &clusterView)
                               }
                               nodeMap.emplace(i, std::make_pair(rpcEndPoint, connection));
                           });
+    RebuildPlacement();
 
     initStatus = 0;
 }
 
+void StoreNode::SetPlacementPolicy(std::string_view policy)
+{
+    std::unique_lock<std::shared_mutex> nodeLock(nodeMutex);
+    placement = NodePlacement::Create(policy);
+    RebuildPlacement();
+}
+
+void StoreNode::RebuildPlacement()
+{
+    std::vector<std::pair<int, uint32_t>> nodes;
+    nodes.reserve(nodeMap.size());
+    for (auto &kv : nodeMap) {
+        nodes.emplace_back(kv.first, 1);
+    }
+    placement->Rebuild(nodes);
+}
+
 int StoreNode::UpdateNodeConfig()
 {
     int ret = 0;
@@ -64,6 +82,9 @@ int StoreNode::UpdateNodeConfig()
         std::shared_ptr<CuckooIOClient> connection(CreateIOConnection(newNodeKv.second));
         nodeMap.emplace(newNodeKv.first, std::make_pair(newNodeKv.second, connection));
     }
+    if (!toDel.empty() || !storeNodes.empty()) {
+        RebuildPlacement();
+    }
 #endif
     return ret;
 }
@@ -114,6 +135,7 @@ void StoreNode::Delete()
 {
     std::unique_lock<std::shared_mutex> lock(nodeMutex);
     nodeMap.clear();
+    RebuildPlacement();
 }
 
 CuckooIOClient *StoreNode::CreateIOConnection(const std::string &rpcEndPoint)
@@ -203,24 +225,11 @@ int StoreNode::GetNumberofAllNodes()
     return nodeMap.size();
 }
 
-uint64_t hash64(uint64_t x)
-{
-    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
-    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
-    x = x ^ (x >> 31);
-    return x;
-}
-
 int StoreNode::AllocNode(uint64_t inodeId)
 {
     std::shared_lock<std::shared_mutex> lock(nodeMutex);
-    if (!nodeMap.empty()) {
-        int index = (hash64(inodeId)) % nodeMap.size();
-        auto it = nodeMap.begin();
-        std::advance(it, index);
-        return it->first;
-    }
-    return nodeId;
+    int allocNodeId = placement->Locate(hash64(inodeId));
+    return allocNodeId >= 0 ? allocNodeId : nodeId;
 }
 
 int StoreNode::GetNextNode(int nodeId, uint64_t inodeId)
@@ -246,6 +255,7 @@ void StoreNode::DeleteNode(int nodeId)
 {
     std::unique_lock<std::shared_mutex> lock(nodeMutex);
     nodeMap.erase(nodeId);
+    RebuildPlacement();
 }
 
 std::vector<int> StoreNode::GetAllNodeId()
@@ -0,0 +1,82 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "connection/placement.h"
+
+#include <algorithm>
+
+#include "log/logging.h"
+
+uint64_t hash64(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+    x = x ^ (x >> 31);
+    return x;
+}
+
+std::unique_ptr<NodePlacement> NodePlacement::Create(std::string_view policy)
+{
+    if (policy == "jump") {
+        return std::make_unique<JumpPlacement>();
+    }
+    if (policy != "ring") {
+        CUCKOO_LOG(LOG_WARNING) << "unknown placement policy " << policy << ", use ring";
+    }
+    return std::make_unique<RingPlacement>();
+}
+
+void RingPlacement::Rebuild(const std::vector<std::pair<int, uint32_t>> &nodes)
+{
+    ring.clear();
+    for (auto &[nodeId, weight] : nodes) {
+        uint32_t virtualNodes = std::max<uint32_t>(weight, 1) * VIRTUAL_NODES_PER_WEIGHT;
+        for (uint32_t i = 0; i < virtualNodes; ++i) {
+            uint64_t point = hash64((static_cast<uint64_t>(nodeId) << 32) | i);
+            ring.emplace_back(point, nodeId);
+        }
+    }
+    std::sort(ring.begin(), ring.end());
+}
+
+int RingPlacement::Locate(uint64_t key) const
+{
+    if (ring.empty()) {
+        return -1;
+    }
+    auto it = std::upper_bound(ring.begin(), ring.end(), key, [](uint64_t k, const auto &point) {
+        return k < point.first;
+    });
+    if (it == ring.end()) {
+        it = ring.begin();
+    }
+    return it->second;
+}
+
+void JumpPlacement::Rebuild(const std::vector<std::pair<int, uint32_t>> &nodes)
+{
+    buckets.clear();
+    buckets.reserve(nodes.size());
+    for (auto &node : nodes) {
+        buckets.emplace_back(node.first);
+    }
+    std::sort(buckets.begin(), buckets.end());
+}
+
+int JumpPlacement::Locate(uint64_t key) const
+{
+    if (buckets.empty()) {
+        return -1;
+    }
+    // Lamping & Veach, "A Fast, Minimal Memory, Consistent Hash Algorithm"
+    int64_t b = -1;
+    int64_t j = 0;
+    int64_t numBuckets = static_cast<int64_t>(buckets.size());
+    while (j < numBuckets) {
+        b = j;
+        key = key * UINT64_C(2862933555777941757) + 1;
+        j = static_cast<int64_t>((b + 1) * (static_cast<double>(1LL << 31) / static_cast<double>((key >> 33) + 1)));
+    }
+    return buckets[b];
+}
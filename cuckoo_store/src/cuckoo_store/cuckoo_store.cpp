@@ -4,12 +4,19 @@
 
 #include "cuckoo_store/cuckoo_store.h"
 
+#include <map>
+#include <thread>
+
+#include <sys/stat.h>
+
 #include "conf/cuckoo_property_key.h"
 #include "connection/node.h"
 #include "cuckoo_code.h"
 #include "disk_cache/disk_cache.h"
 #include "init/cuckoo_init.h"
+#include "io_engine/io_engine.h"
 #include "stats/cuckoo_stats.h"
+#include "storage/local_storage.h"
 #include "storage/obs_storage.h"
 
 void CuckooStore::SetCuckooStoreParam(std::string &newNodeConfig) { nodeConfig = newNodeConfig; }
@@ -22,6 +29,12 @@ CuckooStore *CuckooStore::GetInstance()
 
 void CuckooStore::DeleteInstance()
 {
+    if (writeBack) {
+        writeBack->Stop();
+    }
+    if (segmentCache) {
+        segmentCache->Stop();
+    }
     StoreNode::DeleteInstance();
     if (storage) {
         storage->DeleteInstance();
@@ -54,34 +67,117 @@ int CuckooStore::InitStore()
     isInference = config->GetBool(CuckooPropertyKey::CUCKOO_IS_INFERENCE);
     toLocal = config->GetBool(CuckooPropertyKey::CUCKOO_TO_LOCAL);
     std::string mountPath = config->GetString(CuckooPropertyKey::CUCKOO_MOUNT_PATH);
+    std::string placementPolicy = config->GetString(CuckooPropertyKey::CUCKOO_PLACEMENT_POLICY);
+    MemPoolOptions memPoolOptions;
+    memPoolOptions.hugePage = config->GetBool(CuckooPropertyKey::CUCKOO_MEM_POOL_HUGEPAGE);
+    memPoolOptions.numaLocal = config->GetBool(CuckooPropertyKey::CUCKOO_MEM_POOL_NUMA_LOCAL);
+    IoEngineOptions ioEngineOptions;
+    ioEngineOptions.engine = config->GetString(CuckooPropertyKey::CUCKOO_IO_ENGINE);
+    ioEngineOptions.queueDepth = config->GetUint32(CuckooPropertyKey::CUCKOO_IO_URING_DEPTH);
+    ioEngineOptions.fixedBuffers = config->GetBool(CuckooPropertyKey::CUCKOO_IO_URING_FIXED_BUFFERS);
+    readAheadOptions.blockSize = CUCKOO_BLOCK_SIZE;
+    readAheadOptions.maxStreams = config->GetUint32(CuckooPropertyKey::CUCKOO_READ_AHEAD_STREAMS);
+    readAheadOptions.maxWindowBlocks = config->GetUint32(CuckooPropertyKey::CUCKOO_READ_AHEAD_MAX_BLOCKS);
+    uint32_t snapshotInterval = config->GetUint32(CuckooPropertyKey::CUCKOO_CACHE_SNAPSHOT_INTERVAL);
+    std::string storageType = config->GetString(CuckooPropertyKey::CUCKOO_STORAGE);
+    LocalStorageOptions localStorageOptions;
+    localStorageOptions.root = config->GetString(CuckooPropertyKey::CUCKOO_LOCAL_STORAGE_ROOT);
+    localStorageOptions.latencyUs = config->GetUint32(CuckooPropertyKey::CUCKOO_LOCAL_STORAGE_LATENCY_US);
+    localStorageOptions.bandwidthMBps = config->GetUint32(CuckooPropertyKey::CUCKOO_LOCAL_STORAGE_BANDWIDTH_MBPS);
+    downloadRangeSize = config->GetUint32(CuckooPropertyKey::CUCKOO_DOWNLOAD_RANGE_SIZE);
+    downloadParallelism = config->GetUint32(CuckooPropertyKey::CUCKOO_DOWNLOAD_PARALLELISM);
+    uploadPartSize = config->GetUint32(CuckooPropertyKey::CUCKOO_UPLOAD_PART_SIZE);
+    uploadParallelism = config->GetUint32(CuckooPropertyKey::CUCKOO_UPLOAD_PARALLELISM);
+    uploadStreaming = config->GetBool(CuckooPropertyKey::CUCKOO_UPLOAD_STREAMING);
+    WriteBackOptions writeBackOptions;
+    writeBackOptions.concurrency = config->GetUint32(CuckooPropertyKey::CUCKOO_WRITE_BACK_CONCURRENCY);
+    writeBackOptions.rateMBps = config->GetUint32(CuckooPropertyKey::CUCKOO_WRITE_BACK_RATE_MBPS);
+    writeBackOptions.delayMs = config->GetUint32(CuckooPropertyKey::CUCKOO_WRITE_BACK_DELAY_MS);
+    std::string layoutName = config->GetString(CuckooPropertyKey::CUCKOO_OBJECT_LAYOUT);
+    /* configs written before the option existed keep the path layout */
+    if (layoutName.empty()) {
+        layoutName = "path";
+    }
+    if (layoutName != "path" && layoutName != "inode") {
+        CUCKOO_LOG(LOG_ERROR) << "unknown cuckoo_object_layout " << layoutName;
+        return -EINVAL;
+    }
+    bool inodeKeyed = layoutName == "inode";
+    bool layoutMigrate = config->GetBool(CuckooPropertyKey::CUCKOO_OBJECT_LAYOUT_MIGRATE);
+    bool packedCache = config->GetBool(CuckooPropertyKey::CUCKOO_PACKED_CACHE);
+    SegmentCacheOptions segmentCacheOptions;
+    segmentCacheOptions.segmentSize = config->GetUint32(CuckooPropertyKey::CUCKOO_PACKED_SEGMENT_SIZE);
+    segmentCacheOptions.maxFileSize = config->GetUint32(CuckooPropertyKey::CUCKOO_PACKED_MAX_FILE_SIZE);
+    MemCacheOptions memCacheOptions;
+    memCacheOptions.capacity = static_cast<uint64_t>(config->GetUint32(CuckooPropertyKey::CUCKOO_MEM_CACHE_MB)) << 20;
+    memCacheOptions.maxFileSize = bigFileReadSize;
 
     CUCKOO_LOG(LOG_INFO) << "cuckoo_cache rootPath: " << rootPath;
 
     dataPath = rootPath;
     if (persistToStorage) {
-        storage = OBSStorage::GetInstance();
+        if (storageType == "local") {
+            LocalStorage::GetInstance()->SetOptions(localStorageOptions);
+            storage = LocalStorage::GetInstance();
+        } else {
+            storage = OBSStorage::GetInstance();
+        }
 
         ret = storage->Init();
         if (ret != CUCKOO_SUCCESS) {
             CUCKOO_LOG(LOG_ERROR) << "storage init fail " << ret;
             return ret;
         }
+        objectLayout = ObjectLayout(storage, inodeKeyed, layoutMigrate);
     }
 
     READ_BIGFILE_SIZE = bigFileReadSize;
     SetRootPath(rootPath);
     SetTotalDirectory(totalDirectory);
-    ret = DiskCache::GetInstance().Start(rootPath, totalDirectory, 1.0 - storageThreshold, 1.1 - storageThreshold);
+    ret = DiskCache::GetInstance().Start(rootPath,
+                                         totalDirectory,
+                                         1.0 - storageThreshold,
+                                         1.1 - storageThreshold,
+                                         snapshotInterval);
     if (ret != 0) {
         CUCKOO_LOG(LOG_ERROR) << "DiskCache start failed";
         return 1;
     }
-    MemPool().GetInstance().init(CUCKOO_BLOCK_SIZE, preBlockNum);
+    MemPool::GetInstance().init(CUCKOO_BLOCK_SIZE, preBlockNum, memPoolOptions);
+    /* after MemPool, its slabs may be registered as fixed buffers */
+    IoEngine::GetInstance().Init(ioEngineOptions);
     storeThreadPool = ThreadPool::CreateThreadPool(threadNum, 100000, "store thread pool");
     if (storeThreadPool == nullptr || storeThreadPool->Start() != 0) {
         CUCKOO_LOG(LOG_ERROR) << "Cuckoo threadpool init failed";
         return 1;
     }
+    DiskCache::GetInstance().SetThreadPool(storeThreadPool.get());
+    if (memCacheOptions.capacity > 0) {
+        memCache = std::make_unique<MemCache>(memCacheOptions);
+    }
+    /* after DiskCache and IoEngine, segments are cache entries read through the engine */
+    if (packedCache) {
+        segmentCache = std::make_unique<SegmentCache>(segmentCacheOptions);
+        segmentCache->SetThreadPool(storeThreadPool.get());
+        ret = segmentCache->Start();
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "Cuckoo segment cache start failed";
+            return ret;
+        }
+    }
+    /* after DiskCache, replayed files are pinned there */
+    if (persistToStorage && asyncToObs) {
+        writeBackOptions.journalPath = rootPath + "/" + WriteBack::JOURNAL_NAME;
+        writeBack = std::make_unique<WriteBack>(writeBackOptions, [this](uint64_t inodeId, const std::string &path) {
+            return FlushToStorage(path, inodeId);
+        });
+        ret = writeBack->Start();
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "Cuckoo write back start failed";
+            return ret;
+        }
+    }
+    StoreNode::GetInstance()->SetPlacementPolicy(placementPolicy);
 #ifdef ZK_INIT
     ret = StoreNode::GetInstance()->SetNodeConfig(rootPath);
     if (ret != 0) {
@@ -188,6 +284,8 @@ bool CuckooStore::IoError(int err) { return err < 0; }
 int CuckooStore::WriteLocalFileForBrpc(OpenInstance *openInstance, butil::IOBuf &buf, off_t offset)
 {
     size_t writeSize = buf.size();
+    const off_t writeOffset = offset;
+    const size_t totalSize = writeSize;
     uint64_t currentSize = openInstance->currentSize.load();
     uint64_t newSize = std::max(openInstance->currentSize.load(), offset + writeSize);
     uint64_t sizeToAdd = newSize - currentSize;
@@ -232,13 +330,12 @@ int CuckooStore::WriteLocalFileForBrpc(OpenInstance *openInstance, butil::IOBuf
             free(alignedBuf);
             return -EIO;
         }
-        ssize_t retSize = pwrite(openInstance->physicalFd, alignedBuf, writeSize, offset);
+        ssize_t retSize = IoEngine::GetInstance().Write(openInstance->physicalFd, alignedBuf, writeSize, offset);
         free(alignedBuf);
         if (retSize < 0) {
-            int err = errno;
-            CUCKOO_LOG(LOG_ERROR) << "WriteLocalFileForBrpc(): pwrite failed" << strerror(err);
+            CUCKOO_LOG(LOG_ERROR) << "WriteLocalFileForBrpc(): pwrite failed" << strerror(-retSize);
             DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
-            return -err;
+            return retSize;
         }
         CuckooStats::GetInstance().stats[BLOCKCACHE_WRITE] += retSize;
     }
@@ -250,6 +347,9 @@ int CuckooStore::WriteLocalFileForBrpc(OpenInstance *openInstance, butil::IOBuf
         return -ENOENT;
     }
     DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
+    if (uploadStreaming && persistToStorage && !asyncToObs) {
+        StreamWritten(openInstance, writeOffset, totalSize);
+    }
     return 0;
 }
 
@@ -262,8 +362,8 @@ int CuckooStore::WriteFile(OpenInstance *openInstance, const char *buf, size_t s
     // if read -> write, read stream outdated, discard
     // no guarantee on concurrent read and write from fuse
     if (openInstance->preReadStarted.load() && !openInstance->preReadStopped.exchange(true)) {
-        CUCKOO_LOG(LOG_INFO) << "WriteFile(): StopPreReadThreaded";
-        StopPreReadThreaded(openInstance);
+        CUCKOO_LOG(LOG_INFO) << "WriteFile(): StopPreRead";
+        StopPreRead(openInstance);
     }
 
     // open file, init physical fd
@@ -328,12 +428,12 @@ int CuckooStore::ReadFile(OpenInstance *openInstance, char *buf, size_t size, of
             openInstance->isOpened = true;
         }
 
-        /* init and start the read stream */
+        /* init the read stream, local cache files are read directly */
         if (!openInstance->preReadStarted.exchange(true)) {
             if (StoreNode::GetInstance()->IsLocal(openInstance->nodeId)) {
-                StopPreReadThreaded(openInstance);
-            } else if (!StartPreReadThreaded(openInstance)) {
-                StartPreReadThreaded(openInstance);
+                StopPreRead(openInstance);
+            } else {
+                StartPreRead(openInstance);
             }
         }
 
@@ -368,28 +468,21 @@ int CuckooStore::ReadFile(OpenInstance *openInstance, char *buf, size_t size, of
 }
 
 /*
- * Called by ReadFile to start fill readStream
+ * Called by ReadFile to start read-ahead on readStream
  */
-bool CuckooStore::StartPreReadThreaded(OpenInstance *openInstance)
+void CuckooStore::StartPreRead(OpenInstance *openInstance)
 {
-    int fileBlocks = (openInstance->currentSize + CUCKOO_BLOCK_SIZE - 1) / CUCKOO_BLOCK_SIZE;
-
-    if (!openInstance->readStream.Init(openInstance, fileBlocks, CUCKOO_BLOCK_SIZE)) {
-        return false;
-    }
-    openInstance->readStream.StartPushThreaded();
-    return true;
+    openInstance->readStream.Init(openInstance, readAheadOptions, storeThreadPool.get());
 }
 
 /*
  * Called by WriteFile to stop readStream in case of write
  */
-void CuckooStore::StopPreReadThreaded(OpenInstance *openInstance)
+void CuckooStore::StopPreRead(OpenInstance *openInstance)
 {
-    /* stop only once */
     openInstance->preReadStopped.store(true);
     openInstance->directReadFile.store(true);
-    openInstance->readStream.StopPushThreaded();
+    openInstance->readStream.Stop();
 }
 
 /*
@@ -399,19 +492,11 @@ int CuckooStore::ReadToBuffer(CuckooReadBuffer buf, OpenInstance *openInstance,
 {
     CUCKOO_LOG(LOG_INFO) << "CuckooStore::ReadToBuffer(): called";
 
-    /* if random read is marked, no lock is needed */
     if (openInstance->directReadFile.load()) {
         return RandomRead(buf, openInstance, offset);
     }
-    /* for sequence read, make sure to read in order without concurrency */
-    /* peek and store atomically */
-    std::unique_lock<std::shared_mutex> offsetAndBuffLock(openInstance->fileMutex);
-    if (openInstance->directReadFile.load() || openInstance->serialReadEnd != offset) {
-        StopPreReadThreaded(openInstance);
-        offsetAndBuffLock.unlock();
-        return RandomRead(buf, openInstance, offset);
-    }
-    return SequenceRead(buf, openInstance, offset);
+    /* readStream tells sequential streams from random reads itself */
+    return openInstance->readStream.Read(buf.ptr, buf.size, offset);
 }
 
 /*
@@ -444,26 +529,17 @@ int CuckooStore::RandomRead(CuckooReadBuffer buf, OpenInstance *openInstance, of
     }
 }
 
-/*
- * Called to read readStream
- */
-int CuckooStore::SequenceRead(CuckooReadBuffer buf, OpenInstance *openInstance, off_t /*offset*/)
-{
-    // read file from read stream
-    int retSize = openInstance->readStream.WaitPop(buf.ptr, buf.size);
-    if (retSize > 0) {
-        openInstance->serialReadEnd += retSize;
-    }
-    return retSize;
-}
-
 /*
  * Read from local cache file, remote cache file, or obs
  * local file read, if failed read obs
  * remote file read, if failed read obs
  * local file read called by rpc, if failed return failure
  */
-ssize_t CuckooStore::ReadFileLR(char *readBuffer, off_t offset, OpenInstance *openInstance, size_t readBufferSize)
+ssize_t CuckooStore::ReadFileLR(char *readBuffer,
+                                off_t offset,
+                                OpenInstance *openInstance,
+                                size_t readBufferSize,
+                                butil::IOBuf *remoteBuf)
 {
     if (offset >= (ssize_t)openInstance->currentSize) {
         return 0;
@@ -475,22 +551,22 @@ ssize_t CuckooStore::ReadFileLR(char *readBuffer, off_t offset, OpenInstance *op
         if (openInstance->physicalFd != UINT64_MAX && !fileLock.TestLocked(openInstance->inodeId, LockMode::X)) {
             /* not locked, read cache file */
             CuckooStats::GetInstance().stats[BLOCKCACHE_READ] += checkReadLength;
-            retSize = pread(openInstance->physicalFd, readBuffer, readBufferSize, offset);
+            retSize = IoEngine::GetInstance().Read(openInstance->physicalFd, readBuffer, readBufferSize, offset);
             if (retSize != checkReadLength) {
-                int err = errno;
-                if (err == EAGAIN) {
-                    retSize = pread(openInstance->physicalFd, readBuffer, checkReadLength, offset);
-                    if (retSize != checkReadLength) {
-                        err = errno;
-                        CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): pread fd = " << openInstance->physicalFd
-                                              << " failed : " << strerror(err);
-                        retSize = -err;
-                    }
-                } else {
-                    CUCKOO_LOG(LOG_ERROR)
-                        << "In ReadFileLR(): pread fd = " << openInstance->physicalFd << " failed : " << strerror(err);
-                    retSize = -err;
-                }
+                /* short read means the cache file is behind currentSize */
+                int err = retSize < 0 ? -retSize : EIO;
+                CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): pread fd = " << openInstance->physicalFd
+                                      << " failed : " << strerror(err);
+                retSize = -err;
+            }
+        } else if (openInstance->download != nullptr && openInstance->download->Ready(offset, checkReadLength)) {
+            /* loading in the background, the ranges covering this read are in */
+            CuckooStats::GetInstance().stats[BLOCKCACHE_READ] += checkReadLength;
+            retSize = IoEngine::GetInstance().Read(openInstance->download->Fd(), readBuffer, checkReadLength, offset);
+            if (retSize != checkReadLength) {
+                int err = retSize < 0 ? -retSize : EIO;
+                CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): pread loading file failed : " << strerror(err);
+                retSize = -err;
             }
         }
     } else {
@@ -499,7 +575,15 @@ ssize_t CuckooStore::ReadFileLR(char *readBuffer, off_t offset, OpenInstance *op
             std::shared_ptr<CuckooIOClient> cuckooIOClient =
                 StoreNode::GetInstance()->GetRpcConnection(openInstance->nodeId);
             retSize = -EHOSTUNREACH;
-            if (cuckooIOClient != nullptr) {
+            if (cuckooIOClient != nullptr && remoteBuf != nullptr) {
+                retSize = cuckooIOClient->ReadFile(openInstance->inodeId,
+                                                   openInstance->oflags,
+                                                   *remoteBuf,
+                                                   openInstance->physicalFd,
+                                                   readBufferSize,
+                                                   offset,
+                                                   openInstance->path);
+            } else if (cuckooIOClient != nullptr) {
                 retSize = cuckooIOClient->ReadFile(openInstance->inodeId,
                                                    openInstance->oflags,
                                                    readBuffer,
@@ -512,13 +596,17 @@ ssize_t CuckooStore::ReadFileLR(char *readBuffer, off_t offset, OpenInstance *op
                 CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): read remote failed: " << strerror(-retSize) << ", for node "
                                       << openInstance->nodeId;
                 openInstance->remoteFailed = true;
+                if (remoteBuf != nullptr && retSize < 0) {
+                    /* obs below fills readBuffer, a short reply is returned as is */
+                    remoteBuf->clear();
+                }
             }
         }
     }
     /* Read cache file failed and called by fuse not rpc -> read obs */
     if (retSize < 0 && !openInstance->isRemoteCall && persistToStorage) {
         CUCKOO_LOG(LOG_DEBUG) << "ReadFile from obs : " << openInstance->path;
-        retSize = storage->ReadObject(openInstance->path.substr(1), offset, readBufferSize, -1, readBuffer);
+        retSize = objectLayout.Read(openInstance->path, openInstance->inodeId, offset, readBufferSize, -1, readBuffer);
         if (retSize < 0) {
             CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): obs ReadObject() failed";
             retSize = -EIO;
@@ -527,6 +615,58 @@ ssize_t CuckooStore::ReadFileLR(char *readBuffer, off_t offset, OpenInstance *op
     return retSize;
 }
 
+/*
+ * Called by brpc server only, pread the local cache file straight into IOBuf blocks
+ * so the reply is sent without a staging buffer. Not for O_DIRECT, IOBuf blocks are not aligned.
+ */
+ssize_t CuckooStore::ReadFileLRForBrpc(OpenInstance *openInstance, butil::IOBuf &buf, size_t size, off_t offset)
+{
+    if (offset >= (ssize_t)openInstance->currentSize) {
+        return 0;
+    }
+    if (openInstance->physicalFd == UINT64_MAX || fileLock.TestLocked(openInstance->inodeId, LockMode::X)) {
+        /* let ReadFileLR decide */
+        char *buffer = static_cast<char *>(malloc(size));
+        if (buffer == nullptr) {
+            CUCKOO_LOG(LOG_ERROR) << "Allocation failed for size " << size;
+            return -ENOMEM;
+        }
+        ssize_t retSize = ReadFileLR(buffer, offset, openInstance, size);
+        if (retSize < 0) {
+            free(buffer);
+            return retSize;
+        }
+        buf.append_user_data(buffer, retSize, [](void *ptr) { free(ptr); });
+        return retSize;
+    }
+
+    ssize_t checkReadLength = std::min(size, openInstance->currentSize - offset);
+    CuckooStats::GetInstance().stats[BLOCKCACHE_READ] += checkReadLength;
+    butil::IOPortal portal;
+    ssize_t readSize = 0;
+    int err = 0;
+    while (readSize < checkReadLength) {
+        ssize_t nread = portal.pappend_from_file_descriptor(openInstance->physicalFd,
+                                                            offset + readSize,
+                                                            checkReadLength - readSize);
+        if (nread < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        if (nread <= 0) {
+            err = nread < 0 ? errno : EIO;
+            break;
+        }
+        readSize += nread;
+    }
+    if (readSize != checkReadLength) {
+        CUCKOO_LOG(LOG_ERROR) << "ReadFileLRForBrpc(): pread fd = " << openInstance->physicalFd
+                              << " failed : " << strerror(err);
+        return -err;
+    }
+    buf.append(portal);
+    return readSize;
+}
+
 /*---------------------- open ----------------------*/
 
 /*
@@ -555,6 +695,9 @@ int CuckooStore::OpenFile(OpenInstance *openInstance)
             if (openInstance->nodeFail) {
                 DiskCache::GetInstance().DeleteOldCacheWithNoPin(openInstance->inodeId);
             }
+            if (openInstance->nodeFail || (openInstance->oflags & O_ACCMODE) != O_RDONLY) {
+                DropCachedCopies(openInstance->inodeId);
+            }
             if (DiskCache::GetInstance().Find(openInstance->inodeId, true)) {
                 /* Cache Hits: read file from cache */
                 int localFd = open(fileName.c_str(), openInstance->oflags, 0755);
@@ -623,6 +766,12 @@ int CuckooStore::OpenFile(OpenInstance *openInstance)
         }
         openInstance->writeStream.SetInodeId(openInstance->inodeId);
         openInstance->writeStream.SetDirect(openInstance->oflags & __O_DIRECT);
+        /* writes of a remote file are streamed by the owner, in WriteLocalFileForBrpc, none with write back */
+        if (uploadStreaming && persistToStorage && !asyncToObs &&
+            StoreNode::GetInstance()->IsLocal(openInstance->nodeId) && (openInstance->oflags & O_ACCMODE) != O_RDONLY) {
+            openInstance->writeStream.SetWrittenCallback(
+                [this, openInstance](uint64_t offset, uint64_t size) { StreamWritten(openInstance, offset, size); });
+        }
         ret =
             openInstance->writeStream.SetFd(openInstance->physicalFd); // set physicalFd in local, or cuckooFd in remote
     }
@@ -649,6 +798,12 @@ int CuckooStore::DownLoadFromStorage(OpenInstance *openInstance, bool isSync, bo
     }
     if (!lockerPtr->isLocked()) {
         CUCKOO_LOG(LOG_INFO) << "DownLoadFromStorage(): No need to load obs, other acquired the lock, abort";
+        /* read the ranges already in while the other loads */
+        std::lock_guard lock(downloadMutex);
+        auto it = downloads.find(inodeId);
+        if (it != downloads.end()) {
+            openInstance->download = it->second;
+        }
         return 0;
     }
 
@@ -664,7 +819,7 @@ int CuckooStore::DownLoadFromStorage(OpenInstance *openInstance, bool isSync, bo
     }
 
     /* here cache file must not exist */
-    auto fd = open(fileName.c_str(), O_WRONLY | O_CREAT, 0755);
+    auto fd = open(fileName.c_str(), O_RDWR | O_CREAT, 0755);
     if (fd < 0) {
         int err = errno;
         CUCKOO_LOG(LOG_ERROR) << "DownLoadFromStorage(): Create local file for loading failed: " << strerror(err);
@@ -672,13 +827,17 @@ int CuckooStore::DownLoadFromStorage(OpenInstance *openInstance, bool isSync, bo
         return -err;
     }
 
+    if (!toBuffer && fileSize > downloadRangeSize && downloadParallelism > 1) {
+        return DownLoadRanges(openInstance, fd, lockerPtr, isSync);
+    }
+
     /* pass a copy of shared_ptr to make sure destructed */
     auto loadObs = [=, this]() {
         int size = 0;
         if (toBuffer) {
-            size = storage->ReadObject(path.substr(1), 0, bufSize, fd, readBuffer.get());
+            size = objectLayout.Read(path, inodeId, 0, bufSize, fd, readBuffer.get());
         } else {
-            size = storage->ReadObject(path.substr(1), 0, 0, fd, nullptr);
+            size = objectLayout.Read(path, inodeId, 0, 0, fd, nullptr);
         }
 
         close(fd);
@@ -698,12 +857,66 @@ int CuckooStore::DownLoadFromStorage(OpenInstance *openInstance, bool isSync, bo
     if (isSync) {
         return loadObs();
     } else {
-        storeThreadPool->Submit({.taskName = "", .task = loadObs});
+        storeThreadPool->Submit({.taskName = "load obs", .task = loadObs, .priority = TaskPriority::BACKGROUND});
     }
 
     return 0;
 }
 
+/*
+ * Called by DownLoadFromStorage with the X lock held, the lock is kept until the last range is in.
+ * Readers of an async load find it in openInstance->download, opens coming meanwhile in downloads.
+ */
+int CuckooStore::DownLoadRanges(OpenInstance *openInstance, int fd, std::shared_ptr<FileLocker> lockerPtr, bool isSync)
+{
+    uint64_t inodeId = openInstance->inodeId;
+    uint64_t fileSize = openInstance->originalSize;
+    std::string fileName = GetFilePath(inodeId);
+
+    /* ranges land anywhere in the file */
+    if (ftruncate(fd, fileSize) != 0) {
+        int err = errno;
+        CUCKOO_LOG(LOG_ERROR) << "DownLoadRanges(): Extend local file for loading failed: " << strerror(err);
+        close(fd);
+        std::remove(fileName.c_str());
+        DiskCache::GetInstance().FreePreAllocSpace(fileSize);
+        return -err;
+    }
+    auto download = std::make_shared<RangeDownload>(fd, fileSize, downloadRangeSize);
+    if (!isSync) {
+        openInstance->download = download;
+        std::lock_guard lock(downloadMutex);
+        downloads[inodeId] = download;
+    }
+
+    RangeDownload *raw = download.get();
+    /* the lock goes with the callback, released once loaded */
+    auto loaded = [=, this, locker = std::move(lockerPtr)](int ret) {
+        if (ret < 0) {
+            CUCKOO_LOG(LOG_ERROR) << "DownLoadRanges(): Loading file from obs failed";
+            if (std::remove(fileName.c_str()) != 0) {
+                CUCKOO_LOG(LOG_ERROR) << "DownLoadRanges(): Delete obs tmp file failed" << strerror(errno);
+            }
+        } else {
+            DiskCache::GetInstance().InsertAndUpdate(inodeId, fileSize, isSync);
+        }
+        DiskCache::GetInstance().FreePreAllocSpace(fileSize);
+        {
+            std::lock_guard lock(downloadMutex);
+            auto it = downloads.find(inodeId);
+            if (it != downloads.end() && it->second.get() == raw) {
+                downloads.erase(it);
+            }
+        }
+    };
+    download->Start(storage,
+                    storeThreadPool.get(),
+                    objectLayout.LoadKey(openInstance->path, openInstance->inodeId),
+                    downloadParallelism,
+                    loaded);
+    return isSync ? download->Wait() : 0;
+}
+
 /*
  * Called by OpenFile and ReadSmallFile. Large file try open and return, small file read obs if failed
  */
@@ -769,11 +982,12 @@ int CuckooStore::OpenFileFromRemote(OpenInstance *openInstance, bool largeFile)
     /* Any error for small file, read obs itself */
     if (persistToStorage) {
         CUCKOO_LOG(LOG_WARNING) << "OpenFileFromRemote(): small read remote failed, read obs instead";
-        ret = storage->ReadObject(openInstance->path.substr(1),
-                                  0,
-                                  openInstance->readBufferSize,
-                                  -1,
-                                  openInstance->readBuffer.get());
+        ret = objectLayout.Read(openInstance->path,
+                                openInstance->inodeId,
+                                0,
+                                openInstance->readBufferSize,
+                                -1,
+                                openInstance->readBuffer.get());
         if (ret < 0) {
             CUCKOO_LOG(LOG_ERROR) << "OpenFileFromRemote(): obs ReadObject() " << openInstance->path << " failed";
             return -EIO;
@@ -786,6 +1000,34 @@ int CuckooStore::OpenFileFromRemote(OpenInstance *openInstance, bool largeFile)
     return ret > 0 ? -ret : ret;
 }
 
+int CuckooStore::ReadSmallFileSpeculative(OpenInstance *openInstance)
+{
+    if (openInstance->nodeId < 0 || (openInstance->oflags & O_ACCMODE) != O_RDONLY) {
+        return -EINVAL;
+    }
+    if (StoreNode::GetInstance()->IsLocal(openInstance->nodeId)) {
+        return ReadSmallFilesForBrpc(openInstance->inodeId,
+                                     openInstance->path,
+                                     openInstance->readBuffer.get(),
+                                     openInstance->readBufferSize,
+                                     openInstance->oflags,
+                                     false,
+                                     true);
+    }
+    std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(openInstance->nodeId);
+    if (cuckooIOClient == nullptr) {
+        return -EHOSTUNREACH;
+    }
+    ssize_t ret = cuckooIOClient->ReadSmallFile(openInstance->inodeId,
+                                                openInstance->readBufferSize,
+                                                openInstance->path,
+                                                openInstance->readBuffer.get(),
+                                                openInstance->oflags,
+                                                false,
+                                                true);
+    return ret > 0 ? -ret : ret;
+}
+
 /*---------------------- close ----------------------*/
 
 /*
@@ -823,8 +1065,8 @@ int CuckooStore::CloseTmpFiles(OpenInstance *openInstance, bool isFlush, bool is
 
     /* stop the possible preRead thread */
     if (!isFlush && !openInstance->isRemoteCall) {
-        StopPreReadThreaded(openInstance);
-        openInstance->readStream.WaitPushEnded();
+        StopPreRead(openInstance);
+        openInstance->readStream.WaitLoadEnded();
     }
 
     /* first persist the writeStream, then rpc call remote to flush or close */
@@ -842,21 +1084,34 @@ int CuckooStore::CloseTmpFiles(OpenInstance *openInstance, bool isFlush, bool is
     if (StoreNode::GetInstance()->IsLocal(openInstance->nodeId)) {
         /* close file */
         if (!isFlush) {
-            close(openInstance->physicalFd);
+            IoEngine::GetInstance().Close(openInstance->physicalFd);
             DiskCache::GetInstance().Unpin(openInstance->inodeId);
             return ret;
         }
         /* flush file */
         /* update diskcache file size, do not pin */
         DiskCache::GetInstance().InsertAndUpdate(openInstance->inodeId, openInstance->currentSize, false);
+        if (openInstance->writeCnt > 0) {
+            /* read while the file was written */
+            DropCachedCopies(openInstance->inodeId);
+        }
         if (openInstance->writeCnt > 0 && !openInstance->writeFail) {
             if (isSync) {
                 fsync(openInstance->physicalFd);
                 CUCKOO_LOG(LOG_INFO) << "CloseTmpFiles(): file " << openInstance->path << " fsync-ed";
             }
             /* flush file to storage, e.g. obs */
-            if (persistToStorage) {
-                ret = FlushToStorage(openInstance->path, openInstance->inodeId);
+            if (persistToStorage && writeBack != nullptr) {
+                /* durable in the journal, uploaded in background */
+                ret = writeBack->MarkDirty(openInstance->inodeId, openInstance->path, openInstance->currentSize);
+                openInstance->writeFail = (ret != 0);
+            } else if (persistToStorage) {
+                std::shared_ptr<MultipartUpload> streamed;
+                {
+                    std::lock_guard lock(openInstance->uploadMutex);
+                    streamed = std::move(openInstance->upload);
+                }
+                ret = FlushToStorage(openInstance->path, openInstance->inodeId, streamed);
                 openInstance->writeFail = (ret != 0);
             }
         }
@@ -864,21 +1119,77 @@ int CuckooStore::CloseTmpFiles(OpenInstance *openInstance, bool isFlush, bool is
     return ret;
 }
 
-int CuckooStore::FlushToStorage(std::string path, uint64_t inodeId)
+int CuckooStore::FlushToStorage(std::string path, uint64_t inodeId, std::shared_ptr<MultipartUpload> streamed)
 {
     int ret = 0;
-    std::string object = path.substr(1);
+    std::string object = objectLayout.Key(path, inodeId);
     std::string localFile = GetFilePath(inodeId);
 
-    ret = storage->PutFile(object, localFile);
+    struct stat st;
+    if (stat(localFile.c_str(), &st) != 0) {
+        int err = errno;
+        CUCKOO_LOG(LOG_ERROR) << "Flush file " << object << ": stat " << localFile << " failed: " << strerror(err);
+        return -err;
+    }
+    uint64_t fileSize = st.st_size;
+
+    /* only the parts not streamed yet are left, usually just the tail */
+    bool sent = false;
+    if (streamed != nullptr && streamed->Streamed()) {
+        ret = streamed->Finish(fileSize);
+        sent = ret != -ESTALE;
+        if (!sent) {
+            CUCKOO_LOG(LOG_INFO) << "Flush file " << object << ": streamed parts are stale, upload again";
+        }
+    }
+    streamed.reset();
+
+    if (!sent && fileSize > uploadPartSize && uploadParallelism > 1) {
+        int fd = open(localFile.c_str(), O_RDONLY);
+        if (fd < 0) {
+            int err = errno;
+            CUCKOO_LOG(LOG_ERROR) << "Flush file " << object << ": open " << localFile << " failed: " << strerror(err);
+            return -err;
+        }
+        auto upload = std::make_shared<MultipartUpload>(storage, storeThreadPool.get(), object, fd, uploadPartSize,
+                                                        uploadParallelism);
+        ret = upload->Finish(fileSize);
+    } else if (!sent) {
+        ret = storage->PutFile(object, localFile);
+    }
     if (ret == 0) {
         CUCKOO_LOG(LOG_INFO) << "Flush file " << object << " to obs succeeded!";
+        /* the inode keyed object is newer than one left from the path layout */
+        objectLayout.DropPathObject(path);
     } else {
         CUCKOO_LOG(LOG_ERROR) << "Flush file " << object << " to obs failed!";
     }
     return ret == 0 ? ret : -EIO;
 }
 
+void CuckooStore::StreamWritten(OpenInstance *openInstance, uint64_t offset, uint64_t size)
+{
+    std::shared_ptr<MultipartUpload> upload;
+    {
+        std::lock_guard lock(openInstance->uploadMutex);
+        if (openInstance->upload == nullptr) {
+            int fd = open(GetFilePath(openInstance->inodeId).c_str(), O_RDONLY);
+            if (fd < 0) {
+                return;
+            }
+            std::string key = objectLayout.Key(openInstance->path, openInstance->inodeId);
+            openInstance->upload = std::make_shared<MultipartUpload>(storage,
+                                                                     storeThreadPool.get(),
+                                                                     key,
+                                                                     fd,
+                                                                     uploadPartSize,
+                                                                     uploadParallelism);
+        }
+        upload = openInstance->upload;
+    }
+    upload->Written(offset, size);
+}
+
 /*---------------------- small file open ----------------------*/
 
 /*
@@ -910,6 +1221,20 @@ int CuckooStore::ReadSmallFiles(OpenInstance *openInstance)
     if (openInstance->nodeFail) {
         DiskCache::GetInstance().DeleteOldCacheWithNoPin(inodeId);
     }
+    bool readOnly = !openInstance->nodeFail && (openInstance->oflags & O_ACCMODE) == O_RDONLY;
+    if (!readOnly) {
+        DropCachedCopies(inodeId);
+    } else if (ReadFromMemory(inodeId, readBuffer, bufSize)) {
+        return 0;
+    }
+    /* before reading below, a write meanwhile keeps the content out of memory */
+    uint64_t epoch = memCache != nullptr ? memCache->Epoch(inodeId) : 0;
+    if (readOnly && segmentCache != nullptr &&
+        segmentCache->Read(inodeId, readBuffer, bufSize) == (ssize_t)bufSize) {
+        CuckooStats::GetInstance().stats[BLOCKCACHE_READ] += bufSize;
+        KeepInMemory(inodeId, readBuffer, bufSize, epoch);
+        return 0;
+    }
     /* Check if in disk cache. True then pin the file */
     if (DiskCache::GetInstance().Find(inodeId, true)) {
         /* Cache Hit: read whole file to read buffer */
@@ -921,26 +1246,20 @@ int CuckooStore::ReadSmallFiles(OpenInstance *openInstance)
             return -err;
         }
         CuckooStats::GetInstance().stats[BLOCKCACHE_READ] += bufSize;
-        ssize_t retSize = pread(localFd, readBuffer, bufSize, 0);
+        ssize_t retSize = IoEngine::GetInstance().Read(localFd, readBuffer, bufSize, 0);
         if (retSize != (ssize_t)bufSize) {
-            int err = errno;
-            if (err == EAGAIN) {
-                retSize = pread(localFd, readBuffer, bufSize, 0);
-                if (retSize == (ssize_t)bufSize) {
-                    close(localFd);
-                    DiskCache::GetInstance().Unpin(inodeId);
-                    return 0;
-                }
-                err = errno;
-            }
+            int err = retSize < 0 ? -retSize : EIO;
             CUCKOO_LOG(LOG_ERROR) << "ReadSmallFiles(): Pread size is not equal to size: " << strerror(err);
-            close(localFd);
+            IoEngine::GetInstance().Close(localFd);
             DiskCache::GetInstance().Unpin(inodeId);
             return -err;
         }
-        close(localFd);
+        IoEngine::GetInstance().Close(localFd);
         /* unpin the file after close */
         DiskCache::GetInstance().Unpin(inodeId);
+        if (readOnly) {
+            KeepInMemory(inodeId, readBuffer, bufSize, epoch);
+        }
     } else {
         /* Cache Miss: load file from obs */
         if (!persistToStorage) {
@@ -961,6 +1280,10 @@ int CuckooStore::ReadSmallFiles(OpenInstance *openInstance)
         /* Call is from rpc server. Async load obs and Return err to let caller read obs to buffer itself */
         if (openInstance->isRemoteCall) {
             CUCKOO_LOG(LOG_INFO) << "ReadSmallFiles(): remote call, bg load obs and return failure";
+            if (segmentCache != nullptr && segmentCache->Fits(bufSize)) {
+                PackAsync(inodeId, path, nullptr, bufSize);
+                return -ENOENT;
+            }
             // bg load obs and return failure
             bool isSync = false;
             ret = DownLoadFromStorage(openInstance, isSync);
@@ -969,18 +1292,264 @@ int CuckooStore::ReadSmallFiles(OpenInstance *openInstance)
 
         /* Call is from fuse user. Sync read obs to buffer and Async write to local file */
         /* Sync read obs to read buffer */
-        ret = storage->ReadObject(path.substr(1), 0, bufSize, -1, readBuffer);
+        ret = objectLayout.Read(path, inodeId, 0, bufSize, -1, readBuffer);
         if (ret < 0) {
             CUCKOO_LOG(LOG_ERROR) << "Obs read failed";
             return -EIO;
         }
+        if (readOnly) {
+            KeepInMemory(inodeId, readBuffer, bufSize, epoch);
+        }
         /* Async write to local cache file */
         /* Read buffer is read only after initialization above */
+        if (segmentCache != nullptr && segmentCache->Fits(bufSize)) {
+            PackAsync(inodeId, path, openInstance->readBuffer, bufSize);
+            return 0;
+        }
         return WriteToFileAsync(inodeId, fileName, openInstance->readBuffer, bufSize);
     }
     return 0;
 }
 
+/*
+ * Files on a remote node are read with ReadSmallFiles rpcs of up to READ_SMALL_FILES_MAX_NUM files
+ * and READ_SMALL_FILES_MAX_BYTES, nodes are requested concurrently on the store thread pool. Local files,
+ * and files the rpc failed for, go through ReadSmallFiles, which switches node or reads storage as for a
+ * single file.
+ */
+void CuckooStore::ReadSmallFilesBatch(const std::vector<OpenInstance *> &openInstances, std::vector<int> &results)
+{
+    results.assign(openInstances.size(), 0);
+    /* by node and oflags, both are per rpc */
+    std::map<std::pair<int, int>, std::vector<size_t>> groups;
+    std::vector<size_t> singles;
+    for (size_t i = 0; i < openInstances.size(); ++i) {
+        AllocNodeId(openInstances[i]);
+        if (StoreNode::GetInstance()->IsLocal(openInstances[i]->nodeId)) {
+            singles.push_back(i);
+        } else {
+            groups[{openInstances[i]->nodeId, openInstances[i]->oflags}].push_back(i);
+        }
+    }
+
+    auto readGroup = [&openInstances, &results](int nodeId, int oflags, const std::vector<size_t> &group) {
+        std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(nodeId);
+        size_t start = 0;
+        while (start < group.size()) {
+            std::vector<SmallFileRead> files;
+            uint64_t bytes = 0;
+            for (size_t i = start; i < group.size(); ++i) {
+                OpenInstance *openInstance = openInstances[group[i]];
+                bytes += openInstance->readBufferSize;
+                if (!files.empty() &&
+                    (files.size() == CuckooIOClient::READ_SMALL_FILES_MAX_NUM ||
+                     bytes > CuckooIOClient::READ_SMALL_FILES_MAX_BYTES)) {
+                    break;
+                }
+                files.push_back(SmallFileRead{.inodeId = openInstance->inodeId,
+                                              .size = openInstance->readBufferSize,
+                                              .path = openInstance->path,
+                                              .buffer = openInstance->readBuffer.get(),
+                                              .nodeFail = openInstance->nodeFail,
+                                              .result = 0});
+            }
+            int ret = cuckooIOClient != nullptr ? cuckooIOClient->ReadSmallFiles(files, oflags) : EHOSTUNREACH;
+            for (size_t i = 0; i < files.size(); ++i) {
+                results[group[start + i]] = ret != 0 ? ret : files[i].result;
+            }
+            start += files.size();
+        }
+    };
+    std::vector<std::function<void()>> tasks;
+    for (auto &[key, group] : groups) {
+        tasks.emplace_back([&readGroup, &key, &group]() { readGroup(key.first, key.second, group); });
+    }
+    storeThreadPool->RunAndWait(tasks);
+
+    for (size_t i = 0; i < openInstances.size(); ++i) {
+        if (results[i] != 0) {
+            CUCKOO_LOG(LOG_WARNING) << "ReadSmallFilesBatch(): batch read " << openInstances[i]->path
+                                    << " failed, read it alone";
+            singles.push_back(i);
+        }
+    }
+    for (size_t i : singles) {
+        results[i] = ReadSmallFiles(openInstances[i]);
+    }
+}
+
+int CuckooStore::WriteSmallFile(OpenInstance *openInstance, std::string_view data)
+{
+    openInstance->writeCnt++;
+    int ret = WriteFile(openInstance, data.data(), data.size(), 0);
+    /* flush then close, as fuse does */
+    int closeRet = CloseTmpFiles(openInstance, true, false);
+    ret = ret == 0 ? closeRet : ret;
+    closeRet = CloseTmpFiles(openInstance, false, false);
+    ret = ret == 0 ? closeRet : ret;
+    if (ret == 0 && openInstance->writeFail) {
+        ret = -EIO;
+    }
+    return ret;
+}
+
+void CuckooStore::WriteSmallFilesBatch(const std::vector<OpenInstance *> &openInstances,
+                                       const std::vector<std::string_view> &datas,
+                                       std::vector<int> &results)
+{
+    results.assign(openInstances.size(), 0);
+    std::map<int, std::vector<size_t>> groups;
+    std::vector<size_t> singles;
+    for (size_t i = 0; i < openInstances.size(); ++i) {
+        AllocNodeId(openInstances[i]);
+        if (StoreNode::GetInstance()->IsLocal(openInstances[i]->nodeId)) {
+            singles.push_back(i);
+        } else {
+            groups[openInstances[i]->nodeId].push_back(i);
+        }
+    }
+
+    auto writeGroup = [&openInstances, &datas, &results](int nodeId, const std::vector<size_t> &group) {
+        std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(nodeId);
+        size_t start = 0;
+        while (start < group.size()) {
+            std::vector<SmallFileWrite> files;
+            uint64_t bytes = 0;
+            for (size_t i = start; i < group.size(); ++i) {
+                OpenInstance *openInstance = openInstances[group[i]];
+                bytes += datas[group[i]].size();
+                if (!files.empty() &&
+                    (files.size() == CuckooIOClient::WRITE_SMALL_FILES_MAX_NUM ||
+                     bytes > CuckooIOClient::WRITE_SMALL_FILES_MAX_BYTES)) {
+                    break;
+                }
+                files.push_back(SmallFileWrite{.inodeId = openInstance->inodeId,
+                                               .path = openInstance->path,
+                                               .data = datas[group[i]],
+                                               .nodeFail = openInstance->nodeFail,
+                                               .result = 0});
+            }
+            int ret = cuckooIOClient != nullptr ? cuckooIOClient->WriteSmallFiles(files) : EHOSTUNREACH;
+            for (size_t i = 0; i < files.size(); ++i) {
+                results[group[start + i]] = ret != 0 ? ret : files[i].result;
+                if (results[group[start + i]] == 0) {
+                    openInstances[group[start + i]]->currentSize = files[i].data.size();
+                }
+            }
+            start += files.size();
+        }
+    };
+    std::vector<std::function<void()>> tasks;
+    for (auto &[nodeId, group] : groups) {
+        tasks.emplace_back([&writeGroup, nodeId, &group]() { writeGroup(nodeId, group); });
+    }
+    storeThreadPool->RunAndWait(tasks);
+
+    /* a failed node is switched by the single write */
+    for (size_t i = 0; i < openInstances.size(); ++i) {
+        if (results[i] != 0) {
+            CUCKOO_LOG(LOG_WARNING) << "WriteSmallFilesBatch(): batch write " << openInstances[i]->path
+                                    << " failed, write it alone";
+            singles.push_back(i);
+        }
+    }
+    for (size_t i : singles) {
+        results[i] = WriteSmallFile(openInstances[i], datas[i]);
+    }
+}
+
+int CuckooStore::WriteSmallFileForBrpc(uint64_t inodeId, const std::string &path, butil::IOBuf &buf, bool nodeFail)
+{
+    auto openInstance = std::make_unique<OpenInstance>();
+    openInstance->inodeId = inodeId;
+    openInstance->path = path;
+    openInstance->oflags = O_WRONLY | O_CREAT;
+    openInstance->nodeId = StoreNode::GetInstance()->GetNodeId();
+    openInstance->isRemoteCall = true;
+    openInstance->nodeFail = nodeFail;
+
+    int ret = OpenFile(openInstance.get());
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "WriteSmallFileForBrpc(): create " << path << " failed: " << strerror(-ret);
+        return ret;
+    }
+    openInstance->isOpened = true;
+    if (!buf.empty()) {
+        openInstance->writeCnt++;
+        ret = WriteLocalFileForBrpc(openInstance.get(), buf, 0);
+        if (ret != 0) {
+            openInstance->writeFail = true;
+        }
+    }
+    int closeRet = CloseTmpFiles(openInstance.get(), true, false);
+    ret = ret == 0 ? closeRet : ret;
+    closeRet = CloseTmpFiles(openInstance.get(), false, false);
+    ret = ret == 0 ? closeRet : ret;
+    if (ret == 0 && openInstance->writeFail) {
+        ret = -EIO;
+    }
+    return ret;
+}
+
+void CuckooStore::PackAsync(uint64_t inodeId, const std::string &path, std::shared_ptr<char> buf, size_t bufSize)
+{
+    /* loads and packs of the file are not repeated meanwhile */
+    auto lockerPtr = std::make_shared<FileLocker>(&fileLock, inodeId, LockMode::X, false);
+    if (lockerPtr == nullptr || !lockerPtr->isLocked()) {
+        return;
+    }
+    ThreadTask task;
+    task.taskName = "pack cache";
+    task.priority = TaskPriority::BACKGROUND;
+    task.task = [this, inodeId, path, buf, bufSize, lockerPtr]() {
+        std::shared_ptr<char> data = buf;
+        if (data == nullptr) {
+            data = std::shared_ptr<char>(new char[bufSize], std::default_delete<char[]>());
+            if (objectLayout.Read(path, inodeId, 0, bufSize, -1, data.get()) != (ssize_t)bufSize) {
+                CUCKOO_LOG(LOG_ERROR) << "PackAsync(): Loading file from obs failed";
+                return;
+            }
+        }
+        CuckooStats::GetInstance().stats[BLOCKCACHE_WRITE] += bufSize;
+        int ret = segmentCache->Put(inodeId, data.get(), bufSize);
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "PackAsync(): pack file failed : " << strerror(-ret);
+        }
+    };
+    storeThreadPool->Submit(task);
+}
+
+bool CuckooStore::ReadFromMemory(uint64_t inodeId, char *buf, size_t size)
+{
+    if (memCache == nullptr || !memCache->Fits(size)) {
+        return false;
+    }
+    if (!memCache->Get(inodeId, buf, size)) {
+        CuckooStats::GetInstance().stats[MEMCACHE_MISS]++;
+        return false;
+    }
+    CuckooStats::GetInstance().stats[MEMCACHE_HIT]++;
+    CuckooStats::GetInstance().stats[MEMCACHE_READ] += size;
+    return true;
+}
+
+void CuckooStore::KeepInMemory(uint64_t inodeId, const char *buf, size_t size, uint64_t epoch)
+{
+    if (memCache != nullptr) {
+        memCache->Put(inodeId, buf, size, epoch);
+    }
+}
+
+void CuckooStore::DropCachedCopies(uint64_t inodeId)
+{
+    if (memCache != nullptr) {
+        memCache->Erase(inodeId);
+    }
+    if (segmentCache != nullptr) {
+        segmentCache->Remove(inodeId);
+    }
+}
+
 /*
  * Called by OpenFile and ReadSmallFile. Large file try open and return, small file read obs if failed
  * Use a shared_ptr from read buffer to store the file content
@@ -1016,13 +1585,14 @@ int CuckooStore::WriteToFileAsync(uint64_t inodeId, std::string &fileName, std::
 
     /* Async write the file to local file */
     ThreadTask task;
+    task.taskName = "write cache";
+    task.priority = TaskPriority::BACKGROUND;
     task.task = [fd, buf, bufSize, inodeId, lockerPtr]() {
         CuckooStats::GetInstance().stats[BLOCKCACHE_WRITE] += bufSize;
-        int retSize = pwrite(fd, buf.get(), bufSize, 0);
-        int err = errno;
-        close(fd);
+        ssize_t retSize = IoEngine::GetInstance().Write(fd, buf.get(), bufSize, 0);
+        IoEngine::GetInstance().Close(fd);
         if (retSize < 0) {
-            CUCKOO_LOG(LOG_ERROR) << "WriteToFileAsync(): pwrite failed : " << strerror(err);
+            CUCKOO_LOG(LOG_ERROR) << "WriteToFileAsync(): pwrite failed : " << strerror(-retSize);
         } else {
             DiskCache::GetInstance().InsertAndUpdate(inodeId, bufSize, false);
         }
@@ -1035,14 +1605,15 @@ int CuckooStore::WriteToFileAsync(uint64_t inodeId, std::string &fileName, std::
 }
 
 /*
- * Called by brpc server only
+ * Called by brpc server, and by ReadSmallFileSpeculative for a local file
  */
 int CuckooStore::ReadSmallFilesForBrpc(uint64_t inodeId,
                                        const std::string &path,
                                        char *buf,
                                        size_t size,
                                        int oflags,
-                                       bool nodeFail)
+                                       bool nodeFail,
+                                       bool cachedOnly)
 {
     int ret = 0;
 
@@ -1052,6 +1623,23 @@ int CuckooStore::ReadSmallFilesForBrpc(uint64_t inodeId,
     if (nodeFail) {
         DiskCache::GetInstance().DeleteOldCacheWithNoPin(inodeId);
     }
+    bool readOnly = !nodeFail && (oflags & O_ACCMODE) == O_RDONLY;
+    if (cachedOnly && !readOnly) {
+        return -EINVAL;
+    }
+    if (!readOnly) {
+        DropCachedCopies(inodeId);
+    } else if (ReadFromMemory(inodeId, buf, size)) {
+        return 0;
+    }
+    uint64_t epoch = memCache != nullptr ? memCache->Epoch(inodeId) : 0;
+    if (readOnly && segmentCache != nullptr && segmentCache->Read(inodeId, buf, size) == (ssize_t)size) {
+        CuckooStats::GetInstance().stats[BLOCKCACHE_READ] += size;
+        if (!cachedOnly) {
+            KeepInMemory(inodeId, buf, size, epoch);
+        }
+        return 0;
+    }
 
     if (DiskCache::GetInstance().Find(inodeId, true)) {
         /* Cache Hit: read whole file to read buffer */
@@ -1064,29 +1652,23 @@ int CuckooStore::ReadSmallFilesForBrpc(uint64_t inodeId,
             return -err;
         }
         CuckooStats::GetInstance().stats[BLOCKCACHE_READ] += size;
-        ssize_t retSize = pread(localFd, buf, size, 0);
+        ssize_t retSize = IoEngine::GetInstance().Read(localFd, buf, size, 0);
         if (retSize != (ssize_t)size) {
-            int err = errno;
-            if (err == EAGAIN) {
-                retSize = pread(localFd, buf, size, 0);
-                if (retSize == (ssize_t)size) {
-                    close(localFd);
-                    DiskCache::GetInstance().Unpin(inodeId);
-                    return 0;
-                }
-                err = errno;
-            }
+            int err = retSize < 0 ? -retSize : EIO;
             CUCKOO_LOG(LOG_ERROR) << "ReadSmallFilesForBrpc(): Pread size not equal: " << strerror(err);
-            close(localFd);
+            IoEngine::GetInstance().Close(localFd);
             DiskCache::GetInstance().Unpin(inodeId);
             return -err;
         }
-        close(localFd);
+        IoEngine::GetInstance().Close(localFd);
         /* unpin the file after close */
         DiskCache::GetInstance().Unpin(inodeId);
+        if (readOnly && !cachedOnly) {
+            KeepInMemory(inodeId, buf, size, epoch);
+        }
     } else {
         /* Cache Miss: load file from obs */
-        if (!persistToStorage) {
+        if (!persistToStorage || cachedOnly) {
             CUCKOO_LOG(LOG_ERROR) << "ReadSmallFilesForBrpc(): no local cache exists";
             return -ENOENT;
         }
@@ -1104,6 +1686,10 @@ int CuckooStore::ReadSmallFilesForBrpc(uint64_t inodeId,
         /* O_RDONLY, no need to wait for cache ready */
         /* Async load obs and Return err to let caller read obs to buffer itself */
         CUCKOO_LOG(LOG_INFO) << "ReadSmallFilesForBrpc(): remote call, bg load obs and return failure";
+        if (segmentCache != nullptr && segmentCache->Fits(size)) {
+            PackAsync(inodeId, path, nullptr, size);
+            return -ENOENT;
+        }
         // bg load obs and return failure
         bool isSync = false;
         ret = DownLoadFromStorageForBrpc(inodeId, path, buf, size, isSync, false);
@@ -1158,9 +1744,9 @@ int CuckooStore::DownLoadFromStorageForBrpc(uint64_t inodeId,
     auto loadObs = [=, this]() {
         int size = 0;
         if (toBuffer) {
-            size = storage->ReadObject(path.substr(1), 0, bufSize, fd, buf);
+            size = objectLayout.Read(path, inodeId, 0, bufSize, fd, buf);
         } else {
-            size = storage->ReadObject(path.substr(1), 0, 0, fd, nullptr);
+            size = objectLayout.Read(path, inodeId, 0, 0, fd, nullptr);
         }
 
         close(fd);
@@ -1180,7 +1766,7 @@ int CuckooStore::DownLoadFromStorageForBrpc(uint64_t inodeId,
     if (isSync) {
         return loadObs();
     } else {
-        storeThreadPool->Submit({.taskName = "", .task = loadObs});
+        storeThreadPool->Submit({.taskName = "load obs", .task = loadObs, .priority = TaskPriority::BACKGROUND});
     }
 
     return 0;
@@ -1192,6 +1778,10 @@ int CuckooStore::DeleteFiles(uint64_t inodeId, int nodeId, std::string path)
 {
     int ret = 0;
     if (nodeId == -1 || StoreNode::GetInstance()->IsLocal(nodeId)) {
+        if (writeBack != nullptr) {
+            writeBack->Forget(inodeId);
+        }
+        DropCachedCopies(inodeId);
         if (DiskCache::GetInstance().Find(inodeId, false)) {
             ret = DiskCache::GetInstance().Delete(inodeId);
             if (ret != 0) {
@@ -1217,7 +1807,7 @@ int CuckooStore::DeleteFiles(uint64_t inodeId, int nodeId, std::string path)
     }
 
     if (persistToStorage) {
-        ret = storage->DeleteObject(path.substr(1));
+        ret = objectLayout.Delete(path, inodeId);
         if (ret != 0) {
             CUCKOO_LOG(LOG_ERROR) << "delete file from obs failed! ";
             return -EIO;
@@ -1304,15 +1894,31 @@ int CuckooStore::StatFSForBrpc(const std::string &path,
     return ret;
 }
 
-int CuckooStore::CopyData(const std::string &srcName, const std::string &dstName)
+bool CuckooStore::RenameKeepsData() { return objectLayout.InodeKeyed() && !objectLayout.Migrating(); }
+
+int CuckooStore::CopyData(const std::string &srcName, const std::string &dstName, uint64_t inodeId)
 {
-    std::string srcObject = srcName.substr(1);
-    std::string dstObject = dstName.substr(1);
-    return storage->CopyObject(srcObject, dstObject);
+    /* the source may still be waiting for write back */
+    if (writeBack != nullptr) {
+        int ret = writeBack->Sync(srcName);
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "CopyData(): write back " << srcName << " failed: " << strerror(-ret);
+            return ret;
+        }
+    }
+    if (objectLayout.InodeKeyed()) {
+        /* the object keeps its key, only one left from the path layout is moved to it */
+        return objectLayout.Migrate(srcName, inodeId);
+    }
+    return storage->CopyObject(srcName.substr(1), dstName.substr(1));
 }
 
 int CuckooStore::DeleteDataAfterRename(const std::string &objectName)
 {
+    /* with inode keys only a path keyed object is left, after being moved by CopyData */
+    if (RenameKeepsData()) {
+        return 0;
+    }
     return storage->DeleteObject(objectName.substr(1));
 }
 
@@ -1335,6 +1941,7 @@ int CuckooStore::TruncateFile(OpenInstance *openInstance, off_t size)
     }
 
     if (StoreNode::GetInstance()->IsLocal(openInstance->nodeId)) {
+        DropCachedCopies(openInstance->inodeId);
         ret = ftruncate(openInstance->physicalFd, size);
         if (ret != 0) {
             int err = errno;
@@ -1390,6 +1997,15 @@ int CuckooStore::TruncateOpenInstance(OpenInstance *openInstance, off_t size)
         }
     }
 
+    std::shared_ptr<MultipartUpload> upload;
+    {
+        std::lock_guard lock(openInstance->uploadMutex);
+        upload = openInstance->upload;
+    }
+    if (upload != nullptr) {
+        upload->Truncated(size);
+    }
+
     // truncate openInstance, update both sizes to let future write reflect meta size
     std::unique_lock<std::shared_mutex> sizeLock(openInstance->fileMutex);
     openInstance->currentSize = size;
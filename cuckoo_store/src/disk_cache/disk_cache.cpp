@@ -5,18 +5,83 @@
 #include "disk_cache/disk_cache.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <format>
 
+#include <sys/mman.h>
 #include <sys/statfs.h>
 #include <sys/time.h>
 
 #include "log/logging.h"
+#include "stats/cuckoo_stats.h"
+#include "thread_pool/thread_pool.h"
 #include "util/utils.h"
 
+namespace {
+/* keys remembered per shard after eviction from probation, at least */
+constexpr size_t GHOST_MIN_NUM = 1024;
+constexpr int CHECK_INTERVAL_SEC = 10;
+
+constexpr uint64_t SNAPSHOT_MAGIC = 0x31504e5348434b43; // "CKCHSNP1"
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr uint32_t SNAPSHOT_ENTRY_HOT = 1;
+
+struct SnapshotHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t dirNum;
+    uint64_t entryNum;
+    uint64_t createTime;
+    uint64_t checksum; // of the entries
+    uint32_t clean;    // written at stop, no cache file changed after it
+    uint32_t reserved;
+};
+
+/* entries of one shard are contiguous, probation then protected queue, each from the eviction end */
+struct SnapshotEntry
+{
+    uint64_t inode;
+    uint64_t size;
+    uint64_t atime;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+uint64_t Checksum(const SnapshotEntry *entries, uint64_t num)
+{
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(entries);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (uint64_t i = 0; i < num * sizeof(SnapshotEntry) / sizeof(uint64_t); ++i) {
+        hash = (hash ^ words[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+int WriteAll(int fd, const void *buf, size_t size)
+{
+    const char *pos = static_cast<const char *>(buf);
+    while (size > 0) {
+        ssize_t ret = write(fd, pos, size);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return RETURN_ERROR;
+        }
+        pos += ret;
+        size -= ret;
+    }
+    return RETURN_OK;
+}
+} // namespace
+
 std::vector<CacheItem> DiskCache::initCacheVector;
 std::mutex DiskCache::initCacheMutex;
 
@@ -24,15 +89,20 @@ DiskCache::DiskCache(float ratio) { freeRatio = ratio; }
 
 DiskCache::~DiskCache()
 {
-    stop = true;
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stop = true;
+    }
+    stopCV.notify_all();
     if (cleanupThread.joinable()) {
         cleanupThread.join();
     }
-    inodeToCacheIter.clear();
-    cacheItems.clear();
+    if (snapshotInterval > 0) {
+        SaveSnapshot(true);
+    }
 }
 
-int DiskCache::Start(std::string &path, int dirNum, float ratio, float bgEvitRatio)
+int DiskCache::Start(std::string &path, int dirNum, float ratio, float bgEvitRatio, uint32_t snapshotIntervalSec)
 {
     rootDir = path;
     totalDirNum = dirNum;
@@ -42,9 +112,17 @@ int DiskCache::Start(std::string &path, int dirNum, float ratio, float bgEvitRat
         stop = true;
     }
     bgFreeRatio = bgEvitRatio;
-    ret = ScanCache();
-    if (ret != RETURN_OK) {
-        return ret;
+    snapshotInterval = snapshotIntervalSec;
+    /* a clean snapshot is the whole index, otherwise files cached after it are picked up in background */
+    bool clean = false;
+    bool reconcile = false;
+    if (stop || snapshotInterval == 0 || LoadSnapshot(clean) != RETURN_OK) {
+        ret = ScanCache();
+        if (ret != RETURN_OK) {
+            return ret;
+        }
+    } else {
+        reconcile = !clean;
     }
 
     ret = GetCurFreeRatio();
@@ -57,11 +135,195 @@ int DiskCache::Start(std::string &path, int dirNum, float ratio, float bgEvitRat
         return ret;
     }
 
-    cleanupThread = std::thread(&DiskCache::CheckFreeSpace, this);
+    started = !stop;
+    time_t loadTime = time(nullptr);
+    cleanupThread = std::thread([this, reconcile, loadTime]() {
+        if (reconcile) {
+            Reconcile(loadTime);
+        }
+        CheckFreeSpace();
+    });
     testOBS = TestOBS();
     return RETURN_OK;
 }
 
+int DiskCache::LoadSnapshot(bool &clean)
+{
+    std::string snapshotPath = std::format("{}/{}", rootDir, SNAPSHOT_NAME);
+    int fd = open(snapshotPath.c_str(), O_RDWR);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            CUCKOO_LOG(LOG_WARNING) << "Open cache snapshot " << snapshotPath << " failed: " << strerror(errno);
+        }
+        return RETURN_ERROR;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+        CUCKOO_LOG(LOG_WARNING) << "Cache snapshot " << snapshotPath << " is truncated, scan the cache";
+        close(fd);
+        return RETURN_ERROR;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        CUCKOO_LOG(LOG_WARNING) << "Map cache snapshot " << snapshotPath << " failed: " << strerror(errno);
+        close(fd);
+        return RETURN_ERROR;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    const auto *header = static_cast<const SnapshotHeader *>(data);
+    const auto *entries = reinterpret_cast<const SnapshotEntry *>(header + 1);
+    bool valid = header->magic == SNAPSHOT_MAGIC && header->version == SNAPSHOT_VERSION &&
+                 header->dirNum == (uint32_t)totalDirNum &&
+                 (size_t)st.st_size == sizeof(SnapshotHeader) + header->entryNum * sizeof(SnapshotEntry) &&
+                 header->checksum == Checksum(entries, header->entryNum);
+    if (!valid) {
+        CUCKOO_LOG(LOG_WARNING) << "Cache snapshot " << snapshotPath << " is stale, scan the cache";
+        munmap(data, st.st_size);
+        close(fd);
+        return RETURN_ERROR;
+    }
+    Restore(entries, header->entryNum);
+    clean = header->clean != 0;
+    CUCKOO_LOG(LOG_INFO) << "Loaded " << header->entryNum << " cache entries from snapshot, clean = " << clean;
+    munmap(data, st.st_size);
+
+    /* files cached from now on are not in it */
+    if (clean) {
+        uint32_t dirty = 0;
+        if (pwrite(fd, &dirty, sizeof(dirty), offsetof(SnapshotHeader, clean)) != sizeof(dirty) || fdatasync(fd) != 0) {
+            CUCKOO_LOG(LOG_WARNING) << "Mark cache snapshot dirty failed: " << strerror(errno);
+        }
+    }
+    close(fd);
+    return RETURN_OK;
+}
+
+/*
+ * Entries are taken as they are, files are checked when first found, or skipped by eviction if missing.
+ */
+void DiskCache::Restore(const void *entries, uint64_t num)
+{
+    const auto *entry = static_cast<const SnapshotEntry *>(entries);
+    Shard *lockedShard = nullptr;
+    std::unique_lock<std::mutex> lock;
+    for (uint64_t i = 0; i < num; ++i, ++entry) {
+        Shard &shard = ShardOf(entry->inode);
+        if (&shard != lockedShard) {
+            lock = std::unique_lock<std::mutex>(shard.mutex);
+            lockedShard = &shard;
+        }
+        if (shard.index.contains(entry->inode)) {
+            continue;
+        }
+        CacheItem item;
+        item.inode = entry->inode;
+        item.size = entry->size;
+        item.atime = entry->atime;
+        item.hot = (entry->flags & SNAPSHOT_ENTRY_HOT) != 0;
+        item.unverified = true;
+        auto &queue = item.hot ? shard.hot : shard.probation;
+        queue.emplace_back(item);
+        shard.index[item.inode] = prev(queue.end());
+        (item.hot ? shard.hotBytes : shard.probationBytes) += item.size;
+        usedCap += item.size;
+        freeCap -= item.size;
+        entryNum++;
+    }
+}
+
+/*
+ * Index cache files written after the last snapshot and before this start.
+ */
+void DiskCache::Reconcile(time_t loadTime)
+{
+    uint64_t added = 0;
+    for (int i = 0; i < totalDirNum && !stop; ++i) {
+        std::string dirPath = std::format("{}/{}", rootDir, i);
+        DIR *const dir = opendir(dirPath.c_str());
+        if (!dir) {
+            continue;
+        }
+        for (const struct dirent *f = readdir(dir); f && !stop; f = readdir(dir)) {
+            if (strcmp(f->d_name, ".") == 0 || strcmp(f->d_name, "..") == 0) {
+                continue;
+            }
+            uint64_t inode = atoll(f->d_name);
+            {
+                Shard &shard = ShardOf(inode);
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (shard.index.contains(inode)) {
+                    continue;
+                }
+            }
+            /* files written since start are indexed by the writer */
+            struct stat st;
+            std::string filePath = dirPath + "/" + f->d_name;
+            if (stat(filePath.c_str(), &st) != 0 || st.st_mtime >= loadTime) {
+                continue;
+            }
+            InsertAndUpdate(inode, st.st_size, false);
+            added++;
+        }
+        closedir(dir);
+    }
+    CUCKOO_LOG(LOG_INFO) << "DiskCache::Reconcile(): indexed " << added << " files missing from the snapshot";
+}
+
+int DiskCache::SaveSnapshot(bool clean)
+{
+    if (!started) {
+        return RETURN_OK;
+    }
+    std::lock_guard<std::mutex> snapshotLock(snapshotMutex);
+    std::vector<SnapshotEntry> entries;
+    entries.reserve(entryNum.load());
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto *queue : {&shard.probation, &shard.hot}) {
+            for (auto &item : *queue) {
+                entries.push_back({item.inode, item.size, item.atime, item.hot ? SNAPSHOT_ENTRY_HOT : 0, 0});
+            }
+        }
+    }
+    SnapshotHeader header{};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.dirNum = totalDirNum;
+    header.entryNum = entries.size();
+    header.createTime = static_cast<uint64_t>(time(nullptr));
+    header.checksum = Checksum(entries.data(), entries.size());
+    header.clean = clean ? 1 : 0;
+
+    std::string snapshotPath = std::format("{}/{}", rootDir, SNAPSHOT_NAME);
+    std::string tmpPath = snapshotPath + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Create cache snapshot " << tmpPath << " failed: " << strerror(errno);
+        return RETURN_ERROR;
+    }
+    int ret = WriteAll(fd, &header, sizeof(header));
+    if (ret == RETURN_OK) {
+        ret = WriteAll(fd, entries.data(), entries.size() * sizeof(SnapshotEntry));
+    }
+    if (ret == RETURN_OK && fsync(fd) != 0) {
+        ret = RETURN_ERROR;
+    }
+    close(fd);
+    if (ret != RETURN_OK || rename(tmpPath.c_str(), snapshotPath.c_str()) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Write cache snapshot " << snapshotPath << " failed: " << strerror(errno);
+        unlink(tmpPath.c_str());
+        return RETURN_ERROR;
+    }
+    int dirFd = open(rootDir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    CUCKOO_LOG(LOG_INFO) << "Saved " << entries.size() << " cache entries to snapshot, clean = " << clean;
+    return RETURN_OK;
+}
+
 int DiskCache::ScanCache()
 {
     std::vector<std::thread> initCacheThreads;
@@ -149,8 +411,11 @@ int DiskCache::GetCurFreeRatio()
 
 void DiskCache::CheckFreeSpace()
 {
+    auto lastSnapshot = std::chrono::steady_clock::now();
     while (!stop) {
-        {
+        if (evictPool.load() != nullptr) {
+            TriggerEvict();
+        } else {
             std::lock_guard<std::mutex> lock(mutex);
             int ret = GetCurFreeRatio();
             if (ret != RETURN_OK) {
@@ -162,10 +427,56 @@ void DiskCache::CheckFreeSpace()
             }
             hasFreeSpace = blockRatio >= bgFreeRatio && inodeRatio >= bgFreeRatio;
         }
-        sleep(10);
+        if (snapshotInterval > 0 &&
+            std::chrono::steady_clock::now() - lastSnapshot >= std::chrono::seconds(snapshotInterval)) {
+            SaveSnapshot(false);
+            lastSnapshot = std::chrono::steady_clock::now();
+        }
+        std::unique_lock<std::mutex> lock(stopMutex);
+        stopCV.wait_for(lock, std::chrono::seconds(CHECK_INTERVAL_SEC), [this]() { return stop.load(); });
+    }
+}
+
+void DiskCache::SetThreadPool(ThreadPool *pool) { evictPool = pool; }
+
+/*
+ * Queue one background eviction at a time, it runs behind foreground tasks of the pool.
+ */
+void DiskCache::TriggerEvict()
+{
+    ThreadPool *pool = evictPool.load();
+    if (pool == nullptr || evicting.exchange(true)) {
+        return;
+    }
+    ThreadTask task;
+    task.taskName = "disk cache evict";
+    task.priority = TaskPriority::BACKGROUND;
+    task.task = [this]() { BackgroundEvict(); };
+    if (pool->TrySubmit(task) != 0) {
+        evicting = false;
     }
 }
 
+void DiskCache::BackgroundEvict()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (GetCurFreeRatio() == RETURN_OK) {
+            if (blockRatio < bgFreeRatio || inodeRatio < bgFreeRatio) {
+                hasFreeSpace = false;
+                Cleanup();
+            }
+            hasFreeSpace = blockRatio >= bgFreeRatio && inodeRatio >= bgFreeRatio;
+        }
+    }
+    evicting = false;
+}
+
+DiskCache::Shard &DiskCache::ShardOf(uint64_t key)
+{
+    return shards[(key * 0x9E3779B97F4A7C15ULL) >> (64 - SHARD_BITS)];
+}
+
 void DiskCache::CleanupForEvict(uint64_t preAllocSize)
 {
     // lock
@@ -176,49 +487,17 @@ void DiskCache::CleanupForEvict(uint64_t preAllocSize)
         toFreeCap = (uint64_t)(totalCap * (freeRatio - freeBlockRatio));
         CUCKOO_LOG(LOG_WARNING) << "DiskCache::CleanupForEvict(): Evict file due to block limit, data toFreeCap = "
                                 << toFreeCap;
-        if (toFreeCap > usedCap) {
-            toFreeCap = usedCap;
-        }
+        toFreeCap = std::min(toFreeCap, usedCap.load());
     }
 
     if (inodeRatio < freeRatio) {
         toFreeInode = (uint64_t)(totalInodes * (freeRatio - inodeRatio));
         CUCKOO_LOG(LOG_WARNING) << "DiskCache::CleanupForEvict(): Evict file due to inode limit, inodes toFreeInode = "
                                 << toFreeInode;
-        if (toFreeInode > inodeToCacheIter.size()) {
-            toFreeInode = inodeToCacheIter.size();
-        }
+        toFreeInode = std::min(toFreeInode, entryNum.load());
     }
 
-    uint64_t freedCap = 0;
-    uint64_t freedInode = 0;
-
-    for (auto it = cacheItems.begin(); it != cacheItems.end();) {
-        if (it->refs > 0) {
-            continue;
-        }
-        uint64_t key = it->inode;
-        uint64_t size = it->size;
-        std::string fileName = GetFilePath(key);
-        int ret = remove(fileName.c_str());
-        if (ret == 0) {
-            freedCap += size;
-            freedInode++;
-            it = cacheItems.erase(it);
-            inodeToCacheIter.erase(key);
-            usedCap -= size;
-            freeCap += size;
-            CUCKOO_LOG(LOG_WARNING) << "Evict file: " << fileName;
-        } else {
-            ++it;
-            CUCKOO_LOG(LOG_WARNING) << "Evict file: " << fileName << " failed: " << strerror(errno);
-        }
-        if (freedCap >= toFreeCap && freedInode >= toFreeInode) {
-            CUCKOO_LOG(LOG_WARNING) << "DiskCache::CleanupForEvict(): Evicted " << freedInode << " files, all size is "
-                                    << freedCap;
-            break;
-        }
-    }
+    EvictFiles(toFreeCap, toFreeInode);
 }
 
 void DiskCache::Cleanup()
@@ -231,49 +510,122 @@ void DiskCache::Cleanup()
         toFreeCap = (uint64_t)(totalCap * (freeRatio - blockRatio));
         CUCKOO_LOG(LOG_WARNING) << "DiskCache::Cleanup(): Evict file due to block limit, data toFreeCap = "
                                 << toFreeCap;
-        if (toFreeCap > usedCap) {
-            toFreeCap = usedCap;
-        }
+        toFreeCap = std::min(toFreeCap, usedCap.load());
     }
 
     if (inodeRatio < freeRatio) {
         toFreeInode = (uint64_t)(totalInodes * (freeRatio - inodeRatio));
         CUCKOO_LOG(LOG_WARNING) << "DiskCache::Cleanup(): Evict file due to inode limit, inodes toFreeInode = "
                                 << toFreeInode;
-        if (toFreeInode > inodeToCacheIter.size()) {
-            toFreeInode = inodeToCacheIter.size();
-        }
+        toFreeInode = std::min(toFreeInode, entryNum.load());
     }
 
+    EvictFiles(toFreeCap, toFreeInode);
+}
+
+/*
+ * Take one victim from each shard in turn, so all shards age at the same pace.
+ */
+void DiskCache::EvictFiles(uint64_t toFreeCap, uint64_t toFreeInode)
+{
     uint64_t freedCap = 0;
     uint64_t freedInode = 0;
+    uint32_t idleShards = 0;
+    uint32_t cursor = evictCursor.load();
+    while ((freedCap < toFreeCap || freedInode < toFreeInode) && idleShards < SHARD_NUM) {
+        Shard &shard = shards[cursor++ % SHARD_NUM];
+        uint64_t freedSize = 0;
+        bool evicted = false;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            evicted = EvictOne(shard, freedSize);
+        }
+        if (evicted) {
+            idleShards = 0;
+            freedCap += freedSize;
+            freedInode++;
+        } else {
+            idleShards++;
+        }
+    }
+    evictCursor = cursor;
+    CUCKOO_LOG(LOG_WARNING) << "DiskCache::EvictFiles(): Evicted " << freedInode << " files, all size is " << freedCap;
+}
+
+/*
+ * Probation first while it holds more than its quarter of the shard.
+ */
+bool DiskCache::EvictOne(Shard &shard, uint64_t &freedSize)
+{
+    bool probationFirst = shard.probationBytes * 4 >= shard.probationBytes + shard.hotBytes;
+    if (!probationFirst && shard.probationBytes == 0 && !shard.probation.empty()) {
+        /* all zero sized, go by count */
+        probationFirst = shard.probation.size() * 4 >= shard.probation.size() + shard.hot.size();
+    }
+    if (EvictFrom(shard, !probationFirst, freedSize)) {
+        return true;
+    }
+    return EvictFrom(shard, probationFirst, freedSize);
+}
 
-    for (auto it = cacheItems.begin(); it != cacheItems.end();) {
+bool DiskCache::EvictFrom(Shard &shard, bool fromHot, uint64_t &freedSize)
+{
+    std::list<CacheItem> &queue = fromHot ? shard.hot : shard.probation;
+    /* a full turn of the clock clears every mark, the second one finds a victim if there is any */
+    size_t steps = fromHot ? 2 * queue.size() : queue.size();
+    for (size_t i = 0; i < steps && !queue.empty(); ++i) {
+        auto it = queue.begin();
         if (it->refs > 0) {
+            queue.splice(queue.end(), queue, it);
             continue;
         }
-        uint64_t key = it->inode;
-        uint64_t size = it->size;
-        std::string fileName = GetFilePath(key);
-        int ret = remove(fileName.c_str());
-        if (ret == 0) {
-            freedCap += size;
-            freedInode++;
-            it = cacheItems.erase(it);
-            inodeToCacheIter.erase(key);
-            usedCap -= size;
-            freeCap += size;
-            CUCKOO_LOG(LOG_WARNING) << "Evict file: " << fileName;
-        } else {
-            ++it;
+        if (it->referenced) {
+            it->referenced = false;
+            if (!fromHot) {
+                it->hot = true;
+                shard.probationBytes -= it->size;
+                shard.hotBytes += it->size;
+                shard.stats.promotions++;
+                shard.hot.splice(shard.hot.end(), queue, it);
+            } else {
+                queue.splice(queue.end(), queue, it);
+            }
+            continue;
+        }
+        std::string fileName = GetFilePath(it->inode);
+        if (remove(fileName.c_str()) != 0 && errno != ENOENT) {
             CUCKOO_LOG(LOG_WARNING) << "Evict file: " << fileName << " failed: " << strerror(errno);
+            queue.splice(queue.end(), queue, it);
+            continue;
         }
-        if (freedCap >= toFreeCap && freedInode >= toFreeInode) {
-            CUCKOO_LOG(LOG_WARNING) << "DiskCache::CleanupForEvict(): Evicted " << freedInode << " files, all size is "
-                                    << freedCap;
-            break;
+        CUCKOO_LOG(LOG_WARNING) << "Evict file: " << fileName;
+        if (!fromHot) {
+            shard.ghostQueue.push_back(it->inode);
+            shard.ghosts.insert(it->inode);
+            size_t ghostLimit = std::max(shard.index.size(), GHOST_MIN_NUM);
+            while (shard.ghostQueue.size() > ghostLimit) {
+                shard.ghosts.erase(shard.ghostQueue.front());
+                shard.ghostQueue.pop_front();
+            }
         }
+        freedSize = it->size;
+        shard.stats.evictions++;
+        CuckooStats::GetInstance().stats[DISKCACHE_EVICT]++;
+        Erase(shard, it);
+        return true;
     }
+    return false;
+}
+
+void DiskCache::Erase(Shard &shard, std::list<CacheItem>::iterator item)
+{
+    uint64_t size = item->size;
+    (item->hot ? shard.hotBytes : shard.probationBytes) -= size;
+    shard.index.erase(item->inode);
+    (item->hot ? shard.hot : shard.probation).erase(item);
+    usedCap -= size;
+    freeCap += size;
+    entryNum--;
 }
 
 int DiskCache::Delete(uint64_t key)
@@ -283,34 +635,41 @@ int DiskCache::Delete(uint64_t key)
         int ret = remove(fileName.c_str());
         return ret;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
-        int ret = 0;
-        auto elem = inodeToCacheIter[key];
-        uint64_t size = elem->size;
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
         std::string fileName = GetFilePath(key);
-        ret = remove(fileName.c_str());
-        if (ret != 0) {
+        int ret = remove(fileName.c_str());
+        /* an entry restored from the snapshot may have lost its file already */
+        if (ret != 0 && !(errno == ENOENT && found->second->unverified)) {
             int err = errno;
             CUCKOO_LOG(LOG_ERROR) << "Delete file: " << fileName << " failed: " << strerror(err);
             return -err;
         }
-        cacheItems.erase(elem);
-        inodeToCacheIter.erase(key);
-        usedCap -= size;
-        freeCap += size;
+        Erase(shard, found->second);
         CUCKOO_LOG(LOG_INFO) << "Delete file: " << fileName;
     }
     return 0;
 }
 
+void DiskCache::PinLocked(CacheItem &item)
+{
+    item.refs += 1;
+    item.atime = static_cast<uint64_t>(time(nullptr));
+}
+
 void DiskCache::Pin(uint64_t key)
 {
     if (stop) {
         return;
     }
-    inodeToCacheIter[key]->refs += 1;
-    inodeToCacheIter[key]->atime = static_cast<uint64_t>(time(nullptr));
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        PinLocked(*found->second);
+    }
 }
 
 void DiskCache::Unpin(uint64_t key)
@@ -318,9 +677,11 @@ void DiskCache::Unpin(uint64_t key)
     if (stop) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end() && inodeToCacheIter[key]->refs > 0) {
-        inodeToCacheIter[key]->refs -= 1;
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end() && found->second->refs > 0) {
+        found->second->refs -= 1;
     }
 }
 
@@ -333,36 +694,51 @@ bool DiskCache::Find(uint64_t key, bool needPin)
     if (testOBS) {
         return false;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
-        if (needPin) {
-            Pin(key);
-        }
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found == shard.index.end() || !Verify(shard, found->second)) {
+        shard.stats.misses++;
+        CuckooStats::GetInstance().stats[DISKCACHE_MISS]++;
+        return false;
+    }
+    /* only mark, the eviction hand moves entries */
+    found->second->referenced = true;
+    if (needPin) {
+        PinLocked(*found->second);
+    }
+    shard.stats.hits++;
+    CuckooStats::GetInstance().stats[DISKCACHE_HIT]++;
+    return true;
+}
+
+bool DiskCache::Verify(Shard &shard, std::list<CacheItem>::iterator item)
+{
+    if (!item->unverified) {
+        return true;
+    }
+    if (access(GetFilePath(item->inode).c_str(), F_OK) == 0) {
+        item->unverified = false;
         return true;
     }
+    Erase(shard, item);
     return false;
 }
 
 void DiskCache::DeleteOldCacheWithNoPin(uint64_t key)
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
-        if (inodeToCacheIter[key]->refs <= 0) {
-            int ret = 0;
-            auto elem = inodeToCacheIter[key];
-            uint64_t size = elem->size;
-            std::string fileName = GetFilePath(key);
-            ret = remove(fileName.c_str());
-            if (ret != 0) {
-                int err = errno;
-                CUCKOO_LOG(LOG_ERROR) << "DeleteOldCacheWithNoPin file: " << fileName << " failed: " << strerror(err);
-                return;
-            }
-            cacheItems.erase(elem);
-            inodeToCacheIter.erase(key);
-            usedCap -= size;
-            freeCap += size;
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end() && found->second->refs <= 0) {
+        std::string fileName = GetFilePath(key);
+        int ret = remove(fileName.c_str());
+        if (ret != 0 && !(errno == ENOENT && found->second->unverified)) {
+            int err = errno;
+            CUCKOO_LOG(LOG_ERROR) << "DeleteOldCacheWithNoPin file: " << fileName << " failed: " << strerror(err);
+            return;
         }
+        Erase(shard, found->second);
     }
 }
 
@@ -371,28 +747,41 @@ void DiskCache::InsertAndUpdate(uint64_t key, uint64_t size, bool needPin)
     if (stop) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
         // update
-        usedCap += static_cast<int64_t>(size - inodeToCacheIter[key]->size);
-        freeCap -= static_cast<int64_t>(size - inodeToCacheIter[key]->size);
-        inodeToCacheIter[key]->atime = static_cast<uint64_t>(time(nullptr));
-        inodeToCacheIter[key]->size = size;
-        //
+        CacheItem &item = *found->second;
+        usedCap += size - item.size;
+        freeCap -= size - item.size;
+        (item.hot ? shard.hotBytes : shard.probationBytes) += size - item.size;
+        item.atime = static_cast<uint64_t>(time(nullptr));
+        item.size = size;
     } else {
-        // insert
+        // insert, straight to the protected queue if evicted from probation recently
         CacheItem elem;
         elem.atime = static_cast<uint64_t>(time(nullptr));
         elem.size = size;
         elem.inode = key;
-        cacheItems.emplace_back(elem);
-        inodeToCacheIter[key] = prev(cacheItems.end());
+        elem.hot = shard.ghosts.erase(key) > 0;
+        if (elem.hot) {
+            shard.stats.ghostHits++;
+            shard.hot.emplace_back(elem);
+            shard.index[key] = prev(shard.hot.end());
+            shard.hotBytes += size;
+        } else {
+            shard.probation.emplace_back(elem);
+            shard.index[key] = prev(shard.probation.end());
+            shard.probationBytes += size;
+        }
+        shard.stats.inserts++;
         usedCap += size;
         freeCap -= size;
+        entryNum++;
         if (needPin) {
-            Pin(key);
+            PinLocked(*shard.index[key]);
         }
-        //
     }
 }
 
@@ -401,21 +790,23 @@ bool DiskCache::Update(uint64_t key, uint64_t size)
     if (stop) {
         return true;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
-        // update
-        if (size <= inodeToCacheIter[key]->size) {
-            return true;
-        }
-        usedCap += static_cast<int64_t>(size - inodeToCacheIter[key]->size);
-        freeCap -= static_cast<int64_t>(size - inodeToCacheIter[key]->size);
-        inodeToCacheIter[key]->atime = static_cast<uint64_t>(time(nullptr));
-        inodeToCacheIter[key]->size = size;
-        // CUCKOO_LOG(LOG_INFO) << "Add Cache, inode =  " << key << ", size = " << size << ", usedCap = " << usedCap;
-    } else {
-        CUCKOO_LOG(LOG_ERROR) << "In DiskCache::Add(), inode " << key << " not found";
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        CUCKOO_LOG(LOG_ERROR) << "In DiskCache::Update(), inode " << key << " not found";
         return false;
     }
+    // update
+    CacheItem &item = *found->second;
+    if (size <= item.size) {
+        return true;
+    }
+    usedCap += size - item.size;
+    freeCap -= size - item.size;
+    (item.hot ? shard.hotBytes : shard.probationBytes) += size - item.size;
+    item.atime = static_cast<uint64_t>(time(nullptr));
+    item.size = size;
     return true;
 }
 
@@ -424,21 +815,38 @@ bool DiskCache::Add(uint64_t key, uint64_t size)
     if (stop) {
         return true;
     }
-    std::lock_guard<std::mutex> lock(mutex);
-    if (inodeToCacheIter.find(key) != inodeToCacheIter.end()) {
-        // update
-        usedCap += static_cast<int64_t>(size);
-        freeCap -= static_cast<int64_t>(size);
-        inodeToCacheIter[key]->atime = static_cast<uint64_t>(time(nullptr));
-        inodeToCacheIter[key]->size += size;
-        // CUCKOO_LOG(LOG_INFO) << "Add Cache, inode =  " << key << ", size = " << size << ", usedCap = " << usedCap;
-    } else {
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found == shard.index.end()) {
         CUCKOO_LOG(LOG_ERROR) << "In DiskCache::Add(), inode " << key << " not found";
         return false;
     }
+    // update
+    CacheItem &item = *found->second;
+    usedCap += size;
+    freeCap -= size;
+    (item.hot ? shard.hotBytes : shard.probationBytes) += size;
+    item.atime = static_cast<uint64_t>(time(nullptr));
+    item.size += size;
     return true;
 }
 
+std::vector<DiskCacheShardStats> DiskCache::GetShardStats()
+{
+    std::vector<DiskCacheShardStats> result;
+    result.reserve(SHARD_NUM);
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        DiskCacheShardStats stats = shard.stats;
+        stats.entries = shard.index.size();
+        stats.probationBytes = shard.probationBytes;
+        stats.hotBytes = shard.hotBytes;
+        result.push_back(stats);
+    }
+    return result;
+}
+
 void DiskCache::Evict(uint64_t size)
 {
     std::lock_guard<std::mutex> lock(mutex);
@@ -458,6 +866,8 @@ bool DiskCache::PreAllocSpace(uint64_t size)
         return true;
     } else {
         hasFreeSpace = false;
+        /* let the background eviction free up to bgFreeRatio while evicting just enough here */
+        TriggerEvict();
         int retryCnt = 3;
         do {
             if (retryCnt == 0) {
@@ -489,7 +899,7 @@ bool DiskCache::HasFreeSpace() { return hasFreeSpace.load(); }
 int DiskCache::CheckSpaceEnough()
 {
     float blockRatio = (freeCap + usedCap) * 1.0 / totalCap;
-    float inodeRatio = (freeInodes + inodeToCacheIter.size()) * 1.0 / totalInodes;
+    float inodeRatio = (freeInodes + entryNum.load()) * 1.0 / totalInodes;
     if (blockRatio <= bgFreeRatio || inodeRatio <= bgFreeRatio || blockRatio <= freeRatio || inodeRatio < freeRatio) {
         CUCKOO_LOG(LOG_ERROR) << "The free space can not support CuckooFS running";
         CUCKOO_LOG(LOG_ERROR) << "Free space is not enough";
@@ -0,0 +1,176 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "disk_cache/mem_cache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+/* sketch counters per expected entry, and expected entry size */
+constexpr uint64_t COUNTERS_PER_ENTRY = 4;
+constexpr uint64_t EXPECTED_FILE_SIZE = 16 * 1024;
+constexpr uint64_t MIN_SKETCH_SIZE = 1024;
+constexpr uint64_t MAX_SKETCH_SIZE = 1 << 22;
+
+uint64_t Mix(uint64_t key, uint32_t row)
+{
+    uint64_t x = key + (row + 1) * 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+} // namespace
+
+MemCache::MemCache(const MemCacheOptions &options)
+    : options(options),
+      shardCapacity(options.capacity / SHARD_NUM)
+{
+    uint64_t sketchSize = std::bit_ceil(std::clamp(shardCapacity / EXPECTED_FILE_SIZE * COUNTERS_PER_ENTRY,
+                                                   MIN_SKETCH_SIZE,
+                                                   MAX_SKETCH_SIZE));
+    for (auto &shard : shards) {
+        shard.sketch.assign(sketchSize, 0);
+        /* about ten lookups per counted entry before halving */
+        shard.samplePeriod = sketchSize / COUNTERS_PER_ENTRY * 10;
+    }
+}
+
+MemCache::Shard &MemCache::ShardOf(uint64_t key) { return shards[(key * 0x9E3779B97F4A7C15ULL) >> (64 - SHARD_BITS)]; }
+
+void MemCache::Record(Shard &shard, uint64_t key)
+{
+    uint64_t mask = shard.sketch.size() - 1;
+    for (uint32_t row = 0; row < COUNTER_ROWS; ++row) {
+        uint8_t &counter = shard.sketch[Mix(key, row) & mask];
+        if (counter < COUNTER_MAX) {
+            ++counter;
+        }
+    }
+    if (++shard.additions >= shard.samplePeriod) {
+        for (auto &counter : shard.sketch) {
+            counter >>= 1;
+        }
+        shard.additions /= 2;
+    }
+}
+
+uint32_t MemCache::Frequency(const Shard &shard, uint64_t key) const
+{
+    uint64_t mask = shard.sketch.size() - 1;
+    uint32_t frequency = COUNTER_MAX;
+    for (uint32_t row = 0; row < COUNTER_ROWS; ++row) {
+        frequency = std::min<uint32_t>(frequency, shard.sketch[Mix(key, row) & mask]);
+    }
+    return frequency;
+}
+
+void MemCache::Evict(Shard &shard, std::list<Entry>::iterator entry)
+{
+    shard.bytes -= entry->size;
+    shard.index.erase(entry->key);
+    shard.lru.erase(entry);
+}
+
+bool MemCache::Get(uint64_t key, char *buf, uint64_t size)
+{
+    Shard &shard = ShardOf(key);
+    std::shared_ptr<char[]> data;
+    {
+        std::lock_guard lock(shard.mutex);
+        Record(shard, key);
+        auto found = shard.index.find(key);
+        if (found == shard.index.end()) {
+            ++shard.stats.misses;
+            return false;
+        }
+        if (found->second->size != size) {
+            /* changed elsewhere, not worth keeping */
+            Evict(shard, found->second);
+            ++shard.stats.misses;
+            return false;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+        data = found->second->data;
+        ++shard.stats.hits;
+        shard.stats.bytesServed += size;
+    }
+    memcpy(buf, data.get(), size);
+    return true;
+}
+
+uint64_t MemCache::Epoch(uint64_t key) { return ShardOf(key).epoch.load(); }
+
+bool MemCache::Put(uint64_t key, const char *buf, uint64_t size, uint64_t epoch)
+{
+    if (!Fits(size) || size > shardCapacity) {
+        return false;
+    }
+    /* copied outside the lock, dropped if not admitted */
+    std::shared_ptr<char[]> data(new char[size]);
+    memcpy(data.get(), buf, size);
+
+    Shard &shard = ShardOf(key);
+    std::lock_guard lock(shard.mutex);
+    if (shard.epoch.load() != epoch) {
+        return false;
+    }
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        Evict(shard, found->second);
+    }
+    if (shard.bytes + size > shardCapacity) {
+        /* admitted only if more frequent than every victim */
+        uint64_t toFree = shard.bytes + size - shardCapacity;
+        uint32_t frequency = Frequency(shard, key);
+        uint64_t freed = 0;
+        auto victim = shard.lru.end();
+        while (freed < toFree) {
+            --victim;
+            if (Frequency(shard, victim->key) >= frequency) {
+                ++shard.stats.rejected;
+                return false;
+            }
+            freed += victim->size;
+        }
+        while (victim != shard.lru.end()) {
+            Evict(shard, victim++);
+            ++shard.stats.evictions;
+        }
+    }
+    shard.lru.push_front(Entry{key, size, std::move(data)});
+    shard.index[key] = shard.lru.begin();
+    shard.bytes += size;
+    ++shard.stats.admitted;
+    return true;
+}
+
+void MemCache::Erase(uint64_t key)
+{
+    Shard &shard = ShardOf(key);
+    std::lock_guard lock(shard.mutex);
+    ++shard.epoch;
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        Evict(shard, found->second);
+    }
+}
+
+MemCacheStats MemCache::GetStats()
+{
+    MemCacheStats result{};
+    for (auto &shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        result.entries += shard.index.size();
+        result.bytes += shard.bytes;
+        result.hits += shard.stats.hits;
+        result.misses += shard.stats.misses;
+        result.bytesServed += shard.stats.bytesServed;
+        result.admitted += shard.stats.admitted;
+        result.rejected += shard.stats.rejected;
+        result.evictions += shard.stats.evictions;
+    }
+    return result;
+}
@@ -0,0 +1,484 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "disk_cache/segment_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <sys/stat.h>
+
+#include "disk_cache/disk_cache.h"
+#include "io_engine/io_engine.h"
+#include "log/logging.h"
+#include "thread_pool/thread_pool.h"
+#include "util/utils.h"
+
+namespace {
+constexpr uint32_t RECORD_MAGIC = 0x43534731; // "CSG1"
+constexpr uint32_t RECORD_DEAD = 1;
+constexpr uint32_t RECORD_SEAL = 2;
+
+struct SegmentRecord
+{
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t inodeId;
+    uint64_t size; // of the file data following
+};
+
+/* remove a segment file, indexed by DiskCache or not */
+void DeleteSegmentFile(uint64_t key)
+{
+    DiskCache::GetInstance().Delete(key);
+    std::string path = GetFilePath(key);
+    if (remove(path.c_str()) != 0 && errno != ENOENT) {
+        CUCKOO_LOG(LOG_WARNING) << "Remove segment " << path << " failed: " << strerror(errno);
+    }
+}
+} // namespace
+
+SegmentCache::Segment::~Segment()
+{
+    if (fd >= 0) {
+        IoEngine::GetInstance().Close(fd);
+    }
+}
+
+SegmentCache::SegmentCache(const SegmentCacheOptions &options)
+    : options(options)
+{
+}
+
+SegmentCache::~SegmentCache() { Stop(); }
+
+uint64_t SegmentCache::KeyOf(const Segment &segment) { return SEGMENT_KEY_BIT | segment.id; }
+
+void SegmentCache::SetThreadPool(ThreadPool *newPool) { pool = newPool; }
+
+int SegmentCache::Start()
+{
+    std::string dir = GetSegmentDir();
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        int err = errno;
+        CUCKOO_LOG(LOG_ERROR) << "Create segment dir " << dir << " failed: " << strerror(err);
+        return -err;
+    }
+    DIR *dirp = opendir(dir.c_str());
+    if (dirp == nullptr) {
+        int err = errno;
+        CUCKOO_LOG(LOG_ERROR) << "Open segment dir " << dir << " failed: " << strerror(err);
+        return -err;
+    }
+    std::vector<uint32_t> ids;
+    for (const struct dirent *entry = readdir(dirp); entry != nullptr; entry = readdir(dirp)) {
+        char *end = nullptr;
+        unsigned long id = strtoul(entry->d_name, &end, 10);
+        if (end != entry->d_name && strcmp(end, ".seg") == 0) {
+            ids.push_back(static_cast<uint32_t>(id));
+        }
+    }
+    closedir(dirp);
+    /* a file in a later segment, or later in one, is the newer copy */
+    std::sort(ids.begin(), ids.end());
+
+    std::unordered_map<uint64_t, Location> found;
+    for (uint32_t id : ids) {
+        if (Load(id, found) != 0) {
+            CUCKOO_LOG(LOG_WARNING) << "Segment " << id << " was not sealed, dropped";
+            DeleteSegmentFile(SEGMENT_KEY_BIT | id);
+        }
+    }
+
+    std::vector<std::shared_ptr<Segment>> toCompact;
+    {
+        std::lock_guard appendLock(appendMutex);
+        std::unique_lock lock(mutex);
+        nextId = ids.empty() ? 0 : ids.back() + 1;
+        index = std::move(found);
+        for (auto &[inodeId, location] : index) {
+            location.segment->liveBytes += sizeof(SegmentRecord) + location.size;
+            location.segment->inodes.push_back(inodeId);
+        }
+        for (auto it = segments.begin(); it != segments.end();) {
+            Segment &segment = *it->second;
+            if (segment.liveBytes == 0) {
+                DeleteSegmentFile(KeyOf(segment));
+                it = segments.erase(it);
+                continue;
+            }
+            DiskCache::GetInstance().InsertAndUpdate(KeyOf(segment), segment.size, false);
+            if (segment.liveBytes < segment.size * options.compactRatio) {
+                segment.compacting = true;
+                toCompact.push_back(it->second);
+            }
+            ++it;
+        }
+        CUCKOO_LOG(LOG_INFO) << "SegmentCache: indexed " << index.size() << " files in " << segments.size()
+                             << " segments";
+    }
+    for (auto &segment : toCompact) {
+        ScheduleCompact(segment);
+    }
+    return 0;
+}
+
+int SegmentCache::Load(uint32_t id, std::unordered_map<uint64_t, Location> &found)
+{
+    auto segment = std::make_shared<Segment>();
+    segment->id = id;
+    std::string path = GetFilePath(KeyOf(*segment));
+    segment->fd = open(path.c_str(), O_RDWR);
+    struct stat st;
+    if (segment->fd < 0 || fstat(segment->fd, &st) != 0) {
+        return -EIO;
+    }
+    uint64_t fileSize = st.st_size;
+    std::vector<std::pair<uint64_t, Location>> records;
+    uint64_t offset = 0;
+    bool sealed = false;
+    while (offset + sizeof(SegmentRecord) <= fileSize) {
+        SegmentRecord record;
+        if (pread(segment->fd, &record, sizeof(record), offset) != sizeof(record) || record.magic != RECORD_MAGIC) {
+            break;
+        }
+        if (record.flags & RECORD_SEAL) {
+            sealed = offset + sizeof(record) == fileSize;
+            break;
+        }
+        if (offset + sizeof(record) + record.size > fileSize) {
+            break;
+        }
+        if (!(record.flags & RECORD_DEAD)) {
+            records.emplace_back(record.inodeId, Location{segment, offset, record.size});
+        }
+        offset += sizeof(record) + record.size;
+    }
+    if (!sealed) {
+        return -EIO;
+    }
+    segment->size = fileSize;
+    segment->sealed = true;
+    for (auto &[inodeId, location] : records) {
+        found[inodeId] = location;
+    }
+    std::unique_lock lock(mutex);
+    segments[id] = segment;
+    return 0;
+}
+
+void SegmentCache::Stop()
+{
+    {
+        std::unique_lock lock(compactMutex);
+        compactCV.wait(lock, [this]() { return compactRunning == 0; });
+    }
+    std::lock_guard appendLock(appendMutex);
+    if (active != nullptr) {
+        /* no compaction after stop, the next start indexes the segment as is */
+        SealLocked();
+    }
+}
+
+ssize_t SegmentCache::Read(uint64_t inodeId, char *buf, uint64_t bufSize)
+{
+    Location location;
+    {
+        std::shared_lock lock(mutex);
+        auto found = index.find(inodeId);
+        if (found == index.end()) {
+            ++misses;
+            return -ENOENT;
+        }
+        location = found->second;
+    }
+    /* a different size is a stale copy, replaced once loaded again */
+    if (location.size != bufSize) {
+        ++misses;
+        return -ENOENT;
+    }
+    uint64_t key = KeyOf(*location.segment);
+    if (!DiskCache::GetInstance().Find(key, true)) {
+        Drop(location.segment);
+        ++misses;
+        return -ENOENT;
+    }
+    ssize_t ret = IoEngine::GetInstance().Read(location.segment->fd,
+                                               buf,
+                                               location.size,
+                                               location.offset + sizeof(SegmentRecord));
+    DiskCache::GetInstance().Unpin(key);
+    if (ret != (ssize_t)location.size) {
+        CUCKOO_LOG(LOG_ERROR) << "SegmentCache: read inode " << inodeId << " from segment " << location.segment->id
+                              << " failed: " << strerror(ret < 0 ? -ret : EIO);
+        return ret < 0 ? ret : -EIO;
+    }
+    ++hits;
+    return ret;
+}
+
+int SegmentCache::Put(uint64_t inodeId, const char *buf, uint64_t size)
+{
+    if (!Fits(size)) {
+        return -EFBIG;
+    }
+    return Append(inodeId, buf, size, nullptr);
+}
+
+void SegmentCache::Remove(uint64_t inodeId)
+{
+    Location location;
+    std::shared_ptr<Segment> toCompact;
+    {
+        std::unique_lock lock(mutex);
+        auto found = index.find(inodeId);
+        if (found == index.end()) {
+            return;
+        }
+        location = found->second;
+        index.erase(found);
+        toCompact = UnlinkLocked(location);
+    }
+    /* synced, the copy must not come back after a crash */
+    MarkDead(location, true);
+    if (toCompact != nullptr) {
+        ScheduleCompact(toCompact);
+    }
+}
+
+SegmentCacheStats SegmentCache::GetStats()
+{
+    std::shared_lock lock(mutex);
+    SegmentCacheStats result = stats;
+    result.segments = segments.size();
+    result.files = index.size();
+    result.liveBytes = 0;
+    for (auto &[id, segment] : segments) {
+        result.liveBytes += segment->liveBytes;
+    }
+    result.hits = hits;
+    result.misses = misses;
+    return result;
+}
+
+std::shared_ptr<SegmentCache::Segment> SegmentCache::ActiveFor(uint64_t recordSize,
+                                                               std::shared_ptr<Segment> &toCompact)
+{
+    /* room is kept for the seal record */
+    if (active != nullptr && active->size > 0 &&
+        active->size + recordSize + sizeof(SegmentRecord) > options.segmentSize) {
+        toCompact = SealLocked();
+    }
+    if (active == nullptr) {
+        auto segment = std::make_shared<Segment>();
+        segment->id = nextId++;
+        std::string path = GetFilePath(KeyOf(*segment));
+        segment->fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (segment->fd < 0) {
+            CUCKOO_LOG(LOG_ERROR) << "Create segment " << path << " failed: " << strerror(errno);
+            return nullptr;
+        }
+        /* pinned while filled */
+        DiskCache::GetInstance().InsertAndUpdate(KeyOf(*segment), 0, true);
+        std::unique_lock lock(mutex);
+        segments[segment->id] = segment;
+        active = segment;
+    }
+    return active;
+}
+
+/* returns the sealed segment if it is to be compacted */
+std::shared_ptr<SegmentCache::Segment> SegmentCache::SealLocked()
+{
+    std::shared_ptr<Segment> segment = std::move(active);
+    SegmentRecord record{.magic = RECORD_MAGIC, .flags = RECORD_SEAL, .inodeId = 0, .size = 0};
+    uint64_t key = KeyOf(*segment);
+    bool written = IoEngine::GetInstance().Write(segment->fd, &record, sizeof(record), segment->size) ==
+                       sizeof(record) &&
+                   fdatasync(segment->fd) == 0;
+    if (!written) {
+        /* dropped at the next start */
+        CUCKOO_LOG(LOG_ERROR) << "SegmentCache: seal segment " << segment->id << " failed: " << strerror(errno);
+    }
+    DiskCache::GetInstance().Add(key, sizeof(record));
+    DiskCache::GetInstance().Unpin(key);
+
+    std::unique_lock lock(mutex);
+    segment->size += sizeof(record);
+    segment->sealed = true;
+    if (segments.contains(segment->id) && segment->liveBytes < segment->size * options.compactRatio) {
+        segment->compacting = true;
+        return segment;
+    }
+    return nullptr;
+}
+
+int SegmentCache::Append(uint64_t inodeId, const char *buf, uint64_t size, const Location *expected)
+{
+    uint64_t recordSize = sizeof(SegmentRecord) + size;
+    if (!DiskCache::GetInstance().PreAllocSpace(recordSize)) {
+        return -ENOSPC;
+    }
+    std::unique_lock appendLock(appendMutex);
+    std::shared_ptr<Segment> sealed;
+    std::shared_ptr<Segment> segment = ActiveFor(recordSize, sealed);
+    /* compaction appends, never schedule it under appendMutex */
+    auto compactSealed = [this, &appendLock, &sealed]() {
+        appendLock.unlock();
+        if (sealed != nullptr) {
+            ScheduleCompact(sealed);
+        }
+    };
+    if (segment == nullptr) {
+        DiskCache::GetInstance().FreePreAllocSpace(recordSize);
+        compactSealed();
+        return -EIO;
+    }
+    uint64_t offset = segment->size;
+    SegmentRecord record{.magic = RECORD_MAGIC, .flags = 0, .inodeId = inodeId, .size = size};
+    IoEngine &engine = IoEngine::GetInstance();
+    if (engine.Write(segment->fd, &record, sizeof(record), offset) != sizeof(record) ||
+        engine.Write(segment->fd, buf, size, offset + sizeof(record)) != (ssize_t)size) {
+        /* overwritten by the next record */
+        CUCKOO_LOG(LOG_ERROR) << "SegmentCache: write inode " << inodeId << " to segment " << segment->id
+                              << " failed";
+        DiskCache::GetInstance().FreePreAllocSpace(recordSize);
+        compactSealed();
+        return -EIO;
+    }
+    DiskCache::GetInstance().Add(KeyOf(*segment), recordSize);
+    DiskCache::GetInstance().FreePreAllocSpace(recordSize);
+
+    Location location{segment, offset, size};
+    Location old;
+    bool moved = false;
+    std::shared_ptr<Segment> toCompact;
+    {
+        std::unique_lock lock(mutex);
+        segment->size = offset + recordSize;
+        auto found = index.find(inodeId);
+        if (expected != nullptr && (found == index.end() || found->second.segment != expected->segment ||
+                                    found->second.offset != expected->offset)) {
+            moved = true;
+        } else {
+            if (found != index.end()) {
+                old = found->second;
+                toCompact = UnlinkLocked(old);
+            }
+            index[inodeId] = location;
+            segment->liveBytes += recordSize;
+            segment->inodes.push_back(inodeId);
+            if (expected == nullptr) {
+                ++stats.puts;
+            }
+        }
+    }
+    if (moved) {
+        /* removed or put again while being compacted */
+        MarkDead(location, false);
+    } else if (old.segment != nullptr && expected == nullptr) {
+        MarkDead(old, false);
+    }
+    compactSealed();
+    if (toCompact != nullptr) {
+        ScheduleCompact(toCompact);
+    }
+    return 0;
+}
+
+void SegmentCache::MarkDead(const Location &location, bool sync)
+{
+    uint32_t flags = RECORD_DEAD;
+    int fd = location.segment->fd;
+    if (IoEngine::GetInstance().Write(fd, &flags, sizeof(flags), location.offset + offsetof(SegmentRecord, flags)) !=
+            sizeof(flags) ||
+        (sync && fdatasync(fd) != 0)) {
+        CUCKOO_LOG(LOG_ERROR) << "SegmentCache: mark a file dead in segment " << location.segment->id
+                              << " failed: " << strerror(errno);
+    }
+}
+
+std::shared_ptr<SegmentCache::Segment> SegmentCache::UnlinkLocked(const Location &location)
+{
+    Segment &segment = *location.segment;
+    segment.liveBytes -= sizeof(SegmentRecord) + location.size;
+    if (segment.sealed && !segment.compacting && segments.contains(segment.id) &&
+        segment.liveBytes < segment.size * options.compactRatio) {
+        segment.compacting = true;
+        return location.segment;
+    }
+    return nullptr;
+}
+
+void SegmentCache::Drop(const std::shared_ptr<Segment> &segment)
+{
+    std::unique_lock lock(mutex);
+    if (segments.erase(segment->id) == 0) {
+        return;
+    }
+    for (uint64_t inodeId : segment->inodes) {
+        auto found = index.find(inodeId);
+        if (found != index.end() && found->second.segment == segment) {
+            index.erase(found);
+        }
+    }
+    CUCKOO_LOG(LOG_INFO) << "SegmentCache: segment " << segment->id << " was evicted";
+}
+
+void SegmentCache::ScheduleCompact(std::shared_ptr<Segment> segment)
+{
+    {
+        std::lock_guard lock(compactMutex);
+        ++compactRunning;
+    }
+    ThreadTask task{.taskName = "compact segment",
+                    .task = [this, segment]() { Compact(segment); },
+                    .priority = TaskPriority::BACKGROUND};
+    if (pool == nullptr || pool->TrySubmit(task) != 0) {
+        Compact(segment);
+    }
+}
+
+void SegmentCache::Compact(std::shared_ptr<Segment> segment)
+{
+    std::vector<std::pair<uint64_t, Location>> live;
+    {
+        std::shared_lock lock(mutex);
+        for (uint64_t inodeId : segment->inodes) {
+            auto found = index.find(inodeId);
+            if (found != index.end() && found->second.segment == segment) {
+                live.emplace_back(inodeId, found->second);
+            }
+        }
+    }
+    std::vector<char> buf;
+    uint64_t moved = 0;
+    for (auto &[inodeId, location] : live) {
+        buf.resize(location.size);
+        ssize_t ret = IoEngine::GetInstance().Read(segment->fd,
+                                                   buf.data(),
+                                                   location.size,
+                                                   location.offset + sizeof(SegmentRecord));
+        if (ret == (ssize_t)location.size && Append(inodeId, buf.data(), location.size, &location) == 0) {
+            ++moved;
+        }
+    }
+    /* what could not be moved is a miss from now on */
+    Drop(segment);
+    DeleteSegmentFile(KeyOf(*segment));
+    {
+        std::unique_lock lock(mutex);
+        ++stats.compactions;
+    }
+    CUCKOO_LOG(LOG_INFO) << "SegmentCache: compacted segment " << segment->id << ", moved " << moved << " files";
+
+    std::lock_guard lock(compactMutex);
+    --compactRunning;
+    compactCV.notify_all();
+}
@@ -40,11 +40,21 @@ class RemoteIOServiceImpl : public RemoteIOService {
                        ErrorCodeOnlyReply *response,
                        google::protobuf::Closure *done) override;
 
+    void ReadSmallFiles(google::protobuf::RpcController *cntl_base,
+                        const ReadSmallFilesRequest *request,
+                        ReadSmallFilesReply *response,
+                        google::protobuf::Closure *done) override;
+
     void WriteFile(google::protobuf::RpcController *cntl_base,
                    const WriteRequest *request,
                    WriteReply *response,
                    google::protobuf::Closure *done) override;
 
+    void WriteSmallFiles(google::protobuf::RpcController *cntl_base,
+                         const WriteSmallFilesRequest *request,
+                         WriteSmallFilesReply *response,
+                         google::protobuf::Closure *done) override;
+
     void DeleteFile(google::protobuf::RpcController *cntl_base,
                     const DeleteRequest *request,
                     ErrorCodeOnlyReply *response,
@@ -7,12 +7,33 @@
 #include <securec.h>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <brpc/channel.h>
 
 #include "brpc_io.pb.h"
 #include "util/utils.h"
 
+struct SmallFileRead
+{
+    uint64_t inodeId;
+    uint64_t size;
+    std::string path;
+    char *buffer;
+    bool nodeFail;
+    int result; // of this file, 0 or -errno
+};
+
+struct SmallFileWrite
+{
+    uint64_t inodeId;
+    std::string path;
+    std::string_view data; // the whole file
+    bool nodeFail;
+    int result; // of this file, 0 or -errno
+};
+
 class CuckooIOClient {
   public:
     CuckooIOClient()
@@ -33,6 +54,14 @@ class CuckooIOClient {
                  int BufferSize,
                  off_t offset,
                  const std::string &path = "");
+    // hands over the received attachment without copying it
+    int ReadFile(uint64_t inodeId,
+                 int oflags,
+                 butil::IOBuf &readBuf,
+                 uint64_t &physicalFd,
+                 int bufferSize,
+                 off_t offset,
+                 const std::string &path = "");
     int CloseFile(uint64_t physicalFd, bool isFlush, bool isSync, const char *buf, size_t size, off_t offset);
     int OpenFile(uint64_t inodeId,
                  int oflags,
@@ -41,14 +70,28 @@ class CuckooIOClient {
                  const std::string &path,
                  bool nodeFail);
     int WriteFile(uint64_t physicalFd, const char *writeBuffer, uint64_t size, off_t offset);
-    ssize_t
-    ReadSmallFile(uint64_t inodeId, ssize_t size, std::string &path, char *readBuffer, int oflags, bool nodeFail);
+    ssize_t ReadSmallFile(uint64_t inodeId,
+                          ssize_t size,
+                          std::string &path,
+                          char *readBuffer,
+                          int oflags,
+                          bool nodeFail,
+                          bool cachedOnly = false);
+    // one rpc for all files, at most READ_SMALL_FILES_MAX_NUM files and READ_SMALL_FILES_MAX_BYTES
+    int ReadSmallFiles(std::vector<SmallFileRead> &files, int oflags);
+    // create, write and close new files in one rpc, limits as ReadSmallFiles
+    int WriteSmallFiles(std::vector<SmallFileWrite> &files);
     int DeleteFile(uint64_t inodeId, int nodeId, std::string &path);
     int StatFS(std::string &path, struct StatFSBuf *fsBuf);
     int TruncateOpenInstance(uint64_t physicalFd, off_t size);
     int TruncateFile(uint64_t physicalFd, off_t size);
     int CheckConnection();
 
+    static constexpr size_t READ_SMALL_FILES_MAX_NUM = 1024;
+    static constexpr uint64_t READ_SMALL_FILES_MAX_BYTES = 32 * 1024 * 1024;
+    static constexpr size_t WRITE_SMALL_FILES_MAX_NUM = READ_SMALL_FILES_MAX_NUM;
+    static constexpr uint64_t WRITE_SMALL_FILES_MAX_BYTES = READ_SMALL_FILES_MAX_BYTES;
+
   private:
     std::shared_ptr<brpc::Channel> channel;
     std::unique_ptr<cuckoo::brpc_io::RemoteIOService_Stub> stub;
@@ -6,9 +6,11 @@
 
 #include <memory>
 #include <shared_mutex>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "connection/placement.h"
 #include "cuckoo_io_client.h"
 
 class StoreNode {
@@ -17,8 +19,12 @@ class StoreNode {
     int initStatus = 0;
     int nodeId;
     std::unordered_map<int, std::pair<std::string, std::shared_ptr<CuckooIOClient>>> nodeMap;
+    std::unique_ptr<NodePlacement> placement = NodePlacement::Create("ring");
+    // must hold nodeMutex exclusively
+    void RebuildPlacement();
 
   public:
+    void SetPlacementPolicy(std::string_view policy);
     void SetNodeConfig(int initNodeId, std::string &clusterView);
     int SetNodeConfig(std::string &rootPath);
     static StoreNode *GetInstance();
@@ -0,0 +1,55 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+uint64_t hash64(uint64_t x);
+
+/*
+ * Maps a hashed key onto one of the store nodes. Implementations are rebuilt from the
+ * full membership on every change and are read-only afterwards, so lookups need no locking
+ * beyond what protects the owner's pointer.
+ */
+class NodePlacement {
+  public:
+    virtual ~NodePlacement() = default;
+    // nodes: pairs of nodeId and weight, weight 0 is treated as 1
+    virtual void Rebuild(const std::vector<std::pair<int, uint32_t>> &nodes) = 0;
+    // return -1 when there is no node
+    virtual int Locate(uint64_t key) const = 0;
+
+    static std::unique_ptr<NodePlacement> Create(std::string_view policy);
+};
+
+/* Consistent hash ring with virtual nodes, O(log n) lookup, only ~1/n keys move per join/leave. */
+class RingPlacement : public NodePlacement {
+  public:
+    static constexpr uint32_t VIRTUAL_NODES_PER_WEIGHT = 160;
+
+    void Rebuild(const std::vector<std::pair<int, uint32_t>> &nodes) override;
+    int Locate(uint64_t key) const override;
+
+  private:
+    std::vector<std::pair<uint64_t, int>> ring; // sorted by point
+};
+
+/*
+ * Jump consistent hash over node ids in ascending order, O(ln n) lookup and no extra memory.
+ * Movement is minimal when nodes join or leave at the highest id, removing a node in the
+ * middle reshuffles the buckets above it. Weights are ignored.
+ */
+class JumpPlacement : public NodePlacement {
+  public:
+    void Rebuild(const std::vector<std::pair<int, uint32_t>> &nodes) override;
+    int Locate(uint64_t key) const override;
+
+  private:
+    std::vector<int> buckets;
+};
@@ -10,6 +10,7 @@
 #include <cstring>
 #include <memory>
 #include <mutex>
+#include <string_view>
 #include <unordered_map>
 
 #include <sys/statvfs.h>
@@ -18,7 +19,13 @@
 
 #include "buffer/cuckoo_buffer.h"
 #include "buffer/open_instance.h"
+#include "disk_cache/mem_cache.h"
+#include "disk_cache/segment_cache.h"
+#include "storage/multipart_upload.h"
+#include "storage/object_layout.h"
+#include "storage/range_download.h"
 #include "storage/storage.h"
+#include "storage/write_back.h"
 #include "thread_pool/thread_pool.h"
 #include "util/file_lock.h"
 
@@ -27,18 +34,48 @@ class CuckooStore {
     void SetCuckooStoreParam(std::string &newNodeConfig);
     static CuckooStore *GetInstance();
     void DeleteInstance();
+    /* shared by the fan-out of batch calls */
+    ThreadPool *GetThreadPool() { return storeThreadPool.get(); }
 
     /*-----------------read-----------------*/
     int ReadFile(OpenInstance *openInstance, char *buffer, size_t size, off_t offset);
-    ssize_t ReadFileLR(char *readBuffer, off_t offset, OpenInstance *openInstance, size_t readBufferSize);
+    /* with remoteBuf, data of a remote file is handed over in remoteBuf and readBuffer is left untouched */
+    ssize_t ReadFileLR(char *readBuffer,
+                       off_t offset,
+                       OpenInstance *openInstance,
+                       size_t readBufferSize,
+                       butil::IOBuf *remoteBuf = nullptr);
+    ssize_t ReadFileLRForBrpc(OpenInstance *openInstance, butil::IOBuf &buf, size_t size, off_t offset);
+    /* read the file directly, bypassing readStream */
+    int RandomRead(CuckooReadBuffer buf, OpenInstance *openInstance, off_t offset);
     int ReadSmallFiles(OpenInstance *openInstance);
-    int
-    ReadSmallFilesForBrpc(uint64_t inodeId, const std::string &path, char *buf, size_t size, int oflags, bool nodeFail);
+    /* ReadSmallFiles of many files, with one rpc per remote node, results[i] is that of openInstances[i] */
+    void ReadSmallFilesBatch(const std::vector<OpenInstance *> &openInstances, std::vector<int> &results);
+    /* with cachedOnly, a miss fails with -ENOENT and nothing is loaded or cached */
+    int ReadSmallFilesForBrpc(uint64_t inodeId,
+                              const std::string &path,
+                              char *buf,
+                              size_t size,
+                              int oflags,
+                              bool nodeFail,
+                              bool cachedOnly = false);
+    /*
+     * Read a small file at its cached placement, ahead of the open reply confirming it. Only cached content
+     * is read, and a failure neither switches nor drops the node, the open reads it again if needed.
+     */
+    int ReadSmallFileSpeculative(OpenInstance *openInstance);
 
     /*-----------------func-----------------*/
     int OpenFile(OpenInstance *openInstance);
     int WriteFile(OpenInstance *openInstance, const char *buf, size_t size, off_t offset);
     int WriteLocalFileForBrpc(OpenInstance *openInstance, butil::IOBuf &buf, off_t offset);
+    /* write a new file whole, then flush and close it */
+    int WriteSmallFile(OpenInstance *openInstance, std::string_view data);
+    /* WriteSmallFile of many files, with one rpc per remote node, results[i] is that of openInstances[i] */
+    void WriteSmallFilesBatch(const std::vector<OpenInstance *> &openInstances,
+                              const std::vector<std::string_view> &datas,
+                              std::vector<int> &results);
+    int WriteSmallFileForBrpc(uint64_t inodeId, const std::string &path, butil::IOBuf &buf, bool nodeFail);
     int CloseTmpFiles(OpenInstance *openInstance, bool isFlush, bool isSync);
     int DeleteFiles(uint64_t inodeId, int nodeId, std::string path);
     int StatFS(struct statvfs *vfsbuf);
@@ -48,7 +85,9 @@ class CuckooStore {
                       uint64_t &fbavail,
                       uint64_t &ffiles,
                       uint64_t &fffree);
-    int CopyData(const std::string &srcName, const std::string &dstName);
+    /* persisted data is not moved by a rename, which is then a pure metadata operation */
+    bool RenameKeepsData();
+    int CopyData(const std::string &srcName, const std::string &dstName, uint64_t inodeId);
     int DeleteDataAfterRename(const std::string &objectName);
     int TruncateFile(OpenInstance *openInstance, off_t size);
     int TruncateOpenInstance(OpenInstance *openInstance, off_t size);
@@ -60,12 +99,18 @@ class CuckooStore {
 
   private:
     /*-----------------read-----------------*/
-    bool StartPreReadThreaded(OpenInstance *openInstance);
-    void StopPreReadThreaded(OpenInstance *openInstance);
+    void StartPreRead(OpenInstance *openInstance);
+    void StopPreRead(OpenInstance *openInstance);
     int ReadToBuffer(CuckooReadBuffer buf, OpenInstance *openInstance, off_t offset);
-    int RandomRead(CuckooReadBuffer buf, OpenInstance *openInstance, off_t offset);
-    int SequenceRead(CuckooReadBuffer buf, OpenInstance *openInstance, off_t offset);
     int WriteToFileAsync(uint64_t inodeId, std::string &fileName, std::shared_ptr<char> buf, size_t bufSize);
+    /* put a small file into segmentCache in background, loaded from storage when buf is null */
+    void PackAsync(uint64_t inodeId, const std::string &path, std::shared_ptr<char> buf, size_t bufSize);
+    /* memCache lookup of a small file, counted in CuckooStats */
+    bool ReadFromMemory(uint64_t inodeId, char *buf, size_t size);
+    /* epoch is taken from memCache before the file was read */
+    void KeepInMemory(uint64_t inodeId, const char *buf, size_t size, uint64_t epoch);
+    /* the file changes, drop its copies in memCache and segmentCache */
+    void DropCachedCopies(uint64_t inodeId);
 
     /*-----------------func-----------------*/
     int OpenFileFromRemote(OpenInstance *openInstance, bool largeFile);
@@ -85,7 +130,12 @@ class CuckooStore {
                                    size_t bufSize,
                                    bool isSync,
                                    bool toBuffer);
-    int FlushToStorage(std::string path, uint64_t inodeId);
+    /* large objects are loaded as parallel ranges, fd is taken over */
+    int DownLoadRanges(OpenInstance *openInstance, int fd, std::shared_ptr<FileLocker> lockerPtr, bool isSync);
+    /* parts already sent by streamed are reused when still valid */
+    int FlushToStorage(std::string path, uint64_t inodeId, std::shared_ptr<MultipartUpload> streamed = nullptr);
+    /* data written to the local cache file of a writable openInstance, streamed to storage */
+    void StreamWritten(OpenInstance *openInstance, uint64_t offset, uint64_t size);
     int StatFsStorage(struct statvfs *vfsbuf);
 
   private:
@@ -102,6 +152,22 @@ class CuckooStore {
     std::mutex mutex;
     std::string dataPath;
     std::unique_ptr<ThreadPool> storeThreadPool;
+    ReadAheadOptions readAheadOptions;
+    uint64_t downloadRangeSize{8 * 1024 * 1024};
+    uint32_t downloadParallelism{8};
+    /* running ranged downloads, for opens coming while they are on */
+    std::mutex downloadMutex;
+    std::unordered_map<uint64_t, std::shared_ptr<RangeDownload>> downloads;
+    uint64_t uploadPartSize{16 * 1024 * 1024};
+    uint32_t uploadParallelism{4};
+    bool uploadStreaming{false};
+    /* with cuckoo_async, flushed files are uploaded by it instead of in CloseTmpFiles */
+    std::unique_ptr<WriteBack> writeBack;
+    ObjectLayout objectLayout;
+    /* small read-only files packed into segments, instead of a cache file each */
+    std::unique_ptr<SegmentCache> segmentCache;
+    /* hot small files in DRAM, looked up before both disk caches */
+    std::unique_ptr<MemCache> memCache;
     Storage *storage;
     std::jthread statsThread;
 };
@@ -7,11 +7,13 @@
 #include <dirent.h>
 #include <securec.h>
 #include <atomic>
+#include <condition_variable>
 #include <list>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #ifndef RETURN_OK
@@ -22,14 +24,42 @@
 #define RETURN_ERROR (-1)
 #endif
 
+class ThreadPool;
+
 struct CacheItem
 {
     uint64_t inode{0};
     uint64_t size{0};
     uint64_t atime{0};
     uint32_t refs{0};
+    bool referenced{false}; // hit since the eviction hand last passed
+    bool hot{false};        // in the protected queue
+    bool unverified{false}; // restored from the snapshot, file not checked yet
 };
 
+struct DiskCacheShardStats
+{
+    uint64_t entries;
+    uint64_t probationBytes;
+    uint64_t hotBytes;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t inserts;
+    uint64_t evictions;
+    uint64_t promotions; // probation entries hit again before being evicted
+    uint64_t ghostHits;  // entries inserted again soon after eviction from probation
+};
+
+/*
+ * Index of the local cache files, split into SHARD_NUM shards by inode hash, each with its own lock.
+ * Every shard evicts with 2Q over CLOCK: new files enter a FIFO probation queue, a hit only marks
+ * the entry, and the eviction hand promotes marked entries to a protected queue where hits again
+ * only mark and the hand gives marked entries a second chance. Probation is kept to about a
+ * quarter of the shard, so a single pass over a large dataset can not flush the protected set.
+ * Keys evicted from probation are remembered for a while, inserting them again goes straight to
+ * the protected queue. Pinned entries are never evicted.
+ */
+
 class DiskCache {
   public:
     static DiskCache &GetInstance()
@@ -40,7 +70,11 @@ class DiskCache {
     DiskCache() = default;
     DiskCache(float ratio);
     ~DiskCache();
-    int Start(std::string &path, int dirNum, float ratio, float bgEvitRatio);
+    int Start(std::string &path,
+              int dirNum,
+              float ratio,
+              float bgEvitRatio,
+              uint32_t snapshotIntervalSec = DEFAULT_SNAPSHOT_INTERVAL);
     bool Find(uint64_t key, bool needPin);
     void DeleteOldCacheWithNoPin(uint64_t key);
     void InsertAndUpdate(uint64_t key, uint64_t size, bool needPin);
@@ -48,13 +82,38 @@ class DiskCache {
     bool Update(uint64_t key, uint64_t size);
     int Delete(uint64_t key);
     void Evict(uint64_t size);
+    /* evict unpinned files until both targets are met or nothing is left to evict */
+    void EvictFiles(uint64_t toFreeCap, uint64_t toFreeInode);
     void Unpin(uint64_t key);
     void Pin(uint64_t key);
     bool PreAllocSpace(uint64_t size);
     void FreePreAllocSpace(uint64_t size);
     bool HasFreeSpace();
+    /* background eviction runs on pool once set, instead of the cleanup thread */
+    void SetThreadPool(ThreadPool *pool);
+    std::vector<DiskCacheShardStats> GetShardStats();
+    /* write the index to SNAPSHOT_NAME under the cache root, clean only when no file is written after */
+    int SaveSnapshot(bool clean);
+
+    static constexpr uint32_t SHARD_BITS = 6;
+    static constexpr uint32_t SHARD_NUM = 1 << SHARD_BITS;
+    static constexpr uint32_t DEFAULT_SNAPSHOT_INTERVAL = 300;
+    static constexpr const char *SNAPSHOT_NAME = "cache_index.snap";
 
   private:
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<CacheItem> probation;
+        std::list<CacheItem> hot;
+        std::unordered_map<uint64_t, std::list<CacheItem>::iterator> index;
+        std::list<uint64_t> ghostQueue;
+        std::unordered_set<uint64_t> ghosts;
+        uint64_t probationBytes{0};
+        uint64_t hotBytes{0};
+        DiskCacheShardStats stats{};
+    };
+
     uint64_t totalCap{0};
     std::atomic<uint64_t> freeCap{0};
     float blockRatio{0.0};
@@ -66,17 +125,25 @@ class DiskCache {
 
     bool testOBS = false;
 
-    uint64_t usedCap{0};
+    std::atomic<uint64_t> usedCap{0};
+    std::atomic<uint64_t> entryNum{0};
 
     std::string rootDir;
-    std::list<CacheItem> cacheItems;
-    using cacheIterator = std::list<CacheItem>::iterator;
-    std::unordered_map<uint64_t, cacheIterator> inodeToCacheIter;
+    Shard shards[SHARD_NUM];
+    std::atomic<uint32_t> evictCursor{0};
+    /* protects the space figures below and serializes eviction */
     std::mutex mutex;
 
     std::thread cleanupThread;
+    std::mutex stopMutex;
+    std::condition_variable stopCV;
     std::atomic<bool> stop{false};
+    std::atomic<bool> started{false};
+    uint32_t snapshotInterval{DEFAULT_SNAPSHOT_INTERVAL};
+    std::mutex snapshotMutex;
     std::atomic<bool> hasFreeSpace{true};
+    std::atomic<ThreadPool *> evictPool{nullptr};
+    std::atomic<bool> evicting{false};
 
     int totalDirNum{101};
 
@@ -88,9 +155,20 @@ class DiskCache {
     static std::vector<CacheItem> initCacheVector;
     int GetCurFreeRatio();
     void CheckFreeSpace();
+    void TriggerEvict();
+    void BackgroundEvict();
     void Cleanup();
     void CleanupForEvict(uint64_t size);
+    bool EvictOne(Shard &shard, uint64_t &freedSize);
+    bool EvictFrom(Shard &shard, bool fromHot, uint64_t &freedSize);
+    void Erase(Shard &shard, std::list<CacheItem>::iterator item);
+    void PinLocked(CacheItem &item);
+    Shard &ShardOf(uint64_t key);
     int ScanCache();
     static int Walk(std::string dirPath);
+    int LoadSnapshot(bool &clean);
+    void Restore(const void *entries, uint64_t num);
+    void Reconcile(time_t loadTime);
+    bool Verify(Shard &shard, std::list<CacheItem>::iterator item);
     int CheckSpaceEnough();
 };
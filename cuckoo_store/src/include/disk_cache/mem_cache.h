@@ -0,0 +1,94 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct MemCacheOptions
+{
+    uint64_t capacity = 256 * 1024 * 1024;
+    uint64_t maxFileSize = 1024 * 1024; // larger files are never cached
+};
+
+struct MemCacheStats
+{
+    uint64_t entries;
+    uint64_t bytes;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t bytesServed;
+    uint64_t admitted;
+    uint64_t rejected; // by the admission filter
+    uint64_t evictions;
+};
+
+/*
+ * DRAM cache of whole small files above DiskCache, split into SHARD_NUM shards by inode hash.
+ * Each shard keeps an LRU list and a TinyLFU admission filter: a count-min sketch of 4-bit
+ * counters counts every lookup and is halved every sample period, so it follows recent
+ * popularity. A file is only admitted into a full shard if it was looked up more often than each
+ * LRU entry it would push out, a single scan does not flush the hot files.
+ * Erase bumps the shard's epoch, a Put with an epoch taken before the erase is dropped, so a
+ * read racing with a write can not put back the old content.
+ */
+class MemCache {
+  public:
+    explicit MemCache(const MemCacheOptions &options);
+    MemCache(const MemCache &) = delete;
+    MemCache &operator=(const MemCache &) = delete;
+
+    bool Fits(uint64_t size) const { return size > 0 && size <= options.maxFileSize; }
+    /* copy the file into buf if cached with this size */
+    bool Get(uint64_t key, char *buf, uint64_t size);
+    /* take before reading the file from below, for Put */
+    uint64_t Epoch(uint64_t key);
+    /* returns whether the file was admitted */
+    bool Put(uint64_t key, const char *buf, uint64_t size, uint64_t epoch);
+    /* the file is about to change or be deleted */
+    void Erase(uint64_t key);
+    MemCacheStats GetStats();
+
+    static constexpr uint32_t SHARD_BITS = 4;
+    static constexpr uint32_t SHARD_NUM = 1 << SHARD_BITS;
+
+  private:
+    struct Entry
+    {
+        uint64_t key;
+        uint64_t size;
+        std::shared_ptr<char[]> data;
+    };
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<Entry> lru; // most recent first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        uint64_t bytes{0};
+        std::atomic<uint64_t> epoch{0};
+        /* TinyLFU sketch, COUNTER_ROWS counters of a key spread over one table */
+        std::vector<uint8_t> sketch;
+        uint64_t additions{0};
+        uint64_t samplePeriod{0};
+        MemCacheStats stats{};
+    };
+
+    Shard &ShardOf(uint64_t key);
+    void Record(Shard &shard, uint64_t key);
+    uint32_t Frequency(const Shard &shard, uint64_t key) const;
+    void Evict(Shard &shard, std::list<Entry>::iterator entry);
+
+    static constexpr uint32_t COUNTER_ROWS = 4;
+    static constexpr uint8_t COUNTER_MAX = 15;
+
+    MemCacheOptions options;
+    uint64_t shardCapacity;
+    Shard shards[SHARD_NUM];
+};
@@ -0,0 +1,124 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+struct SegmentCacheOptions
+{
+    uint64_t segmentSize = 64 * 1024 * 1024;
+    uint64_t maxFileSize = 1024 * 1024; // larger files keep a cache file of their own
+    float compactRatio = 0.5;           // sealed segments with less live data are compacted
+};
+
+struct SegmentCacheStats
+{
+    uint64_t segments;
+    uint64_t files;
+    uint64_t liveBytes;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t puts;
+    uint64_t compactions;
+};
+
+/*
+ * Cache of small read-only files packed into segment files under GetSegmentDir(), so that a read is a
+ * single pread on a segment fd kept open, with no open/close and no inode per file.
+ * A segment is one DiskCache entry of key SEGMENT_KEY_BIT | id and evicted as a whole, reads pin
+ * it and see an evicted segment as a miss. Files are appended to the active segment, which is
+ * pinned; once full it is synced and sealed by a trailing record. Removed files are marked dead
+ * in place, and a sealed segment with less than compactRatio of live data has its live files
+ * moved to the active segment and is deleted.
+ * Start indexes the sealed segments of an earlier run, the active one of a crashed run is dropped.
+ */
+class SegmentCache {
+  public:
+    explicit SegmentCache(const SegmentCacheOptions &options);
+    ~SegmentCache();
+    SegmentCache(const SegmentCache &) = delete;
+    SegmentCache &operator=(const SegmentCache &) = delete;
+
+    /* after DiskCache is started and the cache root is set */
+    int Start();
+    /* seal the active segment */
+    void Stop();
+    /* compaction runs on pool once set, otherwise on the thread removing the file */
+    void SetThreadPool(ThreadPool *pool);
+    bool Fits(uint64_t size) const { return size > 0 && size <= options.maxFileSize; }
+
+    /* whole file into buf, returns its size, -ENOENT when not cached or -errno */
+    ssize_t Read(uint64_t inodeId, char *buf, uint64_t bufSize);
+    /* cache a file, replacing an older copy */
+    int Put(uint64_t inodeId, const char *buf, uint64_t size);
+    /* the file is about to change or be deleted, returns once the copy can not come back */
+    void Remove(uint64_t inodeId);
+    SegmentCacheStats GetStats();
+
+  private:
+    struct Segment
+    {
+        uint32_t id{0};
+        int fd{-1};
+        uint64_t size{0};
+        uint64_t liveBytes{0};
+        bool sealed{false};
+        bool compacting{false};
+        std::vector<uint64_t> inodes; // ever put here, some may be gone
+        ~Segment();
+    };
+    struct Location
+    {
+        std::shared_ptr<Segment> segment;
+        uint64_t offset{0}; // of the record header
+        uint64_t size{0};
+    };
+
+    static uint64_t KeyOf(const Segment &segment);
+    /*
+     * under appendMutex, a segment sealed on the way that needs compaction is left in toCompact: compaction
+     * appends, so it is scheduled only once appendMutex is released
+     */
+    std::shared_ptr<Segment> ActiveFor(uint64_t recordSize, std::shared_ptr<Segment> &toCompact);
+    std::shared_ptr<Segment> SealLocked();
+    /* append unless expected is set and the file moved away from it */
+    int Append(uint64_t inodeId, const char *buf, uint64_t size, const Location *expected);
+    void MarkDead(const Location &location, bool sync);
+    /* under mutex, returns the segment to compact if removing location made one */
+    std::shared_ptr<Segment> UnlinkLocked(const Location &location);
+    void Drop(const std::shared_ptr<Segment> &segment);
+    void Compact(std::shared_ptr<Segment> segment);
+    void ScheduleCompact(std::shared_ptr<Segment> segment);
+    int Load(uint32_t id, std::unordered_map<uint64_t, Location> &found);
+
+    SegmentCacheOptions options;
+    ThreadPool *pool{nullptr};
+
+    std::shared_mutex mutex;
+    std::unordered_map<uint64_t, Location> index;
+    std::unordered_map<uint32_t, std::shared_ptr<Segment>> segments;
+    SegmentCacheStats stats{};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+    std::mutex appendMutex;
+    std::shared_ptr<Segment> active;
+    uint32_t nextId{0};
+
+    std::mutex compactMutex;
+    std::condition_variable compactCV;
+    uint32_t compactRunning{0};
+};
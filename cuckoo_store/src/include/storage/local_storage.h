@@ -0,0 +1,75 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "storage.h"
+
+struct LocalStorageOptions
+{
+    std::string root = "/tmp/cuckoo_storage";
+    uint32_t latencyUs = 0;     // added to every request
+    uint32_t bandwidthMBps = 0; // shared by all requests, 0 for unlimited
+};
+
+/*
+ * Object storage on a local directory, object keys are paths relative to the root.
+ * Meant for benchmarking the persist/evict/reload path and for offline tiering without an object
+ * store: every request pays latencyUs, and data moves through a single link of bandwidthMBps in
+ * chunks, so concurrent transfers share it the way they share a network link.
+ * Objects are written to a temporary file and renamed, readers never see a partial object.
+ * Parts of a multipart upload are kept under MULTIPART_DIR until completed or aborted.
+ */
+class LocalStorage : public Storage {
+  private:
+    std::atomic<bool> isInit{false};
+    LocalStorageOptions options;
+    std::mutex linkMutex;
+    std::chrono::steady_clock::time_point linkFreeTime{};
+    std::atomic<uint64_t> tmpSeq{0};
+    LocalStorage() = default;
+
+    std::string ObjectPath(const std::string &objectKey);
+    static std::string UploadKey(const std::string &uploadId);
+    static std::string PartKey(const std::string &uploadId, uint32_t partNumber);
+    int CreateParent(const std::string &path);
+    void Delay();
+    void Transfer(uint64_t size);
+    int WriteObject(const std::string &objectKey, int srcFd, const char *buf, uint64_t size);
+
+  public:
+    ~LocalStorage() noexcept override = default;
+
+    static LocalStorage *GetInstance();
+    /* before Init */
+    void SetOptions(const LocalStorageOptions &newOptions);
+    void DeleteInstance() override;
+    int Init() override;
+
+    ssize_t ReadObject(const std::string &objectKey, uint64_t offset, uint64_t size, int fd, char *destBuffer) override;
+    int PutFile(const std::string &objectKey, const std::string &filePath) override;
+    ssize_t
+    PutBuffer(const std::string &objectKey, const char *buf, const uint64_t size, const uint64_t offset) override;
+    int DeleteObject(const std::string &objectKey) override;
+    int CopyObject(const std::string &fromPath, const std::string &toPath) override;
+    int StatFs(struct statvfs *vfsbuf) override;
+    int InitMultipartUpload(const std::string &objectKey, std::string &uploadId) override;
+    int UploadPart(const std::string &objectKey,
+                   const std::string &uploadId,
+                   uint32_t partNumber,
+                   const char *buf,
+                   uint64_t size,
+                   std::string &etag) override;
+    int CompleteMultipartUpload(const std::string &objectKey,
+                                const std::string &uploadId,
+                                const std::vector<std::string> &etags) override;
+    int AbortMultipartUpload(const std::string &objectKey, const std::string &uploadId) override;
+
+    static constexpr uint64_t TRANSFER_CHUNK_SIZE = 1024 * 1024;
+    static constexpr const char *MULTIPART_DIR = ".multipart";
+};
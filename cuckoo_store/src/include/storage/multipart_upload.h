@@ -0,0 +1,84 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "storage.h"
+
+class ThreadPool;
+
+/*
+ * Upload of a local cache file as a multipart object, parts read from the file and sent by up to
+ * parallelism tasks on the pool.
+ * While the file is being written, Written reports the data that hit the file: every part below
+ * the end of a sequential write from offset 0 is sent at once, so by Finish only the tail is left.
+ * A write below a part already sent, a hole, or a truncate makes the streamed parts stale, Finish
+ * then fails with -ESTALE and the caller uploads the file again.
+ * A failed Finish aborts the upload, so does destruction without Finish. Must be owned by a
+ * shared_ptr, running tasks keep it alive.
+ */
+class MultipartUpload : public std::enable_shared_from_this<MultipartUpload> {
+  public:
+    /* fd is taken over, it must be readable */
+    MultipartUpload(Storage *storage,
+                    ThreadPool *pool,
+                    const std::string &objectKey,
+                    int fd,
+                    uint64_t partSize,
+                    uint32_t parallelism);
+    ~MultipartUpload();
+    MultipartUpload(const MultipartUpload &) = delete;
+    MultipartUpload &operator=(const MultipartUpload &) = delete;
+
+    /* [offset, offset + size) is in the file */
+    void Written(uint64_t offset, uint64_t size);
+    void Truncated(uint64_t size);
+    /* send the parts left up to fileSize and complete, returns 0 or -errno, called once */
+    int Finish(uint64_t fileSize);
+    /* any part sent before Finish */
+    bool Streamed();
+    uint64_t PartSize() const { return partSize; }
+
+    static constexpr uint32_t MAX_PART_NUM = 10000;
+
+  private:
+    using Part = std::pair<uint32_t, uint64_t>; // (index, size)
+    void QueueLocked(uint32_t part, uint64_t size);
+    /* parts allowed to start, launched after the lock is dropped, the pool may run them inline */
+    std::vector<Part> TakeLocked();
+    void Launch(const std::vector<Part> &parts);
+    void Run(uint32_t part, uint64_t size);
+    int Begin();
+    void Abort();
+
+    Storage *storage;
+    ThreadPool *pool;
+    std::string objectKey;
+    int fd;
+    uint64_t partSize;
+    uint32_t parallelism;
+
+    std::mutex mutex;
+    std::condition_variable idleCV;
+    std::deque<Part> pending;
+    uint32_t inflight{0};
+    uint32_t nextPart{0};
+    uint64_t writtenEnd{0};
+    bool stale{false};
+    bool closed{false}; // completed or aborted
+    int result{0};
+    std::vector<std::string> etags;
+
+    std::once_flag beginOnce;
+    int beginResult{0};
+    std::string uploadId;
+};
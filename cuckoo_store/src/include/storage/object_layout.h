@@ -0,0 +1,43 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "storage.h"
+
+/*
+ * Object keys of files. By path, or with cuckoo_object_layout "inode" by inodeId under INODE_OBJECT_DIR,
+ * so a rename keeps the object. While migrating from the path layout, a file not flushed or renamed since
+ * may still be keyed by path: reads fall back to that key, flushes and renames move it, deletes drop both.
+ */
+class ObjectLayout {
+  public:
+    ObjectLayout() = default;
+    ObjectLayout(Storage *storage, bool inodeKeyed, bool migrate);
+
+    bool InodeKeyed() const { return inodeKeyed; }
+    bool Migrating() const { return migrate; }
+    std::string Key(const std::string &path, uint64_t inodeId) const;
+    ssize_t Read(const std::string &path, uint64_t inodeId, uint64_t offset, uint64_t size, int fd, char *buf);
+    /* key to load from, probed while migrating */
+    std::string LoadKey(const std::string &path, uint64_t inodeId);
+    /* the file was flushed to Key, a path keyed object left is older */
+    void DropPathObject(const std::string &path);
+    /* on rename, copy a path keyed object to Key unless already there, the old key is deleted after */
+    int Migrate(const std::string &path, uint64_t inodeId);
+    /* while migrating, a file is deleted if either key held it */
+    int Delete(const std::string &path, uint64_t inodeId);
+
+    static constexpr const char *INODE_OBJECT_DIR = ".inode";
+
+  private:
+    bool Exists(const std::string &key);
+
+    Storage *storage{nullptr};
+    bool inodeKeyed{false};
+    bool migrate{false};
+};
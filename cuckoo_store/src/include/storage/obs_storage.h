@@ -59,4 +59,15 @@ class OBSStorage : public Storage {
     int DeleteObject(const std::string &objectKey) override;
     int CopyObject(const std::string &fromPath, const std::string &toPath) override;
     int StatFs(struct statvfs *vfsbuf) override;
+    int InitMultipartUpload(const std::string &objectKey, std::string &uploadId) override;
+    int UploadPart(const std::string &objectKey,
+                   const std::string &uploadId,
+                   uint32_t partNumber,
+                   const char *buf,
+                   uint64_t size,
+                   std::string &etag) override;
+    int CompleteMultipartUpload(const std::string &objectKey,
+                                const std::string &uploadId,
+                                const std::vector<std::string> &etags) override;
+    int AbortMultipartUpload(const std::string &objectKey, const std::string &uploadId) override;
 };
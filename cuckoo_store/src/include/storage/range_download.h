@@ -0,0 +1,73 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "storage.h"
+
+class ThreadPool;
+
+/*
+ * Download of one object into a local cache file as parallel ranged GETs.
+ * The object is split into ranges of rangeSize, up to parallelism tasks on the pool claim them in
+ * order and pwrite each one at its offset. A range is marked in the bitmap once written, so
+ * readers can be served from the cache file before the whole object is in.
+ * The first failed range stops the rest. The fd is owned and closed on destruction, readers
+ * holding the download keep it readable even if the file is evicted in the meantime.
+ * Must be owned by a shared_ptr, running tasks keep it alive.
+ */
+class RangeDownload : public std::enable_shared_from_this<RangeDownload> {
+  public:
+    /* result is 0 or -errno, called once by the task finishing last */
+    using DoneCallback = std::function<void(int result)>;
+
+    RangeDownload(int fd, uint64_t size, uint64_t rangeSize);
+    ~RangeDownload();
+    RangeDownload(const RangeDownload &) = delete;
+    RangeDownload &operator=(const RangeDownload &) = delete;
+
+    void Start(Storage *storage,
+               ThreadPool *pool,
+               const std::string &objectKey,
+               uint32_t parallelism,
+               DoneCallback callback);
+    /* whether [offset, offset + len) is in the cache file */
+    bool Ready(uint64_t offset, uint64_t len) const;
+    bool Finished() const { return finished.load(std::memory_order_acquire); }
+    /* load the ranges left on the calling thread too, returns the result once all are done */
+    int Wait();
+    int Fd() const { return fd; }
+    uint64_t RangeNum() const { return rangeNum; }
+    uint64_t ReadyNum() const { return readyNum.load(); }
+
+  private:
+    void Work();
+    int LoadRange(uint64_t range, char *buf);
+
+    int fd;
+    uint64_t size;
+    uint64_t rangeSize;
+    uint64_t rangeNum;
+    std::unique_ptr<std::atomic<uint64_t>[]> bitmap;
+    std::atomic<uint64_t> readyNum{0};
+
+    Storage *storage{nullptr};
+    std::string objectKey;
+    DoneCallback callback;
+    std::atomic<uint64_t> nextRange{0};
+    std::atomic<uint32_t> activeNum{0};
+    std::atomic<int> result{0};
+
+    std::mutex mutex;
+    std::condition_variable finishedCV;
+    std::atomic<bool> finished{false};
+};
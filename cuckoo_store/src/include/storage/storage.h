@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include <sys/stat.h>
 #include <sys/statvfs.h>
@@ -23,4 +24,17 @@ class Storage {
     virtual int DeleteObject(const std::string &objectKey) = 0;
     virtual int CopyObject(const std::string &fromPath, const std::string &toPath) = 0;
     virtual int StatFs(struct statvfs *vfsbuf) = 0;
+
+    /* multipart upload, parts are numbered from 1 and completed in the order of etags */
+    virtual int InitMultipartUpload(const std::string &objectKey, std::string &uploadId) = 0;
+    virtual int UploadPart(const std::string &objectKey,
+                           const std::string &uploadId,
+                           uint32_t partNumber,
+                           const char *buf,
+                           uint64_t size,
+                           std::string &etag) = 0;
+    virtual int CompleteMultipartUpload(const std::string &objectKey,
+                                        const std::string &uploadId,
+                                        const std::vector<std::string> &etags) = 0;
+    virtual int AbortMultipartUpload(const std::string &objectKey, const std::string &uploadId) = 0;
 };
@@ -0,0 +1,120 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct WriteBackOptions
+{
+    std::string journalPath;
+    uint32_t concurrency = 4; // uploads running at a time
+    uint32_t rateMBps = 0;    // shared by all uploads, 0 for unlimited
+    uint32_t delayMs = 0;     // flushes of an inode within it are uploaded once
+    uint32_t retryMs = 1000;  // first retry of a failed upload, doubled up to MAX_RETRY_MS
+};
+
+struct WriteBackStats
+{
+    uint64_t dirty;
+    uint64_t marked;
+    uint64_t coalesced; // flushes absorbed by an upload still queued
+    uint64_t uploaded;
+    uint64_t failed;
+    uint64_t replayed;
+};
+
+/*
+ * Write-back of flushed cache files to storage.
+ * MarkDirty appends the inode to a journal and returns once the journal is synced, concurrent
+ * callers share one fdatasync. Uploads run later on concurrency threads, after delayMs, so an inode
+ * flushed again while queued is uploaded once. A dirty file is pinned in the disk cache until it
+ * is uploaded.
+ * Records carry a generation, a record is dirty until a clean record of a later or the same
+ * generation follows, so the order of the records does not matter. Start replays the journal and
+ * uploads what was left dirty, a torn record at the end is dropped. The journal is rewritten with
+ * only the dirty inodes when it grows COMPACT_SIZE past them.
+ */
+class WriteBack {
+  public:
+    using UploadFunc = std::function<int(uint64_t inodeId, const std::string &path)>;
+
+    WriteBack(const WriteBackOptions &options, UploadFunc upload);
+    ~WriteBack();
+    WriteBack(const WriteBack &) = delete;
+    WriteBack &operator=(const WriteBack &) = delete;
+
+    /* replay the journal and start the uploads, returns 0 or -errno */
+    int Start();
+    /* running uploads are waited for, dirty inodes are left in the journal */
+    void Stop();
+    int MarkDirty(uint64_t inodeId, const std::string &path, uint64_t size);
+    /* the inode is deleted, waits for its running upload so that it can not come back */
+    void Forget(uint64_t inodeId);
+    /* upload the dirty inodes of path now and wait for them, returns 0 or the upload error */
+    int Sync(const std::string &path);
+    WriteBackStats GetStats();
+
+    static constexpr uint32_t MAX_RETRY_MS = 60 * 1000;
+    static constexpr uint64_t COMPACT_SIZE = 4 * 1024 * 1024;
+    static constexpr const char *JOURNAL_NAME = "write_back.journal";
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    struct Entry
+    {
+        std::string path;
+        uint64_t size{0};
+        uint64_t generation{0};
+        Clock::time_point readyTime{};
+        bool queued{false};
+        bool uploading{false};
+        uint32_t retryMs{0};
+        uint64_t attempts{0};
+        int lastError{0};
+    };
+
+    void Run(std::stop_token stoken);
+    void QueueLocked(uint64_t inodeId, Entry &entry, Clock::time_point readyTime);
+    void DropLocked(uint64_t inodeId);
+    /* wait for the upload's turn on the shared rate, false on stop */
+    bool Throttle(std::unique_lock<std::mutex> &lock, uint64_t size);
+    int Append(bool dirty, uint64_t inodeId, uint64_t generation, uint64_t size, const std::string &path, bool sync);
+    int Replay();
+    /* rewrite the journal with the dirty entries, under mutex */
+    int CompactLocked();
+
+    WriteBackOptions options;
+    UploadFunc upload;
+
+    std::mutex mutex;
+    std::condition_variable queueCV;
+    std::condition_variable idleCV;
+    std::condition_variable stopCV;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::set<std::pair<Clock::time_point, uint64_t>> queue;
+    uint64_t generation{0};
+    bool stopping{false};
+    Clock::time_point rateFreeTime{};
+    WriteBackStats stats{};
+    std::vector<std::jthread> workers;
+
+    /* lock order: mutex, syncMutex, journalMutex */
+    std::mutex syncMutex;
+    uint64_t syncedSeq{0};
+    std::mutex journalMutex;
+    int journalFd{-1};
+    uint64_t appendSeq{0};
+    uint64_t journalSize{0};
+    uint64_t liveSize{0};
+};
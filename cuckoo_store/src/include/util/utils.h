@@ -18,6 +18,9 @@
 #define RPC_BYTES_ADDITION (sizeof(int) + sizeof(char))
 #define GRPC_DEFAULT_SEND_MESSAGE_SIZE 4 * 1024 * 1024
 
+/* DiskCache keys with this bit are segments of packed small files, not inodes */
+constexpr uint64_t SEGMENT_KEY_BIT = 1ULL << 62;
+
 extern uint32_t CUCKOO_BLOCK_SIZE;
 extern uint32_t READ_BIGFILE_SIZE;
 
@@ -39,6 +42,7 @@ struct StatFSBuf
 void SetRootPath(std::string str);
 void SetTotalDirectory(int num);
 std::string GetFilePath(uint64_t inodeId);
+std::string GetSegmentDir();
 int GenerateRandom(int minValue, int maxValue);
 std::string GetOBSFilePath(std::string path);
 std::optional<std::string> GetUserName();
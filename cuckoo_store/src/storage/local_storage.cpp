@@ -0,0 +1,383 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "storage/local_storage.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+#include "log/logging.h"
+#include "stats/cuckoo_stats.h"
+
+LocalStorage *LocalStorage::GetInstance()
+{
+    static LocalStorage m_singleton;
+    return &m_singleton;
+}
+
+void LocalStorage::SetOptions(const LocalStorageOptions &newOptions) { options = newOptions; }
+
+int LocalStorage::Init()
+{
+    if (!isInit.load()) {
+        if (options.root.empty()) {
+            CUCKOO_LOG(LOG_ERROR) << "Local storage root is not set";
+            return -1;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(options.root, ec);
+        if (ec || access(options.root.c_str(), R_OK | W_OK | X_OK) != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "Access local storage " << options.root << " failed: " << strerror(errno);
+            return -1;
+        }
+        isInit.store(true);
+        CUCKOO_LOG(LOG_INFO) << "successfully init local storage, root is " << options.root << ", latency "
+                             << options.latencyUs << " us, bandwidth " << options.bandwidthMBps << " MB/s";
+    }
+    return 0;
+}
+
+void LocalStorage::DeleteInstance() { isInit.store(false); }
+
+std::string LocalStorage::ObjectPath(const std::string &objectKey) { return options.root + "/" + objectKey; }
+
+std::string LocalStorage::UploadKey(const std::string &uploadId) { return std::string(MULTIPART_DIR) + "/" + uploadId; }
+
+std::string LocalStorage::PartKey(const std::string &uploadId, uint32_t partNumber)
+{
+    return UploadKey(uploadId) + "/" + std::to_string(partNumber);
+}
+
+int LocalStorage::CreateParent(const std::string &path)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    if (ec) {
+        CUCKOO_LOG(LOG_ERROR) << "Create parent of " << path << " failed: " << ec.message();
+        return -1;
+    }
+    return 0;
+}
+
+void LocalStorage::Delay()
+{
+    if (options.latencyUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(options.latencyUs));
+    }
+}
+
+/*
+ * Reserve the link for size bytes after whatever is already on it and wait until they are through.
+ */
+void LocalStorage::Transfer(uint64_t size)
+{
+    if (options.bandwidthMBps == 0 || size == 0) {
+        return;
+    }
+    auto cost = std::chrono::nanoseconds(size * 1000000000ULL / (options.bandwidthMBps * 1024ULL * 1024));
+    std::chrono::steady_clock::time_point done;
+    {
+        std::lock_guard lock(linkMutex);
+        linkFreeTime = std::max(linkFreeTime, std::chrono::steady_clock::now()) + cost;
+        done = linkFreeTime;
+    }
+    std::this_thread::sleep_until(done);
+}
+
+ssize_t LocalStorage::ReadObject(const std::string &objectKey, uint64_t offset, uint64_t size, int fd, char *destBuffer)
+{
+    Delay();
+    std::string path = ObjectPath(objectKey);
+    int srcFd = open(path.c_str(), O_RDONLY);
+    if (srcFd < 0) {
+        CUCKOO_LOG(LOG_ERROR) << "ReadObject() " << objectKey << " failed: " << strerror(errno);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(srcFd, &st) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "ReadObject() stat " << objectKey << " failed: " << strerror(errno);
+        close(srcFd);
+        return -1;
+    }
+    // size 0 reads to the end of the object
+    uint64_t end = static_cast<uint64_t>(st.st_size);
+    if (size != 0) {
+        end = std::min(end, offset + size);
+    }
+    std::unique_ptr<char[]> chunk;
+    if (destBuffer == nullptr) {
+        chunk = std::make_unique<char[]>(TRANSFER_CHUNK_SIZE);
+    }
+
+    uint64_t done = 0;
+    while (offset + done < end) {
+        uint64_t toRead = std::min(TRANSFER_CHUNK_SIZE, end - offset - done);
+        char *buf = destBuffer != nullptr ? destBuffer + done : chunk.get();
+        ssize_t n = pread(srcFd, buf, toRead, offset + done);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            CUCKOO_LOG(LOG_ERROR) << "ReadObject() " << objectKey << " failed: " << (n < 0 ? strerror(errno) : "EOF");
+            close(srcFd);
+            return -1;
+        }
+        Transfer(n);
+        CuckooStats::GetInstance().stats[OBJ_GET] += n;
+        if (fd != -1) {
+            CuckooStats::GetInstance().stats[BLOCKCACHE_WRITE] += n;
+            if (pwrite(fd, buf, n, done) != n) {
+                CUCKOO_LOG(LOG_ERROR) << "ReadObject() " << objectKey << " write back failed: " << strerror(errno);
+                close(srcFd);
+                return -1;
+            }
+        }
+        done += n;
+    }
+    close(srcFd);
+    return static_cast<ssize_t>(done);
+}
+
+/*
+ * Write size bytes from buf, or from srcFd when buf is null, as the whole object.
+ */
+int LocalStorage::WriteObject(const std::string &objectKey, int srcFd, const char *buf, uint64_t size)
+{
+    std::string path = ObjectPath(objectKey);
+    std::string tmpPath = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(tmpSeq++);
+    if (CreateParent(path) != 0) {
+        return -1;
+    }
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Put object " << objectKey << " failed: " << strerror(errno);
+        return -1;
+    }
+    std::unique_ptr<char[]> chunk;
+    if (buf == nullptr) {
+        chunk = std::make_unique<char[]>(TRANSFER_CHUNK_SIZE);
+    }
+
+    int ret = 0;
+    uint64_t done = 0;
+    while (done < size && ret == 0) {
+        uint64_t toWrite = std::min(TRANSFER_CHUNK_SIZE, size - done);
+        const char *data = buf != nullptr ? buf + done : chunk.get();
+        if (buf == nullptr) {
+            ssize_t n = pread(srcFd, chunk.get(), toWrite, done);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                CUCKOO_LOG(LOG_ERROR) << "Put object " << objectKey
+                                      << " read source failed: " << (n < 0 ? strerror(errno) : "EOF");
+                ret = -1;
+                break;
+            }
+            toWrite = n;
+        }
+        Transfer(toWrite);
+        if (write(fd, data, toWrite) != static_cast<ssize_t>(toWrite)) {
+            CUCKOO_LOG(LOG_ERROR) << "Put object " << objectKey << " failed: " << strerror(errno);
+            ret = -1;
+            break;
+        }
+        CuckooStats::GetInstance().stats[OBJ_PUT] += toWrite;
+        done += toWrite;
+    }
+    if (ret == 0 && fdatasync(fd) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Put object " << objectKey << " sync failed: " << strerror(errno);
+        ret = -1;
+    }
+    close(fd);
+    if (ret == 0 && rename(tmpPath.c_str(), path.c_str()) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Put object " << objectKey << " rename failed: " << strerror(errno);
+        ret = -1;
+    }
+    if (ret != 0) {
+        unlink(tmpPath.c_str());
+    }
+    return ret;
+}
+
+int LocalStorage::PutFile(const std::string &objectKey, const std::string &filePath)
+{
+    Delay();
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        CUCKOO_LOG(LOG_ERROR) << "PutFile " << objectKey << " open " << filePath << " failed: " << strerror(errno);
+        return -1;
+    }
+    struct stat st;
+    int ret = fstat(fd, &st);
+    if (ret == 0) {
+        ret = WriteObject(objectKey, fd, nullptr, st.st_size);
+    }
+    close(fd);
+    return ret;
+}
+
+ssize_t LocalStorage::PutBuffer(const std::string &objectKey, const char *buf, const uint64_t size, const uint64_t offset)
+{
+    Delay();
+    if (buf == nullptr) {
+        return WriteObject(objectKey, -1, "", 0) == 0 ? 0 : -1;
+    }
+    return WriteObject(objectKey, -1, buf + offset, size) == 0 ? static_cast<ssize_t>(size) : -1;
+}
+
+int LocalStorage::DeleteObject(const std::string &objectKey)
+{
+    Delay();
+    if (unlink(ObjectPath(objectKey).c_str()) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "delete object " << objectKey << " failed: " << strerror(errno);
+        return -1;
+    }
+    CUCKOO_LOG(LOG_INFO) << "delete object " << objectKey << " successfully";
+    return 0;
+}
+
+int LocalStorage::CopyObject(const std::string &fromPath, const std::string &toPath)
+{
+    // a server side copy, only the request latency is paid
+    Delay();
+    std::string srcPath = ObjectPath(fromPath);
+    std::string dstPath = ObjectPath(toPath);
+    if (CreateParent(dstPath) != 0) {
+        return -1;
+    }
+    std::string tmpPath = dstPath + ".tmp." + std::to_string(getpid()) + "." + std::to_string(tmpSeq++);
+    std::error_code ec;
+    std::filesystem::copy_file(srcPath, tmpPath, std::filesystem::copy_options::overwrite_existing, ec);
+    if (!ec) {
+        std::filesystem::rename(tmpPath, dstPath, ec);
+    }
+    if (ec) {
+        CUCKOO_LOG(LOG_ERROR) << "CopyObject " << fromPath << " to " << toPath << " failed: " << ec.message();
+        unlink(tmpPath.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+int LocalStorage::StatFs(struct statvfs *vfsbuf)
+{
+    if (statvfs(options.root.c_str(), vfsbuf) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "StatFs local storage failed: " << strerror(errno);
+        return -EIO;
+    }
+    return 0;
+}
+
+int LocalStorage::InitMultipartUpload(const std::string &objectKey, std::string &uploadId)
+{
+    Delay();
+    uploadId = std::to_string(getpid()) + "." + std::to_string(tmpSeq++);
+    std::error_code ec;
+    std::filesystem::create_directories(ObjectPath(UploadKey(uploadId)), ec);
+    if (ec) {
+        CUCKOO_LOG(LOG_ERROR) << "InitMultipartUpload " << objectKey << " failed: " << ec.message();
+        return -1;
+    }
+    return 0;
+}
+
+int LocalStorage::UploadPart(const std::string &objectKey,
+                             const std::string &uploadId,
+                             uint32_t partNumber,
+                             const char *buf,
+                             uint64_t size,
+                             std::string &etag)
+{
+    Delay();
+    if (access(ObjectPath(UploadKey(uploadId)).c_str(), F_OK) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "UploadPart " << objectKey << " no such upload " << uploadId;
+        return -1;
+    }
+    if (WriteObject(PartKey(uploadId, partNumber), -1, buf, size) != 0) {
+        return -1;
+    }
+    etag = std::to_string(partNumber) + "-" + std::to_string(size);
+    return 0;
+}
+
+/*
+ * Concatenated on the storage side, only the request latency is paid.
+ */
+int LocalStorage::CompleteMultipartUpload(const std::string &objectKey,
+                                          const std::string &uploadId,
+                                          const std::vector<std::string> &etags)
+{
+    Delay();
+    std::string path = ObjectPath(objectKey);
+    std::string tmpPath = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(tmpSeq++);
+    if (etags.empty() || CreateParent(path) != 0) {
+        return -1;
+    }
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        CUCKOO_LOG(LOG_ERROR) << "CompleteMultipartUpload " << objectKey << " failed: " << strerror(errno);
+        return -1;
+    }
+    auto chunk = std::make_unique<char[]>(TRANSFER_CHUNK_SIZE);
+    int ret = 0;
+    for (uint32_t i = 0; i < etags.size() && ret == 0; ++i) {
+        std::string partPath = ObjectPath(PartKey(uploadId, i + 1));
+        struct stat st;
+        if (stat(partPath.c_str(), &st) != 0 ||
+            etags[i] != std::to_string(i + 1) + "-" + std::to_string(st.st_size)) {
+            CUCKOO_LOG(LOG_ERROR) << "CompleteMultipartUpload " << objectKey << " part " << i + 1 << " mismatch";
+            ret = -1;
+            break;
+        }
+        int partFd = open(partPath.c_str(), O_RDONLY);
+        if (partFd < 0) {
+            ret = -1;
+            break;
+        }
+        ssize_t n = 0;
+        while ((n = read(partFd, chunk.get(), TRANSFER_CHUNK_SIZE)) > 0) {
+            if (write(fd, chunk.get(), n) != n) {
+                n = -1;
+                break;
+            }
+        }
+        close(partFd);
+        if (n < 0) {
+            CUCKOO_LOG(LOG_ERROR) << "CompleteMultipartUpload " << objectKey << " failed: " << strerror(errno);
+            ret = -1;
+        }
+    }
+    if (ret == 0 && fdatasync(fd) != 0) {
+        ret = -1;
+    }
+    close(fd);
+    if (ret == 0 && rename(tmpPath.c_str(), path.c_str()) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "CompleteMultipartUpload " << objectKey << " rename failed: " << strerror(errno);
+        ret = -1;
+    }
+    if (ret != 0) {
+        unlink(tmpPath.c_str());
+        return ret;
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(ObjectPath(UploadKey(uploadId)), ec);
+    return 0;
+}
+
+int LocalStorage::AbortMultipartUpload(const std::string &objectKey, const std::string &uploadId)
+{
+    Delay();
+    std::error_code ec;
+    if (std::filesystem::remove_all(ObjectPath(UploadKey(uploadId)), ec) == 0 || ec) {
+        CUCKOO_LOG(LOG_ERROR) << "AbortMultipartUpload " << objectKey << " no such upload " << uploadId;
+        return -1;
+    }
+    return 0;
+}
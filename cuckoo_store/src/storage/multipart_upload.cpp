@@ -0,0 +1,216 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "storage/multipart_upload.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "log/logging.h"
+#include "thread_pool/thread_pool.h"
+
+MultipartUpload::MultipartUpload(Storage *storage,
+                                 ThreadPool *pool,
+                                 const std::string &objectKey,
+                                 int fd,
+                                 uint64_t partSize,
+                                 uint32_t parallelism)
+    : storage(storage),
+      pool(pool),
+      objectKey(objectKey),
+      fd(fd),
+      partSize(std::max<uint64_t>(partSize, 1)),
+      parallelism(std::max<uint32_t>(parallelism, 1))
+{
+}
+
+MultipartUpload::~MultipartUpload()
+{
+    Abort();
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void MultipartUpload::Written(uint64_t offset, uint64_t size)
+{
+    std::vector<Part> parts;
+    {
+        std::lock_guard lock(mutex);
+        if (stale || result != 0) {
+            return;
+        }
+        if (offset > writtenEnd || offset < nextPart * partSize) {
+            stale = true;
+            return;
+        }
+        writtenEnd = std::max(writtenEnd, offset + size);
+        while ((nextPart + 1) * partSize <= writtenEnd) {
+            /* keep a part number for the tail */
+            if (nextPart + 1 >= MAX_PART_NUM) {
+                stale = true;
+                break;
+            }
+            QueueLocked(nextPart++, partSize);
+        }
+        parts = TakeLocked();
+    }
+    Launch(parts);
+}
+
+void MultipartUpload::Truncated(uint64_t size)
+{
+    std::lock_guard lock(mutex);
+    if (size < nextPart * partSize) {
+        stale = true;
+    }
+    writtenEnd = std::min(writtenEnd, size);
+}
+
+bool MultipartUpload::Streamed()
+{
+    std::lock_guard lock(mutex);
+    return nextPart > 0;
+}
+
+int MultipartUpload::Finish(uint64_t fileSize)
+{
+    std::unique_lock lock(mutex);
+    auto idle = [this]() { return inflight == 0 && pending.empty(); };
+    if (fileSize == 0 && nextPart == 0) {
+        return -EINVAL;
+    }
+    if (nextPart == 0) {
+        partSize = std::max(partSize, (fileSize + MAX_PART_NUM - 1) / MAX_PART_NUM);
+    }
+    if (fileSize < nextPart * partSize || (fileSize + partSize - 1) / partSize > MAX_PART_NUM) {
+        stale = true;
+    }
+    if (stale) {
+        idleCV.wait(lock, idle);
+        lock.unlock();
+        Abort();
+        return -ESTALE;
+    }
+    while (nextPart * partSize < fileSize) {
+        QueueLocked(nextPart, std::min(partSize, fileSize - nextPart * partSize));
+        ++nextPart;
+    }
+    /* late writes are not part of this upload */
+    stale = true;
+    auto parts = TakeLocked();
+    lock.unlock();
+    Launch(parts);
+    lock.lock();
+    idleCV.wait(lock, idle);
+    int ret = result;
+    auto partEtags = etags;
+    lock.unlock();
+
+    /* no part runs any more, uploadId and closed are ours */
+    if (ret != 0) {
+        Abort();
+        return ret;
+    }
+    if (storage->CompleteMultipartUpload(objectKey, uploadId, partEtags) != 0) {
+        Abort();
+        return -EIO;
+    }
+    closed = true;
+    return 0;
+}
+
+void MultipartUpload::Abort()
+{
+    if (!uploadId.empty() && !closed) {
+        storage->AbortMultipartUpload(objectKey, uploadId);
+    }
+    closed = true;
+}
+
+void MultipartUpload::QueueLocked(uint32_t part, uint64_t size)
+{
+    pending.emplace_back(part, size);
+    if (etags.size() <= part) {
+        etags.resize(part + 1);
+    }
+}
+
+std::vector<MultipartUpload::Part> MultipartUpload::TakeLocked()
+{
+    std::vector<Part> parts;
+    while (inflight < parallelism && !pending.empty()) {
+        parts.push_back(pending.front());
+        pending.pop_front();
+        ++inflight;
+    }
+    return parts;
+}
+
+void MultipartUpload::Launch(const std::vector<Part> &parts)
+{
+    for (auto [part, size] : parts) {
+        ThreadTask task{.taskName = "upload part",
+                        .task = [self = shared_from_this(), part, size]() { self->Run(part, size); },
+                        .priority = TaskPriority::BACKGROUND};
+        if (pool == nullptr || pool->Submit(task) != 0) {
+            Run(part, size);
+        }
+    }
+}
+
+int MultipartUpload::Begin()
+{
+    std::call_once(beginOnce, [this]() {
+        beginResult = storage->InitMultipartUpload(objectKey, uploadId) == 0 ? 0 : -EIO;
+    });
+    return beginResult;
+}
+
+void MultipartUpload::Run(uint32_t part, uint64_t size)
+{
+    int ret = Begin();
+    std::string etag;
+    if (ret == 0) {
+        auto buf = std::make_unique<char[]>(size);
+        uint64_t done = 0;
+        while (done < size) {
+            ssize_t n = pread(fd, buf.get() + done, size - done, part * partSize + done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                CUCKOO_LOG(LOG_ERROR) << "MultipartUpload: read part " << part << " of " << objectKey
+                                      << " failed: " << (n < 0 ? strerror(errno) : "EOF");
+                ret = -EIO;
+                break;
+            }
+            done += n;
+        }
+        if (ret == 0 && storage->UploadPart(objectKey, uploadId, part + 1, buf.get(), size, etag) != 0) {
+            ret = -EIO;
+        }
+    }
+
+    std::vector<Part> parts;
+    {
+        std::lock_guard lock(mutex);
+        --inflight;
+        if (ret != 0) {
+            if (result == 0) {
+                result = ret;
+            }
+            pending.clear();
+        } else {
+            etags[part] = etag;
+        }
+        parts = TakeLocked();
+        if (inflight == 0 && pending.empty()) {
+            idleCV.notify_all();
+        }
+    }
+    Launch(parts);
+}
@@ -0,0 +1,80 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "storage/object_layout.h"
+
+#include <cerrno>
+
+#include "log/logging.h"
+
+ObjectLayout::ObjectLayout(Storage *storage, bool inodeKeyed, bool migrate)
+    : storage(storage),
+      inodeKeyed(inodeKeyed),
+      migrate(inodeKeyed && migrate)
+{
+}
+
+std::string ObjectLayout::Key(const std::string &path, uint64_t inodeId) const
+{
+    if (inodeKeyed) {
+        return std::string(INODE_OBJECT_DIR) + "/" + std::to_string(inodeId);
+    }
+    return path.substr(1);
+}
+
+bool ObjectLayout::Exists(const std::string &key)
+{
+    char probe;
+    return storage->ReadObject(key, 0, 1, -1, &probe) >= 0;
+}
+
+ssize_t ObjectLayout::Read(const std::string &path, uint64_t inodeId, uint64_t offset, uint64_t size, int fd, char *buf)
+{
+    ssize_t ret = storage->ReadObject(Key(path, inodeId), offset, size, fd, buf);
+    if (ret < 0 && migrate) {
+        ret = storage->ReadObject(path.substr(1), offset, size, fd, buf);
+    }
+    return ret;
+}
+
+std::string ObjectLayout::LoadKey(const std::string &path, uint64_t inodeId)
+{
+    std::string key = Key(path, inodeId);
+    if (migrate && !Exists(key)) {
+        return path.substr(1);
+    }
+    return key;
+}
+
+void ObjectLayout::DropPathObject(const std::string &path)
+{
+    if (migrate) {
+        storage->DeleteObject(path.substr(1));
+    }
+}
+
+int ObjectLayout::Migrate(const std::string &path, uint64_t inodeId)
+{
+    std::string key = Key(path, inodeId);
+    if (!migrate || Exists(key)) {
+        return 0;
+    }
+    int ret = storage->CopyObject(path.substr(1), key);
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "ObjectLayout::Migrate(): copy " << path << " to " << key << " failed";
+        return -EIO;
+    }
+    return 0;
+}
+
+int ObjectLayout::Delete(const std::string &path, uint64_t inodeId)
+{
+    int ret = storage->DeleteObject(Key(path, inodeId));
+    if (migrate) {
+        /* a file not migrated yet only has the path key, storages do not tell a missing key from a failure */
+        int pathRet = storage->DeleteObject(path.substr(1));
+        ret = ret == 0 || pathRet == 0 ? 0 : pathRet;
+    }
+    return ret != 0 ? -EIO : 0;
+}
@@ -36,6 +36,12 @@ struct PutBufCallbackType
     const obs_error_details *error = nullptr;
 };
 
+struct UploadPartCallbackType
+{
+    PutBufCallbackType put;
+    char etag[OBS_COMMON_LEN] = {0};
+};
+
 struct GetObjectCallbackType
 {
     int fd = 0;
@@ -711,4 +717,181 @@ void OBSStorage::InitObsOptions(obs_options &option)
     }
     CUCKOO_LOG(LOG_DEBUG) << "InitObsOptions done";
     CUCKOO_LOG(LOG_DEBUG) << "host is " << hostName;
-}
\ No newline at end of file
+}
+obs_status UploadPartPropertiesCallback(const obs_response_properties *properties, void *callbackData)
+{
+    if (properties == nullptr) {
+        return OBS_STATUS_ErrorUnknown;
+    }
+    auto *data = static_cast<UploadPartCallbackType *>(callbackData);
+    if (data != nullptr && properties->etag != nullptr) {
+        errno_t err = strcpy_s(data->etag, sizeof(data->etag), properties->etag);
+        if (err != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
+            return OBS_STATUS_AbortedByCallback;
+        }
+    }
+    return OBS_STATUS_OK;
+}
+
+void UploadPartCompleteCallback(obs_status status, const obs_error_details *error, void *callbackData)
+{
+    if (callbackData) {
+        PutBufCompleteCallback(status, error, &static_cast<UploadPartCallbackType *>(callbackData)->put);
+    }
+}
+
+int UploadPartDataCallback(int bufferSize, char *buffer, void *callbackData)
+{
+    if (callbackData == nullptr) {
+        return OBS_STATUS_ErrorUnknown;
+    }
+    return PutBufCallBack(bufferSize, buffer, &static_cast<UploadPartCallbackType *>(callbackData)->put);
+}
+
+obs_status CompleteMultipartUploadCallback(const char * /*location*/,
+                                           const char * /*bucket*/,
+                                           const char * /*key*/,
+                                           const char * /*etag*/,
+                                           void * /*callbackData*/)
+{
+    return OBS_STATUS_OK;
+}
+
+int OBSStorage::InitMultipartUpload(const std::string &objectKey, std::string &uploadId)
+{
+    obs_options option;
+    InitObsOptions(option);
+
+    obs_put_properties putProperties;
+    init_put_properties(&putProperties);
+
+    char uploadIdReturn[OBS_COMMON_LEN] = {0};
+    obs_response_handler handler = {&NormalPropertiesCallback, &NormalCompleteCallback};
+    NormalBackType data;
+    int retryCount = RETRY_NUM;
+    while (retryCount > 0) {
+        initiate_multi_part_upload(&option,
+                                   const_cast<char *>(objectKey.c_str()),
+                                   sizeof(uploadIdReturn),
+                                   uploadIdReturn,
+                                   &putProperties,
+                                   nullptr,
+                                   &handler,
+                                   &data);
+        DoRetry(data.retStatus, retryCount);
+    }
+    if (OBS_STATUS_OK != data.retStatus) {
+        CUCKOO_LOG(LOG_ERROR) << "InitMultipartUpload " << objectKey
+                              << " failed: " << obs_get_status_name(data.retStatus);
+        return -1;
+    }
+    uploadId = uploadIdReturn;
+    return 0;
+}
+
+int OBSStorage::UploadPart(const std::string &objectKey,
+                           const std::string &uploadId,
+                           uint32_t partNumber,
+                           const char *buf,
+                           uint64_t size,
+                           std::string &etag)
+{
+    obs_options option;
+    InitObsOptions(option);
+
+    obs_put_properties putProperties;
+    init_put_properties(&putProperties);
+
+    obs_upload_part_info uploadPartInfo;
+    errno_t err = memset_s(&uploadPartInfo, sizeof(uploadPartInfo), 0, sizeof(uploadPartInfo));
+    if (err != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
+        return -1;
+    }
+    uploadPartInfo.part_number = partNumber;
+    uploadPartInfo.upload_id = const_cast<char *>(uploadId.c_str());
+
+    obs_upload_handler handler = {{&UploadPartPropertiesCallback, &UploadPartCompleteCallback},
+                                  &UploadPartDataCallback,
+                                  nullptr};
+    UploadPartCallbackType data;
+    int retryCount = RETRY_NUM;
+    while (retryCount > 0) {
+        /* every try sends the whole part again */
+        data.put.putBuffer = buf;
+        data.put.bufferSize = size;
+        data.put.curOffset = 0;
+        data.put.retStatus = OBS_STATUS_BUTT;
+        upload_part(&option,
+                    const_cast<char *>(objectKey.c_str()),
+                    &uploadPartInfo,
+                    size,
+                    &putProperties,
+                    nullptr,
+                    &handler,
+                    &data);
+        DoRetry(data.put.retStatus, retryCount);
+    }
+    if (OBS_STATUS_OK != data.put.retStatus) {
+        CUCKOO_LOG(LOG_ERROR) << "UploadPart " << objectKey << " part " << partNumber
+                              << " failed: " << obs_get_status_name(data.put.retStatus);
+        return -1;
+    }
+    etag = data.etag;
+    return 0;
+}
+
+int OBSStorage::CompleteMultipartUpload(const std::string &objectKey,
+                                        const std::string &uploadId,
+                                        const std::vector<std::string> &etags)
+{
+    obs_options option;
+    InitObsOptions(option);
+
+    obs_put_properties putProperties;
+    init_put_properties(&putProperties);
+
+    std::vector<obs_complete_upload_Info> parts(etags.size());
+    for (size_t i = 0; i < etags.size(); ++i) {
+        parts[i].part_number = i + 1;
+        parts[i].etag = const_cast<char *>(etags[i].c_str());
+    }
+    obs_complete_multi_part_upload_handler handler = {{&NormalPropertiesCallback, &NormalCompleteCallback},
+                                                      &CompleteMultipartUploadCallback};
+    NormalBackType data;
+    int retryCount = RETRY_NUM;
+    while (retryCount > 0) {
+        complete_multi_part_upload(&option,
+                                   const_cast<char *>(objectKey.c_str()),
+                                   uploadId.c_str(),
+                                   parts.size(),
+                                   parts.data(),
+                                   &putProperties,
+                                   &handler,
+                                   &data);
+        DoRetry(data.retStatus, retryCount);
+    }
+    if (OBS_STATUS_OK != data.retStatus) {
+        CUCKOO_LOG(LOG_ERROR) << "CompleteMultipartUpload " << objectKey
+                              << " failed: " << obs_get_status_name(data.retStatus);
+        return -1;
+    }
+    return 0;
+}
+
+int OBSStorage::AbortMultipartUpload(const std::string &objectKey, const std::string &uploadId)
+{
+    obs_options option;
+    InitObsOptions(option);
+
+    obs_response_handler handler = {&NormalPropertiesCallback, &NormalCompleteCallback};
+    NormalBackType data;
+    abort_multi_part_upload(&option, const_cast<char *>(objectKey.c_str()), uploadId.c_str(), &handler, &data);
+    if (OBS_STATUS_OK != data.retStatus) {
+        CUCKOO_LOG(LOG_ERROR) << "AbortMultipartUpload " << objectKey
+                              << " failed: " << obs_get_status_name(data.retStatus);
+        return -1;
+    }
+    return 0;
+}
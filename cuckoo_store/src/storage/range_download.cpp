@@ -0,0 +1,139 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "storage/range_download.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "io_engine/io_engine.h"
+#include "log/logging.h"
+#include "thread_pool/thread_pool.h"
+
+namespace {
+constexpr uint64_t BITS_PER_WORD = 64;
+}
+
+RangeDownload::RangeDownload(int fd, uint64_t size, uint64_t rangeSize)
+    : fd(fd),
+      size(size),
+      rangeSize(std::max<uint64_t>(rangeSize, 1)),
+      rangeNum((size + this->rangeSize - 1) / this->rangeSize),
+      bitmap(std::make_unique<std::atomic<uint64_t>[]>((rangeNum + BITS_PER_WORD - 1) / BITS_PER_WORD))
+{
+}
+
+RangeDownload::~RangeDownload()
+{
+    if (fd >= 0) {
+        IoEngine::GetInstance().Close(fd);
+    }
+}
+
+void RangeDownload::Start(Storage *storage,
+                          ThreadPool *pool,
+                          const std::string &objectKey,
+                          uint32_t parallelism,
+                          DoneCallback callback)
+{
+    this->storage = storage;
+    this->objectKey = objectKey;
+    this->callback = std::move(callback);
+    uint32_t taskNum = static_cast<uint32_t>(std::clamp<uint64_t>(rangeNum, 1, std::max<uint32_t>(parallelism, 1)));
+    activeNum = taskNum;
+    for (uint32_t i = 0; i < taskNum; ++i) {
+        ThreadTask task{.taskName = "load range",
+                        .task = [self = shared_from_this()]() { self->Work(); },
+                        .priority = TaskPriority::BACKGROUND};
+        if (pool == nullptr || pool->Submit(task) != 0) {
+            Work();
+        }
+    }
+}
+
+void RangeDownload::Work()
+{
+    auto buf = std::make_unique<char[]>(std::min(rangeSize, size));
+    while (result.load() == 0) {
+        uint64_t range = nextRange.fetch_add(1);
+        if (range >= rangeNum) {
+            break;
+        }
+        int ret = LoadRange(range, buf.get());
+        if (ret != 0) {
+            int expected = 0;
+            result.compare_exchange_strong(expected, ret);
+            break;
+        }
+        bitmap[range / BITS_PER_WORD].fetch_or(1ULL << (range % BITS_PER_WORD), std::memory_order_release);
+        ++readyNum;
+    }
+    buf.reset();
+
+    if (activeNum.fetch_sub(1) == 1) {
+        /* the callback may hold locks of the loading, drop them before waking the waiters */
+        {
+            DoneCallback done = std::move(callback);
+            callback = nullptr;
+            if (done) {
+                done(result.load());
+            }
+        }
+        {
+            std::lock_guard lock(mutex);
+            finished.store(true, std::memory_order_release);
+        }
+        finishedCV.notify_all();
+    }
+}
+
+int RangeDownload::LoadRange(uint64_t range, char *buf)
+{
+    uint64_t offset = range * rangeSize;
+    uint64_t len = std::min(rangeSize, size - offset);
+    ssize_t ret = storage->ReadObject(objectKey, offset, len, -1, buf);
+    if (ret != static_cast<ssize_t>(len)) {
+        CUCKOO_LOG(LOG_ERROR) << "RangeDownload: read " << objectKey << " range " << range << " got " << ret
+                              << " of " << len;
+        return -EIO;
+    }
+    ret = IoEngine::GetInstance().Write(fd, buf, len, offset);
+    if (ret != static_cast<ssize_t>(len)) {
+        CUCKOO_LOG(LOG_ERROR) << "RangeDownload: write " << objectKey << " range " << range
+                              << " failed: " << strerror(ret < 0 ? -ret : EIO);
+        return ret < 0 ? static_cast<int>(ret) : -EIO;
+    }
+    return 0;
+}
+
+bool RangeDownload::Ready(uint64_t offset, uint64_t len) const
+{
+    if (len == 0) {
+        return true;
+    }
+    if (offset + len > size) {
+        return false;
+    }
+    for (uint64_t range = offset / rangeSize; range <= (offset + len - 1) / rangeSize; ++range) {
+        if ((bitmap[range / BITS_PER_WORD].load(std::memory_order_acquire) & (1ULL << (range % BITS_PER_WORD))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int RangeDownload::Wait()
+{
+    /* help with the ranges left instead of only waiting, the pool may be busy or be ours */
+    uint32_t active = activeNum.load();
+    while (active > 0 && !activeNum.compare_exchange_weak(active, active + 1)) {
+    }
+    if (active > 0) {
+        Work();
+    }
+    std::unique_lock lock(mutex);
+    finishedCV.wait(lock, [this]() { return finished.load(); });
+    return result.load();
+}
@@ -0,0 +1,489 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "storage/write_back.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "disk_cache/disk_cache.h"
+#include "log/logging.h"
+
+namespace {
+constexpr uint32_t RECORD_MAGIC = 0x43574231; // "CWB1"
+constexpr uint32_t RECORD_DIRTY = 1;
+constexpr uint32_t RECORD_CLEAN = 2;
+constexpr uint32_t MAX_PATH_LEN = 4096;
+
+struct JournalRecord
+{
+    uint32_t magic;
+    uint32_t type;
+    uint64_t inodeId;
+    uint64_t generation;
+    uint64_t size; // of the file when flushed, so a replayed upload is rate limited too
+    uint32_t pathLen;
+    uint32_t checksum; // FNV-1a of the record with checksum 0, then the path
+};
+
+uint32_t Checksum(const JournalRecord &record, const char *path)
+{
+    JournalRecord copy = record;
+    copy.checksum = 0;
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const char *data, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ULL;
+        }
+    };
+    mix(reinterpret_cast<const char *>(&copy), sizeof(copy));
+    mix(path, record.pathLen);
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+std::string Encode(uint32_t type, uint64_t inodeId, uint64_t generation, uint64_t size, const std::string &path)
+{
+    JournalRecord record{.magic = RECORD_MAGIC,
+                         .type = type,
+                         .inodeId = inodeId,
+                         .generation = generation,
+                         .size = size,
+                         .pathLen = static_cast<uint32_t>(path.size()),
+                         .checksum = 0};
+    record.checksum = Checksum(record, path.data());
+    std::string buf(reinterpret_cast<const char *>(&record), sizeof(record));
+    buf += path;
+    return buf;
+}
+
+int WriteAll(int fd, const char *buf, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, buf, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n < 0 ? -errno : -EIO;
+        }
+        buf += n;
+        size -= n;
+    }
+    return 0;
+}
+
+/* make a rename in the directory of path durable */
+int SyncParent(const std::string &path)
+{
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return -errno;
+    }
+    int ret = fsync(fd) == 0 ? 0 : -errno;
+    close(fd);
+    return ret;
+}
+} // namespace
+
+WriteBack::WriteBack(const WriteBackOptions &options, UploadFunc upload)
+    : options(options),
+      upload(std::move(upload))
+{
+    this->options.concurrency = std::max<uint32_t>(this->options.concurrency, 1);
+}
+
+WriteBack::~WriteBack() { Stop(); }
+
+int WriteBack::Start()
+{
+    int ret = Replay();
+    if (ret != 0) {
+        return ret;
+    }
+    std::lock_guard lock(mutex);
+    stopping = false;
+    for (uint32_t i = 0; i < options.concurrency; ++i) {
+        workers.emplace_back([this](std::stop_token stoken) { Run(stoken); });
+    }
+    return 0;
+}
+
+void WriteBack::Stop()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    queueCV.notify_all();
+    stopCV.notify_all();
+    idleCV.notify_all();
+    workers.clear();
+    std::lock_guard journalLock(journalMutex);
+    if (journalFd >= 0) {
+        close(journalFd);
+        journalFd = -1;
+    }
+}
+
+int WriteBack::MarkDirty(uint64_t inodeId, const std::string &path, uint64_t size)
+{
+    if (path.size() > MAX_PATH_LEN) {
+        return -ENAMETOOLONG;
+    }
+    uint64_t gen = 0;
+    {
+        std::lock_guard lock(mutex);
+        gen = ++generation;
+        ++stats.marked;
+        auto [found, added] = entries.try_emplace(inodeId);
+        Entry &entry = found->second;
+        if (added) {
+            DiskCache::GetInstance().Pin(inodeId);
+        }
+        entry.path = path;
+        entry.size = size;
+        entry.generation = gen;
+        if (entry.queued) {
+            ++stats.coalesced;
+        } else if (!entry.uploading) {
+            QueueLocked(inodeId, entry, Clock::now() + std::chrono::milliseconds(options.delayMs));
+        }
+        /* a running upload queues the entry again once done */
+    }
+    int ret = Append(true, inodeId, gen, size, path, true);
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "WriteBack: journal " << path << " failed: " << strerror(-ret);
+    }
+    return ret;
+}
+
+void WriteBack::Forget(uint64_t inodeId)
+{
+    std::unique_lock lock(mutex);
+    idleCV.wait(lock, [&]() {
+        auto found = entries.find(inodeId);
+        return found == entries.end() || !found->second.uploading;
+    });
+    auto found = entries.find(inodeId);
+    if (found == entries.end()) {
+        return;
+    }
+    uint64_t gen = found->second.generation;
+    std::string path = found->second.path;
+    DropLocked(inodeId);
+    lock.unlock();
+    /* synced, a replay must not bring the object back */
+    Append(false, inodeId, gen, 0, path, true);
+}
+
+int WriteBack::Sync(const std::string &path)
+{
+    std::unique_lock lock(mutex);
+    std::unordered_map<uint64_t, uint64_t> waiting; // inode to attempts before
+    auto now = Clock::now();
+    for (auto &[inodeId, entry] : entries) {
+        if (entry.path != path) {
+            continue;
+        }
+        waiting.emplace(inodeId, entry.attempts);
+        if (entry.queued && entry.readyTime > now) {
+            queue.erase({entry.readyTime, inodeId});
+            entry.queued = false;
+            QueueLocked(inodeId, entry, now);
+        }
+    }
+    if (waiting.empty()) {
+        return 0;
+    }
+    queueCV.notify_all();
+
+    int ret = 0;
+    idleCV.wait(lock, [&]() {
+        if (stopping) {
+            ret = -ESHUTDOWN;
+            return true;
+        }
+        for (auto it = waiting.begin(); it != waiting.end();) {
+            auto found = entries.find(it->first);
+            if (found == entries.end()) {
+                it = waiting.erase(it);
+                continue;
+            }
+            const Entry &entry = found->second;
+            if (entry.attempts > it->second && !entry.uploading && entry.lastError != 0) {
+                ret = entry.lastError;
+                return true;
+            }
+            ++it;
+        }
+        return waiting.empty();
+    });
+    return ret;
+}
+
+WriteBackStats WriteBack::GetStats()
+{
+    std::lock_guard lock(mutex);
+    WriteBackStats result = stats;
+    result.dirty = entries.size();
+    return result;
+}
+
+void WriteBack::QueueLocked(uint64_t inodeId, Entry &entry, Clock::time_point readyTime)
+{
+    entry.readyTime = readyTime;
+    entry.queued = true;
+    queue.emplace(readyTime, inodeId);
+    queueCV.notify_one();
+}
+
+void WriteBack::DropLocked(uint64_t inodeId)
+{
+    auto found = entries.find(inodeId);
+    if (found->second.queued) {
+        queue.erase({found->second.readyTime, inodeId});
+    }
+    entries.erase(found);
+    DiskCache::GetInstance().Unpin(inodeId);
+    idleCV.notify_all();
+}
+
+bool WriteBack::Throttle(std::unique_lock<std::mutex> &lock, uint64_t size)
+{
+    if (options.rateMBps == 0) {
+        return true;
+    }
+    auto start = std::max(Clock::now(), rateFreeTime);
+    rateFreeTime = start + std::chrono::microseconds(size / options.rateMBps);
+    stopCV.wait_until(lock, start, [this]() { return stopping; });
+    return !stopping;
+}
+
+void WriteBack::Run(std::stop_token stoken)
+{
+    std::unique_lock lock(mutex);
+    while (!stopping && !stoken.stop_requested()) {
+        if (queue.empty()) {
+            queueCV.wait(lock);
+            continue;
+        }
+        auto [readyTime, inodeId] = *queue.begin();
+        if (readyTime > Clock::now()) {
+            queueCV.wait_until(lock, readyTime);
+            continue;
+        }
+        queue.erase(queue.begin());
+        Entry &entry = entries.at(inodeId);
+        entry.queued = false;
+        entry.uploading = true;
+        uint64_t gen = entry.generation;
+        std::string path = entry.path;
+        if (!Throttle(lock, entry.size)) {
+            /* replayed on the next start */
+            entries.at(inodeId).uploading = false;
+            idleCV.notify_all();
+            break;
+        }
+
+        lock.unlock();
+        int ret = upload(inodeId, path);
+        lock.lock();
+
+        auto found = entries.find(inodeId);
+        if (found == entries.end()) {
+            continue;
+        }
+        Entry &done = found->second;
+        done.uploading = false;
+        ++done.attempts;
+        done.lastError = ret;
+        if (ret != 0) {
+            ++stats.failed;
+            done.retryMs = done.retryMs == 0 ? options.retryMs : std::min(done.retryMs * 2, MAX_RETRY_MS);
+            CUCKOO_LOG(LOG_ERROR) << "WriteBack: upload " << path << " failed: " << strerror(-ret) << ", retry in "
+                                  << done.retryMs << " ms";
+            QueueLocked(inodeId, done, Clock::now() + std::chrono::milliseconds(done.retryMs));
+        } else if (done.generation != gen) {
+            /* flushed again while uploading */
+            ++stats.uploaded;
+            done.retryMs = 0;
+            QueueLocked(inodeId, done, Clock::now() + std::chrono::milliseconds(options.delayMs));
+        } else {
+            ++stats.uploaded;
+            DropLocked(inodeId);
+            Append(false, inodeId, gen, 0, path, false);
+            bool compact = false;
+            {
+                std::lock_guard journalLock(journalMutex);
+                compact = journalSize > liveSize + COMPACT_SIZE;
+            }
+            if (compact) {
+                CompactLocked();
+            }
+        }
+        idleCV.notify_all();
+    }
+}
+
+int WriteBack::Append(bool dirty,
+                      uint64_t inodeId,
+                      uint64_t generation,
+                      uint64_t size,
+                      const std::string &path,
+                      bool sync)
+{
+    std::string record = Encode(dirty ? RECORD_DIRTY : RECORD_CLEAN, inodeId, generation, size, path);
+    uint64_t seq = 0;
+    {
+        std::lock_guard journalLock(journalMutex);
+        if (journalFd < 0) {
+            return -EBADF;
+        }
+        int ret = WriteAll(journalFd, record.data(), record.size());
+        if (ret != 0) {
+            return ret;
+        }
+        journalSize += record.size();
+        seq = ++appendSeq;
+    }
+    if (!sync) {
+        return 0;
+    }
+    /* whoever syncs covers every record appended before */
+    std::lock_guard syncLock(syncMutex);
+    if (syncedSeq >= seq) {
+        return 0;
+    }
+    std::lock_guard journalLock(journalMutex);
+    uint64_t target = appendSeq;
+    if (fdatasync(journalFd) != 0) {
+        return -errno;
+    }
+    syncedSeq = target;
+    return 0;
+}
+
+int WriteBack::Replay()
+{
+    int fd = open(options.journalPath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        int err = errno;
+        CUCKOO_LOG(LOG_ERROR) << "WriteBack: open journal " << options.journalPath << " failed: " << strerror(err);
+        return -err;
+    }
+
+    struct Replayed
+    {
+        std::string path;
+        uint64_t size{0};
+        uint64_t dirtyGen{0};
+        uint64_t cleanGen{0};
+    };
+    std::unordered_map<uint64_t, Replayed> replayed;
+    uint64_t maxGen = 0;
+    uint64_t offset = 0;
+    std::string path;
+    while (true) {
+        JournalRecord record{};
+        ssize_t n = pread(fd, &record, sizeof(record), offset);
+        if (n == 0) {
+            break;
+        }
+        bool valid = n == sizeof(record) && record.magic == RECORD_MAGIC &&
+                     (record.type == RECORD_DIRTY || record.type == RECORD_CLEAN) && record.pathLen <= MAX_PATH_LEN;
+        if (valid) {
+            path.resize(record.pathLen);
+            valid = pread(fd, path.data(), record.pathLen, offset + sizeof(record)) == (ssize_t)record.pathLen &&
+                    record.checksum == Checksum(record, path.data());
+        }
+        if (!valid) {
+            CUCKOO_LOG(LOG_WARNING) << "WriteBack: journal " << options.journalPath << " is torn at " << offset
+                                    << ", the rest is dropped";
+            break;
+        }
+        Replayed &item = replayed[record.inodeId];
+        if (record.type == RECORD_DIRTY && record.generation > item.dirtyGen) {
+            item.dirtyGen = record.generation;
+            item.size = record.size;
+            item.path = path;
+        } else if (record.type == RECORD_CLEAN) {
+            item.cleanGen = std::max(item.cleanGen, record.generation);
+        }
+        maxGen = std::max(maxGen, record.generation);
+        offset += sizeof(record) + record.pathLen;
+    }
+
+    std::unique_lock lock(mutex);
+    {
+        std::lock_guard journalLock(journalMutex);
+        if (journalFd >= 0) {
+            close(journalFd);
+        }
+        journalFd = fd;
+        journalSize = offset;
+    }
+    generation = std::max(generation, maxGen);
+    auto now = Clock::now();
+    for (auto &[inodeId, item] : replayed) {
+        if (item.dirtyGen <= item.cleanGen || entries.contains(inodeId)) {
+            continue;
+        }
+        Entry &entry = entries[inodeId];
+        entry.path = item.path;
+        entry.size = item.size;
+        entry.generation = item.dirtyGen;
+        DiskCache::GetInstance().Pin(inodeId);
+        QueueLocked(inodeId, entry, now);
+        ++stats.replayed;
+    }
+    CUCKOO_LOG(LOG_INFO) << "WriteBack: replayed " << stats.replayed << " dirty files from " << options.journalPath;
+    return CompactLocked();
+}
+
+int WriteBack::CompactLocked()
+{
+    std::string buf;
+    for (auto &[inodeId, entry] : entries) {
+        buf += Encode(RECORD_DIRTY, inodeId, entry.generation, entry.size, entry.path);
+    }
+    std::string tmpPath = options.journalPath + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) {
+        int err = errno;
+        CUCKOO_LOG(LOG_ERROR) << "WriteBack: create " << tmpPath << " failed: " << strerror(err);
+        return -err;
+    }
+    int ret = WriteAll(fd, buf.data(), buf.size());
+    if (ret == 0 && fdatasync(fd) != 0) {
+        ret = -errno;
+    }
+    std::lock_guard syncLock(syncMutex);
+    std::lock_guard journalLock(journalMutex);
+    if (ret == 0 && rename(tmpPath.c_str(), options.journalPath.c_str()) != 0) {
+        ret = -errno;
+    }
+    if (ret == 0) {
+        ret = SyncParent(options.journalPath);
+    }
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "WriteBack: compact journal " << options.journalPath << " failed: " << strerror(-ret);
+        close(fd);
+        unlink(tmpPath.c_str());
+        return ret;
+    }
+    /* records appended to the old journal are already in entries */
+    if (journalFd >= 0) {
+        close(journalFd);
+    }
+    journalFd = fd;
+    journalSize = buf.size();
+    liveSize = buf.size();
+    syncedSeq = appendSeq;
+    return 0;
+}
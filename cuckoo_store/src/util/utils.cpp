@@ -18,10 +18,15 @@ void SetTotalDirectory(int num) { totalDirectory = num; }
 
 std::string GetFilePath(uint64_t inodeId)
 {
+    if (inodeId & SEGMENT_KEY_BIT) {
+        return std::format("{}/{}.seg", GetSegmentDir(), inodeId & ~SEGMENT_KEY_BIT);
+    }
     int directoryId = inodeId % totalDirectory;
     return std::format("{}/{}/{}-large", rootPath, directoryId, inodeId);
 }
 
+std::string GetSegmentDir() { return std::format("{}/segments", rootPath); }
+
 int GenerateRandom(int minValue, int maxValue)
 {
     static std::random_device seed;
@@ -0,0 +1,145 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "stat_cache.h"
+
+class StatCacheUT : public testing::Test {
+  public:
+    void TearDown() override { StatCache::GetInstance().Init(0, 0); }
+
+    static void Put(const std::string &path, off_t size)
+    {
+        struct stat st = {};
+        st.st_size = size;
+        StatCache::GetInstance().Put(path, &st, StatCache::GetInstance().Generation(path));
+    }
+
+    static off_t CachedSize(const std::string &path)
+    {
+        struct stat st = {};
+        return StatCache::GetInstance().Get(path, &st) ? st.st_size : -1;
+    }
+};
+
+TEST_F(StatCacheUT, Disabled)
+{
+    StatCache::GetInstance().Init(0, 1000);
+    Put("/a", 1);
+    EXPECT_EQ(CachedSize("/a"), -1);
+}
+
+TEST_F(StatCacheUT, Hit)
+{
+    StatCache::GetInstance().Init(1024, 60000);
+    EXPECT_EQ(CachedSize("/a"), -1);
+    Put("/a", 1);
+    Put("/b", 2);
+    EXPECT_EQ(CachedSize("/a"), 1);
+    EXPECT_EQ(CachedSize("/b"), 2);
+    Put("/a", 3);
+    EXPECT_EQ(CachedSize("/a"), 3);
+    StatCache::GetInstance().Invalidate("/a");
+    EXPECT_EQ(CachedSize("/a"), -1);
+    EXPECT_EQ(CachedSize("/b"), 2);
+}
+
+TEST_F(StatCacheUT, LeaseExpiry)
+{
+    StatCache::GetInstance().Init(1024, 50);
+    Put("/a", 1);
+    EXPECT_EQ(CachedSize("/a"), 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(CachedSize("/a"), -1);
+}
+
+TEST_F(StatCacheUT, InvalidateTree)
+{
+    StatCache::GetInstance().Init(1024, 60000);
+    Put("/d", 1);
+    Put("/d/f", 2);
+    Put("/dd", 3);
+    StatCache::GetInstance().InvalidateTree("/d");
+    EXPECT_EQ(CachedSize("/d"), -1);
+    EXPECT_EQ(CachedSize("/d/f"), -1);
+    EXPECT_EQ(CachedSize("/dd"), 3);
+}
+
+TEST_F(StatCacheUT, InvalidateParent)
+{
+    StatCache::GetInstance().Init(1024, 60000);
+    Put("/", 1);
+    Put("/d", 2);
+    Put("/d/f", 3);
+    StatCache::GetInstance().InvalidateParent("/d/f");
+    EXPECT_EQ(CachedSize("/d"), -1);
+    EXPECT_EQ(CachedSize("/d/f"), 3);
+    EXPECT_EQ(CachedSize("/"), 1);
+    Put("/d", 2);
+    StatCache::GetInstance().InvalidateParent("/d/");
+    EXPECT_EQ(CachedSize("/"), -1);
+    EXPECT_EQ(CachedSize("/d"), 2);
+    // the root has no parent
+    Put("/", 1);
+    StatCache::GetInstance().InvalidateParent("/");
+    EXPECT_EQ(CachedSize("/"), 1);
+}
+
+// a stat fetched before an invalidation must not be put after it
+TEST_F(StatCacheUT, InvalidationRacingPut)
+{
+    StatCache &cache = StatCache::GetInstance();
+    cache.Init(1024, 60000);
+    struct stat stale = {};
+    stale.st_size = 1;
+
+    uint64_t generation = cache.Generation("/a");
+    cache.Invalidate("/a");
+    cache.Put("/a", &stale, generation);
+    EXPECT_EQ(CachedSize("/a"), -1);
+
+    generation = cache.Generation("/d/f");
+    cache.InvalidateTree("/d");
+    cache.Put("/d/f", &stale, generation);
+    EXPECT_EQ(CachedSize("/d/f"), -1);
+
+    // a fetch started after the invalidation is cached
+    Put("/a", 2);
+    EXPECT_EQ(CachedSize("/a"), 2);
+}
+
+TEST_F(StatCacheUT, ConcurrentInvalidation)
+{
+    StatCache &cache = StatCache::GetInstance();
+    cache.Init(1024, 60000);
+    constexpr int ROUNDS = 10000;
+    std::atomic<int> invalidated{0};
+    std::thread writer([&cache, &invalidated]() {
+        for (int i = 1; i <= ROUNDS; ++i) {
+            invalidated.store(i);
+            cache.Invalidate("/a");
+        }
+    });
+    // a put of round k is dropped or erased by the invalidation of round k + 1
+    for (int i = 0; i < ROUNDS; ++i) {
+        uint64_t generation = cache.Generation("/a");
+        struct stat st = {};
+        st.st_size = invalidated.load();
+        cache.Put("/a", &st, generation);
+        int latest = invalidated.load();
+        off_t cached = CachedSize("/a");
+        if (cached >= 0) {
+            EXPECT_GE(cached + 1, latest);
+        }
+    }
+    writer.join();
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,3 +1,7 @@
+#include <string_view>
+#include <tuple>
+#include <vector>
+
 #include "test_cuckoo_store.h"
 
 #include "connection/node.h"
@@ -540,6 +544,64 @@ TEST_F(CuckooStoreUT, ReadRemoteRandomSmall)
     EXPECT_EQ(0, memcmp(writeBuf, readBuf, readSize));
 }
 
+TEST_F(CuckooStoreUT, ReadSmallBatch)
+{
+    /* a local and a remote file written above, and a missing one */
+    std::vector<std::shared_ptr<OpenInstance>> instances;
+    std::vector<OpenInstance *> toRead;
+    for (auto [inodeId, nodeId, path] : {std::tuple(10000UL, 0, "/ReadLocalSmall"),
+                                         std::tuple(20000UL, 1, "/ReadRemoteSmall"),
+                                         std::tuple(20099UL, 1, "/ReadRemoteMissing")}) {
+        NewOpenInstance(inodeId, StoreNode::GetInstance()->GetNodeId() + nodeId, path, O_RDONLY);
+        openInstance->originalSize = size;
+        openInstance->currentSize = size;
+        openInstance->readBuffer = std::shared_ptr<char>((char *)malloc(size), free);
+        openInstance->readBufferSize = size;
+        instances.push_back(openInstance);
+        toRead.push_back(openInstance.get());
+    }
+    std::vector<int> results;
+    CuckooStore::GetInstance()->ReadSmallFilesBatch(toRead, results);
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_EQ(results[0], 0);
+    EXPECT_EQ(results[1], 0);
+    EXPECT_NE(results[2], 0);
+    EXPECT_EQ(0, memcmp(writeBuf, instances[0]->readBuffer.get(), size));
+    EXPECT_EQ(0, memcmp(writeBuf, instances[1]->readBuffer.get(), size));
+}
+
+TEST_F(CuckooStoreUT, WriteSmallBatch)
+{
+    /* new files on the local and on a remote node, written whole at once */
+    ResetBuf(false);
+    std::vector<std::shared_ptr<OpenInstance>> instances;
+    std::vector<OpenInstance *> toWrite;
+    std::vector<std::string_view> datas;
+    for (auto [inodeId, nodeId, path] : {std::tuple(10100UL, 0, "/WriteLocalBatch"),
+                                         std::tuple(20100UL, 1, "/WriteRemoteBatch"),
+                                         std::tuple(20101UL, 1, "/WriteRemoteBatchHalf")}) {
+        NewOpenInstance(inodeId, StoreNode::GetInstance()->GetNodeId() + nodeId, path, O_WRONLY | O_CREAT);
+        instances.push_back(openInstance);
+        toWrite.push_back(openInstance.get());
+        datas.emplace_back(writeBuf, inodeId == 20101 ? size / 2 : size);
+    }
+    std::vector<int> results;
+    CuckooStore::GetInstance()->WriteSmallFilesBatch(toWrite, datas, results);
+    ASSERT_EQ(results.size(), 3);
+    for (size_t i = 0; i < instances.size(); ++i) {
+        EXPECT_EQ(results[i], 0);
+        EXPECT_EQ(instances[i]->currentSize, datas[i].size());
+
+        NewOpenInstance(instances[i]->inodeId, instances[i]->nodeId, instances[i]->path, O_RDONLY);
+        openInstance->originalSize = datas[i].size();
+        openInstance->currentSize = datas[i].size();
+        openInstance->readBuffer = std::shared_ptr<char>((char *)malloc(datas[i].size()), free);
+        openInstance->readBufferSize = datas[i].size();
+        EXPECT_EQ(CuckooStore::GetInstance()->ReadSmallFiles(openInstance.get()), 0);
+        EXPECT_EQ(0, memcmp(writeBuf, openInstance->readBuffer.get(), datas[i].size()));
+    }
+}
+
 TEST_F(CuckooStoreUT, ReadRemoteSeqLarge)
 {
     NewOpenInstance(20001, StoreNode::GetInstance()->GetNodeId() + 1, "/ReadRemoteLarge", O_WRONLY | O_CREAT);
@@ -628,6 +690,29 @@ TEST_F(CuckooStoreUT, ReadRemoteHole)
     delete[] static_cast<char *>(zeroBlock);
 }
 
+TEST_F(CuckooStoreUT, ReadRemoteShort)
+{
+    NewOpenInstance(20002, StoreNode::GetInstance()->GetNodeId() + 1, "/ReadRemoteShort", O_WRONLY | O_CREAT);
+    ResetBuf(true);
+    int ret = CuckooStore::GetInstance()->WriteFile(openInstance.get(), writeBuf, size, 0);
+    EXPECT_EQ(ret, 0);
+
+    NewOpenInstance(20002, StoreNode::GetInstance()->GetNodeId() + 1, "/ReadRemoteShort", O_RDONLY);
+    openInstance->originalSize = size;
+    openInstance->currentSize = size;
+    ret = CuckooStore::GetInstance()->OpenFile(openInstance.get());
+    EXPECT_EQ(ret, 0);
+    /* the remote node only knows size bytes, its reply to a read across the end is short */
+    openInstance->currentSize = size * 2;
+    off_t offset = size - readSize / 2;
+    butil::IOBuf remoteBuf;
+    ssize_t retSize = CuckooStore::GetInstance()->ReadFileLR(readBuf, offset, openInstance.get(), readSize, &remoteBuf);
+    EXPECT_EQ(retSize, (ssize_t)readSize / 2);
+    EXPECT_EQ(remoteBuf.size(), readSize / 2);
+    std::string data = remoteBuf.to_string();
+    EXPECT_EQ(0, memcmp(writeBuf + offset, data.data(), data.size()));
+}
+
 /* ------------------------------------------- RDWR local -------------------------------------------*/
 // all large file
 TEST_F(CuckooStoreUT, PrereadWriteLocal)
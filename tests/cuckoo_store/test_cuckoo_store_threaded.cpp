@@ -359,6 +359,24 @@ TEST_F(CuckooStoreUT, ReadRemoteLargeDifferent)
     EXPECT_EQ(0, memcmp(writeBuf + readSize, readBuf2, readSize));
 }
 
+TEST_F(CuckooStoreUT, ReadRemoteLargeSequential)
+{
+    // sequential reads of a remote file go through the read stream and the remote IOBuf path
+    constexpr int ROUND = 2;
+    for (int round = 0; round < ROUND; ++round) {
+        NewOpenInstance(20001, StoreNode::GetInstance()->GetNodeId() - 1, "/ReadRemoteLarge", O_RDONLY);
+        openInstance->originalSize = size;
+        openInstance->currentSize = size;
+        for (size_t offset = 0; offset < size; offset += readSize) {
+            size_t expected = std::min(readSize, size - offset);
+            int ret = CuckooStore::GetInstance()->ReadFile(openInstance.get(), readBuf, readSize, offset);
+            ASSERT_EQ(ret, (int)expected);
+            ASSERT_EQ(0, memcmp(writeBuf + offset, readBuf, expected));
+        }
+        CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), false, false);
+    }
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
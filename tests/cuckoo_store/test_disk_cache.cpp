@@ -1,12 +1,193 @@
+#include <utime.h>
+#include <chrono>
+#include <fstream>
+#include <numeric>
+
 #include "test_disk_cache.h"
 #include "disk_cache/disk_cache.h"
+#include "util/utils.h"
 
 std::string DiskCacheUT::rootPath = "/tmp/testdir/";
 
+static std::pair<uint64_t, uint64_t> PromotionsAndEvictions()
+{
+    uint64_t promotions = 0;
+    uint64_t evictions = 0;
+    for (auto &shard : DiskCache::GetInstance().GetShardStats()) {
+        promotions += shard.promotions;
+        evictions += shard.evictions;
+    }
+    return {promotions, evictions};
+}
+
+static uint64_t Entries(DiskCache &cache = DiskCache::GetInstance())
+{
+    auto stats = cache.GetShardStats();
+    return std::accumulate(stats.begin(), stats.end(), 0UL, [](uint64_t sum, const DiskCacheShardStats &shard) {
+        return sum + shard.entries;
+    });
+}
+
 TEST_F(DiskCacheUT, Start)
 {
     int ret = DiskCache::GetInstance().Start(rootPath, 100, 0.2, 0.2);
     EXPECT_EQ(ret, 0);
+    SetRootPath(rootPath);
+    SetTotalDirectory(100);
+}
+
+TEST_F(DiskCacheUT, PinUnpin)
+{
+    uint64_t key = 1000001;
+    std::ofstream(GetFilePath(key)) << "data";
+    DiskCache::GetInstance().InsertAndUpdate(key, 4, true);
+    EXPECT_TRUE(DiskCache::GetInstance().Find(key, true));
+
+    // pinned twice, never evicted
+    DiskCache::GetInstance().EvictFiles(UINT64_MAX, Entries());
+    EXPECT_TRUE(DiskCache::GetInstance().Find(key, false));
+    DiskCache::GetInstance().Unpin(key);
+    DiskCache::GetInstance().EvictFiles(UINT64_MAX, Entries());
+    EXPECT_TRUE(DiskCache::GetInstance().Find(key, false));
+
+    DiskCache::GetInstance().Unpin(key);
+    DiskCache::GetInstance().EvictFiles(UINT64_MAX, Entries());
+    EXPECT_FALSE(DiskCache::GetInstance().Find(key, false));
+    EXPECT_NE(access(GetFilePath(key).c_str(), F_OK), 0);
+    EXPECT_EQ(Entries(), 0);
+}
+
+TEST_F(DiskCacheUT, ScanResistance)
+{
+    constexpr uint64_t HOT_NUM = 256;
+    constexpr uint64_t SCAN_NUM = DiskCache::SHARD_NUM * 64;
+    constexpr uint64_t HOT_BASE = 2000000;
+    constexpr uint64_t SCAN_BASE = 3000000;
+    auto [promotionsBefore, evictionsBefore] = PromotionsAndEvictions();
+    for (uint64_t i = 0; i < HOT_NUM; ++i) {
+        DiskCache::GetInstance().InsertAndUpdate(HOT_BASE + i, 4096, false);
+        EXPECT_TRUE(DiskCache::GetInstance().Find(HOT_BASE + i, false));
+    }
+    // one pass over a large dataset, every file read once
+    for (uint64_t i = 0; i < SCAN_NUM; ++i) {
+        DiskCache::GetInstance().InsertAndUpdate(SCAN_BASE + i, 4096, false);
+    }
+    DiskCache::GetInstance().EvictFiles(0, SCAN_NUM / 4);
+    for (uint64_t i = 0; i < HOT_NUM; ++i) {
+        EXPECT_TRUE(DiskCache::GetInstance().Find(HOT_BASE + i, false)) << i;
+    }
+
+    auto [promotions, evictions] = PromotionsAndEvictions();
+    EXPECT_EQ(promotions - promotionsBefore, HOT_NUM);
+    EXPECT_EQ(evictions - evictionsBefore, SCAN_NUM / 4);
+    EXPECT_EQ(Entries(), HOT_NUM + SCAN_NUM - SCAN_NUM / 4);
+}
+
+TEST_F(DiskCacheUT, GhostHit)
+{
+    // a file evicted from probation and cached again soon goes to the protected queue
+    uint64_t ghostHits = 0;
+    uint64_t evicted = 0;
+    for (uint64_t key = 3000000; key < 3000000 + DiskCache::SHARD_NUM * 64; ++key) {
+        if (!DiskCache::GetInstance().Find(key, false)) {
+            DiskCache::GetInstance().InsertAndUpdate(key, 4096, false);
+            ++evicted;
+        }
+    }
+    for (auto &shard : DiskCache::GetInstance().GetShardStats()) {
+        ghostHits += shard.ghostHits;
+    }
+    EXPECT_GT(evicted, 0);
+    EXPECT_EQ(ghostHits, evicted);
+    DiskCache::GetInstance().EvictFiles(UINT64_MAX, Entries());
+    EXPECT_EQ(Entries(), 0);
+}
+
+TEST_F(DiskCacheUT, Concurrent)
+{
+    constexpr int THREAD_NUM = 8;
+    constexpr uint64_t KEY_NUM = 4096;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_NUM; ++t) {
+        threads.emplace_back([t]() {
+            for (uint64_t i = 0; i < KEY_NUM; ++i) {
+                uint64_t key = 4000000 + t * KEY_NUM + i;
+                DiskCache::GetInstance().InsertAndUpdate(key, 1, true);
+                DiskCache::GetInstance().Add(key, 1);
+                DiskCache::GetInstance().Find(key, false);
+                DiskCache::GetInstance().Unpin(key);
+                if (i % 4 == 0) {
+                    DiskCache::GetInstance().EvictFiles(0, 1);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    DiskCache::GetInstance().EvictFiles(UINT64_MAX, Entries());
+    EXPECT_EQ(Entries(), 0);
+}
+
+TEST_F(DiskCacheUT, SnapshotRestart)
+{
+    constexpr uint64_t BASE = 5000000;
+    constexpr uint64_t NUM = 1000;
+    std::string snapshotPath = rootPath + "/" + DiskCache::SNAPSHOT_NAME;
+    {
+        DiskCache cache;
+        ASSERT_EQ(cache.Start(rootPath, 100, 0.2, 0.2), 0);
+        for (uint64_t key = BASE; key < BASE + NUM; ++key) {
+            // only even files are left on disk
+            if (key % 2 == 0) {
+                std::ofstream(GetFilePath(key)) << "data";
+            }
+            cache.InsertAndUpdate(key, 4, false);
+        }
+        // a clean snapshot is written at stop
+    }
+    ASSERT_EQ(access(snapshotPath.c_str(), F_OK), 0);
+
+    // written before the restart but after the snapshot
+    uint64_t untracked = BASE + NUM + 1;
+    std::ofstream(GetFilePath(untracked)) << "data";
+    struct utimbuf past = {time(nullptr) - 3600, time(nullptr) - 3600};
+    utime(GetFilePath(untracked).c_str(), &past);
+    {
+        DiskCache cache;
+        ASSERT_EQ(cache.Start(rootPath, 100, 0.2, 0.2), 0);
+        EXPECT_EQ(Entries(cache), NUM);
+        // deleting an entry whose file is gone drops it from the index
+        cache.DeleteOldCacheWithNoPin(BASE + 1);
+        EXPECT_EQ(cache.Delete(BASE + 3), 0);
+        EXPECT_EQ(Entries(cache), NUM - 2);
+        // missing files are found out on first use
+        for (uint64_t key = BASE; key < BASE + NUM; ++key) {
+            EXPECT_EQ(cache.Find(key, false), key % 2 == 0);
+        }
+        EXPECT_EQ(Entries(cache), NUM / 2);
+        EXPECT_FALSE(cache.Find(untracked, false));
+
+        // the snapshot is dirty once loaded, another start indexes the files missing from it
+        DiskCache other;
+        ASSERT_EQ(other.Start(rootPath, 100, 0.2, 0.2), 0);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!other.Find(untracked, false) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_TRUE(other.Find(untracked, false));
+    }
+
+    // a broken snapshot falls back to scanning the directories
+    std::ofstream(snapshotPath, std::ios::trunc) << "garbage";
+    {
+        DiskCache cache;
+        ASSERT_EQ(cache.Start(rootPath, 100, 0.2, 0.2), 0);
+        EXPECT_EQ(Entries(cache), NUM / 2 + 1);
+        cache.EvictFiles(UINT64_MAX, Entries(cache));
+        EXPECT_EQ(Entries(cache), 0);
+    }
+    unlink(snapshotPath.c_str());
 }
 
 int main(int argc, char **argv)
@@ -0,0 +1,186 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "buffer/mem_pool.h"
+#include "io_engine/io_engine.h"
+
+class IoEngineUT : public testing::Test {
+  public:
+    static void SetUpTestSuite()
+    {
+        MemPool::GetInstance().init(BLOCK_SIZE, 64);
+        IoEngineOptions options;
+        options.fixedBuffers = true;
+        IoEngine::GetInstance().Init(options);
+    }
+
+    void SetUp() override
+    {
+        fileName = "/tmp/io_engine_ut_" + std::to_string(getpid());
+        fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        ASSERT_GE(fd, 0);
+    }
+
+    void TearDown() override
+    {
+        IoEngine::GetInstance().Close(fd);
+        unlink(fileName.c_str());
+    }
+
+    static std::vector<char> Pattern(size_t size)
+    {
+        std::vector<char> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>(i * 131 + i / 4096);
+        }
+        return data;
+    }
+
+    static constexpr size_t BLOCK_SIZE = 512 * 1024;
+    std::string fileName;
+    int fd = -1;
+};
+
+TEST_F(IoEngineUT, ReadWrite)
+{
+    // crosses several IO_CHUNK_SIZE chunks and ends with a partial one
+    size_t size = 3 * IoEngine::IO_CHUNK_SIZE + 12345;
+    auto data = Pattern(size);
+    EXPECT_EQ(IoEngine::GetInstance().Write(fd, data.data(), size, 0), (ssize_t)size);
+
+    std::vector<char> out(size + 4096);
+    EXPECT_EQ(IoEngine::GetInstance().Read(fd, out.data(), out.size(), 0), (ssize_t)size);
+    EXPECT_EQ(memcmp(out.data(), data.data(), size), 0);
+
+    // short only at EOF
+    EXPECT_EQ(IoEngine::GetInstance().Read(fd, out.data(), 4096, size - 100), 100);
+    EXPECT_EQ(memcmp(out.data(), data.data() + size - 100, 100), 0);
+    EXPECT_EQ(IoEngine::GetInstance().Read(fd, out.data(), 4096, size + 1), 0);
+    EXPECT_EQ(IoEngine::GetInstance().Read(-1, out.data(), 4096, 0), -EBADF);
+}
+
+TEST_F(IoEngineUT, HotFdAndFixedBuffer)
+{
+    auto data = Pattern(BLOCK_SIZE);
+    ASSERT_EQ(IoEngine::GetInstance().Write(fd, data.data(), BLOCK_SIZE, 0), (ssize_t)BLOCK_SIZE);
+
+    // the fd becomes a fixed file after a few reads, the buffer is inside a registered slab
+    char *block = static_cast<char *>(MemPool::GetInstance().alloc());
+    ASSERT_NE(block, nullptr);
+    for (int i = 0; i < 10; ++i) {
+        memset(block, 0, BLOCK_SIZE);
+        ASSERT_EQ(IoEngine::GetInstance().Read(fd, block, BLOCK_SIZE, 0), (ssize_t)BLOCK_SIZE);
+        ASSERT_EQ(memcmp(block, data.data(), BLOCK_SIZE), 0);
+    }
+
+    // reusing the fd number for another file must not read the old one through the ring
+    IoEngine::GetInstance().Close(fd);
+    std::string otherName = fileName + "_other";
+    fd = open(otherName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    unlink(otherName.c_str());
+    EXPECT_EQ(IoEngine::GetInstance().Read(fd, block, BLOCK_SIZE, 0), 0);
+    MemPool::GetInstance().free(block);
+}
+
+TEST_F(IoEngineUT, Batch)
+{
+    constexpr size_t FILE_NUM = 100;
+    constexpr size_t FILE_SIZE = 8192;
+    auto data = Pattern(FILE_NUM * FILE_SIZE);
+    ASSERT_EQ(IoEngine::GetInstance().Write(fd, data.data(), data.size(), 0), (ssize_t)data.size());
+
+    std::vector<char> out(data.size());
+    std::vector<IoRequest> reqs(FILE_NUM);
+    for (size_t i = 0; i < FILE_NUM; ++i) {
+        reqs[i].fd = fd;
+        reqs[i].buf = out.data() + i * FILE_SIZE;
+        reqs[i].size = FILE_SIZE;
+        reqs[i].offset = i * FILE_SIZE;
+    }
+    IoEngine::GetInstance().Submit(reqs.data(), reqs.size());
+    for (auto &req : reqs) {
+        EXPECT_EQ(req.result, (ssize_t)FILE_SIZE);
+    }
+    EXPECT_EQ(memcmp(out.data(), data.data(), data.size()), 0);
+}
+
+TEST_F(IoEngineUT, Concurrent)
+{
+    constexpr int THREAD_NUM = 8;
+    constexpr int ROUND = 200;
+    constexpr size_t SIZE = 64 * 1024;
+    auto data = Pattern(THREAD_NUM * SIZE);
+    ASSERT_EQ(IoEngine::GetInstance().Write(fd, data.data(), data.size(), 0), (ssize_t)data.size());
+
+    std::vector<std::thread> threads;
+    std::atomic<int> failed = 0;
+    for (int t = 0; t < THREAD_NUM; ++t) {
+        threads.emplace_back([&, t]() {
+            std::vector<char> out(SIZE);
+            for (int i = 0; i < ROUND; ++i) {
+                ssize_t ret = IoEngine::GetInstance().Read(fd, out.data(), SIZE, t * SIZE);
+                if (ret != (ssize_t)SIZE || memcmp(out.data(), data.data() + t * SIZE, SIZE) != 0) {
+                    ++failed;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failed, 0);
+}
+
+TEST_F(IoEngineUT, Benchmark)
+{
+    // many small cache files read with one submission vs one pread each
+    constexpr size_t FILE_NUM = 256;
+    constexpr size_t FILE_SIZE = 16 * 1024;
+    auto data = Pattern(FILE_NUM * FILE_SIZE);
+    ASSERT_EQ(IoEngine::GetInstance().Write(fd, data.data(), data.size(), 0), (ssize_t)data.size());
+    std::vector<char> out(data.size());
+    constexpr int ROUND = 20;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUND; ++r) {
+        for (size_t i = 0; i < FILE_NUM; ++i) {
+            ASSERT_EQ(pread(fd, out.data() + i * FILE_SIZE, FILE_SIZE, i * FILE_SIZE), (ssize_t)FILE_SIZE);
+        }
+    }
+    auto syncCost = std::chrono::steady_clock::now() - start;
+
+    std::vector<IoRequest> reqs(FILE_NUM);
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUND; ++r) {
+        for (size_t i = 0; i < FILE_NUM; ++i) {
+            reqs[i] = IoRequest{fd, out.data() + i * FILE_SIZE, FILE_SIZE, (off_t)(i * FILE_SIZE)};
+        }
+        IoEngine::GetInstance().Submit(reqs.data(), reqs.size());
+    }
+    auto batchCost = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(memcmp(out.data(), data.data(), data.size()), 0);
+
+    auto perRead = [](auto cost) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(cost).count() / (ROUND * FILE_NUM);
+    };
+    std::println("io engine {}: pread {} ns/file, batch {} ns/file",
+                 IoEngine::GetInstance().UringEnabled() ? "uring" : "sync",
+                 perRead(syncCost),
+                 perRead(batchCost));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,163 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "storage/local_storage.h"
+#include "storage/object_layout.h"
+
+class LocalStorageUT : public testing::Test {
+  public:
+    void SetUp() override
+    {
+        root = "/tmp/local_storage_ut_" + std::to_string(getpid());
+        LocalStorageOptions options;
+        options.root = root;
+        LocalStorage::GetInstance()->SetOptions(options);
+        ASSERT_EQ(LocalStorage::GetInstance()->Init(), 0);
+    }
+
+    void TearDown() override
+    {
+        LocalStorage::GetInstance()->DeleteInstance();
+        std::filesystem::remove_all(root);
+    }
+
+    static std::vector<char> Pattern(size_t size)
+    {
+        std::vector<char> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>(i * 131 + i / 4096);
+        }
+        return data;
+    }
+
+    std::string root;
+};
+
+TEST_F(LocalStorageUT, PutReadDelete)
+{
+    auto *storage = LocalStorage::GetInstance();
+    auto data = Pattern(3 * LocalStorage::TRANSFER_CHUNK_SIZE + 100);
+    ASSERT_EQ(storage->PutBuffer("dir/sub/obj", data.data(), data.size(), 0), (ssize_t)data.size());
+
+    // a range into a buffer
+    std::vector<char> buf(LocalStorage::TRANSFER_CHUNK_SIZE * 2);
+    ASSERT_EQ(storage->ReadObject("dir/sub/obj", 100, buf.size(), -1, buf.data()), (ssize_t)buf.size());
+    EXPECT_EQ(memcmp(buf.data(), data.data() + 100, buf.size()), 0);
+
+    // size 0 reads the whole object into fd
+    std::string local = root + "/local";
+    int fd = open(local.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(storage->ReadObject("dir/sub/obj", 0, 0, fd, nullptr), (ssize_t)data.size());
+    std::vector<char> back(data.size());
+    ASSERT_EQ(pread(fd, back.data(), back.size(), 0), (ssize_t)back.size());
+    EXPECT_EQ(back, data);
+    close(fd);
+
+    // a range past the end is cut short
+    EXPECT_EQ(storage->ReadObject("dir/sub/obj", data.size() - 10, 100, -1, buf.data()), 10);
+
+    EXPECT_EQ(storage->DeleteObject("dir/sub/obj"), 0);
+    EXPECT_EQ(storage->ReadObject("dir/sub/obj", 0, 10, -1, buf.data()), -1);
+    EXPECT_NE(storage->DeleteObject("dir/sub/obj"), 0);
+}
+
+TEST_F(LocalStorageUT, PutFileCopy)
+{
+    auto *storage = LocalStorage::GetInstance();
+    auto data = Pattern(LocalStorage::TRANSFER_CHUNK_SIZE + 7);
+    std::string local = root + "/local";
+    std::ofstream(local, std::ios::binary).write(data.data(), data.size());
+
+    ASSERT_EQ(storage->PutFile("a/file", local), 0);
+    ASSERT_EQ(storage->CopyObject("a/file", "b/file"), 0);
+    std::vector<char> buf(data.size());
+    ASSERT_EQ(storage->ReadObject("b/file", 0, buf.size(), -1, buf.data()), (ssize_t)buf.size());
+    EXPECT_EQ(buf, data);
+
+    // overwritten as a whole
+    ASSERT_EQ(storage->PutBuffer("b/file", "new", 3, 0), 3);
+    EXPECT_EQ(storage->ReadObject("b/file", 0, 0, -1, buf.data()), 3);
+    EXPECT_EQ(memcmp(buf.data(), "new", 3), 0);
+
+    EXPECT_NE(storage->PutFile("c/file", root + "/missing"), 0);
+    EXPECT_NE(storage->CopyObject("missing", "c/file"), 0);
+
+    struct statvfs vfs;
+    EXPECT_EQ(storage->StatFs(&vfs), 0);
+    EXPECT_GT(vfs.f_blocks, 0);
+}
+
+TEST_F(LocalStorageUT, Throttle)
+{
+    auto *storage = LocalStorage::GetInstance();
+    LocalStorageOptions options;
+    options.root = root;
+    options.latencyUs = 20000;
+    options.bandwidthMBps = 40;
+    storage->SetOptions(options);
+    auto data = Pattern(4 * 1024 * 1024);
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(storage->PutBuffer("obj", data.data(), data.size(), 0), (ssize_t)data.size());
+    auto cost = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(cost, std::chrono::milliseconds(20 + 100));
+
+    // two readers share the link
+    start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> readers;
+        for (int i = 0; i < 2; ++i) {
+            readers.emplace_back([&]() {
+                std::vector<char> buf(data.size());
+                EXPECT_EQ(storage->ReadObject("obj", 0, buf.size(), -1, buf.data()), (ssize_t)buf.size());
+            });
+        }
+    }
+    cost = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(cost, std::chrono::milliseconds(20 + 200));
+}
+
+TEST_F(LocalStorageUT, ObjectLayoutMigrate)
+{
+    auto *storage = LocalStorage::GetInstance();
+    ObjectLayout layout(storage, true, true);
+    auto data = Pattern(1000);
+    std::vector<char> buf(data.size());
+    EXPECT_EQ(layout.Key("/dir/a", 7), std::string(ObjectLayout::INODE_OBJECT_DIR) + "/7");
+
+    // never migrated, only keyed by path
+    ASSERT_EQ(storage->PutBuffer("dir/a", data.data(), data.size(), 0), (ssize_t)data.size());
+    EXPECT_EQ(layout.LoadKey("/dir/a", 7), "dir/a");
+    ASSERT_EQ(layout.Read("/dir/a", 7, 0, buf.size(), -1, buf.data()), (ssize_t)buf.size());
+    EXPECT_EQ(buf, data);
+    EXPECT_EQ(layout.Delete("/dir/a", 7), 0);
+    EXPECT_LT(storage->ReadObject("dir/a", 0, 10, -1, buf.data()), 0);
+    EXPECT_EQ(layout.Delete("/dir/a", 7), -EIO);
+
+    // moved to the inode key by a rename
+    ASSERT_EQ(storage->PutBuffer("dir/b", data.data(), data.size(), 0), (ssize_t)data.size());
+    ASSERT_EQ(layout.Migrate("/dir/b", 8), 0);
+    EXPECT_EQ(storage->DeleteObject("dir/b"), 0);
+    EXPECT_EQ(layout.LoadKey("/dir/c", 8), layout.Key("/dir/c", 8));
+    ASSERT_EQ(layout.Read("/dir/c", 8, 0, buf.size(), -1, buf.data()), (ssize_t)buf.size());
+    EXPECT_EQ(buf, data);
+    EXPECT_EQ(layout.Delete("/dir/c", 8), 0);
+    EXPECT_LT(layout.Read("/dir/b", 8, 0, 10, -1, buf.data()), 0);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,138 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "disk_cache/mem_cache.h"
+
+class MemCacheUT : public testing::Test {
+  public:
+    static MemCacheOptions Options(uint64_t capacity)
+    {
+        MemCacheOptions options;
+        options.capacity = capacity;
+        options.maxFileSize = 64 * 1024;
+        return options;
+    }
+
+    static std::string Data(uint64_t key, uint64_t size) { return std::string(size, static_cast<char>('a' + key % 26)); }
+
+    static bool Put(MemCache &cache, uint64_t key, uint64_t size)
+    {
+        std::string data = Data(key, size);
+        return cache.Put(key, data.data(), size, cache.Epoch(key));
+    }
+
+    static bool Cached(MemCache &cache, uint64_t key, uint64_t size)
+    {
+        std::vector<char> buf(size);
+        return cache.Get(key, buf.data(), size) && std::string(buf.data(), size) == Data(key, size);
+    }
+};
+
+TEST_F(MemCacheUT, PutGet)
+{
+    MemCache cache(Options(16 * 1024 * 1024));
+    EXPECT_FALSE(cache.Fits(0));
+    EXPECT_FALSE(cache.Fits(64 * 1024 + 1));
+    EXPECT_FALSE(Put(cache, 1, 64 * 1024 + 1));
+
+    for (uint64_t key = 1; key <= 100; ++key) {
+        EXPECT_TRUE(Put(cache, key, 1000 + key));
+    }
+    for (uint64_t key = 1; key <= 100; ++key) {
+        EXPECT_TRUE(Cached(cache, key, 1000 + key));
+    }
+    /* a size mismatch is a stale copy */
+    EXPECT_FALSE(Cached(cache, 1, 10));
+    EXPECT_FALSE(Cached(cache, 1, 1001));
+    EXPECT_FALSE(Cached(cache, 1000, 10));
+
+    auto stats = cache.GetStats();
+    EXPECT_EQ(stats.entries, 99);
+    EXPECT_EQ(stats.hits, 100);
+    EXPECT_EQ(stats.misses, 3);
+    EXPECT_EQ(stats.admitted, 100);
+    EXPECT_EQ(stats.bytesServed, 100 * 1000 + 5050);
+}
+
+TEST_F(MemCacheUT, ScanResistance)
+{
+    /* 16 shards of 64KiB, 16 files of 4KiB each */
+    MemCache cache(Options(MemCache::SHARD_NUM * 64 * 1024));
+    constexpr uint64_t SIZE = 4 * 1024;
+    std::vector<uint64_t> hot;
+    for (uint64_t key = 1; key <= 64; ++key) {
+        hot.push_back(key);
+    }
+    for (int round = 0; round < 4; ++round) {
+        for (uint64_t key : hot) {
+            if (!Cached(cache, key, SIZE)) {
+                Put(cache, key, SIZE);
+            }
+        }
+    }
+    /* one pass over many cold files */
+    for (uint64_t key = 1000; key < 5000; ++key) {
+        if (!Cached(cache, key, SIZE)) {
+            Put(cache, key, SIZE);
+        }
+    }
+    uint64_t hits = 0;
+    for (uint64_t key : hot) {
+        hits += Cached(cache, key, SIZE);
+    }
+    EXPECT_EQ(hits, hot.size());
+    EXPECT_GT(cache.GetStats().rejected, 0);
+}
+
+TEST_F(MemCacheUT, EraseDropsRacingPut)
+{
+    MemCache cache(Options(16 * 1024 * 1024));
+    ASSERT_TRUE(Put(cache, 1, 100));
+    uint64_t epoch = cache.Epoch(1);
+    /* written while the old content was read from below */
+    cache.Erase(1);
+    std::string old = Data(1, 100);
+    EXPECT_FALSE(cache.Put(1, old.data(), old.size(), epoch));
+    EXPECT_FALSE(Cached(cache, 1, 100));
+    EXPECT_TRUE(Put(cache, 1, 100));
+    EXPECT_TRUE(Cached(cache, 1, 100));
+}
+
+TEST_F(MemCacheUT, Concurrent)
+{
+    MemCache cache(Options(MemCache::SHARD_NUM * 256 * 1024));
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t]() {
+            for (uint64_t i = 0; i < 5000; ++i) {
+                uint64_t key = (i * 7 + t) % 500;
+                uint64_t size = 1024 + key;
+                std::vector<char> buf(size);
+                if (cache.Get(key, buf.data(), size)) {
+                    EXPECT_EQ(std::string(buf.data(), size), Data(key, size));
+                } else {
+                    Put(cache, key, size);
+                }
+                if (i % 100 == 0) {
+                    cache.Erase(key);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto stats = cache.GetStats();
+    EXPECT_LE(stats.bytes, MemCache::SHARD_NUM * 256 * 1024);
+    EXPECT_GT(stats.hits, 0);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,185 @@
+#include <pthread.h>
+#include <chrono>
+#include <print>
+#include <queue>
+#include <thread>
+#include <unordered_set>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "buffer/mem_pool.h"
+
+/* the spinlock + queue pool used before, kept as the benchmark baseline */
+class LegacyMemPool {
+  public:
+    LegacyMemPool(size_t blockSize, size_t capacity)
+        : m_blockSize(blockSize),
+          m_capacity(capacity)
+    {
+        pthread_spin_init(&m_memLock, 0);
+    }
+    ~LegacyMemPool()
+    {
+        while (!m_freeBlocks.empty()) {
+            ::free(m_freeBlocks.front());
+            m_freeBlocks.pop();
+        }
+    }
+    void *alloc()
+    {
+        void *block = nullptr;
+        pthread_spin_lock(&m_memLock);
+        if (!m_freeBlocks.empty()) {
+            block = m_freeBlocks.front();
+            m_freeBlocks.pop();
+        }
+        pthread_spin_unlock(&m_memLock);
+        block = block ? block : aligned_alloc(512, m_blockSize);
+        m_size += block ? 1 : 0;
+        return block;
+    }
+    void free(void *buf)
+    {
+        if (m_size-- < m_capacity) {
+            pthread_spin_lock(&m_memLock);
+            m_freeBlocks.push(buf);
+            pthread_spin_unlock(&m_memLock);
+        } else {
+            ::free(buf);
+        }
+    }
+
+  private:
+    size_t m_blockSize;
+    size_t m_capacity;
+    std::atomic<size_t> m_size = 0;
+    std::queue<void *> m_freeBlocks;
+    pthread_spinlock_t m_memLock;
+};
+
+constexpr size_t BLOCK_SIZE = 256 * 1024;
+
+TEST(MemPoolUT, AllocFree)
+{
+    MemPool pool(BLOCK_SIZE, 8);
+    void *block = pool.alloc();
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 512, 0);
+    memset(block, 0xab, BLOCK_SIZE);
+    EXPECT_EQ(pool.GetStats().inUse, 1);
+    pool.free(block);
+    EXPECT_EQ(pool.GetStats().inUse, 0);
+    EXPECT_EQ(pool.GetStats().cached, 1);
+    // recycled rather than carved again
+    void *again = pool.alloc();
+    EXPECT_EQ(again, block);
+    EXPECT_EQ(pool.GetStats().carved, 1);
+    pool.free(again);
+}
+
+TEST(MemPoolUT, Overflow)
+{
+    MemPool pool(BLOCK_SIZE, 4);
+    std::vector<void *> blocks = pool.calloc(6);
+    ASSERT_EQ(blocks.size(), 6);
+    std::unordered_set<void *> unique(blocks.begin(), blocks.end());
+    EXPECT_EQ(unique.size(), 6);
+    auto stats = pool.GetStats();
+    EXPECT_EQ(stats.carved, 4);
+    EXPECT_EQ(stats.overflow, 2);
+    EXPECT_EQ(stats.inUse, 6);
+    for (auto block : blocks) {
+        pool.free(block);
+    }
+    stats = pool.GetStats();
+    EXPECT_EQ(stats.overflow, 0);
+    EXPECT_EQ(stats.inUse, 0);
+    EXPECT_EQ(stats.cached, 4);
+}
+
+TEST(MemPoolUT, HugePageNuma)
+{
+    MemPool pool(BLOCK_SIZE, 16, MemPoolOptions{.hugePage = true, .numaLocal = true});
+    std::vector<void *> blocks = pool.calloc(16);
+    ASSERT_EQ(blocks.size(), 16);
+    EXPECT_EQ(pool.GetStats().overflow, 0);
+    for (auto block : blocks) {
+        memset(block, 0, BLOCK_SIZE);
+        pool.free(block);
+    }
+    EXPECT_EQ(pool.GetStats().inUse, 0);
+}
+
+TEST(MemPoolUT, Concurrent)
+{
+    constexpr int threadNum = 16;
+    constexpr int rounds = 20000;
+    MemPool pool(BLOCK_SIZE, 64);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadNum; ++t) {
+        threads.emplace_back([&pool, t]() {
+            for (int i = 0; i < rounds; ++i) {
+                auto *block = static_cast<int *>(pool.alloc());
+                ASSERT_NE(block, nullptr);
+                *block = t;
+                std::this_thread::yield();
+                // nobody else may own the block meanwhile
+                ASSERT_EQ(*block, t);
+                pool.free(block);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto stats = pool.GetStats();
+    EXPECT_EQ(stats.inUse, 0);
+    EXPECT_EQ(stats.overflow, 0);
+    EXPECT_LE(stats.carved, 64);
+}
+
+template <typename Pool>
+static double BenchAllocFree(Pool &pool, int threadNum, int rounds)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadNum; ++t) {
+        threads.emplace_back([&pool, rounds]() {
+            void *blocks[4];
+            for (int i = 0; i < rounds; ++i) {
+                for (auto &block : blocks) {
+                    block = pool.alloc();
+                }
+                for (auto &block : blocks) {
+                    pool.free(block);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return static_cast<double>(cost.count()) / (static_cast<double>(threadNum) * rounds * 4);
+}
+
+/* run with --gtest_also_run_disabled_tests --gtest_filter=MemPoolUT.DISABLED_Benchmark */
+TEST(MemPoolUT, DISABLED_Benchmark)
+{
+    constexpr int rounds = 100000;
+    for (int threadNum : {1, 8, 50}) {
+        LegacyMemPool legacy(BLOCK_SIZE, 500);
+        MemPool pool(BLOCK_SIZE, 500);
+        double legacyNs = BenchAllocFree(legacy, threadNum, rounds);
+        double poolNs = BenchAllocFree(pool, threadNum, rounds);
+        std::println("threads {:>2}: legacy {:.1f} ns/op, mem pool {:.1f} ns/op", threadNum, legacyNs, poolNs);
+        EXPECT_EQ(pool.GetStats().inUse, 0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,151 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "storage/local_storage.h"
+#include "storage/multipart_upload.h"
+#include "thread_pool/thread_pool.h"
+
+class MultipartUploadUT : public testing::Test {
+  public:
+    void SetUp() override
+    {
+        root = "/tmp/multipart_upload_ut_" + std::to_string(getpid());
+        LocalStorageOptions options;
+        options.root = root;
+        LocalStorage::GetInstance()->SetOptions(options);
+        ASSERT_EQ(LocalStorage::GetInstance()->Init(), 0);
+        pool = ThreadPool::CreateThreadPool(4, 1024, "ut");
+        ASSERT_EQ(pool->Start(), 0);
+        data = Pattern(FILE_SIZE);
+        fileName = root + "_cache";
+        writeFd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ASSERT_GE(writeFd, 0);
+    }
+
+    void TearDown() override
+    {
+        close(writeFd);
+        pool->Stop();
+        LocalStorage::GetInstance()->DeleteInstance();
+        std::filesystem::remove_all(root);
+        std::filesystem::remove(fileName);
+    }
+
+    std::shared_ptr<MultipartUpload> NewUpload(const std::string &key)
+    {
+        int fd = open(fileName.c_str(), O_RDONLY);
+        EXPECT_GE(fd, 0);
+        return std::make_shared<MultipartUpload>(LocalStorage::GetInstance(), pool.get(), key, fd, PART_SIZE, 3);
+    }
+
+    void Write(uint64_t offset, uint64_t size, MultipartUpload *upload = nullptr)
+    {
+        ASSERT_EQ(pwrite(writeFd, data.data() + offset, size, offset), (ssize_t)size);
+        if (upload != nullptr) {
+            upload->Written(offset, size);
+        }
+    }
+
+    bool Uploaded(const std::string &key)
+    {
+        std::vector<char> buf(FILE_SIZE + 1);
+        ssize_t ret = LocalStorage::GetInstance()->ReadObject(key, 0, buf.size(), -1, buf.data());
+        return ret == (ssize_t)FILE_SIZE && std::equal(data.begin(), data.end(), buf.begin());
+    }
+
+    bool NoParts()
+    {
+        std::string dir = root + "/" + LocalStorage::MULTIPART_DIR;
+        return !std::filesystem::exists(dir) || std::filesystem::is_empty(dir);
+    }
+
+    static std::vector<char> Pattern(size_t size)
+    {
+        std::vector<char> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>(i * 167 + i / 1000);
+        }
+        return data;
+    }
+
+    static constexpr uint64_t PART_SIZE = 64 * 1024;
+    static constexpr uint64_t FILE_SIZE = 10 * PART_SIZE + 123;
+    std::string root;
+    std::string fileName;
+    int writeFd = -1;
+    std::vector<char> data;
+    std::unique_ptr<ThreadPool> pool;
+};
+
+TEST_F(MultipartUploadUT, Whole)
+{
+    Write(0, FILE_SIZE);
+    auto upload = NewUpload("whole");
+    EXPECT_FALSE(upload->Streamed());
+    EXPECT_EQ(upload->Finish(FILE_SIZE), 0);
+    EXPECT_TRUE(Uploaded("whole"));
+    EXPECT_TRUE(NoParts());
+}
+
+TEST_F(MultipartUploadUT, Streamed)
+{
+    auto upload = NewUpload("streamed");
+    // writes not aligned to parts
+    uint64_t offset = 0;
+    while (offset < FILE_SIZE) {
+        uint64_t size = std::min<uint64_t>(50000, FILE_SIZE - offset);
+        Write(offset, size, upload.get());
+        offset += size;
+    }
+    EXPECT_TRUE(upload->Streamed());
+    EXPECT_EQ(upload->Finish(FILE_SIZE), 0);
+    EXPECT_TRUE(Uploaded("streamed"));
+    EXPECT_TRUE(NoParts());
+}
+
+TEST_F(MultipartUploadUT, StaleOnRewrite)
+{
+    auto upload = NewUpload("stale");
+    Write(0, FILE_SIZE, upload.get());
+    // below a part already sent
+    Write(10, 100, upload.get());
+    EXPECT_EQ(upload->Finish(FILE_SIZE), -ESTALE);
+    upload.reset();
+    EXPECT_TRUE(NoParts());
+    EXPECT_FALSE(std::filesystem::exists(root + "/stale"));
+
+    upload = NewUpload("hole");
+    Write(PART_SIZE, 100, upload.get());
+    EXPECT_FALSE(upload->Streamed());
+    EXPECT_EQ(upload->Finish(FILE_SIZE), -ESTALE);
+}
+
+TEST_F(MultipartUploadUT, StaleOnTruncate)
+{
+    auto upload = NewUpload("truncate");
+    Write(0, 3 * PART_SIZE, upload.get());
+    upload->Truncated(PART_SIZE);
+    EXPECT_EQ(upload->Finish(FILE_SIZE), -ESTALE);
+}
+
+TEST_F(MultipartUploadUT, ShortFile)
+{
+    // the file is shorter than the size claimed
+    Write(0, PART_SIZE);
+    auto upload = NewUpload("short");
+    EXPECT_EQ(upload->Finish(FILE_SIZE), -EIO);
+    upload.reset();
+    EXPECT_TRUE(NoParts());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
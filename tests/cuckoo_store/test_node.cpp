@@ -1,6 +1,7 @@
 #include "test_node.h"
 
 #include "connection/node.h"
+#include "connection/placement.h"
 
 std::shared_ptr<CuckooConfig> NodeUT::config = nullptr;
 std::string NodeUT::localEndpoint;
@@ -85,6 +86,53 @@ TEST_F(NodeUT, AllocNode)
     EXPECT_TRUE(conn);
 }
 
+static double MovedRatio(NodePlacement &placement,
+                         const std::vector<std::pair<int, uint32_t>> &before,
+                         const std::vector<std::pair<int, uint32_t>> &after,
+                         uint64_t keyNum)
+{
+    std::vector<int> owners(keyNum);
+    placement.Rebuild(before);
+    for (uint64_t i = 0; i < keyNum; ++i) {
+        owners[i] = placement.Locate(hash64(i));
+    }
+    placement.Rebuild(after);
+    uint64_t moved = 0;
+    for (uint64_t i = 0; i < keyNum; ++i) {
+        moved += placement.Locate(hash64(i)) != owners[i];
+    }
+    return static_cast<double>(moved) / keyNum;
+}
+
+TEST_F(NodeUT, PlacementMovement)
+{
+    constexpr uint64_t keyNum = 100000;
+    std::vector<std::pair<int, uint32_t>> eight;
+    for (int i = 0; i < 8; ++i) {
+        eight.emplace_back(i, 1);
+    }
+    auto nine = eight;
+    nine.emplace_back(8, 1);
+    auto sevenMiddle = eight;
+    sevenMiddle.erase(sevenMiddle.begin() + 3);
+
+    uint64_t moduloMoved = 0;
+    for (uint64_t i = 0; i < keyNum; ++i) {
+        moduloMoved += hash64(i) % eight.size() != hash64(i) % nine.size();
+    }
+    // modulo placement moves about 8/9 of the keys on join
+    EXPECT_GT(static_cast<double>(moduloMoved) / keyNum, 0.5);
+
+    for (auto policy : {"ring", "jump"}) {
+        auto placement = NodePlacement::Create(policy);
+        // the ideal fraction is 1/9 on join, allow imbalance from hashing
+        EXPECT_LT(MovedRatio(*placement, eight, nine, keyNum), 0.2);
+    }
+    auto ring = NodePlacement::Create("ring");
+    // the ideal fraction is 1/8 when any node leaves
+    EXPECT_LT(MovedRatio(*ring, eight, sevenMiddle, keyNum), 0.2);
+}
+
 TEST_F(NodeUT, GetNextNode)
 {
     int nodeId = config->GetUint32(CuckooPropertyKey::CUCKOO_NODE_ID);
@@ -0,0 +1,146 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "storage/local_storage.h"
+#include "storage/range_download.h"
+#include "thread_pool/thread_pool.h"
+
+class RangeDownloadUT : public testing::Test {
+  public:
+    void SetUp() override
+    {
+        root = "/tmp/range_download_ut_" + std::to_string(getpid());
+        SetBandwidth(0);
+        ASSERT_EQ(LocalStorage::GetInstance()->Init(), 0);
+        data = Pattern(OBJECT_SIZE);
+        ASSERT_EQ(LocalStorage::GetInstance()->PutBuffer("obj", data.data(), data.size(), 0), (ssize_t)data.size());
+        pool = ThreadPool::CreateThreadPool(4, 1024, "ut");
+        ASSERT_EQ(pool->Start(), 0);
+        fileName = root + "/cache";
+    }
+
+    void TearDown() override
+    {
+        pool->Stop();
+        LocalStorage::GetInstance()->DeleteInstance();
+        std::filesystem::remove_all(root);
+    }
+
+    void SetBandwidth(uint32_t bandwidthMBps)
+    {
+        LocalStorageOptions options;
+        options.root = root;
+        options.bandwidthMBps = bandwidthMBps;
+        LocalStorage::GetInstance()->SetOptions(options);
+    }
+
+    std::shared_ptr<RangeDownload> NewDownload()
+    {
+        int fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        EXPECT_GE(fd, 0);
+        EXPECT_EQ(ftruncate(fd, OBJECT_SIZE), 0);
+        return std::make_shared<RangeDownload>(fd, OBJECT_SIZE, RANGE_SIZE);
+    }
+
+    bool Same(int fd, uint64_t offset, uint64_t len)
+    {
+        std::vector<char> buf(len);
+        return pread(fd, buf.data(), len, offset) == (ssize_t)len &&
+               std::equal(buf.begin(), buf.end(), data.begin() + offset);
+    }
+
+    static std::vector<char> Pattern(size_t size)
+    {
+        std::vector<char> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>(i * 131 + i / 4096);
+        }
+        return data;
+    }
+
+    static constexpr uint64_t RANGE_SIZE = 256 * 1024;
+    static constexpr uint64_t OBJECT_SIZE = 16 * RANGE_SIZE + 1000;
+    std::string root;
+    std::string fileName;
+    std::vector<char> data;
+    std::unique_ptr<ThreadPool> pool;
+};
+
+TEST_F(RangeDownloadUT, Whole)
+{
+    auto download = NewDownload();
+    std::atomic<int> calls = 0;
+    std::atomic<int> result = 1;
+    download->Start(LocalStorage::GetInstance(), pool.get(), "obj", 4, [&](int ret) {
+        ++calls;
+        result = ret;
+    });
+    EXPECT_EQ(download->Wait(), 0);
+    EXPECT_TRUE(download->Finished());
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(result, 0);
+    EXPECT_EQ(download->RangeNum(), 17);
+    EXPECT_EQ(download->ReadyNum(), 17);
+    EXPECT_TRUE(download->Ready(0, OBJECT_SIZE));
+    EXPECT_FALSE(download->Ready(0, OBJECT_SIZE + 1));
+    EXPECT_TRUE(Same(download->Fd(), 0, OBJECT_SIZE));
+}
+
+TEST_F(RangeDownloadUT, ReadyBeforeDone)
+{
+    // about 20 ms a range, readers see the first ranges long before the end
+    SetBandwidth(12);
+    auto download = NewDownload();
+    download->Start(LocalStorage::GetInstance(), pool.get(), "obj", 2, nullptr);
+    bool partial = false;
+    while (!download->Finished()) {
+        uint64_t ready = download->ReadyNum();
+        if (ready > 0 && ready < download->RangeNum()) {
+            partial = true;
+        }
+        for (uint64_t offset = 0; offset < OBJECT_SIZE; offset += RANGE_SIZE) {
+            uint64_t len = std::min(RANGE_SIZE, OBJECT_SIZE - offset);
+            if (download->Ready(offset, len)) {
+                EXPECT_TRUE(Same(download->Fd(), offset, len)) << offset;
+            }
+        }
+        usleep(5000);
+    }
+    EXPECT_TRUE(partial);
+    EXPECT_EQ(download->Wait(), 0);
+    EXPECT_TRUE(Same(download->Fd(), 0, OBJECT_SIZE));
+}
+
+TEST_F(RangeDownloadUT, Missing)
+{
+    auto download = NewDownload();
+    std::atomic<int> result = 0;
+    download->Start(LocalStorage::GetInstance(), pool.get(), "missing", 4, [&](int ret) { result = ret; });
+    EXPECT_EQ(download->Wait(), -EIO);
+    EXPECT_EQ(result, -EIO);
+    EXPECT_FALSE(download->Ready(0, 1));
+}
+
+TEST_F(RangeDownloadUT, NoPool)
+{
+    // loaded on the calling thread
+    auto download = NewDownload();
+    download->Start(LocalStorage::GetInstance(), nullptr, "obj", 4, nullptr);
+    EXPECT_TRUE(download->Finished());
+    EXPECT_EQ(download->Wait(), 0);
+    EXPECT_TRUE(Same(download->Fd(), 0, OBJECT_SIZE));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -9,100 +9,137 @@ char *CuckooStoreUT::readBuf = nullptr;
 size_t CuckooStoreUT::readSize = 0;
 char *CuckooStoreUT::readBuf2 = nullptr;
 
-static Pipe s_pipe;
+static constexpr size_t FILE_BLOCKS = 16;
+static std::unique_ptr<ThreadPool> s_pool;
+static std::vector<char> s_data;
 
-/*-------------------------------------------- Pipe --------------------------------------------*/
+static ReadAheadOptions Options()
+{
+    ReadAheadOptions options;
+    options.blockSize = CUCKOO_BLOCK_SIZE;
+    options.maxStreams = 4;
+    options.maxWindowBlocks = 8;
+    return options;
+}
 
-TEST_F(CuckooStoreUT, WaitPush)
+static bool Expect(const char *buf, off_t offset, size_t len)
 {
-    ResetBuf(true);
-    NewOpenInstance(100, StoreNode::GetInstance()->GetNodeId(), "/WaitPush", O_RDWR | O_CREAT);
-    int ret = CuckooStore::GetInstance()->WriteFile(openInstance.get(), writeBuf, size, 0);
+    return memcmp(buf, s_data.data() + offset, len) == 0;
+}
+
+/*-------------------------------------------- ReadStream --------------------------------------------*/
+
+TEST_F(CuckooStoreUT, ReadStreamInit)
+{
+    s_data.resize(FILE_BLOCKS * CUCKOO_BLOCK_SIZE - 100);
+    for (size_t i = 0; i < s_data.size(); ++i) {
+        s_data[i] = static_cast<char>(i * 131 + i / 4096);
+    }
+    NewOpenInstance(200, StoreNode::GetInstance()->GetNodeId(), "/ReadStream", O_RDWR | O_CREAT);
+    int ret = CuckooStore::GetInstance()->WriteFile(openInstance.get(), s_data.data(), s_data.size(), 0);
     EXPECT_EQ(ret, 0);
     ret = CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), true, true);
     EXPECT_EQ(ret, 0);
     ret = CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), false, true);
     EXPECT_EQ(ret, 0);
-    NewOpenInstance(100, StoreNode::GetInstance()->GetNodeId(), "/WaitPush", O_RDONLY);
-    openInstance->originalSize = size;
-    openInstance->currentSize = size;
+
+    NewOpenInstance(200, StoreNode::GetInstance()->GetNodeId(), "/ReadStream", O_RDONLY);
+    openInstance->originalSize = s_data.size();
+    openInstance->currentSize = s_data.size();
     ret = CuckooStore::GetInstance()->OpenFile(openInstance.get());
     EXPECT_EQ(ret, 0);
 
-    int blockSize = config->GetUint32(CuckooPropertyKey::CUCKOO_BLOCK_SIZE);
-    s_pipe.Init(blockSize);
-    ssize_t retSize = s_pipe.WaitPush(openInstance.get(), 0);
-    EXPECT_EQ(retSize, blockSize);
+    s_pool = ThreadPool::CreateThreadPool(4, 1000, "read stream ut");
+    ASSERT_NE(s_pool, nullptr);
+    EXPECT_EQ(s_pool->Start(), 0);
+    openInstance->readStream.Init(openInstance.get(), Options(), s_pool.get());
 }
 
-TEST_F(CuckooStoreUT, WaitPop)
+TEST_F(CuckooStoreUT, ReadStreamReadZero)
 {
-    int popSize = config->GetUint32(CuckooPropertyKey::CUCKOO_BLOCK_SIZE) / 2;
-    char *buf = (char *)malloc(popSize);
-    bool end = false;
-    ssize_t retSize = s_pipe.WaitPop(buf, popSize, end);
-    EXPECT_EQ(retSize, popSize);
-    EXPECT_FALSE(end);
-    retSize = s_pipe.WaitPop(buf, popSize, end);
-    EXPECT_EQ(retSize, popSize);
-    EXPECT_TRUE(end);
-    s_pipe.Destroy();
+    char buf[16];
+    EXPECT_EQ(openInstance->readStream.Read(buf, 0, 0), 0);
+    EXPECT_EQ(openInstance->readStream.Read(buf, sizeof(buf), s_data.size()), 0);
 }
 
-/*-------------------------------------------- ReadStream --------------------------------------------*/
-
-TEST_F(CuckooStoreUT, ReadStreamInit)
+TEST_F(CuckooStoreUT, ReadStreamSequential)
 {
-    int fileBlocks = (openInstance->currentSize + CUCKOO_BLOCK_SIZE - 1) / CUCKOO_BLOCK_SIZE;
-
-    EXPECT_TRUE(openInstance->readStream.Init(openInstance.get(), fileBlocks, CUCKOO_BLOCK_SIZE));
-    openInstance->readStream.StartPushThreaded();
+    // unaligned reads, the last one is short at end of file
+    size_t chunk = CUCKOO_BLOCK_SIZE / 3;
+    std::vector<char> buf(chunk);
+    off_t offset = 0;
+    while (offset < (off_t)s_data.size()) {
+        ssize_t ret = openInstance->readStream.Read(buf.data(), chunk, offset);
+        ASSERT_EQ(ret, (ssize_t)std::min(chunk, s_data.size() - offset));
+        ASSERT_TRUE(Expect(buf.data(), offset, ret));
+        offset += ret;
+    }
+    auto stats = openInstance->readStream.GetStats();
+    EXPECT_EQ(stats.streams, 1);
+    EXPECT_GT(stats.hits + stats.waits, 0);
+    EXPECT_LE(stats.maxWindow, Options().maxWindowBlocks);
 }
 
-TEST_F(CuckooStoreUT, ReadStreamReadZero)
+TEST_F(CuckooStoreUT, ReadStreamSmallJump)
 {
-    ssize_t ret = openInstance->readStream.WaitPop(readBuf, 0);
-    EXPECT_EQ(ret, 0);
+    // a jump back within the tolerance continues the stream
+    size_t len = 4096;
+    std::vector<char> buf(len);
+    off_t offset = s_data.size() - CUCKOO_BLOCK_SIZE;
+    EXPECT_EQ(openInstance->readStream.Read(buf.data(), len, offset), (ssize_t)len);
+    EXPECT_TRUE(Expect(buf.data(), offset, len));
+    EXPECT_EQ(openInstance->readStream.GetStats().streams, 1);
 }
 
-TEST_F(CuckooStoreUT, ReadStreamReadExceed)
+TEST_F(CuckooStoreUT, ReadStreamInterleaved)
 {
-    size_t largeSize = 2 * config->GetUint32(CuckooPropertyKey::CUCKOO_BLOCK_SIZE);
-    char *buf = (char *)malloc(size);
-    auto index = openInstance->readStream.pipeIndex;
-    ssize_t ret = openInstance->readStream.WaitPop(buf, largeSize);
-    EXPECT_EQ(ret, largeSize);
-    EXPECT_EQ((index + 2) % openInstance->readStream.pipeNum, openInstance->readStream.pipeIndex);
-    free(buf);
+    // two readers of the same file are tracked as two streams
+    openInstance->readStream.Stop();
+    openInstance->readStream.WaitLoadEnded();
+    openInstance->readStream.Init(openInstance.get(), Options(), s_pool.get());
+    size_t len = CUCKOO_BLOCK_SIZE / 2;
+    std::vector<char> buf(len);
+    off_t first = 0;
+    off_t second = FILE_BLOCKS / 2 * CUCKOO_BLOCK_SIZE;
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_EQ(openInstance->readStream.Read(buf.data(), len, first), (ssize_t)len);
+        ASSERT_TRUE(Expect(buf.data(), first, len));
+        ASSERT_EQ(openInstance->readStream.Read(buf.data(), len, second), (ssize_t)len);
+        ASSERT_TRUE(Expect(buf.data(), second, len));
+        first += len;
+        second += len;
+    }
+    auto stats = openInstance->readStream.GetStats();
+    EXPECT_EQ(stats.streams, 2);
+    EXPECT_GT(stats.hits + stats.waits, 0);
 }
 
-TEST_F(CuckooStoreUT, ReadStreamReadHalf)
+TEST_F(CuckooStoreUT, ReadStreamRandom)
 {
-    size_t halfSize = config->GetUint32(CuckooPropertyKey::CUCKOO_BLOCK_SIZE) / 2;
-    char *buf = (char *)malloc(halfSize);
-    auto index = openInstance->readStream.pipeIndex;
-    ssize_t ret = openInstance->readStream.WaitPop(buf, halfSize);
-    EXPECT_EQ(ret, halfSize);
-    EXPECT_EQ(index, openInstance->readStream.pipeIndex);
-    ret = openInstance->readStream.WaitPop(buf, halfSize);
-    EXPECT_EQ(ret, halfSize);
-    EXPECT_EQ((index + 1) % openInstance->readStream.pipeNum, openInstance->readStream.pipeIndex);
-    free(buf);
+    size_t len = 8192;
+    std::vector<char> buf(len);
+    for (int i = 0; i < 64; ++i) {
+        off_t offset = (i * 7919 % FILE_BLOCKS) * CUCKOO_BLOCK_SIZE + i * 97;
+        ssize_t ret = openInstance->readStream.Read(buf.data(), len, offset);
+        ASSERT_EQ(ret, (ssize_t)std::min(len, s_data.size() - offset));
+        ASSERT_TRUE(Expect(buf.data(), offset, ret));
+    }
+    EXPECT_LE(openInstance->readStream.GetStats().streams, Options().maxStreams);
 }
 
-TEST_F(CuckooStoreUT, ReadStreamReadFull)
+TEST_F(CuckooStoreUT, ReadStreamStop)
 {
-    size_t fullSize = config->GetUint32(CuckooPropertyKey::CUCKOO_BLOCK_SIZE);
-    char *buf = (char *)malloc(fullSize);
-    ssize_t ret = 0;
-    while (ret == (ssize_t)readSize) {
-        auto index = openInstance->readStream.pipeIndex;
-        ret = openInstance->readStream.WaitPop(buf, fullSize);
-        EXPECT_EQ(ret, fullSize);
-        EXPECT_EQ((index + 1) % openInstance->readStream.pipeNum, openInstance->readStream.pipeIndex);
-    }
-    free(buf);
+    openInstance->readStream.Stop();
+    openInstance->readStream.WaitLoadEnded();
+    EXPECT_EQ(openInstance->readStream.GetStats().blocks, 0);
+    // reads go to the file directly
+    size_t len = 4096;
+    std::vector<char> buf(len);
+    EXPECT_EQ(openInstance->readStream.Read(buf.data(), len, CUCKOO_BLOCK_SIZE), (ssize_t)len);
+    EXPECT_TRUE(Expect(buf.data(), CUCKOO_BLOCK_SIZE, len));
+    EXPECT_EQ(CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), false, false), 0);
     openInstance = nullptr;
+    s_pool = nullptr;
 }
 
 int main(int argc, char **argv)
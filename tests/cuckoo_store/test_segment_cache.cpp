@@ -0,0 +1,209 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "disk_cache/disk_cache.h"
+#include "disk_cache/segment_cache.h"
+#include "io_engine/io_engine.h"
+#include "thread_pool/thread_pool.h"
+#include "util/utils.h"
+
+class SegmentCacheUT : public testing::Test {
+  public:
+    static void SetUpTestSuite()
+    {
+        std::filesystem::remove_all(rootPath);
+        for (int i = 0; i < DIR_NUM; ++i) {
+            std::filesystem::create_directories(rootPath + std::to_string(i));
+        }
+        SetRootPath(rootPath);
+        SetTotalDirectory(DIR_NUM);
+        ASSERT_EQ(DiskCache::GetInstance().Start(rootPath, DIR_NUM, 0.01, 0.01, 0), 0);
+        IoEngine::GetInstance().Init(IoEngineOptions{});
+    }
+
+    void SetUp() override { std::filesystem::remove_all(GetSegmentDir()); }
+
+    static std::unique_ptr<SegmentCache> NewCache(uint64_t segmentSize = 64 * 1024)
+    {
+        SegmentCacheOptions options;
+        options.segmentSize = segmentSize;
+        options.maxFileSize = 8 * 1024;
+        auto cache = std::make_unique<SegmentCache>(options);
+        EXPECT_EQ(cache->Start(), 0);
+        return cache;
+    }
+
+    static std::string Data(uint64_t inodeId, uint64_t size)
+    {
+        std::string data(size, '\0');
+        for (uint64_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>('a' + (inodeId + i) % 26);
+        }
+        return data;
+    }
+
+    static bool Cached(SegmentCache &cache, uint64_t inodeId, uint64_t size)
+    {
+        std::vector<char> buf(size);
+        return cache.Read(inodeId, buf.data(), size) == (ssize_t)size &&
+               std::string(buf.data(), size) == Data(inodeId, size);
+    }
+
+    static inline std::string rootPath = "/tmp/segment_cache_ut/";
+    static constexpr int DIR_NUM = 4;
+};
+
+TEST_F(SegmentCacheUT, PutRead)
+{
+    auto cache = NewCache();
+    EXPECT_FALSE(cache->Fits(0));
+    EXPECT_FALSE(cache->Fits(8 * 1024 + 1));
+    EXPECT_EQ(cache->Put(1, Data(1, 9000).data(), 9000), -EFBIG);
+
+    for (uint64_t inodeId = 1; inodeId <= 40; ++inodeId) {
+        std::string data = Data(inodeId, 1000 + inodeId * 100);
+        ASSERT_EQ(cache->Put(inodeId, data.data(), data.size()), 0);
+    }
+    for (uint64_t inodeId = 1; inodeId <= 40; ++inodeId) {
+        EXPECT_TRUE(Cached(*cache, inodeId, 1000 + inodeId * 100));
+    }
+    char buf[16];
+    EXPECT_EQ(cache->Read(1, buf, sizeof(buf)), -ENOENT);
+    EXPECT_EQ(cache->Read(100, buf, sizeof(buf)), -ENOENT);
+
+    auto stats = cache->GetStats();
+    EXPECT_EQ(stats.files, 40);
+    EXPECT_EQ(stats.puts, 40);
+    EXPECT_EQ(stats.hits, 40);
+    EXPECT_EQ(stats.misses, 2);
+    EXPECT_GT(stats.segments, 1);
+}
+
+TEST_F(SegmentCacheUT, RemoveCompacts)
+{
+    auto cache = NewCache();
+    for (uint64_t inodeId = 1; inodeId <= 40; ++inodeId) {
+        std::string data = Data(inodeId, 4000);
+        ASSERT_EQ(cache->Put(inodeId, data.data(), data.size()), 0);
+    }
+    uint64_t segments = cache->GetStats().segments;
+    /* empties the sealed segments below the ratio */
+    for (uint64_t inodeId = 1; inodeId <= 40; inodeId += 4) {
+        for (uint64_t i = inodeId; i < inodeId + 3; ++i) {
+            cache->Remove(i);
+        }
+    }
+    auto stats = cache->GetStats();
+    EXPECT_EQ(stats.files, 10);
+    EXPECT_GT(stats.compactions, 0);
+    EXPECT_LT(stats.segments, segments);
+    for (uint64_t inodeId = 1; inodeId <= 40; ++inodeId) {
+        EXPECT_EQ(Cached(*cache, inodeId, 4000), inodeId % 4 == 0) << inodeId;
+    }
+}
+
+// without a pool compaction runs inline on the thread replacing the file
+TEST_F(SegmentCacheUT, ReplaceCompactsInline)
+{
+    auto cache = NewCache();
+    for (uint64_t inodeId = 1; inodeId <= 40; ++inodeId) {
+        std::string data = Data(inodeId, 4000);
+        ASSERT_EQ(cache->Put(inodeId, data.data(), data.size()), 0);
+    }
+    for (uint64_t inodeId = 1; inodeId <= 12; ++inodeId) {
+        std::string data = Data(inodeId, 3000);
+        ASSERT_EQ(cache->Put(inodeId, data.data(), data.size()), 0);
+    }
+    EXPECT_GT(cache->GetStats().compactions, 0);
+    for (uint64_t inodeId = 1; inodeId <= 40; ++inodeId) {
+        EXPECT_TRUE(Cached(*cache, inodeId, inodeId <= 12 ? 3000 : 4000)) << inodeId;
+    }
+}
+
+TEST_F(SegmentCacheUT, Restart)
+{
+    auto cache = NewCache();
+    for (uint64_t inodeId = 1; inodeId <= 20; ++inodeId) {
+        std::string data = Data(inodeId, 2000);
+        ASSERT_EQ(cache->Put(inodeId, data.data(), data.size()), 0);
+    }
+    std::string newer = Data(7, 3000);
+    ASSERT_EQ(cache->Put(7, newer.data(), newer.size()), 0);
+    cache->Remove(3);
+    cache->Stop();
+    cache.reset();
+
+    cache = NewCache();
+    EXPECT_EQ(cache->GetStats().files, 19);
+    EXPECT_FALSE(Cached(*cache, 3, 2000));
+    EXPECT_TRUE(Cached(*cache, 7, 3000));
+    EXPECT_TRUE(Cached(*cache, 20, 2000));
+}
+
+TEST_F(SegmentCacheUT, UnsealedDropped)
+{
+    auto cache = NewCache(1024 * 1024);
+    for (uint64_t inodeId = 1; inodeId <= 5; ++inodeId) {
+        std::string data = Data(inodeId, 2000);
+        ASSERT_EQ(cache->Put(inodeId, data.data(), data.size()), 0);
+    }
+    /* a crash leaves the active segment unsealed */
+    std::filesystem::path copy = rootPath + "crashed.seg";
+    std::filesystem::copy_file(GetSegmentDir() + "/0.seg", copy, std::filesystem::copy_options::overwrite_existing);
+    cache.reset();
+    std::filesystem::rename(copy, GetSegmentDir() + "/0.seg");
+
+    cache = NewCache(1024 * 1024);
+    EXPECT_EQ(cache->GetStats().files, 0);
+    EXPECT_FALSE(std::filesystem::exists(GetSegmentDir() + "/0.seg"));
+    EXPECT_FALSE(Cached(*cache, 1, 2000));
+}
+
+TEST_F(SegmentCacheUT, Concurrent)
+{
+    auto pool = ThreadPool::CreateThreadPool(2, 64, "segment_ut");
+    ASSERT_EQ(pool->Start(), 0);
+    auto cache = NewCache(32 * 1024);
+    cache->SetThreadPool(pool.get());
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t]() {
+            for (int round = 0; round < 50; ++round) {
+                for (uint64_t inodeId = t * 100; inodeId < t * 100 + 10; ++inodeId) {
+                    std::string data = Data(inodeId, 1500);
+                    EXPECT_EQ(cache->Put(inodeId, data.data(), data.size()), 0);
+                    EXPECT_TRUE(Cached(*cache, inodeId, 1500));
+                    if (round % 3 == 0) {
+                        cache->Remove(inodeId);
+                    }
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    cache->Stop();
+    pool->Stop();
+    auto stats = cache->GetStats();
+    EXPECT_EQ(stats.files, 40);
+    EXPECT_GT(stats.compactions, 0);
+    for (uint64_t t = 0; t < 4; ++t) {
+        for (uint64_t inodeId = t * 100; inodeId < t * 100 + 10; ++inodeId) {
+            EXPECT_TRUE(Cached(*cache, inodeId, 1500));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,195 @@
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <mutex>
+#include <print>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "thread_pool/thread_pool.h"
+
+using namespace std::chrono_literals;
+
+TEST(ThreadPoolUT, RunAll)
+{
+    auto pool = ThreadPool::CreateThreadPool(4, 64, "ut");
+    ASSERT_EQ(pool->Start(), 0);
+    std::atomic<int> done = 0;
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(pool->Submit({.taskName = "count", .task = [&done]() { ++done; }}), 0);
+    }
+    // queued tasks are run before the workers exit
+    pool->Stop();
+    EXPECT_EQ(done, 10000);
+    EXPECT_EQ(pool->GetStats().completed, 10000);
+    EXPECT_NE(pool->Submit({.taskName = "noop", .task = []() {}}), 0);
+}
+
+TEST(ThreadPoolUT, ForegroundFirst)
+{
+    auto pool = ThreadPool::CreateThreadPool(1, 64, "ut");
+    std::mutex mutex;
+    std::vector<TaskPriority> order;
+    auto record = [&](TaskPriority priority) {
+        return ThreadTask{.taskName = "record",
+                          .task =
+                              [&, priority]() {
+                                  std::lock_guard lock(mutex);
+                                  order.push_back(priority);
+                              },
+                          .priority = priority};
+    };
+    // queued before the worker starts, so the order is decided by priority only
+    for (int i = 0; i < 5; ++i) {
+        pool->Submit(record(TaskPriority::BACKGROUND));
+        pool->Submit(record(TaskPriority::FOREGROUND));
+    }
+    EXPECT_EQ(pool->GetStats().queued[static_cast<int>(TaskPriority::BACKGROUND)], 5);
+    ASSERT_EQ(pool->Start(), 0);
+    pool->Stop();
+    ASSERT_EQ(order.size(), 10);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(order[i], i < 5 ? TaskPriority::FOREGROUND : TaskPriority::BACKGROUND);
+    }
+}
+
+TEST(ThreadPoolUT, Backpressure)
+{
+    auto pool = ThreadPool::CreateThreadPool(1, 2, "ut");
+    ASSERT_EQ(pool->Start(), 0);
+    std::latch release(1);
+    std::latch running(1);
+    pool->Submit({.taskName = "block", .task = [&]() {
+        running.count_down();
+        release.wait();
+    }});
+    running.wait();
+    EXPECT_EQ(pool->TrySubmit({.taskName = "noop", .task = []() {}}), 0);
+    EXPECT_EQ(pool->TrySubmit({.taskName = "noop", .task = []() {}}), 0);
+    EXPECT_EQ(pool->TrySubmit({.taskName = "noop", .task = []() {}}), -EAGAIN);
+
+    // Submit waits for room instead of failing
+    std::atomic<bool> submitted = false;
+    std::jthread submitter([&]() {
+        pool->Submit({.taskName = "noop", .task = []() {}});
+        submitted = true;
+    });
+    std::this_thread::sleep_for(50ms);
+    EXPECT_FALSE(submitted);
+    release.count_down();
+    submitter.join();
+    EXPECT_TRUE(submitted);
+    pool->Stop();
+    EXPECT_EQ(pool->GetStats().completed, 4);
+}
+
+TEST(ThreadPoolUT, SubmitFromWorkerWhenFull)
+{
+    // a worker submitting to its own full pool must not wait for itself
+    auto pool = ThreadPool::CreateThreadPool(1, 1, "ut");
+    ASSERT_EQ(pool->Start(), 0);
+    std::atomic<int> done = 0;
+    std::latch finished(1);
+    pool->Submit({.taskName = "submit children", .task = [&]() {
+        for (int i = 0; i < 10; ++i) {
+            pool->Submit({.taskName = "count", .task = [&done]() { ++done; }});
+        }
+        finished.count_down();
+    }});
+    finished.wait();
+    pool->Stop();
+    EXPECT_EQ(done, 10);
+    EXPECT_GT(pool->GetStats().inlined, 0);
+}
+
+TEST(ThreadPoolUT, Steal)
+{
+    constexpr int THREAD_NUM = 4;
+    auto pool = ThreadPool::CreateThreadPool(THREAD_NUM, 1024, "ut");
+    ASSERT_EQ(pool->Start(), 0);
+    // every child lands in the deque of the worker running the parent, the others steal them
+    std::atomic<int> done = 0;
+    std::latch finished(THREAD_NUM * 16);
+    pool->Submit({.taskName = "submit children", .task = [&]() {
+        for (int i = 0; i < THREAD_NUM * 16; ++i) {
+            pool->Submit({.taskName = "child", .task = [&]() {
+                std::this_thread::sleep_for(1ms);
+                ++done;
+                finished.count_down();
+            }});
+        }
+    }});
+    finished.wait();
+    EXPECT_EQ(done, THREAD_NUM * 16);
+    EXPECT_GT(pool->GetStats().stolen, 0);
+}
+
+TEST(ThreadPoolUT, RunAndWait)
+{
+    auto pool = ThreadPool::CreateThreadPool(4, 64, "ut");
+    ASSERT_EQ(pool->Start(), 0);
+    std::vector<int> results(16, 0);
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < results.size(); ++i) {
+        tasks.emplace_back([&results, i]() {
+            std::this_thread::sleep_for(1ms);
+            results[i] = static_cast<int>(i) + 1;
+        });
+    }
+    pool->RunAndWait(tasks);
+    for (size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(results[i], static_cast<int>(i) + 1);
+    }
+
+    // from the only worker, with the queue full, the caller runs them all
+    std::atomic<int> done = 0;
+    std::latch finished(1);
+    pool = ThreadPool::CreateThreadPool(1, 1, "ut");
+    ASSERT_EQ(pool->Start(), 0);
+    pool->Submit({.taskName = "run nested", .task = [&]() {
+        std::vector<std::function<void()>> nested(8, [&done]() { ++done; });
+        pool->RunAndWait(nested);
+        finished.count_down();
+    }});
+    finished.wait();
+    EXPECT_EQ(done, 8);
+    pool->Stop();
+}
+
+TEST(ThreadPoolUT, Benchmark)
+{
+    constexpr int SUBMITTER_NUM = 8;
+    constexpr int TASK_NUM = 100000;
+    auto pool = ThreadPool::CreateThreadPool(8, 100000, "ut");
+    ASSERT_EQ(pool->Start(), 0);
+    std::atomic<int> done = 0;
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> submitters;
+        for (int t = 0; t < SUBMITTER_NUM; ++t) {
+            submitters.emplace_back([&]() {
+                for (int i = 0; i < TASK_NUM / SUBMITTER_NUM; ++i) {
+                    pool->Submit({.taskName = "count", .task = [&done]() { ++done; }});
+                }
+            });
+        }
+    }
+    pool->Stop();
+    auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    EXPECT_EQ(done, TASK_NUM);
+    auto stats = pool->GetStats();
+    std::println("thread pool: {} ns/task, queue latency avg {} us max {} us, stolen {}",
+                 cost.count() / TASK_NUM,
+                 stats.avgQueueLatencyUs,
+                 stats.maxQueueLatencyUs,
+                 stats.stolen);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
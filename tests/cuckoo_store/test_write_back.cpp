@@ -0,0 +1,166 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "storage/write_back.h"
+
+class WriteBackUT : public testing::Test {
+  public:
+    void SetUp() override
+    {
+        journal = "/tmp/write_back_ut_" + std::to_string(getpid()) + ".journal";
+        std::filesystem::remove(journal);
+    }
+
+    void TearDown() override { std::filesystem::remove(journal); }
+
+    std::unique_ptr<WriteBack> NewWriteBack(uint32_t delayMs, uint32_t concurrency = 2, uint32_t rateMBps = 0)
+    {
+        WriteBackOptions options;
+        options.journalPath = journal;
+        options.concurrency = concurrency;
+        options.rateMBps = rateMBps;
+        options.delayMs = delayMs;
+        options.retryMs = 50;
+        auto writeBack = std::make_unique<WriteBack>(options, [this](uint64_t inodeId, const std::string & /*path*/) {
+            int running = ++uploading;
+            int max = maxUploading.load();
+            while (running > max && !maxUploading.compare_exchange_weak(max, running)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(uploadMs));
+            --uploading;
+            std::lock_guard lock(mutex);
+            if (fail) {
+                return -EIO;
+            }
+            uploaded.insert(inodeId);
+            ++uploadNum;
+            return 0;
+        });
+        EXPECT_EQ(writeBack->Start(), 0);
+        return writeBack;
+    }
+
+    static bool WaitClean(WriteBack &writeBack)
+    {
+        for (int i = 0; i < 500 && writeBack.GetStats().dirty > 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return writeBack.GetStats().dirty == 0;
+    }
+
+    std::string journal;
+    std::mutex mutex;
+    std::atomic<bool> fail = false;
+    std::set<uint64_t> uploaded;
+    std::atomic<int> uploadNum = 0;
+    int uploadMs = 0;
+    std::atomic<int> uploading = 0;
+    std::atomic<int> maxUploading = 0;
+};
+
+TEST_F(WriteBackUT, Coalesce)
+{
+    auto writeBack = NewWriteBack(200);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(writeBack->MarkDirty(1, "/a", 100), 0);
+    }
+    EXPECT_EQ(writeBack->MarkDirty(2, "/b", 100), 0);
+    EXPECT_EQ(writeBack->GetStats().dirty, 2);
+    EXPECT_TRUE(WaitClean(*writeBack));
+    auto stats = writeBack->GetStats();
+    EXPECT_EQ(stats.marked, 6);
+    EXPECT_EQ(stats.coalesced, 4);
+    EXPECT_EQ(stats.uploaded, 2);
+    EXPECT_EQ(uploadNum, 2);
+}
+
+TEST_F(WriteBackUT, Concurrency)
+{
+    uploadMs = 20;
+    auto writeBack = NewWriteBack(0, 3);
+    for (uint64_t i = 0; i < 20; ++i) {
+        EXPECT_EQ(writeBack->MarkDirty(i, "/f" + std::to_string(i), 100), 0);
+    }
+    EXPECT_TRUE(WaitClean(*writeBack));
+    EXPECT_EQ(uploaded.size(), 20);
+    EXPECT_LE(maxUploading, 3);
+    EXPECT_GE(maxUploading, 2);
+}
+
+TEST_F(WriteBackUT, Replay)
+{
+    fail = true;
+    auto writeBack = NewWriteBack(0);
+    EXPECT_EQ(writeBack->MarkDirty(1, "/a", 100), 0);
+    EXPECT_EQ(writeBack->MarkDirty(2, "/b", 100), 0);
+    EXPECT_EQ(writeBack->MarkDirty(3, "/c", 100), 0);
+    writeBack->Forget(2);
+    writeBack.reset();
+
+    // a torn record at the end
+    int fd = open(journal.c_str(), O_WRONLY | O_APPEND);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, "garbage", 7), 7);
+    close(fd);
+
+    fail = false;
+    writeBack = NewWriteBack(0);
+    EXPECT_EQ(writeBack->GetStats().replayed, 2);
+    EXPECT_TRUE(WaitClean(*writeBack));
+    EXPECT_EQ(uploaded, (std::set<uint64_t>{1, 3}));
+    writeBack.reset();
+
+    // nothing left after a clean run
+    uploaded.clear();
+    writeBack = NewWriteBack(0);
+    EXPECT_EQ(writeBack->GetStats().replayed, 0);
+}
+
+// replayed uploads are rate limited by the size the file was flushed with
+TEST_F(WriteBackUT, ReplayThrottle)
+{
+    auto writeBack = NewWriteBack(60 * 1000);
+    EXPECT_EQ(writeBack->MarkDirty(1, "/a", 100 * 1000), 0);
+    EXPECT_EQ(writeBack->MarkDirty(2, "/b", 100 * 1000), 0);
+    writeBack.reset();
+
+    // 1 MB/s, the second upload starts 100 ms after the first
+    auto start = std::chrono::steady_clock::now();
+    writeBack = NewWriteBack(0, 2, 1);
+    EXPECT_EQ(writeBack->GetStats().replayed, 2);
+    EXPECT_TRUE(WaitClean(*writeBack));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(90));
+    EXPECT_EQ(uploaded, (std::set<uint64_t>{1, 2}));
+}
+
+TEST_F(WriteBackUT, Sync)
+{
+    auto writeBack = NewWriteBack(60 * 1000);
+    EXPECT_EQ(writeBack->MarkDirty(1, "/a", 100), 0);
+    EXPECT_EQ(writeBack->MarkDirty(2, "/b", 100), 0);
+    EXPECT_EQ(writeBack->Sync("/a"), 0);
+    EXPECT_EQ(uploaded, std::set<uint64_t>{1});
+    EXPECT_EQ(writeBack->Sync("/c"), 0);
+
+    fail = true;
+    EXPECT_EQ(writeBack->Sync("/b"), -EIO);
+    EXPECT_GE(writeBack->GetStats().failed, 1);
+    fail = false;
+    EXPECT_TRUE(WaitClean(*writeBack));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}